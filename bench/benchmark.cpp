@@ -0,0 +1,199 @@
+#include "contocorrente.h"
+#include "utilita.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace std;
+
+/**
+ * @brief Stream di output che scarta tutto (per misurare solo la formattazione)
+ */
+class StreamNullo : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+/**
+ * @brief Genera transazioni sintetiche ripetibili
+ * @param righe Numero di transazioni
+ * @return vector<Transazione> Transazioni quasi ordinate per data
+ */
+vector<Transazione> generaTransazioni(size_t righe) {
+    static const vector<string> modelli = {
+        "Pagamento POS supermercato", "Bonifico affitto", "Bolletta luce Enel", "Bolletta gas",
+        "Stipendio", "Prelievo bancomat", "Caffè bar centrale", "Ristorante da Mario",
+        "Abbonamento palestra", "Rifornimento carburante", "Farmacia comunale", "Libreria università",
+        "Commissioni bancarie", "Rimborso spese", "Acquisto online", "Assicurazione auto"};
+    minstd_rand generatore(42);
+    vector<Transazione> risultati;
+    risultati.reserve(righe);
+    int giorno = dataInGiorni("2021-01-01");
+    for (size_t i = 0; i < righe; i++) {
+        if (generatore() % 64 == 0) {
+            giorno++;
+        }
+        int ritardo = (generatore() % 20 == 0) ? static_cast<int>(generatore() % 10) : 0;
+        const string& modello = modelli[generatore() % modelli.size()];
+        double importo = (modello == "Stipendio" || modello == "Rimborso spese" ? 1 : -1) *
+                         static_cast<double>(generatore() % 100000) / 100.0;
+        risultati.emplace_back(modello + " " + to_string(generatore() % 500), importo, giorniInData(giorno - ritardo));
+    }
+    return risultati;
+}
+
+/**
+ * @brief Misura il tempo migliore di una funzione su più ripetizioni
+ * @param nome Nome del benchmark
+ * @param righe Righe elaborate per ripetizione (per il throughput)
+ * @param ripetizioni Numero di ripetizioni
+ * @param f Funzione da misurare
+ */
+template <typename F>
+void misura(const string& nome, size_t righe, int ripetizioni, F f) {
+    double migliore = 1e300;
+    for (int r = 0; r < ripetizioni; r++) {
+        auto inizio = chrono::steady_clock::now();
+        f();
+        chrono::duration<double, milli> durata = chrono::steady_clock::now() - inizio;
+        migliore = min(migliore, durata.count());
+    }
+    cout << left << setw(40) << nome << right << setw(12) << fixed << setprecision(2) << migliore << " ms"
+         << setw(14) << setprecision(0) << righe / (migliore / 1000.0) << " righe/s" << endl;
+}
+
+int main(int argc, char** argv) {
+    size_t righe = 1000000;
+    int ripetizioni = 3;
+    for (int i = 1; i < argc; i++) {
+        string argomento = argv[i];
+        if (argomento == "--rapido") {
+            righe = 100000;
+            ripetizioni = 1;
+        } else if (argomento == "--righe" && i + 1 < argc) {
+            righe = strtoull(argv[++i], nullptr, 10);
+        } else if (argomento == "--ripetizioni" && i + 1 < argc) {
+            ripetizioni = max(1, atoi(argv[++i]));
+        } else {
+            cerr << "Uso: " << argv[0] << " [--rapido] [--righe N] [--ripetizioni R]" << endl;
+            return 1;
+        }
+    }
+
+    string file = (filesystem::temp_directory_path() / ("benchmark_conto_" + to_string(getpid()) + ".dat")).string();
+    vector<Transazione> dati = generaTransazioni(righe);
+
+    // I messaggi di caricamento del conto non interessano qui
+    StreamNullo nullo;
+    streambuf* coutOriginale = cout.rdbuf(&nullo);
+    ContoCorrente conto(file);
+    cout.rdbuf(coutOriginale);
+    cout << "Benchmark su " << righe << " transazioni, migliore di " << ripetizioni << " ripetizioni" << endl;
+
+    auto silenzioso = [&](auto f) {
+        cout.rdbuf(&nullo);
+        f();
+        cout.rdbuf(coutOriginale);
+    };
+
+    misura("inserimento ordinato per data", righe, ripetizioni, [&] {
+        silenzioso([&] {
+            ContoCorrente nuovo(file + ".vuoto");
+            nuovo.setOrdinatoPerData(true);
+            for (const Transazione& t : dati) {
+                nuovo.aggiungiTransazione(t);
+            }
+        });
+    });
+    conto.importa(dati);
+    conto.setOrdinatoPerData(true);
+
+    misura("salvataggio testo", righe, ripetizioni, [&] { silenzioso([&] { conto.salvaSuFile(); }); });
+    misura("caricamento testo", righe, ripetizioni, [&] { silenzioso([&] { ContoCorrente letto(file); }); });
+    conto.setFormatoFile(FormatoFile::Compresso);
+    misura("salvataggio compresso", righe, ripetizioni, [&] { silenzioso([&] { conto.salvaSuFile(); }); });
+    misura("caricamento compresso", righe, ripetizioni, [&] { silenzioso([&] { ContoCorrente letto(file); }); });
+    OpzioniControlli controlli;
+    controlli.ogniRighe = 65536;
+    conto.setPuntiDiControllo(controlli);
+    silenzioso([&] { conto.salvaSuFile(); });
+    size_t trovateVerifica = 0;
+    misura("verifica punti di controllo", righe, ripetizioni, [&] {
+        trovateVerifica += conto.verificaFile().righeVerificate;
+    });
+
+    size_t trovate = trovateVerifica;
+    misura("ricerca per parola chiave", righe, ripetizioni, [&] {
+        trovate += conto.cercaPerParolaChiave("AFFITTO").size();
+    });
+    misura("ricerca parola assente", righe, ripetizioni, [&] {
+        trovate += conto.cercaPerParolaChiave("parcheggio").size();
+    });
+    misura("filtro intervallo + parola", righe, ripetizioni, [&] {
+        trovate += conto.conta(Filtro().traDate("2022-01-01", "2022-12-31").conParolaChiave("bolletta"));
+    });
+    misura("indice ricerca approssimata", righe, ripetizioni, [&] { conto.setRicercaApprossimata(true); });
+    misura("ricerca approssimata", righe, ripetizioni, [&] {
+        trovate += conto.cercaApprossimata("bolleta eneI").size();
+    });
+    conto.setRicercaApprossimata(false);
+    misura("aggregazione per mese", righe, ripetizioni, [&] { trovate += conto.aggrega(Raggruppamento::Mese).size(); });
+    misura("aggregazione per descrizione", righe, ripetizioni, [&] {
+        trovate += conto.aggrega(Raggruppamento::Descrizione).size();
+    });
+    misura("top 100 uscite", righe, ripetizioni, [&] { trovate += conto.topUscite(100).size(); });
+    misura("mediana esatta", righe, ripetizioni, [&] { trovate += conto.quantileImporti(0.5, Filtro()) > 0; });
+
+    Classificatore regole;
+    regole.aggiungiRegola("Casa", "affitto");
+    regole.aggiungiRegola("Utenze", "bolletta");
+    regole.aggiungiRegola("Svago", "ristorante");
+    regole.aggiungiRegola("Svago", "caffè");
+    regole.aggiungiRegola("Trasporti", "carburante");
+    regole.aggiungiRegola("Salute", "farmacia");
+    regole.aggiungiRegola("Entrate", "stipendio");
+    misura("classificazione in categorie", righe, ripetizioni, [&] { conto.setClassificatore(regole); });
+
+    misura("esportazione CSV", righe, ripetizioni, [&] {
+        ostream out(&nullo);
+        trovate += conto.esporta(out, FormatoEsportazione::Csv);
+    });
+    misura("deduplicazione reimportazione", righe, ripetizioni, [&] {
+        silenzioso([&] {
+            ContoCorrente copia(file);
+            copia.setDeduplicazione(true);
+            trovate += copia.importa(dati).scartate.size();
+        });
+    });
+
+    // Estratto bancario: le stesse righe con qualche differenza tipica
+    vector<Transazione> estratto;
+    estratto.reserve(dati.size());
+    minstd_rand variazioni(7);
+    for (const Transazione& t : dati) {
+        switch (variazioni() % 100) {
+            case 0: break;  // assente dall'estratto
+            case 1: estratto.emplace_back("Addebito " + t.getDescrizione(), t.getImporto(), t.getData()); break;
+            case 2: estratto.emplace_back(t.getDescrizione(), t.getImporto(), giorniInData(dataInGiorni(t.getData()) + 1)); break;
+            case 3: estratto.emplace_back(t.getDescrizione(), t.getImporto() - 1.0, t.getData()); break;
+            default: estratto.push_back(t);
+        }
+    }
+    misura("riconciliazione con estratto", righe, ripetizioni, [&] {
+        trovate += riconcilia(dati, estratto).abbinate.size();
+    });
+
+    remove(file.c_str());
+    remove((file + ".mesi").c_str());
+    remove((file + ".blocchi").c_str());
+    return trovate == 0;
+}
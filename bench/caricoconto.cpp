@@ -0,0 +1,213 @@
+#include "contocorrente.h"
+#include "generatorecarico.h"
+#include "utilita.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using namespace std;
+
+/**
+ * @brief Operazioni della miscela di carico
+ */
+enum Operazione { Inserimento, Ricerca, Saldo, Salvataggio, NUMERO_OPERAZIONI };
+
+static const array<string, NUMERO_OPERAZIONI> NOMI_OPERAZIONI = {"inserimento", "ricerca", "saldo", "salvataggio"};
+
+/**
+ * @brief Stream di output che scarta tutto (per silenziare i messaggi del conto)
+ */
+class StreamNullo : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+/**
+ * @brief Latenze misurate da un thread, in nanosecondi, per tipo di operazione
+ */
+struct LatenzeThread {
+    array<vector<uint64_t>, NUMERO_OPERAZIONI> latenze;
+};
+
+/**
+ * @brief Restituisce il percentile p di latenze già ordinate
+ * @param ordinate Latenze ordinate
+ * @param p Percentile in [0, 1]
+ * @return double Latenza in microsecondi
+ */
+static double percentile(const vector<uint64_t>& ordinate, double p) {
+    if (ordinate.empty()) {
+        return 0.0;
+    }
+    size_t indice = min(ordinate.size() - 1, static_cast<size_t>(p * (ordinate.size() - 1) + 0.5));
+    return ordinate[indice] / 1000.0;
+}
+
+/**
+ * @brief Legge una miscela nel formato "I:R:S:W" (pesi interi)
+ * @param testo Testo da interpretare
+ * @param pesi Pesi letti
+ * @return bool false se il formato non è valido
+ */
+static bool leggiMiscela(const string& testo, array<int, NUMERO_OPERAZIONI>& pesi) {
+    stringstream ss(testo);
+    string campo;
+    int totale = 0;
+    for (int i = 0; i < NUMERO_OPERAZIONI; i++) {
+        if (!getline(ss, campo, ':') || campo.empty()) {
+            return false;
+        }
+        pesi[i] = atoi(campo.c_str());
+        if (pesi[i] < 0) {
+            return false;
+        }
+        totale += pesi[i];
+    }
+    return totale > 0;
+}
+
+/**
+ * @brief Driver di carico: riproduce una miscela di operazioni da più thread
+ *
+ * Il conto è precaricato con righe sintetiche; ogni thread sceglie poi le
+ * operazioni secondo i pesi della miscela. Come nel server, letture sotto
+ * lock condiviso e scritture sotto lock esclusivo: la latenza misurata
+ * include quindi l'attesa del lock, come la vedrebbe un client.
+ */
+int main(int argc, char** argv) {
+    size_t righe = 200000;
+    size_t operazioni = 100000;
+    unsigned numeroThread = max(1u, thread::hardware_concurrency());
+    array<int, NUMERO_OPERAZIONI> pesi = {200, 500, 299, 1};
+    ParametriGeneratore parametri;
+    for (int i = 1; i < argc; i++) {
+        string argomento = argv[i];
+        if (argomento == "--righe" && i + 1 < argc) {
+            righe = strtoull(argv[++i], nullptr, 10);
+        } else if (argomento == "--operazioni" && i + 1 < argc) {
+            operazioni = strtoull(argv[++i], nullptr, 10);
+        } else if (argomento == "--thread" && i + 1 < argc) {
+            numeroThread = max(1, atoi(argv[++i]));
+        } else if (argomento == "--miscela" && i + 1 < argc && leggiMiscela(argv[i + 1], pesi)) {
+            i++;
+        } else if (argomento == "--vocabolario" && i + 1 < argc) {
+            parametri.vocabolario = max<size_t>(1, strtoull(argv[++i], nullptr, 10));
+        } else if (argomento == "--seme" && i + 1 < argc) {
+            parametri.seme = strtoull(argv[++i], nullptr, 10);
+        } else {
+            cerr << "Uso: " << argv[0] << " [--righe N] [--operazioni N] [--thread T]"
+                 << " [--miscela I:R:S:W] [--vocabolario V] [--seme S]" << endl;
+            return 1;
+        }
+    }
+
+    string file = (filesystem::temp_directory_path() / ("carico_conto_" + to_string(getpid()) + ".dat")).string();
+    StreamNullo nullo;
+    streambuf* coutOriginale = cout.rdbuf(&nullo);
+    ContoCorrente conto(file);
+    GeneratoreTransazioni generatore(parametri);
+    conto.importa(generatore.genera(righe));
+    cout.rdbuf(coutOriginale);
+
+    // Le righe da inserire proseguono la sequenza del precaricamento
+    vector<Transazione> nuove = generatore.genera(operazioni);
+    string primaData = parametri.dataIniziale;
+    string ultimaData = generatore.getDataCorrente();
+    int primoGiorno = dataInGiorni(primaData);
+    int giorni = max(1, dataInGiorni(ultimaData) - primoGiorno);
+
+    cout << "Carico su " << righe << " righe iniziali, " << operazioni << " operazioni, " << numeroThread
+         << " thread, miscela " << pesi[0] << ":" << pesi[1] << ":" << pesi[2] << ":" << pesi[3] << endl;
+
+    shared_mutex mutexConto;
+    vector<LatenzeThread> misure(numeroThread);
+    vector<thread> lavoratori;
+    size_t trovate = 0;
+    mutex mutexTrovate;
+    cout.rdbuf(&nullo);
+    auto inizio = chrono::steady_clock::now();
+    for (unsigned t = 0; t < numeroThread; t++) {
+        lavoratori.emplace_back([&, t] {
+            ParametriGeneratore propri = parametri;
+            propri.seme = parametri.seme + 1 + t;
+            GeneratoreTransazioni parole(propri);
+            mt19937_64 casuale(propri.seme);
+            discrete_distribution<int> scelta(pesi.begin(), pesi.end());
+            size_t trovateThread = 0;
+            for (size_t i = t; i < operazioni; i += numeroThread) {
+                int operazione = scelta(casuale);
+                auto partenza = chrono::steady_clock::now();
+                switch (operazione) {
+                    case Inserimento: {
+                        unique_lock<shared_mutex> lock(mutexConto);
+                        conto.aggiungiTransazione(nuove[i]);
+                        break;
+                    }
+                    case Ricerca: {
+                        // Ricerca di un esercente, con la stessa popolarità che ha nei dati
+                        const string& descrizione = parole.descrizioneCasuale();
+                        shared_lock<shared_mutex> lock(mutexConto);
+                        trovateThread += conto.cercaPerParolaChiave(descrizione).size();
+                        break;
+                    }
+                    case Saldo: {
+                        string data = giorniInData(primoGiorno + static_cast<int>(casuale() % giorni));
+                        shared_lock<shared_mutex> lock(mutexConto);
+                        trovateThread += conto.calcolaSaldoAl(data) != 0.0;
+                        break;
+                    }
+                    case Salvataggio: {
+                        unique_lock<shared_mutex> lock(mutexConto);
+                        conto.salvaSuFile();
+                        break;
+                    }
+                }
+                chrono::nanoseconds durata = chrono::steady_clock::now() - partenza;
+                misure[t].latenze[operazione].push_back(durata.count());
+            }
+            lock_guard<mutex> lock(mutexTrovate);
+            trovate += trovateThread;
+        });
+    }
+    for (thread& lavoratore : lavoratori) {
+        lavoratore.join();
+    }
+    chrono::duration<double> totale = chrono::steady_clock::now() - inizio;
+    cout.rdbuf(coutOriginale);
+
+    cout << fixed << "Durata " << setprecision(3) << totale.count() << " s, throughput "
+         << setprecision(0) << operazioni / totale.count() << " op/s" << endl;
+    cout << left << setw(14) << "operazione" << right << setw(10) << "conteggio" << setw(12) << "op/s"
+         << setw(12) << "p50 us" << setw(12) << "p90 us" << setw(12) << "p99 us" << setw(12) << "p99.9 us"
+         << setw(12) << "max us" << endl;
+    for (int operazione = 0; operazione < NUMERO_OPERAZIONI; operazione++) {
+        vector<uint64_t> tutte;
+        for (const LatenzeThread& m : misure) {
+            tutte.insert(tutte.end(), m.latenze[operazione].begin(), m.latenze[operazione].end());
+        }
+        sort(tutte.begin(), tutte.end());
+        cout << left << setw(14) << NOMI_OPERAZIONI[operazione] << right << setw(10) << tutte.size() << setw(12)
+             << setprecision(0) << tutte.size() / totale.count() << setprecision(1) << setw(12)
+             << percentile(tutte, 0.5) << setw(12) << percentile(tutte, 0.9) << setw(12) << percentile(tutte, 0.99)
+             << setw(12) << percentile(tutte, 0.999) << setw(12) << percentile(tutte, 1.0) << endl;
+    }
+
+    remove(file.c_str());
+    remove((file + ".mesi").c_str());
+    remove((file + ".blocchi").c_str());
+    return trovate == 0;
+}
@@ -0,0 +1,160 @@
+#include "aggregazione.h"
+#include "parallelo.h"
+#include "utilita.h"
+#include <unordered_map>
+#include <algorithm>
+
+using namespace std;
+
+static const size_t MINIMO_PER_BLOCCO = 1 << 16;
+
+/**
+ * @brief Aggregati di un blocco: tabella hash chiave -> posizione nel vettore
+ */
+struct TabellaAggregati {
+    unordered_map<string, size_t> posizioni;
+    vector<Aggregato> gruppi;
+
+    /**
+     * @brief Restituisce l'aggregato della chiave, creandolo se assente
+     */
+    Aggregato& gruppo(const string& chiave) {
+        auto trovata = posizioni.find(chiave);
+        if (trovata != posizioni.end()) {
+            return gruppi[trovata->second];
+        }
+        posizioni.emplace(chiave, gruppi.size());
+        gruppi.push_back(Aggregato{chiave, 0.0, 0, 0.0, 0.0});
+        return gruppi.back();
+    }
+};
+
+/**
+ * @brief Scrive nel buffer la chiave di raggruppamento di una transazione
+ * @param t Transazione
+ * @param criterio Criterio di raggruppamento
+ * @param chiave Buffer riutilizzato fra le righe per evitare allocazioni
+ */
+static void estraiChiave(const Transazione& t, Raggruppamento criterio, string& chiave) {
+    switch (criterio) {
+        case Raggruppamento::Giorno:
+            chiave.assign(t.getData(), 0, 10);
+            break;
+        case Raggruppamento::Mese:
+            chiave.assign(t.getData(), 0, 7);
+            break;
+        case Raggruppamento::Anno:
+            chiave.assign(t.getData(), 0, 4);
+            break;
+        case Raggruppamento::Descrizione:
+            normalizzaDescrizione(t.getDescrizione(), chiave);
+            break;
+    }
+}
+
+/**
+ * @brief Aggrega le transazioni in blocchi paralleli e fonde i parziali
+ * @param righe Prima transazione
+ * @param n Numero di transazioni
+ * @param criterio Criterio di raggruppamento
+ * @param lapideVisibile Indica se una riga eliminata va contata (nulla = mai)
+ * @return vector<Aggregato> Aggregati ordinati per chiave
+ */
+vector<Aggregato> aggregaTransazioni(const Transazione* righe, size_t n, Raggruppamento criterio,
+                                     const function<bool(size_t)>& lapideVisibile) {
+    size_t blocchi = numeroBlocchiParalleli(n, MINIMO_PER_BLOCCO);
+    vector<TabellaAggregati> parziali(blocchi);
+
+    eseguiInParallelo(blocchi, [&](size_t b) {
+        TabellaAggregati& tabella = parziali[b];
+        string chiave;
+        size_t fine = inizioBlocco(n, blocchi, b + 1);
+        for (size_t i = inizioBlocco(n, blocchi, b); i < fine; i++) {
+            if (righe[i].isEliminata() && !(lapideVisibile && lapideVisibile(i))) {
+                continue;
+            }
+            estraiChiave(righe[i], criterio, chiave);
+            Aggregato& g = tabella.gruppo(chiave);
+            double importo = righe[i].getImporto();
+            g.somma += importo;
+            g.conteggio++;
+            if (importo > 0) {
+                g.entrate += importo;
+            } else {
+                g.uscite += importo;
+            }
+        }
+    });
+
+    TabellaAggregati& totale = parziali[0];
+    for (size_t b = 1; b < blocchi; b++) {
+        for (const Aggregato& parziale : parziali[b].gruppi) {
+            Aggregato& g = totale.gruppo(parziale.chiave);
+            g.somma += parziale.somma;
+            g.conteggio += parziale.conteggio;
+            g.entrate += parziale.entrate;
+            g.uscite += parziale.uscite;
+        }
+    }
+
+    vector<Aggregato> risultato = move(totale.gruppi);
+    sort(risultato.begin(), risultato.end(),
+         [](const Aggregato& a, const Aggregato& b) { return a.chiave < b.chiave; });
+    return risultato;
+}
+
+/**
+ * @brief Aggrega per categoria con parziali densi per blocco
+ * @param righe Prima transazione
+ * @param n Numero di transazioni
+ * @param categorie Nomi delle categorie
+ * @param lapideVisibile Indica se una riga eliminata va contata (nulla = mai)
+ * @return vector<Aggregato> Aggregati non vuoti ordinati per nome
+ *
+ * Il gruppo 0 raccoglie le righe senza categoria (o con un indice fuori
+ * dall'elenco), il gruppo c + 1 la categoria c.
+ */
+vector<Aggregato> aggregaPerCategoria(const Transazione* righe, size_t n, const vector<string>& categorie,
+                                      const function<bool(size_t)>& lapideVisibile) {
+    size_t gruppi = categorie.size() + 1;
+    size_t blocchi = numeroBlocchiParalleli(n, MINIMO_PER_BLOCCO);
+    vector<vector<Aggregato>> parziali(blocchi, vector<Aggregato>(gruppi, Aggregato{"", 0.0, 0, 0.0, 0.0}));
+
+    eseguiInParallelo(blocchi, [&](size_t b) {
+        vector<Aggregato>& tabella = parziali[b];
+        size_t fine = inizioBlocco(n, blocchi, b + 1);
+        for (size_t i = inizioBlocco(n, blocchi, b); i < fine; i++) {
+            if (righe[i].isEliminata() && !(lapideVisibile && lapideVisibile(i))) {
+                continue;
+            }
+            int categoria = righe[i].getCategoria();
+            size_t gruppo = (categoria >= 0 && static_cast<size_t>(categoria) < categorie.size()) ? categoria + 1 : 0;
+            Aggregato& g = tabella[gruppo];
+            double importo = righe[i].getImporto();
+            g.somma += importo;
+            g.conteggio++;
+            if (importo > 0) {
+                g.entrate += importo;
+            } else {
+                g.uscite += importo;
+            }
+        }
+    });
+
+    vector<Aggregato> risultato;
+    for (size_t g = 0; g < gruppi; g++) {
+        Aggregato totale{g == 0 ? "" : categorie[g - 1], 0.0, 0, 0.0, 0.0};
+        for (size_t b = 0; b < blocchi; b++) {
+            totale.somma += parziali[b][g].somma;
+            totale.conteggio += parziali[b][g].conteggio;
+            totale.entrate += parziali[b][g].entrate;
+            totale.uscite += parziali[b][g].uscite;
+        }
+        if (totale.conteggio > 0) {
+            risultato.push_back(totale);
+        }
+    }
+    sort(risultato.begin(), risultato.end(),
+         [](const Aggregato& a, const Aggregato& b) { return a.chiave < b.chiave; });
+    return risultato;
+}
@@ -0,0 +1,64 @@
+#ifndef AGGREGAZIONE_H
+#define AGGREGAZIONE_H
+
+#include "transazione.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+using namespace std;
+
+/**
+ * @brief Criterio di raggruppamento delle transazioni
+ */
+enum class Raggruppamento {
+    Giorno,       /**< Chiave YYYY-MM-DD */
+    Mese,         /**< Chiave YYYY-MM */
+    Anno,         /**< Chiave YYYY */
+    Descrizione   /**< Chiave: descrizione normalizzata (vedi normalizzaDescrizione) */
+};
+
+/**
+ * @brief Totali di un gruppo di transazioni
+ */
+struct Aggregato {
+    string chiave;      /**< Chiave del gruppo */
+    double somma;       /**< Somma algebrica degli importi */
+    int conteggio;      /**< Numero di transazioni del gruppo */
+    double entrate;     /**< Somma degli importi positivi */
+    double uscite;      /**< Somma degli importi negativi o nulli */
+};
+
+/**
+ * @brief Raggruppa un intervallo di transazioni e ne calcola i totali per gruppo
+ * @param righe Puntatore alla prima transazione
+ * @param n Numero di transazioni
+ * @param criterio Criterio di raggruppamento
+ * @param lapideVisibile Chiamata con la posizione di ogni riga eliminata: true se
+ *        va ancora contata (nulla = le righe eliminate sono ignorate)
+ * @return vector<Aggregato> Un aggregato per gruppo, ordinati per chiave
+ *
+ * Ogni thread aggrega un blocco contiguo in una propria tabella hash
+ * (aggregati parziali), poi le tabelle vengono fuse. Sotto una certa
+ * dimensione il lavoro è svolto dal solo thread chiamante.
+ */
+vector<Aggregato> aggregaTransazioni(const Transazione* righe, size_t n, Raggruppamento criterio,
+                                     const function<bool(size_t)>& lapideVisibile = nullptr);
+
+/**
+ * @brief Calcola i totali per categoria (vedi Transazione::getCategoria)
+ * @param righe Puntatore alla prima transazione
+ * @param n Numero di transazioni
+ * @param categorie Nomi delle categorie, indicizzati come le categorie delle righe
+ * @param lapideVisibile Come in aggregaTransazioni
+ * @return vector<Aggregato> Un aggregato per ogni categoria presente, ordinati per nome
+ *
+ * Le righe senza categoria finiscono nel gruppo con chiave vuota. Poiché le
+ * categorie sono indici, i parziali sono vettori densi invece di tabelle hash.
+ */
+vector<Aggregato> aggregaPerCategoria(const Transazione* righe, size_t n, const vector<string>& categorie,
+                                      const function<bool(size_t)>& lapideVisibile = nullptr);
+
+#endif // AGGREGAZIONE_H
@@ -0,0 +1,14 @@
+#include "asincrono.h"
+
+using namespace std;
+
+static const size_t THREAD_IO = 4;  /**< Operazioni di I/O contemporanee */
+
+/**
+ * @brief Restituisce il pool di I/O condiviso
+ * @return PoolThread& Pool inizializzato al primo utilizzo
+ */
+PoolThread& poolIO() {
+    static PoolThread pool(THREAD_IO);
+    return pool;
+}
@@ -0,0 +1,261 @@
+#ifndef ASINCRONO_H
+#define ASINCRONO_H
+
+#include "poolthread.h"
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Pool di thread condiviso per le operazioni di I/O asincrone
+ * @return PoolThread& Pool creato al primo utilizzo
+ *
+ * Le operazioni bloccanti (lettura e scrittura dei file) vengono eseguite
+ * qui, così il thread che le avvia resta libero.
+ */
+PoolThread& poolIO();
+
+/**
+ * @brief Punto di attesa sincrona per uno o più compiti
+ */
+struct SegnaleCompletamento {
+    mutex m;                  /**< Protegge rimanenti */
+    condition_variable cv;    /**< Segnala l'ultimo completamento */
+    size_t rimanenti;         /**< Compiti non ancora terminati */
+};
+
+template <typename T> class Compito;
+
+/**
+ * @brief Parte comune delle promesse dei compiti
+ *
+ * Il compito parte sospeso; al termine riprende la coroutine che lo attende
+ * (trasferimento simmetrico) oppure segnala chi lo attende in modo sincrono.
+ */
+struct PromessaBase {
+    coroutine_handle<> continuazione;       /**< Coroutine da riprendere al termine */
+    SegnaleCompletamento* segnale = nullptr; /**< Attesa sincrona (attendi) */
+    exception_ptr eccezione;                 /**< Eccezione uscita dal corpo */
+
+    /**
+     * @brief Awaiter della sospensione finale
+     */
+    struct AttesaFinale {
+        bool await_ready() noexcept { return false; }
+
+        template <typename P>
+        coroutine_handle<> await_suspend(coroutine_handle<P> h) noexcept {
+            PromessaBase& promessa = h.promise();
+            if (promessa.continuazione) {
+                return promessa.continuazione;
+            }
+            // Dopo la notifica il frame può essere distrutto da chi attende:
+            // da qui in poi si usa solo il segnale, che appartiene a chi attende
+            SegnaleCompletamento* segnale = promessa.segnale;
+            if (segnale) {
+                lock_guard<mutex> lock(segnale->m);
+                if (--segnale->rimanenti == 0) {
+                    segnale->cv.notify_all();
+                }
+            }
+            return noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    suspend_always initial_suspend() noexcept { return {}; }
+    AttesaFinale final_suspend() noexcept { return {}; }
+    void unhandled_exception() { eccezione = current_exception(); }
+};
+
+/**
+ * @brief Promessa di un compito con valore di ritorno
+ */
+template <typename T>
+struct PromessaCompito : PromessaBase {
+    optional<T> valore;   /**< Valore restituito con co_return */
+
+    Compito<T> get_return_object();
+    void return_value(T v) { valore = move(v); }
+};
+
+/**
+ * @brief Promessa di un compito senza valore di ritorno
+ */
+template <>
+struct PromessaCompito<void> : PromessaBase {
+    Compito<void> get_return_object();
+    void return_void() {}
+};
+
+/**
+ * @brief Coroutine C++20 che produce un valore di tipo T
+ *
+ * Il compito parte solo quando viene atteso: con co_await da un'altra
+ * coroutine, oppure in modo sincrono con attendi() o attendiTutti().
+ * Le eccezioni lanciate nel corpo vengono rilanciate a chi attende.
+ */
+template <typename T>
+class Compito {
+public:
+    using promise_type = PromessaCompito<T>;
+
+    /**
+     * @brief Costruttore usato dalla promessa
+     * @param h Handle della coroutine
+     */
+    explicit Compito(coroutine_handle<promise_type> h) : handle(h) {}
+
+    /**
+     * @brief Costruttore di spostamento
+     * @param altro Compito da cui prendere la coroutine
+     */
+    Compito(Compito&& altro) noexcept : handle(exchange(altro.handle, {})) {}
+
+    Compito(const Compito&) = delete;
+    Compito& operator=(const Compito&) = delete;
+
+    /**
+     * @brief Distruttore: distrugge la coroutine (che deve essere terminata o mai avviata)
+     */
+    ~Compito() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    coroutine_handle<> await_suspend(coroutine_handle<> chiamante) noexcept {
+        handle.promise().continuazione = chiamante;
+        return handle;
+    }
+
+    T await_resume() { return risultato(); }
+
+    /**
+     * @brief Avvia il compito e blocca il thread chiamante fino al termine
+     * @return T Valore prodotto dal compito
+     *
+     * Non va chiamato da un thread di poolIO(), che potrebbe servire
+     * proprio a completare il compito.
+     */
+    T attendi() {
+        SegnaleCompletamento segnale;
+        segnale.rimanenti = 1;
+        avvia(segnale);
+        unique_lock<mutex> lock(segnale.m);
+        segnale.cv.wait(lock, [&segnale] { return segnale.rimanenti == 0; });
+        lock.unlock();
+        return risultato();
+    }
+
+    /**
+     * @brief Avvia il compito segnalandone il termine (usato da attendiTutti)
+     * @param segnale Segnale da decrementare al termine
+     */
+    void avvia(SegnaleCompletamento& segnale) {
+        handle.promise().segnale = &segnale;
+        handle.resume();
+    }
+
+    /**
+     * @brief Restituisce il risultato di un compito terminato
+     * @return T Valore prodotto
+     */
+    T risultato() {
+        promise_type& promessa = handle.promise();
+        if (promessa.eccezione) {
+            rethrow_exception(promessa.eccezione);
+        }
+        if constexpr (!is_void_v<T>) {
+            return move(*promessa.valore);
+        }
+    }
+
+private:
+    coroutine_handle<promise_type> handle;   /**< Coroutine del compito */
+};
+
+template <typename T>
+Compito<T> PromessaCompito<T>::get_return_object() {
+    return Compito<T>(coroutine_handle<PromessaCompito<T>>::from_promise(*this));
+}
+
+inline Compito<void> PromessaCompito<void>::get_return_object() {
+    return Compito<void>(coroutine_handle<PromessaCompito<void>>::from_promise(*this));
+}
+
+/**
+ * @brief Avvia insieme più compiti e attende che terminino tutti
+ * @param compiti Compiti da eseguire
+ *
+ * Tutti i compiti vengono avviati prima di attendere, quindi le loro
+ * operazioni di I/O procedono in parallelo. I risultati (o le eccezioni)
+ * si leggono poi con risultato().
+ */
+template <typename T>
+void attendiTutti(vector<Compito<T>>& compiti) {
+    SegnaleCompletamento segnale;
+    segnale.rimanenti = compiti.size();
+    for (Compito<T>& compito : compiti) {
+        compito.avvia(segnale);
+    }
+    unique_lock<mutex> lock(segnale.m);
+    segnale.cv.wait(lock, [&segnale] { return segnale.rimanenti == 0; });
+}
+
+/**
+ * @brief Awaiter che esegue un lavoro bloccante su poolIO()
+ *
+ * La coroutine viene sospesa, il lavoro eseguito su un thread del pool e
+ * la coroutine ripresa su quello stesso thread.
+ */
+template <typename F>
+class AttesaPoolIO {
+private:
+    F lavoro;                 /**< Lavoro bloccante da eseguire */
+    exception_ptr eccezione;  /**< Eccezione lanciata dal lavoro */
+
+public:
+    explicit AttesaPoolIO(F f) : lavoro(move(f)) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(coroutine_handle<> h) {
+        poolIO().accoda([this, h] {
+            try {
+                lavoro();
+            } catch (...) {
+                eccezione = current_exception();
+            }
+            h.resume();
+        });
+    }
+
+    void await_resume() {
+        if (eccezione) {
+            rethrow_exception(eccezione);
+        }
+    }
+};
+
+/**
+ * @brief Crea un awaiter che esegue un lavoro bloccante su poolIO()
+ * @param lavoro Funzione da eseguire
+ * @return AttesaPoolIO<F> Awaiter da usare con co_await
+ */
+template <typename F>
+AttesaPoolIO<F> suPoolIO(F lavoro) {
+    return AttesaPoolIO<F>(move(lavoro));
+}
+
+#endif // ASINCRONO_H
@@ -0,0 +1,180 @@
+#include "classificatore.h"
+#include "transazione.h"
+#include "utilita.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * @brief Costruttore
+ */
+Classificatore::Classificatore() : numeroClassi(1), compilato(false) {
+    fill(classi, classi + 256, 0);
+}
+
+/**
+ * @brief Aggiunge una regola convertendo la parola chiave in minuscolo
+ * @param categoria Nome della categoria
+ * @param parola Parola chiave
+ * @return int Indice della categoria
+ */
+int Classificatore::aggiungiRegola(const string& categoria, const string& parola) {
+    if (parola.empty()) {
+        throw invalid_argument("Parola chiave vuota per la categoria " + categoria);
+    }
+    int indice = cercaCategoria(categoria);
+    if (indice == NESSUNA_CATEGORIA) {
+        if (categorie.size() > static_cast<size_t>(Transazione::MASSIMA_CATEGORIA)) {
+            throw invalid_argument("Troppe categorie: al massimo " + to_string(Transazione::MASSIMA_CATEGORIA + 1));
+        }
+        indice = static_cast<int>(categorie.size());
+        categorie.push_back(categoria);
+    }
+
+    string piegata(parola.size(), '\0');
+    unsigned char precedente = 0;
+    for (size_t i = 0; i < parola.size(); i++) {
+        unsigned char c = static_cast<unsigned char>(parola[i]);
+        piegata[i] = static_cast<char>(piegaByte(precedente, c));
+        precedente = c;
+    }
+    regole.push_back(Regola{piegata, indice});
+    compilato = false;
+    return indice;
+}
+
+/**
+ * @brief Costruisce il trie delle parole chiave e lo completa in automa
+ *
+ * Dopo la costruzione del trie una visita in ampiezza calcola i collegamenti
+ * di fallimento e sostituisce ogni transizione mancante con quella dello
+ * stato di fallimento: ogni byte del testo costa un solo accesso alla tabella.
+ * In ogni stato viene memorizzata la regola di priorità massima tra quelle
+ * che terminano lì o negli stati raggiungibili seguendo i fallimenti.
+ */
+void Classificatore::compila() {
+    fill(classi, classi + 256, 0);
+    numeroClassi = 1;
+    for (const Regola& regola : regole) {
+        for (char c : regola.parola) {
+            unsigned char byte = static_cast<unsigned char>(c);
+            if (classi[byte] == 0) {
+                classi[byte] = static_cast<uint16_t>(numeroClassi++);
+            }
+        }
+    }
+
+    transizioni.assign(numeroClassi, -1);
+    migliore.assign(1, -1);
+    for (size_t r = 0; r < regole.size(); r++) {
+        int32_t stato = 0;
+        for (char c : regole[r].parola) {
+            size_t cella = stato * numeroClassi + classi[static_cast<unsigned char>(c)];
+            if (transizioni[cella] == -1) {
+                transizioni[cella] = static_cast<int32_t>(migliore.size());
+                transizioni.resize(transizioni.size() + numeroClassi, -1);
+                migliore.push_back(-1);
+            }
+            stato = transizioni[cella];
+        }
+        if (migliore[stato] == -1) {
+            migliore[stato] = static_cast<int32_t>(r);
+        }
+    }
+
+    vector<int32_t> fallimento(migliore.size(), 0);
+    vector<int32_t> coda;
+    coda.reserve(migliore.size());
+    for (size_t c = 0; c < numeroClassi; c++) {
+        if (transizioni[c] == -1) {
+            transizioni[c] = 0;
+        } else {
+            coda.push_back(transizioni[c]);
+        }
+    }
+    for (size_t i = 0; i < coda.size(); i++) {
+        int32_t stato = coda[i];
+        int32_t ereditata = migliore[fallimento[stato]];
+        if (ereditata != -1 && (migliore[stato] == -1 || ereditata < migliore[stato])) {
+            migliore[stato] = ereditata;
+        }
+        for (size_t c = 0; c < numeroClassi; c++) {
+            size_t cella = stato * numeroClassi + c;
+            int32_t successivo = transizioni[fallimento[stato] * numeroClassi + c];
+            if (transizioni[cella] == -1) {
+                transizioni[cella] = successivo;
+            } else {
+                fallimento[transizioni[cella]] = successivo;
+                coda.push_back(transizioni[cella]);
+            }
+        }
+    }
+    compilato = true;
+}
+
+/**
+ * @brief Percorre l'automa sui byte della descrizione piegati in minuscolo
+ * @param descrizione Descrizione da classificare
+ * @return int Categoria della regola di priorità massima trovata
+ */
+int Classificatore::classifica(const string& descrizione) const {
+    if (!compilato) {
+        throw logic_error("Classificatore non compilato");
+    }
+    int32_t stato = 0;
+    int32_t trovata = -1;
+    unsigned char precedente = 0;
+    for (char c : descrizione) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        stato = transizioni[stato * numeroClassi + classi[piegaByte(precedente, byte)]];
+        precedente = byte;
+        int32_t regola = migliore[stato];
+        if (regola != -1 && (trovata == -1 || regola < trovata)) {
+            trovata = regola;
+            if (trovata == 0) {
+                break;
+            }
+        }
+    }
+    return trovata == -1 ? NESSUNA_CATEGORIA : regole[trovata].categoria;
+}
+
+/**
+ * @brief Cerca una categoria per nome
+ * @param nome Nome della categoria
+ * @return int Indice o NESSUNA_CATEGORIA
+ */
+int Classificatore::cercaCategoria(const string& nome) const {
+    auto trovata = find(categorie.begin(), categorie.end(), nome);
+    return trovata == categorie.end() ? NESSUNA_CATEGORIA : static_cast<int>(trovata - categorie.begin());
+}
+
+/**
+ * @brief Getter per il nome di una categoria
+ * @param categoria Indice della categoria
+ * @return const string& Nome della categoria
+ */
+const string& Classificatore::getNomeCategoria(int categoria) const {
+    static const string nessuna;
+    if (categoria < 0 || categoria >= static_cast<int>(categorie.size())) {
+        return nessuna;
+    }
+    return categorie[categoria];
+}
+
+/**
+ * @brief Getter per i nomi delle categorie
+ * @return const vector<string>& Nomi delle categorie
+ */
+const vector<string>& Classificatore::getCategorie() const {
+    return categorie;
+}
+
+/**
+ * @brief Indica se l'automa è aggiornato
+ * @return bool true se compilato
+ */
+bool Classificatore::isCompilato() const {
+    return compilato;
+}
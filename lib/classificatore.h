@@ -0,0 +1,103 @@
+#ifndef CLASSIFICATORE_H
+#define CLASSIFICATORE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Classificatore delle descrizioni in categorie tramite parole chiave
+ *
+ * Ogni regola associa una parola chiave a una categoria (ad esempio
+ * "affitto" -> "Casa"). Dopo compila() tutte le parole chiave sono riunite
+ * in un unico automa di Aho-Corasick: una descrizione viene classificata in
+ * un solo passaggio sui suoi byte, indipendentemente dal numero di regole.
+ *
+ * Il confronto non distingue maiuscole e minuscole (incluse le lettere
+ * accentate, come contieneParolaChiave). Se più regole corrispondono vince
+ * quella aggiunta per prima.
+ */
+class Classificatore {
+private:
+    /**
+     * @brief Regola: parola chiave già convertita in minuscolo e categoria
+     */
+    struct Regola {
+        string parola;    /**< Parola chiave piegata in minuscolo */
+        int categoria;    /**< Indice della categoria */
+    };
+
+    vector<string> categorie;      /**< Nomi delle categorie */
+    vector<Regola> regole;         /**< Regole in ordine di priorità */
+    uint16_t classi[256];          /**< Classe di ogni byte (0 = byte assente dalle parole chiave) */
+    size_t numeroClassi;           /**< Numero di classi di byte */
+    vector<int32_t> transizioni;   /**< Automa deterministico: stato * numeroClassi + classe -> stato */
+    vector<int32_t> migliore;      /**< Regola di priorità massima riconosciuta in ogni stato (-1 se nessuna) */
+    bool compilato;                /**< true se l'automa riflette tutte le regole */
+
+public:
+    static constexpr int NESSUNA_CATEGORIA = -1;  /**< Categoria delle descrizioni senza corrispondenze */
+
+    /**
+     * @brief Crea un classificatore senza regole
+     */
+    Classificatore();
+
+    /**
+     * @brief Aggiunge una regola
+     * @param categoria Nome della categoria (creata se non esiste)
+     * @param parola Parola chiave da cercare nella descrizione
+     * @return int Indice della categoria
+     * @throws std::invalid_argument Se la parola chiave è vuota o le categorie
+     *         superano Transazione::MASSIMA_CATEGORIA + 1
+     *
+     * L'automa va ricompilato con compila() prima della classificazione.
+     */
+    int aggiungiRegola(const string& categoria, const string& parola);
+
+    /**
+     * @brief Costruisce l'automa di tutte le regole
+     *
+     * La tabella delle transizioni usa solo le classi dei byte presenti nelle
+     * parole chiave, quindi resta piccola anche con molte regole.
+     */
+    void compila();
+
+    /**
+     * @brief Classifica una descrizione
+     * @param descrizione Descrizione da classificare
+     * @return int Indice della categoria o NESSUNA_CATEGORIA
+     * @throws std::logic_error Se le regole sono cambiate dopo l'ultima compila()
+     */
+    int classifica(const string& descrizione) const;
+
+    /**
+     * @brief Cerca una categoria per nome
+     * @param nome Nome della categoria
+     * @return int Indice della categoria o NESSUNA_CATEGORIA se non esiste
+     */
+    int cercaCategoria(const string& nome) const;
+
+    /**
+     * @brief Restituisce il nome di una categoria
+     * @param categoria Indice della categoria
+     * @return const string& Nome (stringa vuota per NESSUNA_CATEGORIA)
+     */
+    const string& getNomeCategoria(int categoria) const;
+
+    /**
+     * @brief Restituisce i nomi di tutte le categorie
+     * @return const vector<string>& Nomi in ordine di indice
+     */
+    const vector<string>& getCategorie() const;
+
+    /**
+     * @brief Indica se l'automa è aggiornato
+     * @return bool true se compila() è stata chiamata dopo l'ultima regola
+     */
+    bool isCompilato() const;
+};
+
+#endif // CLASSIFICATORE_H
@@ -1,8 +1,16 @@
 #include "contocorrente.h"
+#include "formatocompresso.h"
+#include "utilita.h"
+#include "parallelo.h"
+#include "tracciato.h"
 #include <iostream>
 #include <fstream>
 #include <iomanip>
 #include <filesystem>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
 
 using namespace std;
 
@@ -12,108 +20,1351 @@ using namespace std;
  * 
  * Imposta il nome del file e carica automaticamente le transazioni esistenti
  */
-ContoCorrente::ContoCorrente(const string& file) : nomeFile(file) {
+ContoCorrente::ContoCorrente(const string& file) : nomeFile(file), formato(FormatoFile::Testo),
+      ordinatoPerData(false), righeOrdinate(0), sketchDaRicostruire(false),
+      mutexSketch(make_unique<mutex>()), deduplicazione(false), versione(0),
+      tokenIstantanee(make_shared<int>(0)), prossimoId(1), righeEliminate(0), versioneUltimaEliminazione(0) {
     caricaDaFile();  // Carica le transazioni all'avvio
 }
 
 /**
  * @brief Aggiunge una transazione esistente al conto
  * @param t Transazione da aggiungere
+ * @return bool true se la transazione è stata aggiunta
  * 
- * Aggiunge la transazione al vettore delle transazioni
+ * Aggiunge la transazione al vettore delle transazioni, salvo che
+ * la deduplicazione sia attiva e la transazione sia già presente
  */
-void ContoCorrente::aggiungiTransazione(const Transazione& t) {
+bool ContoCorrente::aggiungiTransazione(const Transazione& t) {
+    if (deduplicazione) {
+        uint64_t impronta = improntaTransazione(t);
+        if (impronte.conta(impronta) > 0) {
+            return false;
+        }
+        impronte.incrementa(impronta);
+    }
+    accoda(t);
+    return true;
+}
+
+/**
+ * @brief Aggiunge una nuova transazione con i parametri specificati
+ * @param desc Descrizione della transazione
+ * @param importo Importo della transazione
+ * @param data Data della transazione
+ * @return bool true se la transazione è stata aggiunta
+ * 
+ * Crea una nuova transazione e la aggiunge al vettore
+ */
+bool ContoCorrente::aggiungiTransazione(const string& desc, double importo, const string& data) {
+    Transazione t(desc, importo, data);
+    return aggiungiTransazione(t);
+}
+
+/**
+ * @brief Cerca la riga valida con l'identificativo indicato
+ * @param id Identificativo
+ * @return size_t Posizione della riga o transazioni.size()
+ */
+size_t ContoCorrente::posizioneDi(uint64_t id) const {
+    if (id >= posizioniPerId.size() || posizioniPerId[id] == NESSUNA) {
+        return transazioni.size();
+    }
+    return posizioniPerId[id];
+}
+
+/**
+ * @brief Aggiorna l'indice degli identificativi
+ * @param da Prima riga da indicizzare
+ */
+void ContoCorrente::indicizzaId(size_t da) {
+    if (posizioniPerId.size() < prossimoId) {
+        posizioniPerId.resize(prossimoId, NESSUNA);
+    }
+    for (size_t i = da; i < transazioni.size(); i++) {
+        if (!transazioni[i].isEliminata()) {
+            posizioniPerId[transazioni[i].getId()] = i;
+        }
+    }
+}
+
+/**
+ * @brief Assegna gli identificativi alle righe caricate
+ * @param da Prima riga caricata
+ * 
+ * Gli identificativi del file sono scartati (e riassegnati a tutte le righe)
+ * se sono ripetuti o se il massimo supera di molto il numero di righe:
+ * l'indice diretto occuperebbe troppa memoria.
+ */
+void ContoCorrente::assegnaIdCaricati(size_t da) {
+    bool validi = da == 0;
+    uint64_t massimo = 0;
+    for (size_t i = da; i < transazioni.size() && validi; i++) {
+        massimo = max(massimo, transazioni[i].getId());
+    }
+    if (validi && massimo > 16 * transazioni.size() + 65536) {
+        cout << "Identificativi nel file troppo sparsi: vengono riassegnati." << endl;
+        validi = false;
+    }
+    if (validi && massimo > 0) {
+        vector<bool> usati(massimo + 1, false);
+        for (const Transazione& t : transazioni) {
+            if (t.getId() != 0 && usati[t.getId()]) {
+                cout << "Identificativi nel file ripetuti: vengono riassegnati." << endl;
+                validi = false;
+                break;
+            }
+            usati[t.getId()] = true;
+        }
+    }
+    if (validi) {
+        prossimoId = max(prossimoId, massimo + 1);
+    }
+    for (size_t i = da; i < transazioni.size(); i++) {
+        if (!validi || transazioni[i].getId() == 0) {
+            transazioni[i].setId(prossimoId++);
+        }
+    }
+}
+
+/**
+ * @brief Trasforma una riga in lapide
+ * @param posizione Posizione della riga
+ * @param sostituita true se la riga viene sostituita da una nuova versione
+ * 
+ * La lapide registra la nuova versione del conto: le istantanee precedenti
+ * continuano a vedere la riga. Riepiloghi e impronte vengono decrementati e
+ * lo sketch degli importi viene segnato da ricostruire; in modalità
+ * ordinata i saldi cumulati sono ricalcolati dalla riga in poi. Una riga
+ * sostituita non pubblica l'eliminazione nel flusso: lo fa la nuova versione.
+ */
+void ContoCorrente::lapida(size_t posizione, bool sostituita) {
+    Transazione& t = transazioni[posizione];
+    versione++;
+    t.setEliminata(true);
+    // La versione serve solo alle istantanee esistenti: quelle create dopo
+    // hanno una versione successiva e non vedono comunque la riga
+    if (istantaneeAttive()) {
+        versioniEliminazione[posizione] = versione;
+    } else {
+        versioniEliminazione.clear();
+    }
+    versioneUltimaEliminazione = versione;
+    righeEliminate++;
+    posizioniPerId[t.getId()] = NESSUNA;
+    sketchDaRicostruire = true;
+    if (flusso && !sostituita) {
+        flusso->pubblica(t, OperazioneFlusso::Eliminazione);
+    }
+    if (condiviso) {
+        condiviso->elimina(t.getId());
+    }
+    registraNelMese(t, -1);
+    if (deduplicazione) {
+        impronte.decrementa(improntaTransazione(t));
+    }
+    if (ordinatoPerData && posizione < righeOrdinate) {
+        ricalcolaSaldiCumulati(posizione);
+    }
+}
+
+/**
+ * @brief Visibilità di una riga a una versione
+ * @param posizione Posizione della riga
+ * @param versione Versione dell'istantanea
+ * @return bool true se la riga non era ancora eliminata a quella versione
+ * 
+ * Una lapide senza versione registrata è stata creata senza istantanee
+ * attive, quindi precede ogni istantanea esistente.
+ */
+bool ContoCorrente::isVisibile(size_t posizione, uint64_t versione) const {
+    if (!transazioni[posizione].isEliminata()) {
+        return true;
+    }
+    auto trovata = versioniEliminazione.find(posizione);
+    return trovata != versioniEliminazione.end() && trovata->second > versione;
+}
+
+/**
+ * @brief Sostituisce una transazione con una nuova versione
+ * @param id Identificativo della transazione
+ * @param nuova Nuovo contenuto
+ * @return bool true se la transazione è stata modificata
+ * 
+ * Con la deduplicazione attiva la nuova versione viene registrata tra le
+ * impronte ma non rifiutata: la modifica è una correzione esplicita.
+ */
+bool ContoCorrente::modificaTransazione(uint64_t id, const Transazione& nuova) {
+    size_t posizione = posizioneDi(id);
+    if (posizione == transazioni.size()) {
+        return false;
+    }
+    lapida(posizione, true);
+    if (deduplicazione) {
+        impronte.incrementa(improntaTransazione(nuova));
+    }
+    accoda(nuova, id);
+    if (righeEliminate >= SOGLIA_LAPIDI && righeEliminate * 4 >= transazioni.size()) {
+        rimuoviEliminate();
+    }
+    return true;
+}
+
+/**
+ * @brief Sostituisce una transazione con i parametri specificati
+ * @param id Identificativo della transazione
+ * @param desc Nuova descrizione
+ * @param importo Nuovo importo
+ * @param data Nuova data
+ * @return bool true se la transazione è stata modificata
+ */
+bool ContoCorrente::modificaTransazione(uint64_t id, const string& desc, double importo, const string& data) {
+    return modificaTransazione(id, Transazione(desc, importo, data));
+}
+
+/**
+ * @brief Elimina una transazione
+ * @param id Identificativo della transazione
+ * @return bool true se la transazione è stata eliminata
+ * 
+ * Quando le lapidi sono almeno SOGLIA_LAPIDI e almeno un quarto delle righe
+ * vengono rimosse in un solo passaggio, con costo ammortizzato O(1) per
+ * eliminazione. In modalità ordinata ogni eliminazione ricalcola anche i
+ * saldi cumulati dalla riga eliminata alla fine del prefisso ordinato: O(n)
+ * nel caso peggiore, O(1) per le righe recenti.
+ */
+bool ContoCorrente::eliminaTransazione(uint64_t id) {
+    size_t posizione = posizioneDi(id);
+    if (posizione == transazioni.size()) {
+        return false;
+    }
+    lapida(posizione);
+    if (righeEliminate >= SOGLIA_LAPIDI && righeEliminate * 4 >= transazioni.size()) {
+        rimuoviEliminate();
+    }
+    return true;
+}
+
+/**
+ * @brief Getter per il numero di lapidi
+ * @return size_t Righe eliminate non ancora compattate
+ */
+size_t ContoCorrente::getRigheEliminate() const {
+    return righeEliminate;
+}
+
+/**
+ * @brief Cerca una transazione per identificativo
+ * @param id Identificativo
+ * @return optional<Transazione> Transazione trovata o vuoto
+ */
+optional<Transazione> ContoCorrente::trova(uint64_t id) const {
+    size_t posizione = posizioneDi(id);
+    if (posizione == transazioni.size()) {
+        return nullopt;
+    }
+    return transazioni[posizione];
+}
+
+/**
+ * @brief Confronta due transazioni per data
+ */
+static bool perData(const Transazione& a, const Transazione& b) {
+    return a.getData() < b.getData();
+}
+
+/**
+ * @brief Confronta una transazione con una data (per lower_bound)
+ */
+static bool primaDellaData(const Transazione& t, const string& data) {
+    return t.getData() < data;
+}
+
+/**
+ * @brief Confronta una data con una transazione (per upper_bound)
+ */
+static bool dataPrimaDi(const string& data, const Transazione& t) {
+    return data < t.getData();
+}
+
+/**
+ * @brief Accoda una transazione rispettando la modalità ordinata
+ * @param t Transazione da accodare
+ * @param id Identificativo da assegnare (0 per il prossimo libero)
+ * 
+ * Se il flusso è abilitato la transazione viene anche pubblicata ai sottoscrittori;
+ * se è impostato un classificatore ne viene memorizzata la categoria; se la
+ * ricerca approssimata è attiva la descrizione viene indicizzata.
+ * 
+ * Se la transazione non precede l'ultima riga ordinata estende il prefisso
+ * ordinato in O(1), altrimenti resta nella coda non ordinata che viene
+ * fusa quando supera SOGLIA_CODA righe. La fusione sposta righe già
+ * esistenti, quindi viene rimandata finché ci sono istantanee attive.
+ */
+void ContoCorrente::accoda(const Transazione& t, uint64_t id) {
     transazioni.push_back(t);
+    transazioni.back().setId(id != 0 ? id : prossimoId++);
+    transazioni.back().setEliminata(false);
+    indicizzaId(transazioni.size() - 1);
+    versione++;
+    sketchImporti.aggiungi(fabs(t.getImporto()));
+    registraNelMese(t, 1);
+    if (classificatore) {
+        transazioni.back().setCategoria(classificatore->classifica(t.getDescrizione()));
+    }
+    if (flusso) {
+        flusso->pubblica(transazioni.back(), id != 0 ? OperazioneFlusso::Sostituzione : OperazioneFlusso::Inserimento);
+    }
+    if (indiceApprossimato) {
+        indiceApprossimato->aggiungi(t.getDescrizione(), transazioni.back().getId());
+    }
+    if (condiviso && !condiviso->pubblica(transazioni.back())) {
+        cout << "Segmento condiviso " << condiviso->getNome()
+             << " pieno o riga non rappresentabile: pubblicazione interrotta." << endl;
+        condiviso.reset();
+    }
+    aggiornaIndiceBlocchi();
+    if (!ordinatoPerData) {
+        return;
+    }
+    
+    if (righeOrdinate + 1 == transazioni.size() &&
+        (righeOrdinate == 0 || transazioni[righeOrdinate - 1].getData() <= t.getData())) {
+        saldiCumulati.push_back(saldiCumulati.back() + t.getImporto());
+        righeOrdinate++;
+    } else if (transazioni.size() - righeOrdinate >= SOGLIA_CODA && !istantaneeAttive()) {
+        unisciCoda();
+    }
+}
+
+/**
+ * @brief Fonde la coda non ordinata nel prefisso ordinato
+ * 
+ * La coda viene ordinata in modo stabile e fusa solo con la parte del prefisso
+ * successiva alla sua data minima: per righe arrivate con poco ritardo il
+ * costo è proporzionale alla distanza dalla fine, non alla dimensione del conto.
+ */
+void ContoCorrente::unisciCoda() {
+    if (righeOrdinate == transazioni.size()) {
+        return;
+    }
+    
+    auto inizioCoda = transazioni.begin() + righeOrdinate;
+    stable_sort(inizioCoda, transazioni.end(), perData);
+    auto inizio = upper_bound(transazioni.begin(), inizioCoda, *inizioCoda, perData);
+    size_t da = inizio - transazioni.begin();
+    inplace_merge(inizio, inizioCoda, transazioni.end(), perData);
+    // Senza istantanee attive le versioni delle lapidi non servono più e le
+    // posizioni registrate non corrispondono alle righe spostate
+    versioniEliminazione.clear();
+    
+    righeOrdinate = transazioni.size();
+    ricalcolaSaldiCumulati(da);
+    indicizzaId(da);
+    indiceBlocchi.invalidaDa(da);
+    aggiornaIndiceBlocchi();
+}
+
+/**
+ * @brief Indicizza i blocchi completi le cui righe non verranno più spostate
+ * 
+ * In modalità ordinata le fusioni inseriscono le righe arrivate in ritardo
+ * poco prima della fine del vettore: l'ultimo blocco completo resta quindi
+ * senza filtri, altrimenti ogni fusione lo farebbe ricostruire.
+ */
+void ContoCorrente::aggiornaIndiceBlocchi() {
+    size_t stabili = transazioni.size();
+    if (ordinatoPerData) {
+        stabili -= min(stabili, IndiceBlocchi::RIGHE_PER_BLOCCO);
+    }
+    indiceBlocchi.aggiorna(transazioni, stabili);
+}
+
+/**
+ * @brief Ricalcola i saldi cumulati a partire da una riga
+ * @param da Prima riga da ricalcolare
+ * 
+ * Le lapidi contribuiscono con importo nullo.
+ */
+void ContoCorrente::ricalcolaSaldiCumulati(size_t da) {
+    saldiCumulati.resize(righeOrdinate + 1);
+    for (size_t i = da; i < righeOrdinate; i++) {
+        double importo = transazioni[i].isEliminata() ? 0.0 : transazioni[i].getImporto();
+        saldiCumulati[i + 1] = saldiCumulati[i] + importo;
+    }
+}
+
+/**
+ * @brief Registra le impronte delle righe a partire da una posizione
+ * @param da Prima riga da registrare
+ */
+void ContoCorrente::registraImpronte(size_t da) {
+    impronte.riserva(transazioni.size());
+    for (size_t i = da; i < transazioni.size(); i++) {
+        if (!transazioni[i].isEliminata()) {
+            impronte.incrementa(improntaTransazione(transazioni[i]));
+        }
+    }
+}
+
+/**
+ * @brief Importa transazioni scartando quelle già presenti
+ * @param nuove Transazioni da importare
+ * @return RapportoImportazione Esito dell'importazione
+ * 
+ * Le occorrenze all'interno dell'estratto sono contate in una tabella
+ * locale: la k-esima occorrenza è nuova se il conto ne contiene meno di k
+ * (contando anche quelle appena importate).
+ */
+RapportoImportazione ContoCorrente::importa(const vector<Transazione>& nuove) {
+    RapportoImportazione rapporto;
+    if (!deduplicazione) {
+        for (const Transazione& t : nuove) {
+            accoda(t);
+        }
+        rapporto.importate = nuove.size();
+        return rapporto;
+    }
+    
+    TabellaImpronte occorrenze;
+    occorrenze.riserva(nuove.size());
+    impronte.riserva(transazioni.size() + nuove.size());
+    for (const Transazione& t : nuove) {
+        uint64_t impronta = improntaTransazione(t);
+        if (impronte.conta(impronta) < occorrenze.incrementa(impronta)) {
+            impronte.incrementa(impronta);
+            accoda(t);
+            rapporto.importate++;
+        } else {
+            rapporto.scartate.push_back(t);
+        }
+    }
+    return rapporto;
+}
+
+/**
+ * @brief Importa le transazioni di un file
+ * @param file Percorso del file
+ * @return RapportoImportazione Esito dell'importazione
+ */
+RapportoImportazione ContoCorrente::importaDaFile(const string& file) {
+    ifstream in(file, ios::binary);
+    if (!in.is_open()) {
+        throw runtime_error("File " + file + " non trovato");
+    }
+    if (int versioneFormato = FormatoCompresso::riconosci(in)) {
+        return importa(FormatoCompresso::leggi(in, versioneFormato));
+    }
+    
+    vector<Transazione> lette;
+    int righeNonValide = 0;
+    string linea;
+    while (getline(in, linea)) {
+        if (linea.empty() || isRigaControllo(linea)) {
+            continue;
+        }
+        try {
+            lette.push_back(Transazione::fromString(linea));
+        } catch (const exception& e) {
+            righeNonValide++;
+        }
+    }
+    RapportoImportazione rapporto = importa(lette);
+    rapporto.righeNonValide = righeNonValide;
+    return rapporto;
+}
+
+/**
+ * @brief Attiva o disattiva la deduplicazione
+ * @param attiva true per rifiutare i duplicati
+ */
+void ContoCorrente::setDeduplicazione(bool attiva) {
+    if (attiva == deduplicazione) {
+        return;
+    }
+    deduplicazione = attiva;
+    impronte.svuota();
+    if (attiva) {
+        registraImpronte(0);
+    }
+}
+
+/**
+ * @brief Indica se la deduplicazione è attiva
+ * @return bool true se attiva
+ */
+bool ContoCorrente::isDeduplicazione() const {
+    return deduplicazione;
+}
+
+/**
+ * @brief Attiva o disattiva l'indice della ricerca approssimata
+ * @param attiva true per costruire l'indice sulle righe valide
+ */
+void ContoCorrente::setRicercaApprossimata(bool attiva) {
+    indiceApprossimato.reset();
+    if (!attiva) {
+        return;
+    }
+    auto indice = make_shared<IndiceApprossimato>();
+    for (const Transazione& t : transazioni) {
+        if (!t.isEliminata()) {
+            indice->aggiungi(t.getDescrizione(), t.getId());
+        }
+    }
+    indiceApprossimato = indice;
+}
+
+/**
+ * @brief Indica se l'indice della ricerca approssimata è attivo
+ * @return bool true se attivo
+ */
+bool ContoCorrente::isRicercaApprossimata() const {
+    return indiceApprossimato != nullptr;
+}
+
+/**
+ * @brief Cerca le descrizioni simili a un testo
+ * @param testo Testo cercato
+ * @param maxRisultati Numero massimo di descrizioni restituite
+ * @param maxDistanza Distanza massima per parola (negativa = automatica)
+ * @return vector<RisultatoApprossimato> Descrizioni ordinate con le loro transazioni
+ * 
+ * L'indice conserva anche gli identificativi di righe poi modificate o
+ * eliminate: ognuno viene risolto con posizioneDi e tenuto solo se la
+ * versione valida ha ancora la descrizione trovata. Le descrizioni rimaste
+ * senza transazioni vengono saltate, quindi l'indice è interrogato per un
+ * numero crescente di risultati finché non ne bastano maxRisultati.
+ */
+vector<RisultatoApprossimato> ContoCorrente::cercaApprossimata(const string& testo, size_t maxRisultati,
+                                                               int maxDistanza) const {
+    if (!indiceApprossimato) {
+        throw runtime_error("Ricerca approssimata non attiva: chiamare setRicercaApprossimata(true)");
+    }
+    const IndiceApprossimato* indice = indiceApprossimato.get();
+
+    vector<RisultatoApprossimato> risultati;
+    string normalizzata;
+    string confronto;
+    for (size_t richiesti = maxRisultati; maxRisultati > 0; richiesti *= 2) {
+        vector<DescrizioneApprossimata> trovate = indice->cerca(testo, richiesti, maxDistanza);
+        risultati.clear();
+        for (const DescrizioneApprossimata& d : trovate) {
+            normalizzaDescrizione(d.descrizione, normalizzata);
+            RisultatoApprossimato risultato{d.descrizione, d.distanza, {}};
+            for (uint64_t id : d.id) {
+                size_t posizione = posizioneDi(id);
+                if (posizione == transazioni.size()) {
+                    continue;
+                }
+                normalizzaDescrizione(transazioni[posizione].getDescrizione(), confronto);
+                if (confronto == normalizzata) {
+                    risultato.transazioni.push_back(transazioni[posizione]);
+                }
+            }
+            if (!risultato.transazioni.empty()) {
+                risultati.push_back(move(risultato));
+                if (risultati.size() == maxRisultati) {
+                    return risultati;
+                }
+            }
+        }
+        if (trovate.size() < richiesti) {
+            break;
+        }
+    }
+    return risultati;
+}
+
+/**
+ * @brief Crea un'istantanea del conto
+ * @return Istantanea Numero di righe e versione correnti
+ */
+Istantanea ContoCorrente::istantanea() const {
+    Istantanea ist;
+    ist.righe = transazioni.size();
+    ist.versione = versione;
+    ist.token = tokenIstantanee;
+    return ist;
+}
+
+/**
+ * @brief Getter per la versione corrente
+ * @return uint64_t Numero di modifiche applicate
+ */
+uint64_t ContoCorrente::getVersione() const {
+    return versione;
+}
+
+/**
+ * @brief Indica se esistono istantanee non ancora distrutte
+ * @return bool true se almeno un'istantanea è attiva
+ */
+bool ContoCorrente::istantaneeAttive() const {
+    return tokenIstantanee.use_count() > 1;
+}
+
+/**
+ * @brief Verifica che l'istantanea sia stata creata da questo conto
+ * @param ist Istantanea da verificare
+ * @throws std::invalid_argument Se l'istantanea appartiene a un altro conto
+ */
+void ContoCorrente::verificaIstantanea(const Istantanea& ist) const {
+    if (ist.token != tokenIstantanee || ist.righe > transazioni.size()) {
+        throw invalid_argument("Istantanea non valida per questo conto");
+    }
+}
+
+/**
+ * @brief Lunghezza del prefisso ordinato visibile nell'istantanea
+ * @param ist Istantanea da verificare
+ * @return size_t Righe ordinate tra le prime ist.righe (0 fuori dalla modalità ordinata)
+ * 
+ * Finché l'istantanea è attiva le fusioni sono sospese, quindi le sue righe
+ * non cambiano posizione e il prefisso ordinato corrente, troncato alle sue
+ * righe, è ordinato anche per lei.
+ */
+size_t ContoCorrente::prefissoOrdinato(const Istantanea& ist) const {
+    verificaIstantanea(ist);
+    return ordinatoPerData ? min(righeOrdinate, ist.righe) : 0;
+}
+
+/**
+ * @brief Prefisso ordinato utilizzabile con i saldi cumulati
+ * @param ist Istantanea da verificare
+ * @return size_t Righe del prefisso, oppure 0 se i saldi non valgono per l'istantanea
+ * 
+ * I saldi cumulati escludono tutte le lapidi correnti: sono corretti per
+ * un'istantanea solo se nessuna riga è stata eliminata dopo la sua creazione.
+ */
+size_t ContoCorrente::prefissoSaldi(const Istantanea& ist) const {
+    size_t ordinate = prefissoOrdinato(ist);
+    return ist.versione >= versioneUltimaEliminazione ? ordinate : 0;
+}
+
+/**
+ * @brief Calcola il saldo totale sommando tutti gli importi
+ * @return double Saldo totale del conto
+ * 
+ * Somma algebrica di tutti gli importi delle transazioni
+ */
+double ContoCorrente::calcolaSaldo() const {
+    return calcolaSaldo(istantanea());
+}
+
+/**
+ * @brief Calcola il saldo delle righe visibili nell'istantanea
+ * @param ist Istantanea del conto
+ * @return double Saldo all'istante dell'istantanea
+ */
+double ContoCorrente::calcolaSaldo(const Istantanea& ist) const {
+    size_t ordinate = prefissoSaldi(ist);
+    double saldo = ordinate > 0 ? saldiCumulati[ordinate] : 0.0;
+    for (size_t i = ordinate; i < ist.righe; i++) {
+        if (isVisibile(i, ist.versione)) {
+            saldo += transazioni[i].getImporto();
+        }
+    }
+    return saldo;
+}
+
+/**
+ * @brief Cerca transazioni per data specifica
+ * @param data Data da cercare in formato YYYY-MM-DD
+ * @return vector<Transazione> Vettore delle transazioni trovate
+ * 
+ * Confronta la data esatta di ogni transazione con quella specificata.
+ * In modalità ordinata individua le righe con una ricerca binaria
+ * e scansiona solo la coda non ordinata. I blocchi il cui filtro di Bloom
+ * esclude la data vengono saltati senza leggere le righe.
+ */
+vector<Transazione> ContoCorrente::cercaPerData(const string& data) const {
+    return cercaPerData(data, istantanea());
+}
+
+/**
+ * @brief Cerca transazioni per data nell'istantanea
+ * @param data Data da cercare
+ * @param ist Istantanea del conto
+ * @return vector<Transazione> Vettore delle transazioni trovate
+ */
+vector<Transazione> ContoCorrente::cercaPerData(const string& data, const Istantanea& ist) const {
+    vector<Transazione> risultati;
+    auto inizioScansione = transazioni.begin() + prefissoOrdinato(ist);
+    if (ordinatoPerData) {
+        auto primo = lower_bound(transazioni.begin(), inizioScansione, data, primaDellaData);
+        auto ultimo = upper_bound(primo, inizioScansione, data, dataPrimaDi);
+        for (auto it = primo; it != ultimo; ++it) {
+            if (isVisibile(it - transazioni.begin(), ist.versione)) {
+                risultati.push_back(*it);
+            }
+        }
+    }
+    uint64_t chiave = IndiceBlocchi::chiaveData(data);
+    size_t i = inizioScansione - transazioni.begin();
+    while (i < ist.righe) {
+        size_t fineBlocco = min(ist.righe, IndiceBlocchi::fineBlocco(i));
+        if (indiceBlocchi.escludeData(i, chiave)) {
+            i = fineBlocco;
+            continue;
+        }
+        for (; i < fineBlocco; i++) {
+            if (transazioni[i].getData() == data && isVisibile(i, ist.versione)) {
+                risultati.push_back(transazioni[i]);
+            }
+        }
+    }
+    return risultati;
+}
+
+/**
+ * @brief Cerca transazioni in un intervallo di date
+ * @param da Data iniziale inclusa
+ * @param a Data finale inclusa
+ * @return vector<Transazione> Vettore delle transazioni trovate
+ * 
+ * Le date in formato YYYY-MM-DD si confrontano correttamente come stringhe.
+ * In modalità ordinata il prefisso ordinato è delimitato con ricerche binarie.
+ */
+vector<Transazione> ContoCorrente::cercaPerIntervallo(const string& da, const string& a) const {
+    return cercaPerIntervallo(da, a, istantanea());
+}
+
+/**
+ * @brief Cerca transazioni in un intervallo di date nell'istantanea
+ * @param da Data iniziale inclusa
+ * @param a Data finale inclusa
+ * @param ist Istantanea del conto
+ * @return vector<Transazione> Vettore delle transazioni trovate
+ */
+vector<Transazione> ContoCorrente::cercaPerIntervallo(const string& da, const string& a, const Istantanea& ist) const {
+    vector<Transazione> risultati;
+    auto inizioScansione = transazioni.begin() + prefissoOrdinato(ist);
+    auto fine = transazioni.begin() + ist.righe;
+    if (ordinatoPerData) {
+        auto primo = lower_bound(transazioni.begin(), inizioScansione, da, primaDellaData);
+        auto ultimo = upper_bound(primo, inizioScansione, a, dataPrimaDi);
+        for (auto it = primo; it != ultimo; ++it) {
+            if (isVisibile(it - transazioni.begin(), ist.versione)) {
+                risultati.push_back(*it);
+            }
+        }
+    }
+    for (auto it = inizioScansione; it != fine; ++it) {
+        if (it->getData() >= da && it->getData() <= a && isVisibile(it - transazioni.begin(), ist.versione)) {
+            risultati.push_back(*it);
+        }
+    }
+    if (ordinatoPerData && inizioScansione != fine) {
+        stable_sort(risultati.begin(), risultati.end(), perData);
+    }
+    return risultati;
+}
+
+/**
+ * @brief Calcola il saldo alla fine della data indicata
+ * @param data Data limite inclusa
+ * @return double Somma degli importi fino alla data
+ * 
+ * In modalità ordinata il contributo del prefisso ordinato è letto dai saldi
+ * cumulati dopo una ricerca binaria; la coda viene sommata a parte.
+ */
+double ContoCorrente::calcolaSaldoAl(const string& data) const {
+    return calcolaSaldoAl(data, istantanea());
+}
+
+/**
+ * @brief Calcola il saldo alla fine di una data nell'istantanea
+ * @param data Data limite inclusa
+ * @param ist Istantanea del conto
+ * @return double Somma degli importi fino alla data
+ */
+double ContoCorrente::calcolaSaldoAl(const string& data, const Istantanea& ist) const {
+    double saldo = 0.0;
+    auto inizioScansione = transazioni.begin() + prefissoSaldi(ist);
+    auto fine = transazioni.begin() + ist.righe;
+    if (inizioScansione != transazioni.begin()) {
+        auto limite = upper_bound(transazioni.begin(), inizioScansione, data, dataPrimaDi);
+        saldo = saldiCumulati[limite - transazioni.begin()];
+    }
+    for (auto it = inizioScansione; it != fine; ++it) {
+        if (it->getData() <= data && isVisibile(it - transazioni.begin(), ist.versione)) {
+            saldo += it->getImporto();
+        }
+    }
+    return saldo;
+}
+
+/**
+ * @brief Cerca transazioni per parola chiave nella descrizione
+ * @param parola Parola chiave da cercare
+ * @return vector<Transazione> Vettore delle transazioni che contengono la parola
+ * 
+ * Compila la parola una sola volta e la riusa con il metodo
+ * contieneParolaChiave di ogni transazione. Per parole di almeno 3 byte
+ * salta i blocchi il cui filtro non contiene tutti i trigrammi della parola.
+ */
+vector<Transazione> ContoCorrente::cercaPerParolaChiave(const string& parola) const {
+    return cercaPerParolaChiave(parola, istantanea());
+}
+
+/**
+ * @brief Cerca transazioni per parola chiave nell'istantanea
+ * @param parola Parola chiave da cercare
+ * @param ist Istantanea del conto
+ * @return vector<Transazione> Vettore delle transazioni che contengono la parola
+ */
+vector<Transazione> ContoCorrente::cercaPerParolaChiave(const string& parola, const Istantanea& ist) const {
+    vector<Transazione> risultati;
+    ParolaChiave compilata(parola);
+    vector<uint64_t> chiavi = IndiceBlocchi::chiaviParola(compilata.getPiegata());
+    verificaIstantanea(ist);
+    size_t i = 0;
+    while (i < ist.righe) {
+        size_t fineBlocco = min(ist.righe, IndiceBlocchi::fineBlocco(i));
+        if (indiceBlocchi.escludeParola(i, chiavi)) {
+            i = fineBlocco;
+            continue;
+        }
+        for (; i < fineBlocco; i++) {
+            if (isVisibile(i, ist.versione) && transazioni[i].contieneParolaChiave(compilata)) {
+                risultati.push_back(transazioni[i]);
+            }
+        }
+    }
+    return risultati;
+}
+
+/**
+ * @brief Visita le transazioni accettate dal filtro
+ * @param filtro Condizioni da soddisfare
+ * @param visita Funzione chiamata per ogni transazione accettata
+ * 
+ * Piano di visita: il vincolo sulle date è l'unico che può sfruttare un
+ * indice (il prefisso ordinato), quindi viene applicato per primo con due
+ * ricerche binarie; le altre condizioni sono valutate riga per riga.
+ */
+void ContoCorrente::perOgni(const Filtro& filtro, const function<void(const Transazione&)>& visita) const {
+    perOgni(filtro, visita, istantanea());
+}
+
+/**
+ * @brief Visita le transazioni dell'istantanea accettate dal filtro
+ * @param filtro Condizioni da soddisfare
+ * @param visita Funzione chiamata per ogni transazione accettata
+ * @param ist Istantanea del conto
+ */
+void ContoCorrente::perOgni(const Filtro& filtro, const function<void(const Transazione&)>& visita,
+                            const Istantanea& ist) const {
+    size_t ordinate = prefissoOrdinato(ist);
+    size_t inizioScansione = 0;
+    if (ordinatoPerData && (filtro.getHaDataMinima() || filtro.getHaDataMassima())) {
+        auto fineOrdinate = transazioni.begin() + ordinate;
+        auto primo = filtro.getHaDataMinima()
+            ? lower_bound(transazioni.begin(), fineOrdinate, filtro.getDataMinima(), primaDellaData)
+            : transazioni.begin();
+        auto ultimo = filtro.getHaDataMassima()
+            ? upper_bound(primo, fineOrdinate, filtro.getDataMassima(), dataPrimaDi)
+            : fineOrdinate;
+        for (auto it = primo; it != ultimo; ++it) {
+            if (isVisibile(it - transazioni.begin(), ist.versione) && filtro.accetta(*it, false)) {
+                visita(*it);
+            }
+        }
+        inizioScansione = ordinate;
+    }
+    
+    for (size_t i = inizioScansione; i < ist.righe; i++) {
+        if (isVisibile(i, ist.versione) && filtro.accetta(transazioni[i])) {
+            visita(transazioni[i]);
+        }
+    }
+}
+
+/**
+ * @brief Cerca le transazioni accettate dal filtro
+ * @param filtro Condizioni da soddisfare
+ * @return vector<Transazione> Transazioni trovate
+ */
+vector<Transazione> ContoCorrente::cerca(const Filtro& filtro) const {
+    return cerca(filtro, istantanea());
+}
+
+/**
+ * @brief Cerca le transazioni dell'istantanea accettate dal filtro
+ * @param filtro Condizioni da soddisfare
+ * @param ist Istantanea del conto
+ * @return vector<Transazione> Transazioni trovate
+ */
+vector<Transazione> ContoCorrente::cerca(const Filtro& filtro, const Istantanea& ist) const {
+    vector<Transazione> risultati;
+    perOgni(filtro, [&risultati](const Transazione& t) { risultati.push_back(t); }, ist);
+    return risultati;
+}
+
+/**
+ * @brief Conta le transazioni accettate dal filtro
+ * @param filtro Condizioni da soddisfare
+ * @return int Numero di transazioni trovate
+ */
+int ContoCorrente::conta(const Filtro& filtro) const {
+    return conta(filtro, istantanea());
+}
+
+/**
+ * @brief Conta le transazioni dell'istantanea accettate dal filtro
+ * @param filtro Condizioni da soddisfare
+ * @param ist Istantanea del conto
+ * @return int Numero di transazioni trovate
+ */
+int ContoCorrente::conta(const Filtro& filtro, const Istantanea& ist) const {
+    int count = 0;
+    perOgni(filtro, [&count](const Transazione&) { count++; }, ist);
+    return count;
+}
+
+/**
+ * @brief Seleziona le k transazioni con il valore assoluto maggiore
+ * @param k Numero massimo di transazioni
+ * @param visita Funzione che visita le candidate (tipicamente perOgni)
+ * @return vector<Transazione> Transazioni ordinate per valore assoluto decrescente
+ * 
+ * Lo heap contiene puntatori alle righe del conto, ordinati in modo che in
+ * cima ci sia la più piccola tra le k migliori: ogni candidata costa un
+ * confronto e, solo se entra, O(log k).
+ */
+static vector<Transazione> selezionaMaggiori(size_t k,
+        const function<void(const function<void(const Transazione&)>&)>& visita) {
+    auto maggiore = [](const Transazione* a, const Transazione* b) {
+        return fabs(a->getImporto()) > fabs(b->getImporto());
+    };
+    if (k == 0) {
+        return {};
+    }
+    vector<const Transazione*> heap;
+    heap.reserve(k);
+    visita([&](const Transazione& t) {
+        if (heap.size() < k) {
+            heap.push_back(&t);
+            push_heap(heap.begin(), heap.end(), maggiore);
+        } else if (fabs(t.getImporto()) > fabs(heap.front()->getImporto())) {
+            pop_heap(heap.begin(), heap.end(), maggiore);
+            heap.back() = &t;
+            push_heap(heap.begin(), heap.end(), maggiore);
+        }
+    });
+    sort_heap(heap.begin(), heap.end(), maggiore);
+    
+    vector<Transazione> risultati;
+    risultati.reserve(heap.size());
+    for (const Transazione* t : heap) {
+        risultati.push_back(*t);
+    }
+    return risultati;
+}
+
+/**
+ * @brief Le k uscite più grandi tra quelle accettate dal filtro
+ * @param k Numero massimo di transazioni
+ * @param filtro Condizioni da soddisfare
+ * @return vector<Transazione> Uscite ordinate dalla più grande
+ */
+vector<Transazione> ContoCorrente::topUscite(size_t k, const Filtro& filtro) const {
+    return topUscite(k, filtro, istantanea());
+}
+
+/**
+ * @brief Le k uscite più grandi nell'istantanea
+ * @param k Numero massimo di transazioni
+ * @param filtro Condizioni da soddisfare
+ * @param ist Istantanea del conto
+ * @return vector<Transazione> Uscite ordinate dalla più grande
+ */
+vector<Transazione> ContoCorrente::topUscite(size_t k, const Filtro& filtro, const Istantanea& ist) const {
+    Filtro soloUscite = filtro;
+    soloUscite.soloUscite();
+    return selezionaMaggiori(k, [&](const function<void(const Transazione&)>& f) { perOgni(soloUscite, f, ist); });
+}
+
+/**
+ * @brief Le k entrate più grandi tra quelle accettate dal filtro
+ * @param k Numero massimo di transazioni
+ * @param filtro Condizioni da soddisfare
+ * @return vector<Transazione> Entrate ordinate dalla più grande
+ */
+vector<Transazione> ContoCorrente::topEntrate(size_t k, const Filtro& filtro) const {
+    return topEntrate(k, filtro, istantanea());
+}
+
+/**
+ * @brief Le k entrate più grandi nell'istantanea
+ * @param k Numero massimo di transazioni
+ * @param filtro Condizioni da soddisfare
+ * @param ist Istantanea del conto
+ * @return vector<Transazione> Entrate ordinate dalla più grande
+ */
+vector<Transazione> ContoCorrente::topEntrate(size_t k, const Filtro& filtro, const Istantanea& ist) const {
+    Filtro soloEntrate = filtro;
+    soloEntrate.soloEntrate();
+    return selezionaMaggiori(k, [&](const function<void(const Transazione&)>& f) { perOgni(soloEntrate, f, ist); });
+}
+
+/**
+ * @brief Quantile approssimato dallo sketch
+ * @param q Quantile richiesto
+ * @return double Valore stimato
+ * 
+ * Se dall'ultima ricostruzione sono state create lapidi lo sketch viene
+ * ricostruito dalle righe valide: il KLL non supporta la rimozione.
+ */
+double ContoCorrente::quantileImporti(double q) const {
+    // I lettori concorrenti (lock condiviso nel server) non devono
+    // ricostruire o leggere lo sketch mentre un altro lo sta ricostruendo
+    lock_guard<mutex> guardia(*mutexSketch);
+    if (sketchDaRicostruire) {
+        sketchImporti = SketchKll();
+        for (const Transazione& t : transazioni) {
+            if (!t.isEliminata()) {
+                sketchImporti.aggiungi(fabs(t.getImporto()));
+            }
+        }
+        sketchDaRicostruire = false;
+    }
+    return sketchImporti.quantile(q);
+}
+
+/**
+ * @brief Quantile esatto sulle sole transazioni filtrate
+ * @param q Quantile richiesto
+ * @param filtro Condizioni da soddisfare
+ * @return double Valore del quantile
+ */
+double ContoCorrente::quantileImporti(double q, const Filtro& filtro) const {
+    return quantileImporti(q, filtro, istantanea());
+}
+
+/**
+ * @brief Quantile esatto sulle transazioni filtrate dell'istantanea
+ * @param q Quantile richiesto
+ * @param filtro Condizioni da soddisfare
+ * @param ist Istantanea del conto
+ * @return double Valore del quantile
+ */
+double ContoCorrente::quantileImporti(double q, const Filtro& filtro, const Istantanea& ist) const {
+    vector<double> valori;
+    perOgni(filtro, [&valori](const Transazione& t) { valori.push_back(fabs(t.getImporto())); }, ist);
+    if (valori.empty()) {
+        return 0.0;
+    }
+    q = min(1.0, max(0.0, q));
+    size_t rango = static_cast<size_t>(ceil(q * valori.size()));
+    auto posizione = valori.begin() + (rango == 0 ? 0 : rango - 1);
+    nth_element(valori.begin(), posizione, valori.end());
+    return *posizione;
+}
+
+/**
+ * @brief Aggiorna le strutture derivate per le righe appena caricate
+ * @param da Prima riga caricata
+ * 
+ * I riepiloghi mensili salvati vengono riusati solo per un caricamento
+ * completo (conto inizialmente vuoto); altrimenti sono aggiornati riga per riga.
+ */
+void ContoCorrente::dopoCaricamento(size_t da) {
+    assegnaIdCaricati(da);
+    indicizzaId(da);
+    for (size_t i = da; i < transazioni.size(); i++) {
+        sketchImporti.aggiungi(fabs(transazioni[i].getImporto()));
+    }
+    versione += transazioni.size() - da;
+    classificaRighe(da);
+    if (deduplicazione) {
+        registraImpronte(da);
+    }
+    if (indiceApprossimato) {
+        for (size_t i = da; i < transazioni.size(); i++) {
+            indiceApprossimato->aggiungi(transazioni[i].getDescrizione(), transazioni[i].getId());
+        }
+    }
+    if (da != 0 || !caricaRiepiloghi()) {
+        for (size_t i = da; i < transazioni.size(); i++) {
+            registraNelMese(transazioni[i], 1);
+        }
+    }
+    if (da == 0) {
+        ifstream file(fileIndiceBlocchi(), ios::binary);
+        if (file.is_open()) {
+            indiceBlocchi.carica(file, transazioni);
+        }
+    }
+    aggiornaIndiceBlocchi();
+    if (ordinatoPerData && !istantaneeAttive()) {
+        unisciCoda();
+    }
 }
 
 /**
- * @brief Aggiunge una nuova transazione con i parametri specificati
- * @param desc Descrizione della transazione
- * @param importo Importo della transazione
- * @param data Data della transazione
+ * @brief Aggiorna il riepilogo del mese della transazione
+ * @param t Transazione
+ * @param segno +1 per aggiungerla, -1 per toglierla
  * 
- * Crea una nuova transazione e la aggiunge al vettore
+ * Gli inserimenti cadono quasi sempre nell'ultimo mese, che viene
+ * controllato per primo; altrimenti il mese è cercato con una ricerca binaria.
  */
-void ContoCorrente::aggiungiTransazione(const string& desc, double importo, const string& data) {
-    Transazione t(desc, importo, data);
-    transazioni.push_back(t);
+void ContoCorrente::registraNelMese(const Transazione& t, int segno) {
+    string mese = t.getData().substr(0, 7);
+    auto it = riepiloghiMesi.end();
+    if (riepiloghiMesi.empty() || riepiloghiMesi.back().mese != mese) {
+        it = lower_bound(riepiloghiMesi.begin(), riepiloghiMesi.end(), mese,
+                         [](const RiepilogoMese& r, const string& m) { return r.mese < m; });
+        if (it == riepiloghiMesi.end() || it->mese != mese) {
+            it = riepiloghiMesi.insert(it, RiepilogoMese{mese, 0, 0, 0, 0});
+        }
+    } else {
+        it = riepiloghiMesi.end() - 1;
+    }
+    
+    long long centesimi = importoInCentesimi(t.getImporto()) * segno;
+    it->somma += centesimi;
+    it->conteggio += segno;
+    if (t.getImporto() > 0) {
+        it->entrate += centesimi;
+    } else {
+        it->uscite += centesimi;
+    }
+    if (it->conteggio == 0) {
+        riepiloghiMesi.erase(it);
+    }
 }
 
 /**
- * @brief Calcola il saldo totale sommando tutti gli importi
- * @return double Saldo totale del conto
+ * @brief Nome del file dei riepiloghi mensili
+ * @return string Nome del file dei dati con estensione ".mesi"
+ */
+string ContoCorrente::fileRiepiloghi() const {
+    return nomeFile + ".mesi";
+}
+
+/**
+ * @brief Impronta delle righe valide per validare i riepiloghi salvati
+ * @param transazioni Righe del conto (le lapidi sono ignorate)
+ * @return uint64_t Somma degli hash FNV-1a di data e centesimi di ogni riga
  * 
- * Somma algebrica di tutti gli importi delle transazioni
+ * I riepiloghi dipendono solo da data e importo delle righe, non dal loro
+ * ordine: la somma degli hash resta uguale se le righe vengono riordinate
+ * ma cambia se una data o un importo viene modificato nel file.
  */
-double ContoCorrente::calcolaSaldo() const {
-    double saldo = 0.0;
+static uint64_t improntaRiepiloghi(const vector<Transazione>& transazioni) {
+    uint64_t somma = 0;
     for (const Transazione& t : transazioni) {
-        saldo += t.getImporto();
+        if (t.isEliminata()) {
+            continue;
+        }
+        uint64_t h = 0xCBF29CE484222325ULL;
+        for (unsigned char c : t.getData()) {
+            h = (h ^ c) * 0x100000001B3ULL;
+        }
+        uint64_t centesimi = static_cast<uint64_t>(importoInCentesimi(t.getImporto()));
+        for (int i = 0; i < 8; i++) {
+            h = (h ^ ((centesimi >> (i * 8)) & 0xFF)) * 0x100000001B3ULL;
+        }
+        somma += h;
     }
-    return saldo;
+    return somma;
 }
 
 /**
- * @brief Cerca transazioni per data specifica
- * @param data Data da cercare in formato YYYY-MM-DD
- * @return vector<Transazione> Vettore delle transazioni trovate
+ * @brief Carica i riepiloghi mensili salvati
+ * @return bool true se il file esiste ed è coerente con le righe caricate
  * 
- * Confronta la data esatta di ogni transazione con quella specificata
+ * La prima riga "#riepiloghi;righe;centesimi;impronta" permette di scartare
+ * un file non aggiornato: numero di righe, somma in centesimi e impronta di
+ * date e importi (improntaRiepiloghi) devono coincidere con quelli delle
+ * transazioni caricate. Righe e somma da sole non bastano: spostare una
+ * riga in un altro mese, o due importi tra due righe, le lascerebbe uguali.
  */
-vector<Transazione> ContoCorrente::cercaPerData(const string& data) const {
-    vector<Transazione> risultati;
+bool ContoCorrente::caricaRiepiloghi() {
+    ifstream file(fileRiepiloghi());
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    long long centesimi = 0;
     for (const Transazione& t : transazioni) {
-        if (t.getData() == data) {
-            risultati.push_back(t);
+        centesimi += importoInCentesimi(t.getImporto());
+    }
+    
+    string linea;
+    vector<RiepilogoMese> letti;
+    try {
+        getline(file, linea);
+        istringstream intestazione(linea);
+        string campo;
+        getline(intestazione, campo, ';');
+        if (campo != "#riepiloghi") {
+            return false;
+        }
+        getline(intestazione, campo, ';');
+        size_t righe = stoull(campo);
+        getline(intestazione, campo, ';');
+        if (righe != transazioni.size() || stoll(campo) != centesimi) {
+            return false;
         }
+        getline(intestazione, campo, ';');
+        if (campo.empty() || stoull(campo, nullptr, 16) != improntaRiepiloghi(transazioni)) {
+            return false;
+        }
+        
+        size_t righeMesi = 0;
+        while (getline(file, linea)) {
+            istringstream ss(linea);
+            RiepilogoMese r;
+            getline(ss, r.mese, ';');
+            getline(ss, campo, ';');
+            r.conteggio = stoi(campo);
+            getline(ss, campo, ';');
+            r.somma = stoll(campo);
+            getline(ss, campo, ';');
+            r.entrate = stoll(campo);
+            getline(ss, campo, ';');
+            r.uscite = stoll(campo);
+            righeMesi += r.conteggio;
+            letti.push_back(r);
+        }
+        if (righeMesi != righe) {
+            return false;
+        }
+    } catch (const exception& e) {
+        return false;
     }
-    return risultati;
+    riepiloghiMesi = move(letti);
+    return true;
 }
 
 /**
- * @brief Cerca transazioni per parola chiave nella descrizione
- * @param parola Parola chiave da cercare
- * @return vector<Transazione> Vettore delle transazioni che contengono la parola
+ * @brief Salva i riepiloghi mensili
  * 
- * Utilizza il metodo contieneParolaChiave di ogni transazione
+ * Un errore di scrittura non compromette i dati: al prossimo caricamento
+ * i riepiloghi verranno ricalcolati dalle righe.
  */
-vector<Transazione> ContoCorrente::cercaPerParolaChiave(const string& parola) const {
-    vector<Transazione> risultati;
-    for (const Transazione& t : transazioni) {
-        if (t.contieneParolaChiave(parola)) {
-            risultati.push_back(t);
-        }
+void ContoCorrente::salvaRiepiloghi() const {
+    long long centesimi = 0;
+    for (const RiepilogoMese& r : riepiloghiMesi) {
+        centesimi += r.somma;
     }
-    return risultati;
+    ofstream file(fileRiepiloghi());
+    if (!file.is_open()) {
+        cout << "Impossibile salvare i riepiloghi mensili in " << fileRiepiloghi() << endl;
+        return;
+    }
+    file << "#riepiloghi;" << getNumeroTransazioni() << ";" << centesimi << ";" << hex
+         << improntaRiepiloghi(transazioni) << dec << "\n";
+    for (const RiepilogoMese& r : riepiloghiMesi) {
+        file << r.mese << ";" << r.conteggio << ";" << r.somma << ";" << r.entrate << ";" << r.uscite << "\n";
+    }
+}
+
+/**
+ * @brief Nome del file dei filtri dei blocchi
+ * @return string Nome del file dei dati con estensione ".blocchi"
+ */
+string ContoCorrente::fileIndiceBlocchi() const {
+    return nomeFile + ".blocchi";
+}
+
+/**
+ * @brief Salva i filtri dei blocchi
+ * 
+ * Come per i riepiloghi, un file mancante o non aggiornato viene
+ * semplicemente ricostruito al caricamento successivo.
+ */
+void ContoCorrente::salvaIndiceBlocchi() const {
+    ofstream file(fileIndiceBlocchi(), ios::binary);
+    if (!file.is_open()) {
+        cout << "Impossibile salvare i filtri dei blocchi in " << fileIndiceBlocchi() << endl;
+        return;
+    }
+    indiceBlocchi.salva(file);
+}
+
+/**
+ * @brief Riepiloghi di tutti i mesi
+ * @return vector<Aggregato> Aggregati per mese
+ */
+vector<Aggregato> ContoCorrente::riepiloghiMensili() const {
+    vector<Aggregato> risultato;
+    risultato.reserve(riepiloghiMesi.size());
+    for (const RiepilogoMese& r : riepiloghiMesi) {
+        risultato.push_back(Aggregato{r.mese, r.somma / 100.0, r.conteggio, r.entrate / 100.0, r.uscite / 100.0});
+    }
+    return risultato;
+}
+
+/**
+ * @brief Totali di un intervallo di mesi
+ * @param daMese Primo mese incluso
+ * @param aMese Ultimo mese incluso
+ * @return Aggregato Totali del periodo
+ */
+Aggregato ContoCorrente::riepilogoPeriodo(const string& daMese, const string& aMese) const {
+    long long somma = 0, entrate = 0, uscite = 0;
+    int conteggio = 0;
+    auto it = lower_bound(riepiloghiMesi.begin(), riepiloghiMesi.end(), daMese,
+                          [](const RiepilogoMese& r, const string& m) { return r.mese < m; });
+    for (; it != riepiloghiMesi.end() && it->mese <= aMese; ++it) {
+        somma += it->somma;
+        entrate += it->entrate;
+        uscite += it->uscite;
+        conteggio += it->conteggio;
+    }
+    return Aggregato{daMese + ".." + aMese, somma / 100.0, conteggio, entrate / 100.0, uscite / 100.0};
 }
 
 /**
  * @brief Carica le transazioni dal file specificato
  * 
- * Legge il file riga per riga e converte ogni riga in una transazione
- * usando il metodo fromString. Gestisce errori di lettura e formato.
+ * Se il file inizia con la firma del formato compresso lo decodifica a blocchi
+ * (e solo se la decodifica riesce il conto continua a salvare in quel formato),
+ * altrimenti legge il file riga per riga e converte ogni riga in una transazione
+ * con TracciatoFile (come fromString, ma senza eccezioni per le righe non
+ * valide). Gestisce errori di lettura e formato.
  */
 void ContoCorrente::caricaDaFile() {
-    ifstream file(nomeFile);
+    ifstream file(nomeFile, ios::binary);
     if (!file.is_open()) {
         cout << "File " << nomeFile << " non trovato. Sarà creato al primo salvataggio." << endl;
         return;
     }
     
+    size_t righePrecedenti = transazioni.size();
+    if (int versioneFormato = FormatoCompresso::riconosci(file)) {
+        try {
+            vector<Transazione> lette = FormatoCompresso::leggi(file, versioneFormato);
+            formato = FormatoFile::Compresso;
+            transazioni.insert(transazioni.end(), lette.begin(), lette.end());
+            dopoCaricamento(righePrecedenti);
+            cout << "Caricate " << lette.size() << " transazioni dal file compresso." << endl;
+        } catch (const exception& e) {
+            cout << "Errore nel caricamento del file compresso: " << e.what() << endl;
+        }
+        return;
+    }
+    
     string linea;
     int count = 0;
     while (getline(file, linea)) {
-        if (!linea.empty()) {
-            try {
-                Transazione t = Transazione::fromString(linea);
-                transazioni.push_back(t);
+        if (!linea.empty() && !isRigaControllo(linea)) {
+            Transazione t;
+            if (TracciatoFile::leggi(linea, t)) {
+                transazioni.push_back(move(t));
                 count++;
-            } catch (const exception& e) {
+            } else {
                 cout << "Errore nel caricamento della linea: " << linea << endl;
             }
         }
     }
     file.close();
+    dopoCaricamento(righePrecedenti);
     cout << "Caricate " << count << " transazioni dal file." << endl;
 }
 
@@ -121,7 +1372,8 @@ void ContoCorrente::caricaDaFile() {
  * @brief Salva le transazioni su file
  * 
  * Crea la directory se non esiste, poi salva ogni transazione
- * usando il metodo toString. Gestisce errori di creazione directory
+ * usando il metodo toString oppure, nel formato compresso, tramite
+ * FormatoCompresso. Gestisce errori di creazione directory
  * e di scrittura file.
  */
 void ContoCorrente::salvaSuFile() const {
@@ -139,25 +1391,241 @@ void ContoCorrente::salvaSuFile() const {
         }
     }
     
-    ofstream file(nomeFile);
+    // Nel formato compresso la codifica avviene in memoria prima di aprire
+    // il file, così un errore non tronca i dati già salvati
+    ostringstream compresso;
+    if (formato == FormatoFile::Compresso) {
+        try {
+            // Due chiamate distinte: con l'operatore ternario il vettore
+            // verrebbe copiato anche senza lapidi
+            if (righeEliminate == 0) {
+                FormatoCompresso::scrivi(compresso, transazioni, controlli);
+            } else {
+                FormatoCompresso::scrivi(compresso, getTransazioni(), controlli);
+            }
+        } catch (const exception& e) {
+            cout << "Errore nella compressione delle transazioni: " << e.what() << endl;
+            return;
+        }
+    }
+    
+    ofstream file(nomeFile, ios::binary);
     if (!file.is_open()) {
         cout << "Errore nell'apertura del file per la scrittura!" << endl;
         return;
     }
     
+    if (formato == FormatoFile::Compresso) {
+        file << compresso.str();
+        file.close();
+        salvaRiepiloghi();
+        salvaIndiceBlocchi();
+        cout << "Transazioni salvate nel file compresso " << nomeFile << endl;
+        return;
+    }
+    
+    // Le righe sono formattate in un buffer scritto a blocchi
+    string buffer;
+    CatenaControlli catena(controlli);
     for (const Transazione& t : transazioni) {
-        file << t.toString() << endl;
+        if (!t.isEliminata()) {
+            if (controlli.isAttive()) {
+                if (catena.richiedeControllo(t)) {
+                    scriviRigaControllo(buffer, catena.chiudi());
+                    buffer.push_back('\n');
+                }
+                catena.aggiungi(t, centesimiTesto(t.getImporto()));
+            }
+            TracciatoFile::scrivi(t, buffer);
+            buffer.push_back('\n');
+            if (buffer.size() >= (1 << 20)) {
+                file.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+    }
+    if (catena.haRigheAperte()) {
+        scriviRigaControllo(buffer, catena.chiudi());
+        buffer.push_back('\n');
     }
+    file.write(buffer.data(), buffer.size());
     file.close();
+    salvaRiepiloghi();
+    salvaIndiceBlocchi();
     cout << "Transazioni salvate nel file " << nomeFile << endl;
 }
 
+/**
+ * @brief Esporta le transazioni accettate dal filtro
+ * @param out Stream di destinazione
+ * @param formato Formato di esportazione
+ * @param filtro Condizioni da soddisfare
+ * @return size_t Transazioni esportate
+ */
+size_t ContoCorrente::esporta(ostream& out, FormatoEsportazione formato, const Filtro& filtro) const {
+    Esportatore esportatore(out, formato);
+    perOgni(filtro, [&esportatore](const Transazione& t) { esportatore.aggiungi(t); });
+    esportatore.termina();
+    return esportatore.getRighe();
+}
+
+/**
+ * @brief Esporta su file le transazioni accettate dal filtro
+ * @param file Percorso del file
+ * @param formato Formato di esportazione
+ * @param filtro Condizioni da soddisfare
+ * @return size_t Transazioni esportate
+ */
+size_t ContoCorrente::esportaSuFile(const string& file, FormatoEsportazione formato, const Filtro& filtro) const {
+    ofstream out(file, ios::binary);
+    if (!out.is_open()) {
+        throw runtime_error("Impossibile creare il file " + file);
+    }
+    return esporta(out, formato, filtro);
+}
+
+/**
+ * @brief Carica le transazioni su un thread del pool di I/O
+ * @return Compito<int> Numero di transazioni caricate
+ */
+Compito<int> ContoCorrente::caricaAsync() {
+    size_t prima = transazioni.size();
+    co_await suPoolIO([this] { caricaDaFile(); });
+    co_return static_cast<int>(transazioni.size() - prima);
+}
+
+/**
+ * @brief Salva le transazioni su un thread del pool di I/O
+ * @return Compito<void> Coroutine del salvataggio
+ */
+Compito<void> ContoCorrente::salvaAsync() const {
+    co_await suPoolIO([this] { salvaSuFile(); });
+}
+
+/**
+ * @brief Compatta memoria e file su un thread del pool di I/O
+ * @return Compito<size_t> Lapidi rimosse
+ */
+Compito<size_t> ContoCorrente::compattaAsync() {
+    size_t rimosse = 0;
+    co_await suPoolIO([this, &rimosse] {
+        rimosse = rimuoviEliminate();
+        compatta();
+        salvaSuFile();
+    });
+    co_return rimosse;
+}
+
+/**
+ * @brief Imposta il formato del file di persistenza
+ * @param f Nuovo formato
+ */
+void ContoCorrente::setFormatoFile(FormatoFile f) {
+    formato = f;
+}
+
+/**
+ * @brief Getter per il formato del file di persistenza
+ * @return FormatoFile Formato corrente
+ */
+FormatoFile ContoCorrente::getFormatoFile() const {
+    return formato;
+}
+
+/**
+ * @brief Imposta i punti di controllo del file dei dati
+ * @param opzioni Regole di inserimento
+ */
+void ContoCorrente::setPuntiDiControllo(const OpzioniControlli& opzioni) {
+    controlli = opzioni;
+}
+
+/**
+ * @brief Restituisce le regole dei punti di controllo
+ * @return const OpzioniControlli& Regole correnti
+ */
+const OpzioniControlli& ContoCorrente::getPuntiDiControllo() const {
+    return controlli;
+}
+
+/**
+ * @brief Verifica il file dei dati
+ * @return RapportoVerifica Esito della verifica
+ * 
+ * Il formato è riconosciuto dalla firma, come in caricaDaFile.
+ */
+RapportoVerifica ContoCorrente::verificaFile() const {
+    ifstream file(nomeFile, ios::binary);
+    if (!file.is_open()) {
+        throw runtime_error("File " + nomeFile + " non trovato");
+    }
+    if (int versioneFormato = FormatoCompresso::riconosci(file)) {
+        return FormatoCompresso::verifica(file, versioneFormato);
+    }
+    stringstream contenuto;
+    contenuto << file.rdbuf();
+    return verificaTesto(contenuto.str());
+}
+
+/**
+ * @brief Attiva o disattiva la modalità ordinata per data
+ * @param attiva true per attivare la modalità
+ * 
+ * All'attivazione tutte le righe vengono trattate come coda e fuse,
+ * il che equivale a un ordinamento stabile dell'intero conto. Se ci sono
+ * istantanee attive la fusione è rimandata: le righe restano in coda.
+ */
+void ContoCorrente::setOrdinatoPerData(bool attiva) {
+    if (attiva == ordinatoPerData) {
+        return;
+    }
+    ordinatoPerData = attiva;
+    righeOrdinate = 0;
+    if (!attiva) {
+        saldiCumulati.clear();
+        saldiCumulati.shrink_to_fit();
+        return;
+    }
+    saldiCumulati.assign(1, 0.0);
+    if (!istantaneeAttive()) {
+        unisciCoda();
+    }
+}
+
+/**
+ * @brief Indica se la modalità ordinata è attiva
+ * @return bool true se attiva
+ */
+bool ContoCorrente::isOrdinatoPerData() const {
+    return ordinatoPerData;
+}
+
 /**
  * @brief Getter per tutte le transazioni
  * @return vector<Transazione> Copia del vettore delle transazioni
  */
 vector<Transazione> ContoCorrente::getTransazioni() const {
-    return transazioni;
+    if (righeEliminate == 0) {
+        return transazioni;
+    }
+    return getTransazioni(istantanea());
+}
+
+/**
+ * @brief Getter per le transazioni visibili nell'istantanea
+ * @param ist Istantanea del conto
+ * @return vector<Transazione> Copia delle prime righe del conto
+ */
+vector<Transazione> ContoCorrente::getTransazioni(const Istantanea& ist) const {
+    verificaIstantanea(ist);
+    vector<Transazione> risultati;
+    risultati.reserve(ist.righe);
+    for (size_t i = 0; i < ist.righe; i++) {
+        if (isVisibile(i, ist.versione)) {
+            risultati.push_back(transazioni[i]);
+        }
+    }
+    return risultati;
 }
 
 /**
@@ -165,7 +1633,7 @@ vector<Transazione> ContoCorrente::getTransazioni() const {
  * @return int Numero totale di transazioni
  */
 int ContoCorrente::getNumeroTransazioni() const {
-    return transazioni.size();
+    return transazioni.size() - righeEliminate;
 }
 
 /**
@@ -175,7 +1643,7 @@ int ContoCorrente::getNumeroTransazioni() const {
  * Data, Importo, Descrizione
  */
 void ContoCorrente::stampaTransazioni() const {
-    if (transazioni.empty()) {
+    if (getNumeroTransazioni() == 0) {
         cout << "Nessuna transazione presente." << endl;
         return;
     }
@@ -185,6 +1653,9 @@ void ContoCorrente::stampaTransazioni() const {
     cout << string(50, '-') << endl;
     
     for (const Transazione& t : transazioni) {
+        if (t.isEliminata()) {
+            continue;
+        }
         cout << setw(12) << t.getData() 
              << setw(15) << fixed << setprecision(2) << t.getImporto() 
              << "  " << t.getDescrizione() << endl;
@@ -199,12 +1670,15 @@ void ContoCorrente::stampaTransazioni() const {
  */
 void ContoCorrente::stampaRiepilogo() const {
     cout << "\n=== RIEPILOGO CONTO ===" << endl;
-    cout << "Numero transazioni: " << transazioni.size() << endl;
+    cout << "Numero transazioni: " << getNumeroTransazioni() << endl;
     cout << "Saldo attuale: " << fixed << setprecision(2) << calcolaSaldo() << " €" << endl;
     
     // Calcola entrate e uscite separate
     double entrate = 0.0, uscite = 0.0;
     for (const Transazione& t : transazioni) {
+        if (t.isEliminata()) {
+            continue;
+        }
         if (t.getImporto() > 0) {
             entrate += t.getImporto();
         } else {
@@ -213,4 +1687,243 @@ void ContoCorrente::stampaRiepilogo() const {
     }
     cout << "Totale entrate: " << entrate << " €" << endl;
     cout << "Totale uscite: " << uscite << " €" << endl;
+}
+
+/**
+ * @brief Raggruppa le transazioni secondo il criterio indicato
+ * @param criterio Criterio di raggruppamento
+ * @return vector<Aggregato> Totali per gruppo ordinati per chiave
+ */
+vector<Aggregato> ContoCorrente::aggrega(Raggruppamento criterio) const {
+    return aggregaTransazioni(transazioni.data(), transazioni.size(), criterio);
+}
+
+/**
+ * @brief Raggruppa le transazioni visibili nell'istantanea
+ * @param criterio Criterio di raggruppamento
+ * @param ist Istantanea del conto
+ * @return vector<Aggregato> Totali per gruppo ordinati per chiave
+ */
+vector<Aggregato> ContoCorrente::aggrega(Raggruppamento criterio, const Istantanea& ist) const {
+    verificaIstantanea(ist);
+    return aggregaTransazioni(transazioni.data(), ist.righe, criterio,
+                              [this, &ist](size_t i) { return isVisibile(i, ist.versione); });
+}
+
+/**
+ * @brief Classifica le righe a partire da una posizione
+ * @param da Prima riga da classificare
+ * 
+ * L'automa è in sola lettura, quindi blocchi diversi di righe possono
+ * essere classificati in parallelo.
+ */
+void ContoCorrente::classificaRighe(size_t da) {
+    if (!classificatore || da >= transazioni.size()) {
+        return;
+    }
+    size_t n = transazioni.size() - da;
+    size_t blocchi = numeroBlocchiParalleli(n, 1 << 14);
+    const Classificatore& regole = *classificatore;
+    eseguiInParallelo(blocchi, [&](size_t b) {
+        size_t fine = da + inizioBlocco(n, blocchi, b + 1);
+        for (size_t i = da + inizioBlocco(n, blocchi, b); i < fine; i++) {
+            transazioni[i].setCategoria(regole.classifica(transazioni[i].getDescrizione()));
+        }
+    });
+}
+
+/**
+ * @brief Imposta e applica le regole di classificazione
+ * @param regole Classificatore da copiare
+ */
+void ContoCorrente::setClassificatore(const Classificatore& regole) {
+    auto compilato = make_shared<Classificatore>(regole);
+    if (!compilato->isCompilato()) {
+        compilato->compila();
+    }
+    classificatore = compilato;
+    classificaRighe(0);
+}
+
+/**
+ * @brief Getter per le regole di classificazione
+ * @return shared_ptr<const Classificatore> Classificatore corrente
+ */
+shared_ptr<const Classificatore> ContoCorrente::getClassificatore() const {
+    return classificatore;
+}
+
+/**
+ * @brief Totali per categoria
+ * @return vector<Aggregato> Aggregati ordinati per nome della categoria
+ */
+vector<Aggregato> ContoCorrente::aggregaPerCategoria() const {
+    return aggregaPerCategoria(istantanea());
+}
+
+/**
+ * @brief Totali per categoria delle righe di un'istantanea
+ * @param ist Istantanea del conto
+ * @return vector<Aggregato> Aggregati ordinati per nome della categoria
+ */
+vector<Aggregato> ContoCorrente::aggregaPerCategoria(const Istantanea& ist) const {
+    verificaIstantanea(ist);
+    static const vector<string> nessuna;
+    return ::aggregaPerCategoria(transazioni.data(), ist.righe, classificatore ? classificatore->getCategorie() : nessuna,
+                                 [this, &ist](size_t i) { return isVisibile(i, ist.versione); });
+}
+
+/**
+ * @brief Memoria occupata dal conto
+ * @return UsoMemoria Ripartizione in byte
+ */
+UsoMemoria ContoCorrente::usoMemoria() const {
+    UsoMemoria uso;
+    uso.righe = transazioni.size() * sizeof(Transazione);
+    uso.capacitaInutilizzata = (transazioni.capacity() - transazioni.size()) * sizeof(Transazione);
+    for (const Transazione& t : transazioni) {
+        uso.testo += memoriaEsterna(t.getDescrizione()) + memoriaEsterna(t.getData());
+    }
+    uso.indici = saldiCumulati.capacity() * sizeof(double) + impronte.getUsoMemoria() +
+                 sketchImporti.getUsoMemoria() + (flusso ? flusso->getUsoMemoria() : 0) +
+                 indiceBlocchi.getUsoMemoria() + posizioniPerId.capacity() * sizeof(size_t) +
+                 (indiceApprossimato ? indiceApprossimato->getUsoMemoria() : 0) +
+                 versioniEliminazione.bucket_count() * sizeof(void*) +
+                 versioniEliminazione.size() * (sizeof(void*) + sizeof(size_t) + sizeof(pair<size_t, uint64_t>));
+    uso.totale = uso.righe + uso.capacitaInutilizzata + uso.testo + uso.indici;
+    return uso;
+}
+
+/**
+ * @brief Rilascia la memoria inutilizzata di vettori e stringhe
+ * 
+ * Le stringhe di capacità superiore alla lunghezza vengono ridotte sul
+ * posto, così le righe conservano identificativo, categoria e lapide (con
+ * istantanee attive le righe eliminate restano nel vettore).
+ */
+void ContoCorrente::compatta() {
+    rimuoviEliminate();
+    for (Transazione& t : transazioni) {
+        if ((memoriaEsterna(t.getDescrizione()) > t.getDescrizione().size() + 1) ||
+            (memoriaEsterna(t.getData()) > t.getData().size() + 1)) {
+            t.compatta();
+        }
+    }
+    transazioni.shrink_to_fit();
+    saldiCumulati.shrink_to_fit();
+}
+
+/**
+ * @brief Rimuove le lapidi dal vettore delle transazioni
+ * @return size_t Righe rimosse
+ * 
+ * La rimozione è stabile, quindi il prefisso ordinato resta ordinato;
+ * saldi cumulati e filtri dei blocchi vengono ricostruiti dalla prima riga
+ * spostata (lo sketch è già stato segnato da ricostruire dalle lapidi).
+ * Con istantanee attive non rimuove nulla.
+ */
+size_t ContoCorrente::rimuoviEliminate() {
+    if (righeEliminate == 0 || istantaneeAttive()) {
+        return 0;
+    }
+    size_t ordinateRimaste = 0;
+    for (size_t i = 0; i < righeOrdinate; i++) {
+        ordinateRimaste += !transazioni[i].isEliminata();
+    }
+    auto primaLapide = find_if(transazioni.begin(), transazioni.end(),
+                               [](const Transazione& t) { return t.isEliminata(); });
+    size_t da = primaLapide - transazioni.begin();
+    transazioni.erase(remove_if(primaLapide, transazioni.end(),
+                                [](const Transazione& t) { return t.isEliminata(); }),
+                      transazioni.end());
+    versioniEliminazione.clear();
+    
+    size_t rimosse = righeEliminate;
+    righeEliminate = 0;
+    if (ordinatoPerData) {
+        righeOrdinate = ordinateRimaste;
+        ricalcolaSaldiCumulati(min(da, righeOrdinate));
+    }
+    indicizzaId(da);
+    indiceBlocchi.invalidaDa(da);
+    aggiornaIndiceBlocchi();
+    return rimosse;
+}
+
+/**
+ * @brief Crea una copia compatta delle transazioni
+ * @return RegistroCompatto Registro compatto
+ */
+RegistroCompatto ContoCorrente::creaRegistroCompatto() const {
+    RegistroCompatto registro = righeEliminate == 0 ? RegistroCompatto(transazioni) : RegistroCompatto(getTransazioni());
+    registro.compatta();
+    return registro;
+}
+
+/**
+ * @brief Abilita il flusso delle nuove transazioni
+ * @param capacita Eventi conservati
+ */
+void ContoCorrente::abilitaFlusso(size_t capacita) {
+    flusso = make_shared<FlussoTransazioni>(capacita);
+}
+
+/**
+ * @brief Riconcilia il conto con un estratto
+ * @param estratto Conto dell'estratto
+ * @param opzioni Opzioni della riconciliazione
+ * @return RapportoRiconciliazione Esito
+ */
+RapportoRiconciliazione ContoCorrente::riconciliaCon(const ContoCorrente& estratto,
+                                                     const OpzioniRiconciliazione& opzioni) const {
+    return riconcilia(righeValide(), estratto.righeValide(), opzioni);
+}
+
+/**
+ * @brief Puntatori alle righe valide
+ * @return vector<const Transazione*> Righe non eliminate
+ */
+vector<const Transazione*> ContoCorrente::righeValide() const {
+    vector<const Transazione*> righe;
+    righe.reserve(transazioni.size() - righeEliminate);
+    for (const Transazione& t : transazioni) {
+        if (!t.isEliminata()) {
+            righe.push_back(&t);
+        }
+    }
+    return righe;
+}
+
+/**
+ * @brief Pubblica il conto in memoria condivisa
+ * @param nome Nome POSIX del segmento
+ * @param capacitaRighe Righe pubblicabili
+ */
+void ContoCorrente::abilitaCondivisione(const string& nome, size_t capacitaRighe) {
+    condiviso.reset();
+    auto pubblicatore = make_shared<PubblicatoreCondiviso>(nome, capacitaRighe);
+    for (const Transazione& t : transazioni) {
+        if (!t.isEliminata() && !pubblicatore->pubblica(t)) {
+            throw runtime_error("Il segmento " + nome + " non può contenere le transazioni attuali");
+        }
+    }
+    condiviso = pubblicatore;
+}
+
+/**
+ * @brief Interrompe la pubblicazione in memoria condivisa
+ */
+void ContoCorrente::disabilitaCondivisione() {
+    condiviso.reset();
+}
+
+/**
+ * @brief Crea una sottoscrizione al flusso
+ * @return Sottoscrizione Nuovo consumatore
+ */
+Sottoscrizione ContoCorrente::sottoscrivi() {
+    if (!flusso) {
+        abilitaFlusso();
+    }
+    return Sottoscrizione(flusso);
 }
\ No newline at end of file
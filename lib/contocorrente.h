@@ -2,11 +2,89 @@
 #define CONTOCORRENTE_H
 
 #include "transazione.h"
+#include "aggregazione.h"
+#include "filtro.h"
+#include "asincrono.h"
+#include "flussotransazioni.h"
+#include "sketchkll.h"
+#include "tabellaimpronte.h"
+#include "registrocompatto.h"
+#include "esportazione.h"
+#include "classificatore.h"
+#include "indiceblocchi.h"
+#include "registrocondiviso.h"
+#include "riconciliazione.h"
+#include "indiceapprossimato.h"
+#include "puntidicontrollo.h"
 #include <vector>
 #include <string>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <cstdint>
 
 using namespace std;
 
+/**
+ * @brief Formato del file di persistenza
+ */
+enum class FormatoFile {
+    Testo,      /**< Una transazione per riga nel formato "descrizione;importo;data" */
+    Compresso   /**< Formato binario a blocchi compressi (vedi FormatoCompresso) */
+};
+
+/**
+ * @brief Esito di un'importazione di transazioni
+ */
+struct RapportoImportazione {
+    int importate = 0;                /**< Transazioni aggiunte al conto */
+    vector<Transazione> scartate;     /**< Transazioni rifiutate perché già presenti */
+    int righeNonValide = 0;           /**< Righe del file che non è stato possibile leggere */
+};
+
+/**
+ * @brief Descrizione trovata dalla ricerca approssimata, con le sue transazioni
+ */
+struct RisultatoApprossimato {
+    string descrizione;               /**< Descrizione trovata */
+    int distanza;                     /**< Somma delle distanze di modifica delle parole cercate */
+    vector<Transazione> transazioni;  /**< Transazioni valide con questa descrizione */
+};
+
+/**
+ * @brief Vista immutabile di un conto in un certo istante
+ *
+ * Contiene solo il numero di righe e la versione del conto al momento della
+ * creazione: non copia le transazioni. Le interrogazioni che ricevono
+ * un'istantanea vedono solo le righe esistenti in quel momento, anche se nel
+ * frattempo ne sono state aggiunte altre. Finché esiste almeno una copia
+ * dell'istantanea il conto rimanda le operazioni che spostano righe già
+ * esistenti (la fusione della coda in modalità ordinata).
+ */
+class Istantanea {
+private:
+    size_t righe = 0;           /**< Righe visibili */
+    uint64_t versione = 0;      /**< Versione del conto alla creazione */
+    shared_ptr<int> token;      /**< Gettone condiviso con il conto che l'ha creata */
+
+    friend class ContoCorrente;
+
+public:
+    /**
+     * @brief Restituisce il numero di righe visibili
+     * @return size_t Numero di transazioni nell'istantanea
+     */
+    size_t getRighe() const { return righe; }
+
+    /**
+     * @brief Restituisce la versione del conto alla creazione
+     * @return uint64_t Versione
+     */
+    uint64_t getVersione() const { return versione; }
+};
+
 /**
  * @brief Classe che gestisce un conto corrente con transazioni
  * 
@@ -18,6 +96,200 @@ class ContoCorrente {
 private:
     vector<Transazione> transazioni;  /**< Lista delle transazioni */
     string nomeFile;                  /**< Nome del file per salvare/caricare i dati */
+    FormatoFile formato;              /**< Formato usato da salvaSuFile */
+    OpzioniControlli controlli;       /**< Punti di controllo scritti da salvaSuFile */
+    bool ordinatoPerData;             /**< true se è attiva la modalità ordinata per data */
+    size_t righeOrdinate;             /**< Lunghezza del prefisso ordinato per data (modalità ordinata) */
+    vector<double> saldiCumulati;     /**< saldiCumulati[i] = somma degli importi delle prime i righe ordinate */
+    shared_ptr<FlussoTransazioni> flusso;  /**< Flusso delle nuove transazioni (nullo se disabilitato) */
+    shared_ptr<PubblicatoreCondiviso> condiviso;  /**< Registro in memoria condivisa (nullo se disabilitato) */
+    mutable SketchKll sketchImporti;  /**< Distribuzione approssimata dei valori assoluti degli importi */
+    mutable bool sketchDaRicostruire; /**< true se lo sketch contiene righe eliminate */
+    unique_ptr<mutex> mutexSketch;    /**< Protegge la ricostruzione dello sketch da parte dei lettori */
+    bool deduplicazione;              /**< true se i duplicati vengono rifiutati */
+    TabellaImpronte impronte;         /**< Occorrenze di ogni impronta (solo in modalità deduplicazione) */
+    uint64_t versione;                /**< Numero di modifiche applicate al conto */
+    shared_ptr<int> tokenIstantanee;  /**< Condiviso con le istantanee: use_count() > 1 se ne esistono */
+    shared_ptr<const Classificatore> classificatore;  /**< Regole delle categorie (nullo se non impostate) */
+    uint64_t prossimoId;              /**< Identificativo da assegnare alla prossima transazione */
+    size_t righeEliminate;            /**< Lapidi presenti in transazioni */
+    uint64_t versioneUltimaEliminazione;  /**< Versione dell'ultima lapide (0 se nessuna) */
+    vector<size_t> posizioniPerId;    /**< posizioniPerId[id] = riga valida con quell'identificativo, o NESSUNA */
+    unordered_map<size_t, uint64_t> versioniEliminazione;  /**< Lapide -> versione che l'ha creata (solo con istantanee attive) */
+    shared_ptr<IndiceApprossimato> indiceApprossimato;  /**< Indice della ricerca approssimata (nullo se disabilitato) */
+
+    /**
+     * @brief Totali materializzati di un mese, in centesimi per restare esatti
+     */
+    struct RiepilogoMese {
+        string mese;           /**< Mese in formato YYYY-MM */
+        long long somma;       /**< Somma degli importi */
+        long long entrate;     /**< Somma degli importi positivi */
+        long long uscite;      /**< Somma degli importi negativi o nulli */
+        int conteggio;         /**< Numero di transazioni */
+    };
+    vector<RiepilogoMese> riepiloghiMesi;  /**< Riepiloghi ordinati per mese */
+    IndiceBlocchi indiceBlocchi;           /**< Filtri di Bloom per blocchi di righe */
+
+    static constexpr size_t SOGLIA_CODA = 64;  /**< Righe fuori ordine accumulate prima di una fusione */
+    static constexpr size_t SOGLIA_LAPIDI = 1024;  /**< Lapidi minime prima di una compattazione automatica */
+    static constexpr size_t NESSUNA = SIZE_MAX;    /**< Posizione di un identificativo senza riga valida */
+
+    /**
+     * @brief Accoda una transazione mantenendo gli invarianti della modalità ordinata
+     * @param t Transazione da accodare
+     * @param id Identificativo da assegnare (0 per assegnarne uno nuovo)
+     */
+    void accoda(const Transazione& t, uint64_t id = 0);
+
+    /**
+     * @brief Cerca la versione valida di una transazione in O(1)
+     * @param id Identificativo della transazione
+     * @return size_t Posizione della riga, oppure transazioni.size() se non esiste
+     */
+    size_t posizioneDi(uint64_t id) const;
+
+    /**
+     * @brief Aggiorna posizioniPerId per le righe valide a partire da una posizione
+     * @param da Prima riga spostata o aggiunta
+     */
+    void indicizzaId(size_t da);
+
+    /**
+     * @brief Assegna gli identificativi alle righe appena caricate
+     * @param da Prima riga caricata
+     * 
+     * In un caricamento completo gli identificativi letti dal file vengono
+     * mantenuti se sono distinti e non troppo sparsi; le righe senza
+     * identificativo (file precedenti) ne ricevono uno nuovo.
+     */
+    void assegnaIdCaricati(size_t da);
+
+    /**
+     * @brief Trasforma una riga in lapide aggiornando indici e riepiloghi
+     * @param posizione Posizione della riga
+     * @param sostituita true se la riga viene sostituita da una nuova versione
+     */
+    void lapida(size_t posizione, bool sostituita = false);
+
+    /**
+     * @brief Verifica se una riga è visibile a una versione del conto
+     * @param posizione Posizione della riga
+     * @param versione Versione dell'istantanea
+     * @return bool true se la riga è valida o è stata eliminata dopo quella versione
+     */
+    bool isVisibile(size_t posizione, uint64_t versione) const;
+
+    /**
+     * @brief Restituisce i puntatori alle righe valide, senza copiarle
+     * @return vector<const Transazione*> Righe valide nell'ordine del conto
+     */
+    vector<const Transazione*> righeValide() const;
+
+    /**
+     * @brief Rimuove fisicamente le lapidi, se nessuna istantanea è attiva
+     * @return size_t Righe rimosse
+     */
+    size_t rimuoviEliminate();
+
+    /**
+     * @brief Righe del prefisso ordinato i cui saldi cumulati valgono per l'istantanea
+     * @param ist Istantanea del conto
+     * @return size_t Come prefissoOrdinato, ma 0 se dopo l'istantanea sono state eliminate righe
+     */
+    size_t prefissoSaldi(const Istantanea& ist) const;
+
+    /**
+     * @brief Fonde la coda non ordinata nel prefisso ordinato
+     *
+     * Ordina la coda e la fonde con la sola parte del prefisso che segue la
+     * data minima della coda, poi aggiorna i saldi cumulati da quel punto.
+     */
+    void unisciCoda();
+
+    /**
+     * @brief Costruisce i filtri dei blocchi completati
+     */
+    void aggiornaIndiceBlocchi();
+
+    /**
+     * @brief Ricalcola i saldi cumulati del prefisso ordinato
+     * @param da Prima riga da cui ricalcolare
+     */
+    void ricalcolaSaldiCumulati(size_t da);
+
+    /**
+     * @brief Registra le impronte delle righe a partire da una posizione
+     * @param da Prima riga da registrare
+     */
+    void registraImpronte(size_t da);
+
+    /**
+     * @brief Indica se esistono istantanee attive
+     * @return bool true se almeno un'istantanea non è stata distrutta
+     */
+    bool istantaneeAttive() const;
+
+    /**
+     * @brief Verifica che un'istantanea appartenga a questo conto
+     * @param ist Istantanea da verificare
+     * @throws std::invalid_argument Se l'istantanea non è di questo conto
+     */
+    void verificaIstantanea(const Istantanea& ist) const;
+
+    /**
+     * @brief Restituisce la parte ordinata delle righe di un'istantanea
+     * @param ist Istantanea (verificata)
+     * @return size_t Numero di righe iniziali ordinate per data
+     */
+    size_t prefissoOrdinato(const Istantanea& ist) const;
+
+    /**
+     * @brief Assegna la categoria alle righe a partire da una posizione
+     * @param da Prima riga da classificare
+     */
+    void classificaRighe(size_t da);
+
+    /**
+     * @brief Aggiorna indici, statistiche e riepiloghi dopo un caricamento da file
+     * @param da Prima riga caricata
+     */
+    void dopoCaricamento(size_t da);
+
+    /**
+     * @brief Aggiunge o toglie una transazione dal riepilogo del suo mese
+     * @param t Transazione
+     * @param segno +1 per aggiungerla, -1 per toglierla
+     */
+    void registraNelMese(const Transazione& t, int segno);
+
+    /**
+     * @brief Restituisce il nome del file dei riepiloghi mensili
+     * @return string Percorso del file accanto al file dei dati
+     */
+    string fileRiepiloghi() const;
+
+    /**
+     * @brief Carica i riepiloghi mensili salvati, se coerenti con le righe caricate
+     * @return bool true se i riepiloghi sono stati caricati
+     */
+    bool caricaRiepiloghi();
+
+    /**
+     * @brief Salva i riepiloghi mensili accanto al file dei dati
+     */
+    void salvaRiepiloghi() const;
+
+    /**
+     * @brief Restituisce il nome del file dei filtri dei blocchi
+     * @return string Percorso del file accanto al file dei dati
+     */
+    string fileIndiceBlocchi() const;
+
+    /**
+     * @brief Salva i filtri dei blocchi accanto al file dei dati
+     */
+    void salvaIndiceBlocchi() const;
 
 public:
     /**
@@ -27,20 +299,153 @@ public:
      * Il costruttore carica automaticamente le transazioni dal file specificato
      */
     ContoCorrente(const string& file = "../data/dati.txt");
+
+    /**
+     * @brief Copia non consentita
+     *
+     * Registro condiviso, flusso, gettone delle istantanee e indice
+     * approssimato sono legati a un solo conto: una copia li condividerebbe
+     * con l'originale (due produttori sullo stesso segmento e sullo stesso
+     * flusso, istantanee valide su entrambi i conti).
+     */
+    ContoCorrente(const ContoCorrente&) = delete;
+
+    /**
+     * @brief Assegnazione per copia non consentita (vedi il costruttore di copia)
+     */
+    ContoCorrente& operator=(const ContoCorrente&) = delete;
+
+    /**
+     * @brief Costruttore di spostamento: il conto di origine non va più usato
+     */
+    ContoCorrente(ContoCorrente&&) = default;
+
+    /**
+     * @brief Assegnazione per spostamento: il conto di origine non va più usato
+     */
+    ContoCorrente& operator=(ContoCorrente&&) = default;
     
     /**
      * @brief Aggiunge una transazione esistente al conto
      * @param t Transazione da aggiungere
+     * @return bool false se la deduplicazione è attiva e la transazione è già presente
      */
-    void aggiungiTransazione(const Transazione& t);
+    bool aggiungiTransazione(const Transazione& t);
     
     /**
      * @brief Aggiunge una nuova transazione al conto
      * @param desc Descrizione della transazione
      * @param importo Importo della transazione (positivo per entrate, negativo per uscite)
      * @param data Data della transazione in formato YYYY-MM-DD
+     * @return bool false se la deduplicazione è attiva e la transazione è già presente
+     */
+    bool aggiungiTransazione(const string& desc, double importo, const string& data);
+    
+    /**
+     * @brief Sostituisce una transazione con una nuova versione
+     * @param id Identificativo della transazione (vedi Transazione::getId)
+     * @param nuova Nuovo contenuto
+     * @return bool false se non esiste una transazione valida con quell'identificativo
+     * 
+     * La versione precedente diventa una lapide e la nuova viene accodata con
+     * lo stesso identificativo: gli inserimenti e le scansioni non pagano
+     * spostamenti di righe e le istantanee già create continuano a vedere la
+     * versione precedente. Saldi, riepiloghi e impronte sono aggiornati subito.
+     */
+    bool modificaTransazione(uint64_t id, const Transazione& nuova);
+    
+    /**
+     * @brief Sostituisce una transazione con una nuova versione
+     * @param id Identificativo della transazione
+     * @param desc Nuova descrizione
+     * @param importo Nuovo importo
+     * @param data Nuova data in formato YYYY-MM-DD
+     * @return bool false se non esiste una transazione valida con quell'identificativo
+     */
+    bool modificaTransazione(uint64_t id, const string& desc, double importo, const string& data);
+    
+    /**
+     * @brief Elimina una transazione
+     * @param id Identificativo della transazione
+     * @return bool false se non esiste una transazione valida con quell'identificativo
+     * 
+     * La riga diventa una lapide, rimossa fisicamente dalla compattazione
+     * (automatica quando le lapidi superano un quarto delle righe). In
+     * modalità ordinata il costo è proporzionale alle righe ordinate che
+     * seguono quella eliminata, per ricalcolarne i saldi cumulati.
+     */
+    bool eliminaTransazione(uint64_t id);
+    
+    /**
+     * @brief Restituisce il numero di lapidi non ancora compattate
+     * @return size_t Righe eliminate o sostituite presenti in memoria
+     */
+    size_t getRigheEliminate() const;
+    
+    /**
+     * @brief Cerca una transazione per identificativo
+     * @param id Identificativo della transazione
+     * @return optional<Transazione> Versione valida della transazione, vuoto se non esiste
+     * 
+     * Gli identificativi sono assegnati in ordine crescente all'inserimento,
+     * salvati nel file e mantenuti dalla modifica: la ricerca usa un indice
+     * diretto e costa O(1) anche dopo fusioni e compattazioni.
+     */
+    optional<Transazione> trova(uint64_t id) const;
+    
+    /**
+     * @brief Importa un insieme di transazioni, ad esempio un estratto conto
+     * @param nuove Transazioni da importare
+     * @return RapportoImportazione Numero di transazioni importate e duplicati scartati
+     * 
+     * Con la deduplicazione attiva l'estratto è confrontato per molteplicità:
+     * la k-esima occorrenza di una transazione viene scartata solo se il conto
+     * ne contiene già almeno k. Così reimportare lo stesso estratto non aggiunge
+     * nulla, ma due spese identiche nello stesso giorno non vengono perse.
+     */
+    RapportoImportazione importa(const vector<Transazione>& nuove);
+    
+    /**
+     * @brief Importa le transazioni di un file (testo o compresso)
+     * @param file Percorso del file da importare
+     * @return RapportoImportazione Esito dell'importazione
+     * @throws std::runtime_error Se il file non esiste o il formato compresso è corrotto
+     */
+    RapportoImportazione importaDaFile(const string& file);
+    
+    /**
+     * @brief Attiva o disattiva la deduplicazione delle transazioni
+     * @param attiva true per rifiutare le transazioni già presenti
+     * 
+     * Due transazioni sono duplicate se hanno la stessa data, lo stesso
+     * importo al centesimo e la stessa descrizione normalizzata. All'attivazione
+     * vengono registrate le impronte delle righe esistenti (duplicati
+     * compresi); il controllo a ogni inserimento costa O(1) ammortizzato.
+     */
+    void setDeduplicazione(bool attiva);
+    
+    /**
+     * @brief Indica se la deduplicazione è attiva
+     * @return bool true se attiva
      */
-    void aggiungiTransazione(const string& desc, double importo, const string& data);
+    bool isDeduplicazione() const;
+    
+    /**
+     * @brief Crea un'istantanea dello stato corrente
+     * @return Istantanea Vista immutabile accettata da tutte le interrogazioni
+     * 
+     * Costa una copia di shared_ptr. Le interrogazioni con l'istantanea
+     * restituiscono sempre gli stessi risultati, qualunque transazione venga
+     * aggiunta nel frattempo; come per il resto della classe, l'accesso
+     * da più thread va sincronizzato esternamente.
+     */
+    Istantanea istantanea() const;
+    
+    /**
+     * @brief Restituisce la versione corrente del conto
+     * @return uint64_t Numero di modifiche applicate (cresce a ogni transazione aggiunta o caricata)
+     */
+    uint64_t getVersione() const;
     
     /**
      * @brief Calcola il saldo totale del conto
@@ -48,6 +453,13 @@ public:
      */
     double calcolaSaldo() const;
     
+    /**
+     * @brief Calcola il saldo all'istante di un'istantanea
+     * @param ist Istantanea del conto
+     * @return double Somma degli importi delle righe visibili
+     */
+    double calcolaSaldo(const Istantanea& ist) const;
+    
     /**
      * @brief Cerca transazioni per data specifica
      * @param data Data da cercare in formato YYYY-MM-DD
@@ -55,6 +467,51 @@ public:
      */
     vector<Transazione> cercaPerData(const string& data) const;
     
+    /**
+     * @brief Cerca transazioni per data in un'istantanea
+     * @param data Data da cercare in formato YYYY-MM-DD
+     * @param ist Istantanea del conto
+     * @return vector<Transazione> Vettore delle transazioni trovate
+     */
+    vector<Transazione> cercaPerData(const string& data, const Istantanea& ist) const;
+    
+    /**
+     * @brief Cerca transazioni in un intervallo di date
+     * @param da Data iniziale inclusa in formato YYYY-MM-DD
+     * @param a Data finale inclusa in formato YYYY-MM-DD
+     * @return vector<Transazione> Vettore delle transazioni trovate
+     * 
+     * In modalità ordinata il risultato è ordinato per data e viene
+     * individuato con una ricerca binaria.
+     */
+    vector<Transazione> cercaPerIntervallo(const string& da, const string& a) const;
+    
+    /**
+     * @brief Cerca transazioni in un intervallo di date in un'istantanea
+     * @param da Data iniziale inclusa in formato YYYY-MM-DD
+     * @param a Data finale inclusa in formato YYYY-MM-DD
+     * @param ist Istantanea del conto
+     * @return vector<Transazione> Vettore delle transazioni trovate
+     */
+    vector<Transazione> cercaPerIntervallo(const string& da, const string& a, const Istantanea& ist) const;
+    
+    /**
+     * @brief Calcola il saldo alla fine di una data
+     * @param data Data in formato YYYY-MM-DD
+     * @return double Somma degli importi delle transazioni con data minore o uguale
+     * 
+     * In modalità ordinata usa una ricerca binaria sui saldi cumulati.
+     */
+    double calcolaSaldoAl(const string& data) const;
+    
+    /**
+     * @brief Calcola il saldo alla fine di una data in un'istantanea
+     * @param data Data in formato YYYY-MM-DD
+     * @param ist Istantanea del conto
+     * @return double Somma degli importi delle righe visibili fino alla data
+     */
+    double calcolaSaldoAl(const string& data, const Istantanea& ist) const;
+    
     /**
      * @brief Cerca transazioni per parola chiave nella descrizione
      * @param parola Parola chiave da cercare
@@ -64,31 +521,317 @@ public:
      */
     vector<Transazione> cercaPerParolaChiave(const string& parola) const;
     
+    /**
+     * @brief Cerca transazioni per parola chiave in un'istantanea
+     * @param parola Parola chiave da cercare
+     * @param ist Istantanea del conto
+     * @return vector<Transazione> Vettore delle transazioni che contengono la parola
+     */
+    vector<Transazione> cercaPerParolaChiave(const string& parola, const Istantanea& ist) const;
+    
+    /**
+     * @brief Attiva o disattiva l'indice della ricerca approssimata
+     * @param attiva true per costruire l'indice e mantenerlo a ogni inserimento
+     * 
+     * L'indice contiene le descrizioni e le parole distinte (vedi
+     * IndiceApprossimato) e gli identificativi delle transazioni di ogni
+     * descrizione. cercaApprossimata richiede l'indice attivo: costruirlo a
+     * ogni chiamata costerebbe quanto una scansione completa del conto.
+     */
+    void setRicercaApprossimata(bool attiva);
+    
+    /**
+     * @brief Indica se l'indice della ricerca approssimata è attivo
+     * @return bool true se attivo
+     */
+    bool isRicercaApprossimata() const;
+    
+    /**
+     * @brief Cerca le descrizioni simili a un testo, tollerando errori di battitura
+     * @param testo Una o più parole, ad esempio "amazn" o "eneI"
+     * @param maxRisultati Numero massimo di descrizioni restituite
+     * @param maxDistanza Distanza di modifica massima per parola (negativa = 0 fino
+     *        a 2 byte, 1 fino a 5, altrimenti 2)
+     * @return vector<RisultatoApprossimato> Descrizioni ordinate per distanza e, a
+     *         parità, per numero di transazioni decrescente
+     * @throws std::runtime_error Se la ricerca approssimata non è attiva (setRicercaApprossimata)
+     * 
+     * Ogni parola cercata deve corrispondere ad almeno una parola della
+     * descrizione; il confronto non distingue maiuscole e minuscole. Le
+     * descrizioni senza transazioni valide non vengono restituite.
+     */
+    vector<RisultatoApprossimato> cercaApprossimata(const string& testo, size_t maxRisultati = 10,
+                                                    int maxDistanza = -1) const;
+    
+    /**
+     * @brief Visita le transazioni che soddisfano un filtro
+     * @param filtro Condizioni da soddisfare (in AND)
+     * @param visita Funzione chiamata per ogni transazione accettata
+     * 
+     * Se il filtro limita le date e la modalità ordinata è attiva, visita solo
+     * il tratto individuato con ricerca binaria più la coda non ordinata;
+     * altrimenti scansiona tutte le righe. Le condizioni restanti sono valutate
+     * in un unico passaggio, senza risultati intermedi. Le transazioni sono
+     * visitate nell'ordine in cui sono memorizzate.
+     */
+    void perOgni(const Filtro& filtro, const function<void(const Transazione&)>& visita) const;
+    
+    /**
+     * @brief Visita le transazioni di un'istantanea che soddisfano un filtro
+     * @param filtro Condizioni da soddisfare (in AND)
+     * @param visita Funzione chiamata per ogni transazione accettata
+     * @param ist Istantanea del conto
+     */
+    void perOgni(const Filtro& filtro, const function<void(const Transazione&)>& visita,
+                 const Istantanea& ist) const;
+    
+    /**
+     * @brief Cerca le transazioni che soddisfano un filtro
+     * @param filtro Condizioni da soddisfare (in AND)
+     * @return vector<Transazione> Vettore delle transazioni trovate
+     */
+    vector<Transazione> cerca(const Filtro& filtro) const;
+    
+    /**
+     * @brief Cerca le transazioni di un'istantanea che soddisfano un filtro
+     * @param filtro Condizioni da soddisfare (in AND)
+     * @param ist Istantanea del conto
+     * @return vector<Transazione> Vettore delle transazioni trovate
+     */
+    vector<Transazione> cerca(const Filtro& filtro, const Istantanea& ist) const;
+    
+    /**
+     * @brief Conta le transazioni che soddisfano un filtro
+     * @param filtro Condizioni da soddisfare (in AND)
+     * @return int Numero di transazioni trovate
+     */
+    int conta(const Filtro& filtro) const;
+    
+    /**
+     * @brief Conta le transazioni di un'istantanea che soddisfano un filtro
+     * @param filtro Condizioni da soddisfare (in AND)
+     * @param ist Istantanea del conto
+     * @return int Numero di transazioni trovate
+     */
+    int conta(const Filtro& filtro, const Istantanea& ist) const;
+    
+    /**
+     * @brief Restituisce le k uscite più grandi in valore assoluto
+     * @param k Numero massimo di transazioni da restituire
+     * @param filtro Condizioni aggiuntive (ad esempio un intervallo di date)
+     * @return vector<Transazione> Uscite ordinate dalla più grande
+     * 
+     * Mantiene un heap di k elementi durante un'unica visita con perOgni:
+     * O(n log k) senza ordinare né copiare l'intero conto.
+     */
+    vector<Transazione> topUscite(size_t k, const Filtro& filtro = Filtro()) const;
+    
+    /**
+     * @brief Restituisce le k uscite più grandi di un'istantanea
+     * @param k Numero massimo di transazioni da restituire
+     * @param filtro Condizioni aggiuntive
+     * @param ist Istantanea del conto
+     * @return vector<Transazione> Uscite ordinate dalla più grande
+     */
+    vector<Transazione> topUscite(size_t k, const Filtro& filtro, const Istantanea& ist) const;
+    
+    /**
+     * @brief Restituisce le k entrate più grandi
+     * @param k Numero massimo di transazioni da restituire
+     * @param filtro Condizioni aggiuntive (ad esempio un intervallo di date)
+     * @return vector<Transazione> Entrate ordinate dalla più grande
+     */
+    vector<Transazione> topEntrate(size_t k, const Filtro& filtro = Filtro()) const;
+    
+    /**
+     * @brief Restituisce le k entrate più grandi di un'istantanea
+     * @param k Numero massimo di transazioni da restituire
+     * @param filtro Condizioni aggiuntive
+     * @param ist Istantanea del conto
+     * @return vector<Transazione> Entrate ordinate dalla più grande
+     */
+    vector<Transazione> topEntrate(size_t k, const Filtro& filtro, const Istantanea& ist) const;
+    
+    /**
+     * @brief Stima un quantile dei valori assoluti degli importi
+     * @param q Quantile in [0, 1] (0.5 = mediana, 0.99 = 99° percentile)
+     * @return double Valore stimato (0 se il conto è vuoto)
+     * 
+     * Usa uno sketch KLL aggiornato a ogni inserimento: la risposta è
+     * immediata e l'errore di rango è di circa l'1%. Lo sketch riflette
+     * sempre lo stato corrente; per un'istantanea usare la variante con filtro.
+     * Dopo modifiche o eliminazioni la prima chiamata ricostruisce lo sketch
+     * dalle righe valide (O(n)). La ricostruzione avviene sotto un mutex
+     * proprio dello sketch, quindi più lettori possono chiamarla insieme;
+     * come le altre letture non va chiamata in concorrenza con una scrittura.
+     */
+    double quantileImporti(double q) const;
+    
+    /**
+     * @brief Calcola un quantile dei valori assoluti degli importi filtrati
+     * @param q Quantile in [0, 1]
+     * @param filtro Condizioni da soddisfare (ad esempio un intervallo di date)
+     * @return double Valore esatto (0 se nessuna transazione è accettata)
+     * 
+     * Raccoglie solo gli importi accettati e seleziona il quantile con
+     * nth_element in tempo lineare, senza ordinamento completo.
+     */
+    double quantileImporti(double q, const Filtro& filtro) const;
+    
+    /**
+     * @brief Calcola un quantile esatto sulle transazioni filtrate di un'istantanea
+     * @param q Quantile in [0, 1]
+     * @param filtro Condizioni da soddisfare
+     * @param ist Istantanea del conto
+     * @return double Valore esatto (0 se nessuna transazione è accettata)
+     */
+    double quantileImporti(double q, const Filtro& filtro, const Istantanea& ist) const;
+    
     /**
      * @brief Carica le transazioni dal file
      * 
      * Legge le transazioni dal file specificato nel costruttore.
      * Se il file non esiste, non fa nulla e stampa un messaggio informativo.
+     * Il formato (testo o compresso) viene riconosciuto automaticamente e
+     * diventa il formato usato dai salvataggi successivi.
      */
     void caricaDaFile();
     
     /**
      * @brief Salva le transazioni su file
      * 
-     * Salva tutte le transazioni nel file specificato nel costruttore.
-     * Crea la directory se non esiste.
+     * Salva tutte le transazioni nel file specificato nel costruttore
+     * usando il formato corrente. Crea la directory se non esiste.
      */
     void salvaSuFile() const;
     
+    /**
+     * @brief Esporta le transazioni che soddisfano un filtro
+     * @param out Stream di destinazione (in modalità binaria per il formato colonnare)
+     * @param formato CSV, JSON Lines o colonnare
+     * @param filtro Condizioni da soddisfare (default: tutte le transazioni)
+     * @return size_t Numero di transazioni esportate
+     * @throws std::invalid_argument Nel formato colonnare, se una data non è nel formato YYYY-MM-DD
+     * 
+     * Le righe sono visitate con perOgni e passate all'Esportatore per
+     * riferimento: nessuna copia delle transazioni, memoria limitata a un lotto.
+     */
+    size_t esporta(ostream& out, FormatoEsportazione formato, const Filtro& filtro = Filtro()) const;
+    
+    /**
+     * @brief Esporta su file le transazioni che soddisfano un filtro
+     * @param file Percorso del file da creare
+     * @param formato CSV, JSON Lines o colonnare
+     * @param filtro Condizioni da soddisfare (default: tutte le transazioni)
+     * @return size_t Numero di transazioni esportate
+     * @throws std::runtime_error Se il file non può essere creato
+     */
+    size_t esportaSuFile(const string& file, FormatoEsportazione formato, const Filtro& filtro = Filtro()) const;
+    
+    /**
+     * @brief Variante asincrona di caricaDaFile
+     * @return Compito<int> Coroutine che produce il numero di transazioni caricate
+     * 
+     * La lettura del file avviene su un thread del pool di I/O condiviso;
+     * nel frattempo il conto non va usato da altri thread. Più conti possono
+     * essere caricati in parallelo con attendiTutti.
+     */
+    Compito<int> caricaAsync();
+    
+    /**
+     * @brief Variante asincrona di salvaSuFile
+     * @return Compito<void> Coroutine che termina a salvataggio completato
+     * 
+     * La scrittura del file avviene su un thread del pool di I/O condiviso;
+     * nel frattempo il conto non va modificato.
+     */
+    Compito<void> salvaAsync() const;
+    
+    /**
+     * @brief Compatta il conto e riscrive il file su un thread del pool di I/O
+     * @return Compito<size_t> Lapidi rimosse dalla memoria
+     * 
+     * Rimuove le lapidi (se nessuna istantanea è attiva), rilascia la
+     * memoria inutilizzata e salva il file senza le righe eliminate;
+     * nel frattempo il conto non va usato.
+     */
+    Compito<size_t> compattaAsync();
+    
+    /**
+     * @brief Imposta il formato usato per il salvataggio
+     * @param f Nuovo formato del file
+     */
+    void setFormatoFile(FormatoFile f);
+    
+    /**
+     * @brief Restituisce il formato usato per il salvataggio
+     * @return FormatoFile Formato corrente
+     */
+    FormatoFile getFormatoFile() const;
+    
+    /**
+     * @brief Imposta i punti di controllo scritti nel file dei dati
+     * @param opzioni Ogni quante righe e/o a ogni nuovo mese (default: nessuno)
+     * 
+     * Ogni punto registra numero di righe, saldo e impronta concatenata di
+     * tutte le righe precedenti; vale per entrambi i formati del file.
+     */
+    void setPuntiDiControllo(const OpzioniControlli& opzioni);
+    
+    /**
+     * @brief Restituisce le regole dei punti di controllo
+     * @return const OpzioniControlli& Regole correnti
+     */
+    const OpzioniControlli& getPuntiDiControllo() const;
+    
+    /**
+     * @brief Verifica il file dei dati con i suoi punti di controllo
+     * @return RapportoVerifica Tratti integri e corrotti, saldo dell'ultimo punto
+     * @throws std::runtime_error Se il file non esiste
+     * 
+     * Non ricarica il conto: legge il file e ricalcola in parallelo ogni tratto
+     * tra due punti di controllo, quindi una corruzione viene localizzata nel
+     * tratto che la contiene. Le righe dopo l'ultimo punto non sono verificabili.
+     */
+    RapportoVerifica verificaFile() const;
+    
+    /**
+     * @brief Attiva o disattiva la modalità ordinata per data
+     * @param attiva true per mantenere le transazioni ordinate per data
+     * 
+     * Quando la modalità viene attivata le transazioni esistenti vengono
+     * ordinate (in modo stabile). Gli inserimenti in ordine di data restano
+     * O(1) ammortizzato; quelli fuori ordine finiscono in una piccola coda
+     * che viene fusa periodicamente. Ricerche per data, per intervallo e
+     * saldo a una data diventano ricerche binarie.
+     */
+    void setOrdinatoPerData(bool attiva);
+    
+    /**
+     * @brief Indica se la modalità ordinata per data è attiva
+     * @return bool true se attiva
+     */
+    bool isOrdinatoPerData() const;
+    
     /**
      * @brief Restituisce tutte le transazioni
      * @return vector<Transazione> Copia del vettore delle transazioni
+     * 
+     * In modalità ordinata le transazioni sono ordinate per data, a meno
+     * delle righe fuori ordine ancora in coda in fondo al vettore.
      */
     vector<Transazione> getTransazioni() const;
     
+    /**
+     * @brief Restituisce le transazioni visibili in un'istantanea
+     * @param ist Istantanea del conto
+     * @return vector<Transazione> Copia delle righe esistenti alla creazione dell'istantanea
+     */
+    vector<Transazione> getTransazioni(const Istantanea& ist) const;
+    
     /**
      * @brief Restituisce il numero di transazioni
-     * @return int Numero totale di transazioni
+     * @return int Numero di transazioni valide (lapidi escluse)
      */
     int getNumeroTransazioni() const;
     
@@ -106,6 +849,162 @@ public:
      * Mostra: numero transazioni, saldo attuale, totale entrate, totale uscite
      */
     void stampaRiepilogo() const;
+    
+    /**
+     * @brief Raggruppa le transazioni e calcola i totali per gruppo
+     * @param criterio Raggruppamento per giorno, mese, anno o descrizione normalizzata
+     * @return vector<Aggregato> Somma, conteggio, entrate e uscite per gruppo, ordinati per chiave
+     * 
+     * Lavora direttamente sulle righe del conto senza copiarle; sui conti
+     * grandi i totali parziali sono calcolati in parallelo.
+     */
+    vector<Aggregato> aggrega(Raggruppamento criterio) const;
+    
+    /**
+     * @brief Raggruppa le transazioni di un'istantanea
+     * @param criterio Raggruppamento per giorno, mese, anno o descrizione normalizzata
+     * @param ist Istantanea del conto
+     * @return vector<Aggregato> Totali per gruppo, ordinati per chiave
+     */
+    vector<Aggregato> aggrega(Raggruppamento criterio, const Istantanea& ist) const;
+    
+    /**
+     * @brief Restituisce i riepiloghi materializzati di ogni mese
+     * @return vector<Aggregato> Un aggregato per mese (chiave YYYY-MM), ordinati per mese
+     * 
+     * I riepiloghi sono aggiornati a ogni inserimento e salvati accanto al
+     * file dei dati (file con estensione aggiuntiva ".mesi"), quindi non
+     * richiedono una scansione delle righe. Gli importi sono arrotondati al
+     * centesimo. Riflettono sempre lo stato corrente, non le istantanee.
+     */
+    vector<Aggregato> riepiloghiMensili() const;
+    
+    /**
+     * @brief Somma i riepiloghi di un intervallo di mesi
+     * @param daMese Primo mese incluso (YYYY-MM)
+     * @param aMese Ultimo mese incluso (YYYY-MM)
+     * @return Aggregato Totali del periodo (chiave "daMese..aMese")
+     * 
+     * Costa O(mesi) indipendentemente dal numero di transazioni.
+     */
+    Aggregato riepilogoPeriodo(const string& daMese, const string& aMese) const;
+    
+    /**
+     * @brief Imposta le regole di classificazione in categorie
+     * @param regole Classificatore con le regole (viene copiato e compilato)
+     * 
+     * Tutte le righe esistenti vengono classificate (in parallelo sui conti
+     * grandi) e la categoria viene memorizzata nella riga; da quel momento
+     * ogni transazione aggiunta o caricata viene classificata all'inserimento.
+     */
+    void setClassificatore(const Classificatore& regole);
+    
+    /**
+     * @brief Restituisce le regole di classificazione correnti
+     * @return shared_ptr<const Classificatore> Classificatore (nullo se non impostato)
+     * 
+     * Serve a tradurre Transazione::getCategoria nel nome della categoria.
+     */
+    shared_ptr<const Classificatore> getClassificatore() const;
+    
+    /**
+     * @brief Calcola i totali per categoria
+     * @return vector<Aggregato> Un aggregato per categoria presente, ordinati per nome
+     * 
+     * Usa le categorie già memorizzate nelle righe, senza rieseguire le regole.
+     * Le righe non classificate sono raccolte nel gruppo con chiave vuota.
+     */
+    vector<Aggregato> aggregaPerCategoria() const;
+    
+    /**
+     * @brief Calcola i totali per categoria delle righe di un'istantanea
+     * @param ist Istantanea del conto
+     * @return vector<Aggregato> Un aggregato per categoria presente, ordinati per nome
+     */
+    vector<Aggregato> aggregaPerCategoria(const Istantanea& ist) const;
+    
+    /**
+     * @brief Restituisce la memoria occupata dal conto
+     * @return UsoMemoria Ripartizione in byte tra righe, capacità inutilizzata, testo e indici
+     * 
+     * Ogni Transazione occupa sizeof(Transazione) byte più il testo delle
+     * stringhe che non rientrano nel buffer interno; la crescita per
+     * raddoppio del vettore lascia in genere capacità inutilizzata.
+     */
+    UsoMemoria usoMemoria() const;
+    
+    /**
+     * @brief Rilascia la memoria inutilizzata
+     * 
+     * Riduce la capacità dei vettori al numero di righe e quella delle
+     * stringhe alla loro lunghezza. Utile dopo un caricamento o
+     * un'importazione di grandi dimensioni. Se nessuna istantanea è attiva
+     * rimuove anche le lapidi lasciate da modifiche ed eliminazioni.
+     */
+    void compatta();
+    
+    /**
+     * @brief Crea una copia compatta delle transazioni
+     * @return RegistroCompatto Registro con righe da 16 byte e descrizioni deduplicate
+     * @throws std::invalid_argument Se una data non è nel formato YYYY-MM-DD
+     */
+    RegistroCompatto creaRegistroCompatto() const;
+    
+    /**
+     * @brief Riconcilia il conto con un estratto bancario
+     * @param estratto Conto che contiene le righe dell'estratto
+     * @param opzioni Finestra di date, soglia di similarità e parallelismo
+     * @return RapportoRiconciliazione Righe abbinate, discordanti e mancanti
+     * @throws std::invalid_argument Se una data non è nel formato YYYY-MM-DD
+     * 
+     * Considera le transazioni valide di entrambi i conti (vedi riconcilia),
+     * lette sul posto: solo le righe riportate nel rapporto vengono copiate.
+     */
+    RapportoRiconciliazione riconciliaCon(const ContoCorrente& estratto,
+                                          const OpzioniRiconciliazione& opzioni = OpzioniRiconciliazione()) const;
+    
+    /**
+     * @brief Abilita la pubblicazione delle nuove transazioni ai sottoscrittori
+     * @param capacita Eventi conservati per i consumatori lenti (arrotondati a potenza di 2)
+     * 
+     * Da quel momento ogni inserimento, modifica o eliminazione pubblica un
+     * evento (con identificativo e tipo di operazione) in un buffer circolare
+     * lock-free; la pubblicazione non attende mai i consumatori.
+     * Richiamarlo sostituisce il flusso: le sottoscrizioni esistenti non
+     * riceveranno più eventi.
+     */
+    void abilitaFlusso(size_t capacita = 4096);
+    
+    /**
+     * @brief Crea una sottoscrizione alle transazioni aggiunte da ora in poi
+     * @return Sottoscrizione Consumatore con il proprio cursore
+     * 
+     * Se il flusso non è abilitato lo abilita con la capacità predefinita.
+     * Le transazioni caricate da file non vengono pubblicate.
+     */
+    Sottoscrizione sottoscrivi();
+    
+    /**
+     * @brief Pubblica il conto in memoria condivisa per i lettori di altri processi
+     * @param nome Nome POSIX del segmento, ad esempio "/conto"
+     * @param capacitaRighe Righe pubblicabili, comprese le versioni eliminate o modificate
+     * @throws std::invalid_argument Se il nome o la capacità non sono validi
+     * @throws std::runtime_error Se il segmento non può essere creato o le righe attuali
+     *         non ci stanno o hanno date non nel formato YYYY-MM-DD
+     * 
+     * Le transazioni valide vengono pubblicate subito; da quel momento
+     * inserimenti, modifiche ed eliminazioni sono riportati nel segmento,
+     * che i processi lettori interrogano con LettoreCondiviso senza caricare
+     * il file. Se il segmento si riempie, o arriva una riga con una data non
+     * rappresentabile, la pubblicazione si interrompe (il conto registra
+     * comunque la riga) e i lettori vedono il registro come non più attivo.
+     */
+    void abilitaCondivisione(const string& nome, size_t capacitaRighe);
+    
+    /**
+     * @brief Interrompe la pubblicazione in memoria condivisa e rimuove il segmento
+     */
+    void disabilitaCondivisione();
 };
 
 #endif // CONTOCORRENTE_H
\ No newline at end of file
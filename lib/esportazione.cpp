@@ -0,0 +1,295 @@
+#include "esportazione.h"
+#include "parallelo.h"
+#include "utilita.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <exception>
+#include <stdexcept>
+
+using namespace std;
+
+static const char FIRMA_COLONNARE[4] = {'C', 'C', 'C', '1'};
+static const size_t MINIMO_PER_BLOCCO = 4096;  /**< Righe minime per formattare un blocco su un thread */
+
+/**
+ * @brief Accoda un importo con due cifre decimali (come Transazione::toString)
+ */
+static void scriviImporto(string& out, double importo) {
+    char buffer[64];
+    auto risultato = to_chars(buffer, buffer + sizeof(buffer), importo, chars_format::fixed, 2);
+    out.append(buffer, risultato.ptr);
+}
+
+/**
+ * @brief Accoda un campo CSV, tra virgolette solo se necessario
+ *
+ * Secondo RFC 4180 un campo che contiene virgole, virgolette o a capo va
+ * racchiuso tra virgolette raddoppiando quelle interne.
+ */
+static void scriviCampoCsv(string& out, const string& campo) {
+    if (campo.find_first_of(",\"\r\n") == string::npos) {
+        out += campo;
+        return;
+    }
+    out.push_back('"');
+    for (char c : campo) {
+        if (c == '"') {
+            out.push_back('"');
+        }
+        out.push_back(c);
+    }
+    out.push_back('"');
+}
+
+/**
+ * @brief Accoda una stringa JSON con i caratteri di controllo e le virgolette in escape
+ *
+ * I byte UTF-8 non ASCII vengono copiati così come sono.
+ */
+static void scriviStringaJson(string& out, const string& testo) {
+    static const char esadecimali[] = "0123456789abcdef";
+    out.push_back('"');
+    for (char c : testo) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (byte < 0x20) {
+                    out += "\\u00";
+                    out.push_back(esadecimali[byte >> 4]);
+                    out.push_back(esadecimali[byte & 0xF]);
+                } else {
+                    out.push_back(c);
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+/**
+ * @brief Accoda un intero in little endian
+ */
+template <typename T>
+static void scriviIntero(string& out, T valore) {
+    uint64_t bit = static_cast<uint64_t>(valore);
+    for (size_t i = 0; i < sizeof(T); i++) {
+        out.push_back(static_cast<char>((bit >> (8 * i)) & 0xFF));
+    }
+}
+
+/**
+ * @brief Legge un intero little endian da un buffer
+ */
+template <typename T>
+static T leggiIntero(const char* dati) {
+    uint64_t bit = 0;
+    for (size_t i = 0; i < sizeof(T); i++) {
+        bit |= static_cast<uint64_t>(static_cast<unsigned char>(dati[i])) << (8 * i);
+    }
+    return static_cast<T>(bit);
+}
+
+/**
+ * @brief Formatta un blocco di righe nel formato indicato
+ * @param righe Puntatori alle transazioni del blocco
+ * @param n Numero di righe
+ * @param formato Formato di esportazione
+ * @param out Buffer in cui scrivere
+ *
+ * Nel formato colonnare il blocco diventa un gruppo di righe completo.
+ */
+static void formattaBlocco(const Transazione* const* righe, size_t n, FormatoEsportazione formato, string& out) {
+    if (formato == FormatoEsportazione::Colonnare) {
+        size_t testo = 0;
+        for (size_t i = 0; i < n; i++) {
+            testo += righe[i]->getDescrizione().size();
+        }
+        out.reserve(4 + n * 16 + testo);
+        scriviIntero<uint32_t>(out, n);
+        for (size_t i = 0; i < n; i++) {
+            scriviIntero<int32_t>(out, dataInGiorni(righe[i]->getData()));
+        }
+        for (size_t i = 0; i < n; i++) {
+            scriviIntero<int64_t>(out, importoInCentesimi(righe[i]->getImporto()));
+        }
+        for (size_t i = 0; i < n; i++) {
+            scriviIntero<uint32_t>(out, righe[i]->getDescrizione().size());
+        }
+        for (size_t i = 0; i < n; i++) {
+            out += righe[i]->getDescrizione();
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        const Transazione& t = *righe[i];
+        if (formato == FormatoEsportazione::Csv) {
+            scriviCampoCsv(out, t.getData());
+            out.push_back(',');
+            scriviImporto(out, t.getImporto());
+            out.push_back(',');
+            scriviCampoCsv(out, t.getDescrizione());
+            out += "\r\n";
+        } else {
+            out += "{\"data\":";
+            scriviStringaJson(out, t.getData());
+            out += ",\"importo\":";
+            scriviImporto(out, t.getImporto());
+            out += ",\"descrizione\":";
+            scriviStringaJson(out, t.getDescrizione());
+            out += "}\n";
+        }
+    }
+}
+
+/**
+ * @brief Costruttore: scrive l'intestazione del formato
+ * @param destinazione Stream di output
+ * @param f Formato di esportazione
+ */
+Esportatore::Esportatore(ostream& destinazione, FormatoEsportazione f)
+    : out(destinazione), formato(f), righe(0), terminato(false) {
+    lotto.reserve(RIGHE_PER_LOTTO);
+    if (formato == FormatoEsportazione::Csv) {
+        out << "data,importo,descrizione\r\n";
+    } else if (formato == FormatoEsportazione::Colonnare) {
+        out.write(FIRMA_COLONNARE, 4);
+    }
+}
+
+/**
+ * @brief Accoda una transazione e svuota il lotto quando è pieno
+ * @param t Transazione da esportare
+ */
+void Esportatore::aggiungi(const Transazione& t) {
+    lotto.push_back(&t);
+    righe++;
+    if (lotto.size() == RIGHE_PER_LOTTO) {
+        svuotaLotto();
+    }
+}
+
+/**
+ * @brief Formatta il lotto in blocchi paralleli e li scrive in ordine
+ *
+ * Le eccezioni dei thread (date non valide nel formato colonnare) vengono
+ * raccolte e rilanciate dal thread chiamante.
+ */
+void Esportatore::svuotaLotto() {
+    if (lotto.empty()) {
+        return;
+    }
+    size_t n = lotto.size();
+    size_t blocchi = numeroBlocchiParalleli(n, MINIMO_PER_BLOCCO);
+    vector<string> pezzi(blocchi);
+    vector<exception_ptr> errori(blocchi);
+    eseguiInParallelo(blocchi, [&](size_t b) {
+        size_t inizio = inizioBlocco(n, blocchi, b);
+        size_t fine = inizioBlocco(n, blocchi, b + 1);
+        try {
+            formattaBlocco(lotto.data() + inizio, fine - inizio, formato, pezzi[b]);
+        } catch (...) {
+            errori[b] = current_exception();
+        }
+    });
+    lotto.clear();
+    for (const exception_ptr& errore : errori) {
+        if (errore) {
+            rethrow_exception(errore);
+        }
+    }
+    for (const string& pezzo : pezzi) {
+        out.write(pezzo.data(), pezzo.size());
+    }
+}
+
+/**
+ * @brief Scrive le righe rimaste e il gruppo vuoto finale del formato colonnare
+ */
+void Esportatore::termina() {
+    if (terminato) {
+        return;
+    }
+    terminato = true;
+    svuotaLotto();
+    if (formato == FormatoEsportazione::Colonnare) {
+        string fine;
+        scriviIntero<uint32_t>(fine, 0);
+        out.write(fine.data(), fine.size());
+    }
+    out.flush();
+}
+
+/**
+ * @brief Getter per il numero di righe esportate
+ * @return size_t Righe accodate
+ */
+size_t Esportatore::getRighe() const {
+    return righe;
+}
+
+/**
+ * @brief Legge un file colonnare gruppo per gruppo
+ * @param in Stream di input
+ * @return vector<Transazione> Transazioni lette
+ */
+vector<Transazione> Esportatore::leggiColonnare(istream& in) {
+    char firma[4];
+    in.read(firma, 4);
+    if (in.gcount() != 4 || !equal(firma, firma + 4, FIRMA_COLONNARE)) {
+        throw runtime_error("File colonnare non valido: firma mancante");
+    }
+
+    vector<Transazione> risultati;
+    string dati;
+    // Le lunghezze lette dal file sono confrontate con i byte rimasti prima
+    // di allocare: un file corrotto non può far riservare gigabyte
+    uint64_t restanti = byteRestanti(in);
+    while (true) {
+        char intestazione[4];
+        in.read(intestazione, 4);
+        if (in.gcount() != 4) {
+            throw runtime_error("File colonnare troncato");
+        }
+        restanti -= min<uint64_t>(restanti, 4);
+        uint32_t n = leggiIntero<uint32_t>(intestazione);
+        if (n == 0) {
+            return risultati;
+        }
+        if (static_cast<uint64_t>(n) * 16 > restanti) {
+            throw runtime_error("File colonnare troncato");
+        }
+        restanti -= static_cast<uint64_t>(n) * 16;
+
+        dati.resize(static_cast<size_t>(n) * 16);
+        in.read(&dati[0], dati.size());
+        if (static_cast<size_t>(in.gcount()) != dati.size()) {
+            throw runtime_error("File colonnare troncato");
+        }
+        const char* giorni = dati.data();
+        const char* centesimi = giorni + n * 4;
+        const char* lunghezze = centesimi + n * 8;
+
+        risultati.reserve(risultati.size() + n);
+        string descrizione;
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t lunghezza = leggiIntero<uint32_t>(lunghezze + i * 4);
+            if (lunghezza > restanti) {
+                throw runtime_error("File colonnare troncato");
+            }
+            restanti -= lunghezza;
+            descrizione.resize(lunghezza);
+            in.read(&descrizione[0], descrizione.size());
+            if (static_cast<size_t>(in.gcount()) != descrizione.size()) {
+                throw runtime_error("File colonnare troncato");
+            }
+            risultati.emplace_back(descrizione, leggiIntero<int64_t>(centesimi + i * 8) / 100.0,
+                                   giorniInData(leggiIntero<int32_t>(giorni + i * 4)));
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef ESPORTAZIONE_H
+#define ESPORTAZIONE_H
+
+#include "transazione.h"
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Formato di esportazione delle transazioni
+ */
+enum class FormatoEsportazione {
+    Csv,        /**< CSV con intestazione "data,importo,descrizione" e virgolette RFC 4180 */
+    JsonLines,  /**< Un oggetto JSON per riga: {"data":...,"importo":...,"descrizione":...} */
+    Colonnare   /**< Formato binario a colonne "CCC1" (vedi Esportatore) */
+};
+
+/**
+ * @brief Scrive transazioni su uno stream in uno dei formati di esportazione
+ *
+ * Le transazioni vengono raccolte per puntatore in lotti di al massimo
+ * RIGHE_PER_LOTTO righe; ogni lotto pieno viene diviso in blocchi formattati
+ * in parallelo e scritti nell'ordine originale. La memoria usata è quindi
+ * limitata dalla dimensione del lotto e non dal numero di righe esportate.
+ *
+ * Il formato colonnare inizia con la firma "CCC1" ed è una sequenza di
+ * gruppi di righe, terminata da un gruppo vuoto. Ogni gruppo contiene (little
+ * endian) il numero di righe n, poi n date in giorni dal 1970-01-01 (int32),
+ * n importi in centesimi (int64), n lunghezze delle descrizioni (uint32) e
+ * infine il testo delle descrizioni concatenato.
+ */
+class Esportatore {
+private:
+    ostream& out;                      /**< Stream di destinazione */
+    FormatoEsportazione formato;       /**< Formato delle righe */
+    vector<const Transazione*> lotto;  /**< Righe in attesa di essere formattate */
+    size_t righe;                      /**< Righe esportate finora */
+    bool terminato;                    /**< true dopo termina() */
+
+    /**
+     * @brief Formatta e scrive le righe del lotto
+     */
+    void svuotaLotto();
+
+public:
+    static constexpr size_t RIGHE_PER_LOTTO = 16384;  /**< Righe raccolte prima di formattare */
+
+    /**
+     * @brief Crea l'esportatore e scrive l'intestazione del formato
+     * @param destinazione Stream di output (in modalità binaria per il formato colonnare)
+     * @param f Formato di esportazione
+     */
+    Esportatore(ostream& destinazione, FormatoEsportazione f);
+
+    /**
+     * @brief Accoda una transazione all'esportazione
+     * @param t Transazione da esportare
+     * @throws std::invalid_argument Nel formato colonnare, se una data non è nel formato YYYY-MM-DD
+     *         (segnalato quando il lotto che la contiene viene formattato)
+     *
+     * La transazione viene memorizzata per indirizzo: deve restare valida
+     * e invariata fino al successivo svuotamento del lotto o a termina().
+     */
+    void aggiungi(const Transazione& t);
+
+    /**
+     * @brief Scrive le righe rimaste e la chiusura del formato
+     *
+     * Va chiamato una sola volta, dopo l'ultima aggiungi.
+     */
+    void termina();
+
+    /**
+     * @brief Restituisce il numero di righe esportate
+     * @return size_t Righe accodate finora
+     */
+    size_t getRighe() const;
+
+    /**
+     * @brief Legge un file esportato nel formato colonnare
+     * @param in Stream di input posizionato all'inizio
+     * @return vector<Transazione> Transazioni lette
+     * @throws std::runtime_error Se la firma manca o il contenuto è troncato
+     */
+    static vector<Transazione> leggiColonnare(istream& in);
+};
+
+#endif // ESPORTAZIONE_H
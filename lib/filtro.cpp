@@ -0,0 +1,147 @@
+#include "filtro.h"
+#include <limits>
+
+using namespace std;
+
+/**
+ * @brief Costruttore: nessuna condizione impostata
+ */
+Filtro::Filtro()
+    : haDataMinima(false), haDataMassima(false),
+      importoMin(-numeric_limits<double>::infinity()),
+      importoMax(numeric_limits<double>::infinity()),
+      haParola(false), parola(""), segno(Segno::Tutti) {
+}
+
+/**
+ * @brief Imposta la data minima
+ * @param data Data minima inclusa
+ * @return Filtro& Il filtro stesso
+ */
+Filtro& Filtro::daData(const string& data) {
+    haDataMinima = true;
+    dataMinima = data;
+    return *this;
+}
+
+/**
+ * @brief Imposta la data massima
+ * @param data Data massima inclusa
+ * @return Filtro& Il filtro stesso
+ */
+Filtro& Filtro::aData(const string& data) {
+    haDataMassima = true;
+    dataMassima = data;
+    return *this;
+}
+
+/**
+ * @brief Imposta entrambe le date dell'intervallo
+ * @param da Data iniziale inclusa
+ * @param a Data finale inclusa
+ * @return Filtro& Il filtro stesso
+ */
+Filtro& Filtro::traDate(const string& da, const string& a) {
+    return daData(da).aData(a);
+}
+
+/**
+ * @brief Imposta l'importo minimo
+ * @param importo Importo minimo incluso
+ * @return Filtro& Il filtro stesso
+ */
+Filtro& Filtro::importoMinimo(double importo) {
+    importoMin = importo;
+    return *this;
+}
+
+/**
+ * @brief Imposta l'importo massimo
+ * @param importo Importo massimo incluso
+ * @return Filtro& Il filtro stesso
+ */
+Filtro& Filtro::importoMassimo(double importo) {
+    importoMax = importo;
+    return *this;
+}
+
+/**
+ * @brief Imposta la parola chiave
+ * @param p Parola chiave
+ * @return Filtro& Il filtro stesso
+ */
+Filtro& Filtro::conParolaChiave(const string& p) {
+    haParola = true;
+    parola = ParolaChiave(p);
+    return *this;
+}
+
+/**
+ * @brief Accetta solo le entrate
+ * @return Filtro& Il filtro stesso
+ */
+Filtro& Filtro::soloEntrate() {
+    segno = Segno::Entrate;
+    return *this;
+}
+
+/**
+ * @brief Accetta solo le uscite
+ * @return Filtro& Il filtro stesso
+ */
+Filtro& Filtro::soloUscite() {
+    segno = Segno::Uscite;
+    return *this;
+}
+
+/**
+ * @brief Getter per la presenza della data minima
+ * @return bool true se impostata
+ */
+bool Filtro::getHaDataMinima() const {
+    return haDataMinima;
+}
+
+/**
+ * @brief Getter per la presenza della data massima
+ * @return bool true se impostata
+ */
+bool Filtro::getHaDataMassima() const {
+    return haDataMassima;
+}
+
+/**
+ * @brief Getter per la data minima
+ * @return const string& Data minima
+ */
+const string& Filtro::getDataMinima() const {
+    return dataMinima;
+}
+
+/**
+ * @brief Getter per la data massima
+ * @return const string& Data massima
+ */
+const string& Filtro::getDataMassima() const {
+    return dataMassima;
+}
+
+/**
+ * @brief Valuta tutte le condizioni su una transazione
+ * @param t Transazione
+ * @param controllaDate false se le date sono già garantite
+ * @return bool true se accettata
+ */
+bool Filtro::accetta(const Transazione& t, bool controllaDate) const {
+    double importo = t.getImporto();
+    if (segno == Segno::Entrate && !(importo > 0)) return false;
+    if (segno == Segno::Uscite && !(importo < 0)) return false;
+    if (importo < importoMin || importo > importoMax) return false;
+
+    if (controllaDate) {
+        if (haDataMinima && t.getData() < dataMinima) return false;
+        if (haDataMassima && t.getData() > dataMassima) return false;
+    }
+
+    return !haParola || t.contieneParolaChiave(parola);
+}
@@ -0,0 +1,136 @@
+#ifndef FILTRO_H
+#define FILTRO_H
+
+#include "transazione.h"
+#include <string>
+
+using namespace std;
+
+/**
+ * @brief Segno degli importi accettati da un filtro
+ */
+enum class Segno {
+    Tutti,     /**< Entrate e uscite */
+    Entrate,   /**< Solo importi positivi */
+    Uscite     /**< Solo importi negativi */
+};
+
+/**
+ * @brief Insieme di condizioni combinabili (in AND) sulle transazioni
+ *
+ * Il filtro si costruisce concatenando i metodi, ad esempio:
+ * Filtro().traDate("2024-01-01", "2024-01-31").importoMinimo(100).conParolaChiave("bonifico")
+ * e viene passato a ContoCorrente::cerca, che sceglie come visitare le righe
+ * (ricerca binaria sulle date in modalità ordinata) e valuta tutte le
+ * condizioni rimanenti in un unico passaggio.
+ */
+class Filtro {
+private:
+    bool haDataMinima;       /**< true se è impostata una data minima */
+    bool haDataMassima;      /**< true se è impostata una data massima */
+    string dataMinima;       /**< Data minima inclusa (YYYY-MM-DD) */
+    string dataMassima;      /**< Data massima inclusa (YYYY-MM-DD) */
+    double importoMin;       /**< Importo minimo incluso */
+    double importoMax;       /**< Importo massimo incluso */
+    bool haParola;           /**< true se è impostata una parola chiave */
+    ParolaChiave parola;     /**< Parola chiave compilata (ricerca case-insensitive) */
+    Segno segno;             /**< Segno degli importi accettati */
+
+public:
+    /**
+     * @brief Costruisce un filtro che accetta tutte le transazioni
+     */
+    Filtro();
+
+    /**
+     * @brief Limita alle transazioni con data maggiore o uguale
+     * @param data Data minima inclusa in formato YYYY-MM-DD
+     * @return Filtro& Il filtro stesso, per concatenare le condizioni
+     */
+    Filtro& daData(const string& data);
+
+    /**
+     * @brief Limita alle transazioni con data minore o uguale
+     * @param data Data massima inclusa in formato YYYY-MM-DD
+     * @return Filtro& Il filtro stesso
+     */
+    Filtro& aData(const string& data);
+
+    /**
+     * @brief Limita alle transazioni in un intervallo di date
+     * @param da Data iniziale inclusa
+     * @param a Data finale inclusa
+     * @return Filtro& Il filtro stesso
+     */
+    Filtro& traDate(const string& da, const string& a);
+
+    /**
+     * @brief Limita alle transazioni con importo maggiore o uguale
+     * @param importo Importo minimo incluso
+     * @return Filtro& Il filtro stesso
+     */
+    Filtro& importoMinimo(double importo);
+
+    /**
+     * @brief Limita alle transazioni con importo minore o uguale
+     * @param importo Importo massimo incluso
+     * @return Filtro& Il filtro stesso
+     */
+    Filtro& importoMassimo(double importo);
+
+    /**
+     * @brief Limita alle transazioni la cui descrizione contiene una parola
+     * @param p Parola chiave (ricerca case-insensitive)
+     * @return Filtro& Il filtro stesso
+     */
+    Filtro& conParolaChiave(const string& p);
+
+    /**
+     * @brief Limita alle sole entrate (importi positivi)
+     * @return Filtro& Il filtro stesso
+     */
+    Filtro& soloEntrate();
+
+    /**
+     * @brief Limita alle sole uscite (importi negativi)
+     * @return Filtro& Il filtro stesso
+     */
+    Filtro& soloUscite();
+
+    /**
+     * @brief Indica se il filtro impone una data minima
+     * @return bool true se impostata
+     */
+    bool getHaDataMinima() const;
+
+    /**
+     * @brief Indica se il filtro impone una data massima
+     * @return bool true se impostata
+     */
+    bool getHaDataMassima() const;
+
+    /**
+     * @brief Restituisce la data minima
+     * @return const string& Data minima (vuota se non impostata)
+     */
+    const string& getDataMinima() const;
+
+    /**
+     * @brief Restituisce la data massima
+     * @return const string& Data massima (vuota se non impostata)
+     */
+    const string& getDataMassima() const;
+
+    /**
+     * @brief Verifica se una transazione soddisfa tutte le condizioni
+     * @param t Transazione da verificare
+     * @param controllaDate false se le date sono già garantite dal piano di visita
+     * @return bool true se la transazione è accettata
+     *
+     * Le condizioni sono valutate dalla più economica (segno e importi)
+     * alla più costosa (parola chiave), interrompendosi alla prima fallita.
+     */
+    bool accetta(const Transazione& t, bool controllaDate = true) const;
+};
+
+#endif // FILTRO_H
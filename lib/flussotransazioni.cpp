@@ -0,0 +1,193 @@
+#include "flussotransazioni.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+static_assert(sizeof(EventoTransazione) % sizeof(uint64_t) == 0,
+              "EventoTransazione deve essere composto da parole intere");
+static_assert(sizeof(EventoTransazione) == 128, "EventoTransazione deve occupare due linee di cache");
+
+/**
+ * @brief Indica se la descrizione è stata troncata
+ * @return bool true se troncata
+ */
+bool EventoTransazione::isTroncata() const {
+    return lunghezzaDescrizione > CAPACITA_DESCRIZIONE;
+}
+
+/**
+ * @brief Ricostruisce la transazione dall'evento
+ * @return Transazione Transazione equivalente (descrizione eventualmente troncata)
+ */
+Transazione EventoTransazione::getTransazione() const {
+    size_t lunghezza = min<size_t>(lunghezzaDescrizione, CAPACITA_DESCRIZIONE);
+    Transazione t(string(descrizione, lunghezza), importo, string(data));
+    t.setId(id);
+    return t;
+}
+
+/**
+ * @brief Costruttore: alloca gli slot
+ * @param capacitaMinima Numero minimo di eventi conservati
+ */
+FlussoTransazioni::FlussoTransazioni(size_t capacitaMinima) : capacita(1), testa(0) {
+    while (capacita < capacitaMinima) {
+        capacita <<= 1;
+    }
+    slot.reset(new Slot[capacita]);
+    for (size_t i = 0; i < capacita; i++) {
+        slot[i].versione.store(0, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Pubblica una modifica del conto
+ * @param t Transazione da pubblicare
+ * @param operazione Tipo di modifica
+ *
+ * La versione dispari segnala ai consumatori che lo slot è in scrittura;
+ * il contenuto è scritto con store atomici rilassati, quindi le letture
+ * concorrenti non sono mai data race, al più vengono scartate.
+ */
+void FlussoTransazioni::pubblica(const Transazione& t, OperazioneFlusso operazione) {
+    uint64_t sequenza = testa.load(memory_order_relaxed);
+
+    EventoTransazione evento;
+    memset(&evento, 0, sizeof(evento));
+    evento.sequenza = sequenza;
+    evento.id = t.getId();
+    evento.operazione = operazione;
+    evento.importo = t.getImporto();
+    strncpy(evento.data, t.getData().c_str(), sizeof(evento.data) - 1);
+    const string& descrizione = t.getDescrizione();
+    evento.lunghezzaDescrizione = static_cast<uint16_t>(min<size_t>(descrizione.size(), UINT16_MAX));
+    memcpy(evento.descrizione, descrizione.data(), min(descrizione.size(), EventoTransazione::CAPACITA_DESCRIZIONE));
+
+    uint64_t parole[PAROLE_EVENTO];
+    memcpy(parole, &evento, sizeof(evento));
+
+    Slot& s = slot[sequenza & (capacita - 1)];
+    s.versione.store(2 * sequenza + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (size_t i = 0; i < PAROLE_EVENTO; i++) {
+        s.parole[i].store(parole[i], memory_order_relaxed);
+    }
+    s.versione.store(2 * sequenza + 2, memory_order_release);
+    testa.store(sequenza + 1, memory_order_release);
+}
+
+/**
+ * @brief Legge un evento per un consumatore
+ * @param cursore Cursore del consumatore
+ * @param evento Evento letto
+ * @param persi Contatore degli eventi persi
+ * @return bool true se un evento è stato letto
+ *
+ * Se lo slot è stato sovrascritto durante la copia (versione cambiata),
+ * il cursore salta al più vecchio evento ancora disponibile e si riprova.
+ */
+bool FlussoTransazioni::leggi(uint64_t& cursore, EventoTransazione& evento, uint64_t& persi) const {
+    while (true) {
+        uint64_t pubblicati = testa.load(memory_order_acquire);
+        if (cursore >= pubblicati) {
+            return false;
+        }
+        if (pubblicati - cursore > capacita) {
+            persi += pubblicati - capacita - cursore;
+            cursore = pubblicati - capacita;
+        }
+
+        const Slot& s = slot[cursore & (capacita - 1)];
+        uint64_t versione = s.versione.load(memory_order_acquire);
+        if (versione == 2 * cursore + 2) {
+            uint64_t parole[PAROLE_EVENTO];
+            for (size_t i = 0; i < PAROLE_EVENTO; i++) {
+                parole[i] = s.parole[i].load(memory_order_relaxed);
+            }
+            atomic_thread_fence(memory_order_acquire);
+            if (s.versione.load(memory_order_relaxed) == versione) {
+                memcpy(&evento, parole, sizeof(evento));
+                cursore++;
+                return true;
+            }
+        }
+        // Slot sovrascritto dal produttore: l'evento è perso
+        persi++;
+        cursore++;
+    }
+}
+
+/**
+ * @brief Getter per il numero di eventi pubblicati
+ * @return uint64_t Testa del flusso
+ */
+uint64_t FlussoTransazioni::getTesta() const {
+    return testa.load(memory_order_acquire);
+}
+
+/**
+ * @brief Getter per la capacità
+ * @return size_t Numero di slot
+ */
+size_t FlussoTransazioni::getCapacita() const {
+    return capacita;
+}
+
+/**
+ * @brief Memoria occupata dagli slot
+ * @return size_t Byte allocati
+ */
+size_t FlussoTransazioni::getUsoMemoria() const {
+    return capacita * sizeof(Slot);
+}
+
+/**
+ * @brief Costruttore: il cursore parte dalla testa attuale
+ * @param f Flusso da leggere
+ */
+Sottoscrizione::Sottoscrizione(shared_ptr<const FlussoTransazioni> f)
+    : flusso(move(f)), cursore(flusso->getTesta()), persi(0) {
+}
+
+/**
+ * @brief Legge il prossimo evento
+ * @param evento Evento letto
+ * @return bool true se letto
+ */
+bool Sottoscrizione::prossimo(EventoTransazione& evento) {
+    return flusso->leggi(cursore, evento, persi);
+}
+
+/**
+ * @brief Legge più eventi in una volta
+ * @param eventi Vettore di destinazione
+ * @param massimo Numero massimo di eventi
+ * @return size_t Eventi letti
+ */
+size_t Sottoscrizione::leggi(vector<EventoTransazione>& eventi, size_t massimo) {
+    size_t letti = 0;
+    EventoTransazione evento;
+    while (letti < massimo && prossimo(evento)) {
+        eventi.push_back(evento);
+        letti++;
+    }
+    return letti;
+}
+
+/**
+ * @brief Getter per gli eventi persi
+ * @return uint64_t Eventi persi
+ */
+uint64_t Sottoscrizione::getPersi() const {
+    return persi;
+}
+
+/**
+ * @brief Eventi pubblicati non ancora letti
+ * @return uint64_t Ritardo
+ */
+uint64_t Sottoscrizione::getRitardo() const {
+    uint64_t pubblicati = flusso->getTesta();
+    return pubblicati > cursore ? pubblicati - cursore : 0;
+}
@@ -0,0 +1,167 @@
+#ifndef FLUSSOTRANSAZIONI_H
+#define FLUSSOTRANSAZIONI_H
+
+#include "transazione.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Modifica del conto descritta da un evento del flusso
+ */
+enum class OperazioneFlusso : uint8_t {
+    Inserimento,    /**< Nuova transazione */
+    Sostituzione,   /**< Nuova versione di una transazione con lo stesso identificativo */
+    Eliminazione    /**< Transazione eliminata (l'evento ne riporta l'ultimo contenuto) */
+};
+
+/**
+ * @brief Copia a dimensione fissa di una transazione pubblicata nel flusso
+ *
+ * Ha dimensione fissa per poter essere copiata nel buffer circolare senza
+ * allocazioni; le descrizioni più lunghe di CAPACITA_DESCRIZIONE byte
+ * vengono troncate (lunghezzaDescrizione conserva la lunghezza originale).
+ */
+struct EventoTransazione {
+    static constexpr size_t CAPACITA_DESCRIZIONE = 85;  /**< Byte di descrizione conservati */
+
+    uint64_t sequenza;                           /**< Numero progressivo dell'evento (da 0) */
+    uint64_t id;                                 /**< Identificativo della transazione */
+    double importo;                              /**< Importo della transazione */
+    char data[16];                               /**< Data terminata da '\0' */
+    uint16_t lunghezzaDescrizione;               /**< Lunghezza originale della descrizione */
+    OperazioneFlusso operazione;                 /**< Tipo di modifica */
+    char descrizione[CAPACITA_DESCRIZIONE];      /**< Descrizione, eventualmente troncata */
+
+    /**
+     * @brief Indica se la descrizione è stata troncata
+     * @return bool true se troncata
+     */
+    bool isTroncata() const;
+
+    /**
+     * @brief Ricostruisce la transazione
+     * @return Transazione Transazione con i dati e l'identificativo dell'evento
+     */
+    Transazione getTransazione() const;
+};
+
+/**
+ * @brief Buffer circolare lock-free a un produttore e più consumatori
+ *
+ * Il produttore (il thread che aggiunge transazioni al conto) scrive l'evento
+ * nello slot sequenza % capacità, proteggendolo con un numero di versione
+ * (seqlock per slot), e poi avanza la testa. Ogni consumatore ha un proprio
+ * cursore e legge senza lock: se resta indietro di più di capacità eventi
+ * quelli più vecchi vengono sovrascritti e il consumatore ne viene informato,
+ * ma il produttore non attende mai.
+ */
+class FlussoTransazioni {
+private:
+    static constexpr size_t PAROLE_EVENTO = sizeof(EventoTransazione) / sizeof(uint64_t);
+
+    /**
+     * @brief Slot del buffer: versione e contenuto dell'evento in parole atomiche
+     */
+    struct alignas(64) Slot {
+        atomic<uint64_t> versione;                  /**< 2s+1 in scrittura, 2s+2 se contiene l'evento s */
+        atomic<uint64_t> parole[PAROLE_EVENTO];     /**< Contenuto dell'evento */
+    };
+
+    unique_ptr<Slot[]> slot;             /**< Slot del buffer */
+    size_t capacita;                     /**< Numero di slot (potenza di 2) */
+    alignas(64) atomic<uint64_t> testa;  /**< Numero di eventi pubblicati */
+
+public:
+    /**
+     * @brief Crea il flusso
+     * @param capacitaMinima Numero minimo di eventi conservati (arrotondato a potenza di 2)
+     */
+    explicit FlussoTransazioni(size_t capacitaMinima);
+
+    /**
+     * @brief Pubblica una modifica del conto (un solo thread produttore)
+     * @param t Transazione aggiunta, sostituita o eliminata (con il suo identificativo)
+     * @param operazione Tipo di modifica
+     */
+    void pubblica(const Transazione& t, OperazioneFlusso operazione = OperazioneFlusso::Inserimento);
+
+    /**
+     * @brief Legge l'evento indicato dal cursore, se disponibile
+     * @param cursore Sequenza del prossimo evento da leggere, avanzata in caso di successo
+     * @param evento Evento letto
+     * @param persi Incrementato degli eventi sovrascritti prima di poter essere letti
+     * @return bool false se non ci sono eventi nuovi
+     */
+    bool leggi(uint64_t& cursore, EventoTransazione& evento, uint64_t& persi) const;
+
+    /**
+     * @brief Restituisce il numero di eventi pubblicati
+     * @return uint64_t Sequenza del prossimo evento
+     */
+    uint64_t getTesta() const;
+
+    /**
+     * @brief Restituisce il numero di eventi conservati
+     * @return size_t Capacità del buffer
+     */
+    size_t getCapacita() const;
+
+    /**
+     * @brief Restituisce la memoria occupata dal buffer
+     * @return size_t Byte allocati per gli slot
+     */
+    size_t getUsoMemoria() const;
+};
+
+/**
+ * @brief Consumatore di un FlussoTransazioni con il proprio cursore
+ *
+ * Una sottoscrizione va usata da un solo thread alla volta; più
+ * sottoscrizioni dello stesso flusso sono indipendenti.
+ */
+class Sottoscrizione {
+private:
+    shared_ptr<const FlussoTransazioni> flusso;   /**< Flusso letto */
+    uint64_t cursore;                             /**< Prossimo evento da leggere */
+    uint64_t persi;                               /**< Eventi sovrascritti prima della lettura */
+
+public:
+    /**
+     * @brief Crea una sottoscrizione a partire dal prossimo evento pubblicato
+     * @param f Flusso da leggere
+     */
+    explicit Sottoscrizione(shared_ptr<const FlussoTransazioni> f);
+
+    /**
+     * @brief Legge il prossimo evento senza bloccare
+     * @param evento Evento letto
+     * @return bool false se non ci sono eventi nuovi
+     */
+    bool prossimo(EventoTransazione& evento);
+
+    /**
+     * @brief Legge fino a massimo eventi accodandoli al vettore
+     * @param eventi Vettore in cui accodare gli eventi
+     * @param massimo Numero massimo di eventi da leggere
+     * @return size_t Numero di eventi letti
+     */
+    size_t leggi(vector<EventoTransazione>& eventi, size_t massimo);
+
+    /**
+     * @brief Restituisce gli eventi persi perché sovrascritti
+     * @return uint64_t Numero di eventi persi
+     */
+    uint64_t getPersi() const;
+
+    /**
+     * @brief Restituisce quanti eventi pubblicati non sono ancora stati letti
+     * @return uint64_t Ritardo del consumatore
+     */
+    uint64_t getRitardo() const;
+};
+
+#endif // FLUSSOTRANSAZIONI_H
@@ -0,0 +1,475 @@
+#include "formatocompresso.h"
+#include "utilita.h"
+#include <memory>
+#include <fstream>
+#include <unordered_map>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+static const char FIRMA[4] = {'\x89', 'C', 'Z', '3'};
+static const char FIRMA_V2[4] = {'\x89', 'C', 'Z', '2'};
+static const char FIRMA_V1[4] = {'\x89', 'C', 'Z', '1'};
+static const uint32_t BYTE_CONTROLLO = 24;  /**< Contenuto di un blocco di controllo: righe, saldo, impronta */
+
+/**
+ * @brief Accoda un intero senza segno in formato varint (7 bit per byte)
+ */
+static void scriviVarint(string& out, uint64_t valore) {
+    while (valore >= 0x80) {
+        out.push_back(static_cast<char>((valore & 0x7F) | 0x80));
+        valore >>= 7;
+    }
+    out.push_back(static_cast<char>(valore));
+}
+
+/**
+ * @brief Accoda un intero con segno in formato zigzag varint
+ */
+static void scriviVarintConSegno(string& out, int64_t valore) {
+    scriviVarint(out, (static_cast<uint64_t>(valore) << 1) ^ static_cast<uint64_t>(valore >> 63));
+}
+
+/**
+ * @brief Legge un varint dal buffer avanzando la posizione
+ * @throws std::runtime_error Se il buffer termina prima della fine del varint
+ */
+static uint64_t leggiVarint(const string& dati, size_t& pos) {
+    uint64_t valore = 0;
+    int shift = 0;
+    while (pos < dati.size() && shift < 64) {
+        uint8_t byte = static_cast<uint8_t>(dati[pos++]);
+        valore |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return valore;
+        }
+        shift += 7;
+    }
+    throw runtime_error("Blocco compresso corrotto: varint troncato");
+}
+
+/**
+ * @brief Legge un intero zigzag varint dal buffer avanzando la posizione
+ */
+static int64_t leggiVarintConSegno(const string& dati, size_t& pos) {
+    uint64_t valore = leggiVarint(dati, pos);
+    return static_cast<int64_t>(valore >> 1) ^ -static_cast<int64_t>(valore & 1);
+}
+
+/**
+ * @brief Scrive un intero a 32 bit in little endian
+ */
+static void scriviUint32(ostream& out, uint32_t valore) {
+    char byte[4];
+    for (int i = 0; i < 4; i++) {
+        byte[i] = static_cast<char>((valore >> (8 * i)) & 0xFF);
+    }
+    out.write(byte, 4);
+}
+
+/**
+ * @brief Accoda un intero a 64 bit in little endian
+ */
+static void scriviUint64(string& out, uint64_t valore) {
+    for (int i = 0; i < 8; i++) {
+        out.push_back(static_cast<char>((valore >> (8 * i)) & 0xFF));
+    }
+}
+
+/**
+ * @brief Legge un intero a 64 bit in little endian da una posizione del buffer
+ */
+static uint64_t leggiUint64(const string& dati, size_t pos) {
+    uint64_t valore = 0;
+    for (int i = 0; i < 8; i++) {
+        valore |= static_cast<uint64_t>(static_cast<uint8_t>(dati[pos + i])) << (8 * i);
+    }
+    return valore;
+}
+
+/**
+ * @brief Scrive un blocco di controllo (intestazione con zero righe e date vuote)
+ */
+static void scriviBloccoControllo(ostream& out, const PuntoDiControllo& punto) {
+    string dati;
+    scriviUint64(dati, punto.righe);
+    scriviUint64(dati, static_cast<uint64_t>(punto.saldoCentesimi));
+    scriviUint64(dati, punto.impronta);
+    scriviUint32(out, 0);
+    scriviUint32(out, static_cast<uint32_t>(INT32_MAX));
+    scriviUint32(out, static_cast<uint32_t>(INT32_MIN));
+    scriviUint32(out, BYTE_CONTROLLO);
+    out.write(dati.data(), dati.size());
+}
+
+/**
+ * @brief Indica se un blocco è un punto di controllo (solo dalla versione 3)
+ */
+static bool isBloccoControllo(const FormatoCompresso::IntestazioneBlocco& intestazione, int versione) {
+    return versione >= 3 && intestazione.righe == 0;
+}
+
+/**
+ * @brief Legge l'intestazione del prossimo blocco
+ * @return bool false se lo stream è terminato esattamente a fine blocco
+ * @throws std::runtime_error Se l'intestazione è troncata
+ */
+static bool leggiIntestazione(istream& in, FormatoCompresso::IntestazioneBlocco& intestazione) {
+    unsigned char byte[16];
+    in.read(reinterpret_cast<char*>(byte), sizeof(byte));
+    if (in.gcount() == 0) {
+        return false;
+    }
+    if (in.gcount() != sizeof(byte)) {
+        throw runtime_error("File compresso corrotto: intestazione di blocco troncata");
+    }
+
+    uint32_t campi[4];
+    for (int c = 0; c < 4; c++) {
+        campi[c] = 0;
+        for (int i = 0; i < 4; i++) {
+            campi[c] |= static_cast<uint32_t>(byte[c * 4 + i]) << (8 * i);
+        }
+    }
+    intestazione.righe = campi[0];
+    intestazione.minGiorno = static_cast<int32_t>(campi[1]);
+    intestazione.maxGiorno = static_cast<int32_t>(campi[2]);
+    intestazione.byteDati = campi[3];
+    return true;
+}
+
+/**
+ * @brief Decodifica il contenuto di un blocco accodando le transazioni trovate
+ * @param intestazione Intestazione del blocco
+ * @param dati Contenuto codificato del blocco
+ * @param risultati Vettore in cui accodare le transazioni
+ * @param minGiorno Data minima da includere
+ * @param maxGiorno Data massima da includere
+ * @param versione Versione del formato (dalla 2 le righe hanno l'identificativo)
+ */
+static void decodificaBlocco(const FormatoCompresso::IntestazioneBlocco& intestazione, const string& dati,
+                             vector<Transazione>& risultati, int minGiorno, int maxGiorno, int versione) {
+    size_t pos = 0;
+    uint64_t voci = leggiVarint(dati, pos);
+    // Ogni voce occupa almeno il byte della sua lunghezza
+    if (voci > intestazione.righe || voci > dati.size() - pos) {
+        throw runtime_error("Blocco compresso corrotto: dizionario non valido");
+    }
+
+    vector<string> dizionario;
+    dizionario.reserve(voci);
+    for (uint64_t i = 0; i < voci; i++) {
+        uint64_t lunghezza = leggiVarint(dati, pos);
+        if (lunghezza > dati.size() - pos) {
+            throw runtime_error("Blocco compresso corrotto: descrizione troncata");
+        }
+        dizionario.emplace_back(dati, pos, lunghezza);
+        pos += lunghezza;
+    }
+
+    int64_t giorno = intestazione.minGiorno;
+    uint64_t id = 0;
+    for (uint32_t r = 0; r < intestazione.righe; r++) {
+        giorno += leggiVarintConSegno(dati, pos);
+        int64_t centesimi = leggiVarintConSegno(dati, pos);
+        uint64_t indice = leggiVarint(dati, pos);
+        if (indice >= dizionario.size()) {
+            throw runtime_error("Blocco compresso corrotto: indice di descrizione non valido");
+        }
+        if (versione >= 2) {
+            id += static_cast<uint64_t>(leggiVarintConSegno(dati, pos));
+            if (id > Transazione::MASSIMO_ID) {
+                throw runtime_error("Blocco compresso corrotto: identificativo non valido");
+            }
+        }
+        if (giorno >= minGiorno && giorno <= maxGiorno) {
+            risultati.emplace_back(dizionario[indice], centesimi / 100.0, giorniInData(static_cast<int>(giorno)));
+            risultati.back().setId(id);
+        }
+    }
+}
+
+/**
+ * @brief Sottrae un blocco dai byte restanti dello stream
+ * @throws std::runtime_error Se il blocco dichiara più byte di quelli rimasti
+ */
+static void consumaBlocco(const FormatoCompresso::IntestazioneBlocco& intestazione, uint64_t& restanti) {
+    if (intestazione.byteDati > restanti) {
+        throw runtime_error("File compresso corrotto: blocco troncato");
+    }
+    restanti -= intestazione.byteDati;
+}
+
+/**
+ * @brief Legge un blocco completo (intestazione già letta) e lo decodifica
+ * @param restanti Byte rimasti nello stream dopo l'intestazione, aggiornati
+ *
+ * La lunghezza dichiarata è confrontata con i byte rimasti prima di
+ * allocare, così un'intestazione corrotta non fa riservare gigabyte.
+ */
+static void leggiBlocco(istream& in, const FormatoCompresso::IntestazioneBlocco& intestazione, uint64_t& restanti,
+                        vector<Transazione>& risultati, int minGiorno, int maxGiorno, int versione) {
+    consumaBlocco(intestazione, restanti);
+    string dati(intestazione.byteDati, '\0');
+    in.read(&dati[0], intestazione.byteDati);
+    if (static_cast<uint32_t>(in.gcount()) != intestazione.byteDati) {
+        throw runtime_error("File compresso corrotto: blocco troncato");
+    }
+    decodificaBlocco(intestazione, dati, risultati, minGiorno, maxGiorno, versione);
+}
+
+/**
+ * @brief Salta il contenuto di un blocco (intestazione già letta)
+ * @param restanti Byte rimasti nello stream dopo l'intestazione, aggiornati
+ * @throws std::runtime_error Se lo stream termina prima della fine del blocco
+ */
+static void saltaBlocco(istream& in, const FormatoCompresso::IntestazioneBlocco& intestazione, uint64_t& restanti) {
+    consumaBlocco(intestazione, restanti);
+    in.seekg(intestazione.byteDati, ios::cur);
+    if (!in) {
+        throw runtime_error("File compresso corrotto: blocco troncato");
+    }
+}
+
+/**
+ * @brief Verifica la presenza della firma del formato compresso
+ * @param in Stream di input
+ * @return int 3 se lo stream inizia con "\x89CZ3", 2 con "\x89CZ2", 1 con "\x89CZ1", altrimenti 0
+ *
+ * Il primo byte non è ASCII e non può iniziare un carattere UTF-8, quindi
+ * nessun file di testo viene scambiato per un file compresso.
+ */
+int FormatoCompresso::riconosci(istream& in) {
+    char firma[4];
+    in.read(firma, 4);
+    if (in.gcount() == 4 && equal(firma, firma + 4, FIRMA)) {
+        return VERSIONE;
+    }
+    if (in.gcount() == 4 && equal(firma, firma + 4, FIRMA_V2)) {
+        return 2;
+    }
+    if (in.gcount() == 4 && equal(firma, firma + 4, FIRMA_V1)) {
+        return 1;
+    }
+    in.clear();
+    in.seekg(0);
+    return 0;
+}
+
+/**
+ * @brief Scrive firma e blocchi compressi
+ * @param out Stream di output
+ * @param transazioni Transazioni da scrivere
+ * @param controlli Regole dei punti di controllo
+ *
+ * Le righe vengono suddivise in blocchi consecutivi da RIGHE_PER_BLOCCO;
+ * ogni blocco ha un proprio dizionario così da poter essere decodificato
+ * indipendentemente dagli altri. Un blocco viene chiuso in anticipo dove le
+ * regole richiedono un punto di controllo, che segue il blocco. Senza punti
+ * di controllo il file è scritto nella versione 2, leggibile anche dalle
+ * versioni precedenti del programma.
+ */
+void FormatoCompresso::scrivi(ostream& out, const vector<Transazione>& transazioni, const OpzioniControlli& controlli) {
+    // Le date vengono convertite prima di scrivere qualsiasi byte, così un
+    // errore di formato non lascia file parziali
+    vector<int> giorni(transazioni.size());
+    for (size_t i = 0; i < transazioni.size(); i++) {
+        giorni[i] = dataInGiorni(transazioni[i].getData());
+    }
+    out.write(controlli.isAttive() ? FIRMA : FIRMA_V2, 4);
+
+    string dati;
+    unordered_map<string, uint32_t> dizionario;
+    vector<uint32_t> indici;
+    CatenaControlli catena(controlli);
+
+    size_t inizio = 0;
+    while (inizio < transazioni.size()) {
+        // Il blocco termina al limite di righe o prima della riga che richiede un punto di controllo
+        size_t fine = inizio;
+        bool controllo = false;
+        do {
+            catena.aggiungi(transazioni[fine], importoInCentesimi(transazioni[fine].getImporto()));
+            fine++;
+            controllo = fine < transazioni.size() && catena.richiedeControllo(transazioni[fine]);
+        } while (fine < transazioni.size() && fine - inizio < RIGHE_PER_BLOCCO && !controllo);
+
+        dati.clear();
+        dizionario.clear();
+        indici.clear();
+        string voci;
+        for (size_t i = inizio; i < fine; i++) {
+            const string& descrizione = transazioni[i].getDescrizione();
+            auto inserita = dizionario.emplace(descrizione, static_cast<uint32_t>(dizionario.size()));
+            if (inserita.second) {
+                scriviVarint(voci, descrizione.size());
+                voci += descrizione;
+            }
+            indici.push_back(inserita.first->second);
+        }
+        scriviVarint(dati, dizionario.size());
+        dati += voci;
+
+        int minGiorno = *min_element(giorni.begin() + inizio, giorni.begin() + fine);
+        int maxGiorno = *max_element(giorni.begin() + inizio, giorni.begin() + fine);
+        int64_t precedente = minGiorno;
+        uint64_t idPrecedente = 0;
+        for (size_t i = inizio; i < fine; i++) {
+            scriviVarintConSegno(dati, giorni[i] - precedente);
+            scriviVarintConSegno(dati, importoInCentesimi(transazioni[i].getImporto()));
+            scriviVarint(dati, indici[i - inizio]);
+            scriviVarintConSegno(dati, static_cast<int64_t>(transazioni[i].getId() - idPrecedente));
+            precedente = giorni[i];
+            idPrecedente = transazioni[i].getId();
+        }
+
+        scriviUint32(out, static_cast<uint32_t>(fine - inizio));
+        scriviUint32(out, static_cast<uint32_t>(minGiorno));
+        scriviUint32(out, static_cast<uint32_t>(maxGiorno));
+        scriviUint32(out, static_cast<uint32_t>(dati.size()));
+        out.write(dati.data(), dati.size());
+
+        if (controllo || (fine == transazioni.size() && catena.haRigheAperte())) {
+            scriviBloccoControllo(out, catena.chiudi());
+        }
+        inizio = fine;
+    }
+}
+
+/**
+ * @brief Decodifica tutti i blocchi dello stream
+ * @param in Stream posizionato dopo la firma
+ * @param versione Versione del formato
+ * @return vector<Transazione> Transazioni lette
+ */
+vector<Transazione> FormatoCompresso::leggi(istream& in, int versione) {
+    vector<Transazione> risultati;
+    uint64_t restanti = byteRestanti(in);
+    IntestazioneBlocco intestazione;
+    while (leggiIntestazione(in, intestazione)) {
+        restanti -= min<uint64_t>(restanti, 16);
+        if (isBloccoControllo(intestazione, versione)) {
+            saltaBlocco(in, intestazione, restanti);
+            continue;
+        }
+        leggiBlocco(in, intestazione, restanti, risultati, INT32_MIN, INT32_MAX, versione);
+    }
+    return risultati;
+}
+
+/**
+ * @brief Decodifica solo i blocchi che intersecano l'intervallo richiesto
+ * @param in Stream posizionato dopo la firma
+ * @param da Data iniziale inclusa
+ * @param a Data finale inclusa
+ * @param versione Versione del formato
+ * @return vector<Transazione> Transazioni nell'intervallo
+ *
+ * I blocchi esterni all'intervallo vengono saltati con un seek
+ * sulla base della sola intestazione.
+ */
+vector<Transazione> FormatoCompresso::leggiIntervallo(istream& in, const string& da, const string& a, int versione) {
+    int minGiorno = dataInGiorni(da);
+    int maxGiorno = dataInGiorni(a);
+
+    vector<Transazione> risultati;
+    uint64_t restanti = byteRestanti(in);
+    IntestazioneBlocco intestazione;
+    while (leggiIntestazione(in, intestazione)) {
+        restanti -= min<uint64_t>(restanti, 16);
+        if (isBloccoControllo(intestazione, versione) || intestazione.maxGiorno < minGiorno ||
+            intestazione.minGiorno > maxGiorno) {
+            saltaBlocco(in, intestazione, restanti);
+            continue;
+        }
+        leggiBlocco(in, intestazione, restanti, risultati, minGiorno, maxGiorno, versione);
+    }
+    return risultati;
+}
+
+/**
+ * @brief Apre un file compresso e ne legge l'intervallo di date richiesto
+ * @param nomeFile Percorso del file
+ * @param da Data iniziale inclusa
+ * @param a Data finale inclusa
+ * @return vector<Transazione> Transazioni nell'intervallo
+ */
+vector<Transazione> FormatoCompresso::leggiIntervallo(const string& nomeFile, const string& da, const string& a) {
+    ifstream file(nomeFile, ios::binary);
+    if (!file.is_open()) {
+        throw runtime_error("File " + nomeFile + " non trovato");
+    }
+    int versione = riconosci(file);
+    if (versione == 0) {
+        throw runtime_error("Il file " + nomeFile + " non è in formato compresso");
+    }
+    return leggiIntervallo(file, da, a, versione);
+}
+
+/**
+ * @brief Verifica i punti di controllo di uno stream compresso
+ * @param in Stream di input posizionato dopo la firma
+ * @param versione Versione restituita da riconosci
+ * @return RapportoVerifica Esito della verifica
+ *
+ * La lettura dei blocchi è sequenziale ma non li decodifica: i tratti tra
+ * due punti di controllo vengono decodificati e verificati in parallelo.
+ * Se un'intestazione è illeggibile il tratto che la contiene è segnalato e
+ * la verifica si ferma, perché la posizione dei blocchi successivi non è nota.
+ */
+RapportoVerifica FormatoCompresso::verifica(istream& in, int versione) {
+    uint64_t restanti = byteRestanti(in);
+
+    vector<SegmentoDaVerificare> segmenti;
+    optional<PuntoDiControllo> precedente = PuntoDiControllo();
+    auto blocchi = make_shared<vector<pair<IntestazioneBlocco, string>>>();
+
+    // Chiude il tratto corrente con i blocchi letti finora
+    auto chiudiSegmento = [&](bool chiuso, optional<PuntoDiControllo> fine, const string& errore) {
+        SegmentoDaVerificare segmento;
+        segmento.inizio = precedente;
+        segmento.fine = fine;
+        segmento.chiuso = chiuso;
+        segmento.errore = errore;
+        segmento.decodifica = [blocchi, versione]() {
+            vector<Transazione> righe;
+            for (const auto& [intestazione, dati] : *blocchi) {
+                decodificaBlocco(intestazione, dati, righe, INT32_MIN, INT32_MAX, versione);
+            }
+            return righe;
+        };
+        segmenti.push_back(move(segmento));
+        precedente = fine;
+        blocchi = make_shared<vector<pair<IntestazioneBlocco, string>>>();
+    };
+
+    try {
+        IntestazioneBlocco intestazione;
+        while (leggiIntestazione(in, intestazione)) {
+            if (intestazione.byteDati + 16ULL > restanti) {
+                throw runtime_error("File compresso corrotto: blocco troncato");
+            }
+            restanti -= intestazione.byteDati + 16ULL;
+            string dati(intestazione.byteDati, '\0');
+            in.read(&dati[0], intestazione.byteDati);
+            if (!isBloccoControllo(intestazione, versione)) {
+                blocchi->emplace_back(intestazione, move(dati));
+                continue;
+            }
+            optional<PuntoDiControllo> punto;
+            if (intestazione.byteDati == BYTE_CONTROLLO) {
+                punto = PuntoDiControllo{leggiUint64(dati, 0), static_cast<int64_t>(leggiUint64(dati, 8)),
+                                         leggiUint64(dati, 16)};
+            }
+            chiudiSegmento(true, punto, "");
+        }
+    } catch (const runtime_error& e) {
+        chiudiSegmento(true, nullopt, e.what());
+        return verificaSegmenti(segmenti);
+    }
+    if (!blocchi->empty()) {
+        chiudiSegmento(false, nullopt, "");
+    }
+    return verificaSegmenti(segmenti);
+}
@@ -0,0 +1,117 @@
+#ifndef FORMATOCOMPRESSO_H
+#define FORMATOCOMPRESSO_H
+
+#include "transazione.h"
+#include "puntidicontrollo.h"
+#include <vector>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ * @brief Codec del formato compresso a blocchi per il salvataggio delle transazioni
+ *
+ * Il file inizia con la firma "\x89CZ3" (il primo byte non può aprire un
+ * file di testo, come nella firma PNG) ed è seguito da una sequenza di blocchi
+ * indipendenti di al massimo RIGHE_PER_BLOCCO transazioni. Ogni blocco ha
+ * un'intestazione fissa (numero righe, data minima, data massima, lunghezza
+ * dei dati) e un contenuto codificato con:
+ * - un dizionario locale delle descrizioni distinte del blocco;
+ * - date codificate come delta (zigzag varint) rispetto alla riga precedente;
+ * - importi in centesimi (zigzag varint);
+ * - descrizioni come indice varint nel dizionario;
+ * - identificativi come delta (zigzag varint) rispetto alla riga precedente.
+ *
+ * Un blocco con zero righe è un punto di controllo (vedi PuntoDiControllo):
+ * contiene righe, saldo in centesimi e impronta cumulati, in tre interi a
+ * 64 bit little endian, e date vuote (minima maggiore della massima).
+ *
+ * I file senza punti di controllo sono scritti come versione 2 ("\x89CZ2"),
+ * identica alla 3 salvo i blocchi di controllo. I file della versione 1
+ * ("\x89CZ1") non contengono gli identificativi e restano leggibili: le
+ * transazioni lette hanno identificativo 0.
+ *
+ * Poiché l'intestazione contiene le date minima e massima, le ricerche per
+ * intervallo di date possono saltare interi blocchi senza decodificarli.
+ */
+class FormatoCompresso {
+public:
+    static constexpr uint32_t RIGHE_PER_BLOCCO = 4096;  /**< Numero massimo di righe per blocco */
+    static constexpr int VERSIONE = 3;                  /**< Versione più recente (con punti di controllo) */
+
+    /**
+     * @brief Intestazione di un blocco compresso
+     */
+    struct IntestazioneBlocco {
+        uint32_t righe;       /**< Numero di transazioni nel blocco */
+        int32_t minGiorno;    /**< Data minima del blocco (giorni dal 1970-01-01) */
+        int32_t maxGiorno;    /**< Data massima del blocco (giorni dal 1970-01-01) */
+        uint32_t byteDati;    /**< Lunghezza in byte del contenuto codificato */
+    };
+
+    /**
+     * @brief Verifica se uno stream inizia con la firma del formato compresso
+     * @param in Stream di input posizionato all'inizio del file
+     * @return int Versione del formato (da 1 a 3), oppure 0 se la firma non è presente
+     *
+     * In caso di esito negativo lo stream viene riportato all'inizio.
+     */
+    static int riconosci(istream& in);
+
+    /**
+     * @brief Scrive le transazioni in formato compresso
+     * @param out Stream di output (aperto in modalità binaria)
+     * @param transazioni Transazioni da scrivere
+     * @param controlli Regole dei punti di controllo (nessuno per default)
+     * @throws std::invalid_argument Se una data non è nel formato YYYY-MM-DD
+     */
+    static void scrivi(ostream& out, const vector<Transazione>& transazioni,
+                       const OpzioniControlli& controlli = OpzioniControlli());
+
+    /**
+     * @brief Legge tutte le transazioni da uno stream compresso
+     * @param in Stream di input posizionato dopo la firma
+     * @param versione Versione restituita da riconosci
+     * @return vector<Transazione> Transazioni decodificate
+     * @throws std::runtime_error Se il contenuto è troncato o corrotto
+     */
+    static vector<Transazione> leggi(istream& in, int versione = VERSIONE);
+
+    /**
+     * @brief Legge solo le transazioni comprese in un intervallo di date
+     * @param in Stream di input posizionato dopo la firma
+     * @param da Data iniziale inclusa (YYYY-MM-DD)
+     * @param a Data finale inclusa (YYYY-MM-DD)
+     * @param versione Versione restituita da riconosci
+     * @return vector<Transazione> Transazioni nell'intervallo
+     * @throws std::runtime_error Se il contenuto è troncato o corrotto
+     *
+     * I blocchi la cui intestazione non interseca l'intervallo vengono saltati
+     * senza essere decompressi.
+     */
+    static vector<Transazione> leggiIntervallo(istream& in, const string& da, const string& a,
+                                               int versione = VERSIONE);
+
+    /**
+     * @brief Legge da file le transazioni comprese in un intervallo di date
+     * @param nomeFile Percorso del file compresso
+     * @param da Data iniziale inclusa (YYYY-MM-DD)
+     * @param a Data finale inclusa (YYYY-MM-DD)
+     * @return vector<Transazione> Transazioni nell'intervallo
+     * @throws std::runtime_error Se il file non esiste o non è in formato compresso
+     */
+    static vector<Transazione> leggiIntervallo(const string& nomeFile, const string& da, const string& a);
+
+    /**
+     * @brief Verifica i punti di controllo di uno stream compresso
+     * @param in Stream di input posizionato dopo la firma
+     * @param versione Versione restituita da riconosci
+     * @return RapportoVerifica Tratti integri e corrotti (vedi verificaSegmenti)
+     */
+    static RapportoVerifica verifica(istream& in, int versione = VERSIONE);
+};
+
+#endif // FORMATOCOMPRESSO_H
@@ -0,0 +1,158 @@
+#include "generatorecarico.h"
+#include "utilita.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * @brief Costruttore del generatore
+ * @param parametri Parametri delle distribuzioni
+ * @throws std::invalid_argument Se i parametri non sono validi
+ */
+GeneratoreTransazioni::GeneratoreTransazioni(const ParametriGeneratore& parametri)
+    : parametri(parametri), generatore(parametri.seme), giorno(dataInGiorni(parametri.dataIniziale)) {
+    if (parametri.righePerGiorno < 1.0 || parametri.vocabolario == 0 || parametri.medianaImporto <= 0.0 ||
+        parametri.ritardoMassimo < 0) {
+        throw invalid_argument("Parametri del generatore non validi");
+    }
+    for (const PagamentoRicorrente& p : parametri.ricorrenti) {
+        if (p.giornoDelMese < 1 || p.giornoDelMese > 28) {
+            throw invalid_argument("Giorno del mese non valido per " + p.descrizione);
+        }
+    }
+    costruisciVocabolario();
+}
+
+/**
+ * @brief Costruisce il vocabolario e la sua distribuzione cumulata
+ *
+ * Le combinazioni sono mescolate prima di assegnare la popolarità, così le
+ * descrizioni più frequenti non sono tutte dello stesso tipo di operazione.
+ */
+void GeneratoreTransazioni::costruisciVocabolario() {
+    static const vector<string> operazioni = {
+        "Pagamento POS", "Addebito SDD", "Acquisto online", "Prelievo bancomat", "Bonifico a favore di"};
+    static const vector<string> esercenti = {
+        "supermercato", "farmacia", "ristorante", "bar", "distributore", "libreria", "ferramenta",
+        "panificio", "pizzeria", "ottica", "cinema", "profumeria", "macelleria", "edicola", "tabaccheria"};
+    static const vector<string> nomi = {
+        "Rossi", "Bianchi", "Verdi", "Esposito", "Romano", "Colombo", "Ricci", "Marino", "Greco",
+        "Bruno", "Gallo", "Conti", "Centrale", "della Stazione", "del Corso", "San Marco"};
+
+    size_t combinazioni = operazioni.size() * esercenti.size() * nomi.size();
+    descrizioni.reserve(parametri.vocabolario);
+    for (size_t i = 0; i < parametri.vocabolario; i++) {
+        size_t c = i % combinazioni;
+        string descrizione = operazioni[c % operazioni.size()] + " " +
+                             esercenti[(c / operazioni.size()) % esercenti.size()] + " " +
+                             nomi[c / (operazioni.size() * esercenti.size())];
+        if (i >= combinazioni) {
+            descrizione += " " + to_string(i / combinazioni);
+        }
+        descrizioni.push_back(move(descrizione));
+    }
+    shuffle(descrizioni.begin(), descrizioni.end(), generatore);
+
+    cumulata.resize(descrizioni.size());
+    double totale = 0.0;
+    for (size_t k = 0; k < descrizioni.size(); k++) {
+        totale += 1.0 / pow(static_cast<double>(k + 1), parametri.esponenteZipf);
+        cumulata[k] = totale;
+    }
+    for (double& c : cumulata) {
+        c /= totale;
+    }
+}
+
+/**
+ * @brief Avanza di un giorno
+ *
+ * I pagamenti ricorrenti del nuovo giorno vengono accodati e precedono le
+ * transazioni ordinarie della giornata.
+ */
+void GeneratoreTransazioni::avanzaGiorno() {
+    giorno++;
+    string data = giorniInData(giorno);
+    int giornoDelMese = (data[8] - '0') * 10 + (data[9] - '0');
+    for (const PagamentoRicorrente& p : parametri.ricorrenti) {
+        if (p.giornoDelMese == giornoDelMese) {
+            inSospeso.emplace_back(p.descrizione, p.importo, data);
+        }
+    }
+}
+
+/**
+ * @brief Genera la prossima transazione
+ * @return Transazione Transazione generata
+ */
+Transazione GeneratoreTransazioni::prossima() {
+    if (!inSospeso.empty()) {
+        Transazione t = inSospeso.front();
+        inSospeso.pop_front();
+        return t;
+    }
+    uniform_real_distribution<double> uniforme(0.0, 1.0);
+    if (uniforme(generatore) * parametri.righePerGiorno < 1.0) {
+        avanzaGiorno();
+        if (!inSospeso.empty()) {
+            return prossima();
+        }
+    }
+
+    const string& descrizione = descrizioneCasuale();
+    lognormal_distribution<double> importi(log(parametri.medianaImporto), parametri.dispersioneImporto);
+    double importo = round(importi(generatore) * 100.0) / 100.0;
+    if (importo == 0.0) {
+        importo = 0.01;
+    }
+    if (uniforme(generatore) >= parametri.quotaEntrate) {
+        importo = -importo;
+    }
+    int data = giorno;
+    if (parametri.ritardoMassimo > 0 && uniforme(generatore) < parametri.quotaRitardi) {
+        data -= uniform_int_distribution<int>(1, parametri.ritardoMassimo)(generatore);
+    }
+    return Transazione(descrizione, importo, giorniInData(data));
+}
+
+/**
+ * @brief Genera più transazioni consecutive
+ * @param righe Numero di transazioni
+ * @return vector<Transazione> Transazioni generate
+ */
+vector<Transazione> GeneratoreTransazioni::genera(size_t righe) {
+    vector<Transazione> risultati;
+    risultati.reserve(righe);
+    for (size_t i = 0; i < righe; i++) {
+        risultati.push_back(prossima());
+    }
+    return risultati;
+}
+
+/**
+ * @brief Sceglie una descrizione con probabilità proporzionale a 1/k^s
+ * @return const string& Descrizione scelta
+ */
+const string& GeneratoreTransazioni::descrizioneCasuale() {
+    double u = uniform_real_distribution<double>(0.0, 1.0)(generatore);
+    size_t k = lower_bound(cumulata.begin(), cumulata.end(), u) - cumulata.begin();
+    return descrizioni[min(k, descrizioni.size() - 1)];
+}
+
+/**
+ * @brief Getter per il vocabolario
+ * @return const vector<string>& Descrizioni in ordine di popolarità
+ */
+const vector<string>& GeneratoreTransazioni::getVocabolario() const {
+    return descrizioni;
+}
+
+/**
+ * @brief Getter per la data corrente
+ * @return string Data corrente
+ */
+string GeneratoreTransazioni::getDataCorrente() const {
+    return giorniInData(giorno);
+}
@@ -0,0 +1,119 @@
+#ifndef GENERATORECARICO_H
+#define GENERATORECARICO_H
+
+#include "transazione.h"
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Pagamento che si ripete ogni mese nello stesso giorno
+ */
+struct PagamentoRicorrente {
+    string descrizione;   /**< Descrizione usata in ogni occorrenza */
+    double importo;       /**< Importo (negativo per le uscite) */
+    int giornoDelMese;    /**< Giorno del mese (1-28) */
+};
+
+/**
+ * @brief Parametri delle distribuzioni usate da GeneratoreTransazioni
+ */
+struct ParametriGeneratore {
+    uint64_t seme = 42;                     /**< Seme del generatore pseudo-casuale */
+    string dataIniziale = "2021-01-01";     /**< Data della prima transazione */
+    double righePerGiorno = 40.0;           /**< Numero medio di transazioni al giorno */
+    size_t vocabolario = 2000;              /**< Descrizioni distinte dei movimenti non ricorrenti */
+    double esponenteZipf = 1.1;             /**< Popolarità delle descrizioni: la k-esima ha peso 1/k^s */
+    double medianaImporto = 25.0;           /**< Mediana degli importi (distribuzione log-normale) */
+    double dispersioneImporto = 1.0;        /**< Deviazione standard del logaritmo degli importi */
+    double quotaEntrate = 0.05;             /**< Frazione dei movimenti non ricorrenti con importo positivo */
+    double quotaRitardi = 0.05;             /**< Frazione delle transazioni registrate con data passata */
+    int ritardoMassimo = 10;                /**< Ritardo massimo in giorni */
+    vector<PagamentoRicorrente> ricorrenti = {
+        {"Stipendio", 2100.0, 27},
+        {"Bonifico affitto", -750.0, 1},
+        {"Bolletta luce", -65.0, 15},
+        {"Abbonamento palestra", -40.0, 5},
+        {"Rata mutuo auto", -230.0, 10}};   /**< Pagamenti mensili */
+};
+
+/**
+ * @brief Generatore di estratti conto sintetici ma realistici
+ *
+ * Produce transazioni in ordine (quasi) cronologico:
+ * - le date avanzano in media di un giorno ogni righePerGiorno righe;
+ *   una quota di righe arriva in ritardo con una data passata;
+ * - le descrizioni sono scelte da un vocabolario con popolarità di Zipf,
+ *   così poche descrizioni coprono la maggior parte dei movimenti;
+ * - gli importi seguono una log-normale arrotondata al centesimo;
+ * - i pagamenti ricorrenti sono emessi una volta al mese nel loro giorno.
+ *
+ * Con lo stesso seme e la stessa libreria standard la sequenza è ripetibile.
+ */
+class GeneratoreTransazioni {
+private:
+    ParametriGeneratore parametri;    /**< Parametri delle distribuzioni */
+    mt19937_64 generatore;            /**< Sorgente pseudo-casuale */
+    vector<string> descrizioni;       /**< Vocabolario, in ordine di popolarità decrescente */
+    vector<double> cumulata;          /**< Distribuzione cumulata di Zipf sul vocabolario */
+    int giorno;                       /**< Giorno corrente (giorni dal 1970-01-01) */
+    deque<Transazione> inSospeso;     /**< Pagamenti ricorrenti ancora da emettere */
+
+    /**
+     * @brief Costruisce il vocabolario combinando tipi di operazione ed esercenti
+     */
+    void costruisciVocabolario();
+
+    /**
+     * @brief Passa al giorno successivo accodando i ricorrenti che scadono
+     */
+    void avanzaGiorno();
+
+public:
+    /**
+     * @brief Costruttore
+     * @param parametri Parametri delle distribuzioni
+     * @throws std::invalid_argument Se i parametri non sono validi
+     */
+    explicit GeneratoreTransazioni(const ParametriGeneratore& parametri = ParametriGeneratore());
+
+    /**
+     * @brief Genera la prossima transazione
+     * @return Transazione Transazione generata
+     */
+    Transazione prossima();
+
+    /**
+     * @brief Genera più transazioni consecutive
+     * @param righe Numero di transazioni
+     * @return vector<Transazione> Transazioni generate
+     */
+    vector<Transazione> genera(size_t righe);
+
+    /**
+     * @brief Sceglie una descrizione del vocabolario con la distribuzione di Zipf
+     * @return const string& Descrizione scelta
+     *
+     * Utile ai driver di carico per cercare parole con la stessa frequenza
+     * con cui compaiono nei dati.
+     */
+    const string& descrizioneCasuale();
+
+    /**
+     * @brief Restituisce il vocabolario delle descrizioni non ricorrenti
+     * @return const vector<string>& Descrizioni, dalla più alla meno frequente
+     */
+    const vector<string>& getVocabolario() const;
+
+    /**
+     * @brief Restituisce la data corrente del generatore
+     * @return string Data in formato YYYY-MM-DD
+     */
+    string getDataCorrente() const;
+};
+
+#endif // GENERATORECARICO_H
@@ -0,0 +1,318 @@
+#include "indiceapprossimato.h"
+#include "utilita.h"
+#include <algorithm>
+#include <cstdlib>
+#include <tuple>
+
+using namespace std;
+
+/**
+ * @brief Byte di riempimento ai bordi delle parole (non compare nel testo normalizzato)
+ */
+static constexpr unsigned char BORDO = 0;
+
+/**
+ * @brief Crea un indice vuoto con una lista per ciascuno dei 65536 bigrammi
+ */
+IndiceApprossimato::IndiceApprossimato() : bigrammi(65536) {}
+
+/**
+ * @brief Separa un testo normalizzato in parole
+ * @param normalizzato Testo normalizzato
+ * @return vector<string> Sequenze di lettere (anche UTF-8) e cifre
+ *
+ * Spazi e punteggiatura ASCII separano le parole; i byte non ASCII fanno
+ * parte della parola, così le lettere accentate non la spezzano.
+ */
+vector<string> IndiceApprossimato::dividiInParole(const string& normalizzato) {
+    vector<string> risultato;
+    string corrente;
+    for (unsigned char c : normalizzato) {
+        if (c >= 0x80 || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) {
+            corrente.push_back(static_cast<char>(c));
+        } else if (!corrente.empty()) {
+            risultato.push_back(move(corrente));
+            corrente.clear();
+        }
+    }
+    if (!corrente.empty()) {
+        risultato.push_back(move(corrente));
+    }
+    return risultato;
+}
+
+/**
+ * @brief Calcola la distanza di Levenshtein (sui byte) entro una soglia
+ * @param a Prima parola
+ * @param b Seconda parola
+ * @param massima Distanza oltre la quale il calcolo si interrompe
+ * @return int Distanza, oppure massima + 1 se la supera
+ *
+ * Programmazione dinamica su due righe; si interrompe appena il minimo di una
+ * riga supera la soglia, perché le righe successive non possono scendere.
+ */
+int IndiceApprossimato::distanzaModifica(const string& a, const string& b, int massima) {
+    int n = static_cast<int>(a.size());
+    int m = static_cast<int>(b.size());
+    if (abs(n - m) > massima) {
+        return massima + 1;
+    }
+    vector<int> precedente(m + 1);
+    vector<int> corrente(m + 1);
+    for (int j = 0; j <= m; j++) {
+        precedente[j] = j;
+    }
+    for (int i = 1; i <= n; i++) {
+        corrente[0] = i;
+        int minimoRiga = i;
+        for (int j = 1; j <= m; j++) {
+            int sostituzione = precedente[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1);
+            corrente[j] = min({sostituzione, precedente[j] + 1, corrente[j - 1] + 1});
+            minimoRiga = min(minimoRiga, corrente[j]);
+        }
+        if (minimoRiga > massima) {
+            return massima + 1;
+        }
+        swap(precedente, corrente);
+    }
+    return min(precedente[m], massima + 1);
+}
+
+/**
+ * @brief Distanza tollerata per una parola di una certa lunghezza
+ * @param lunghezza Byte della parola
+ * @return int 0 fino a 2 byte, 1 fino a 5, altrimenti 2
+ */
+int IndiceApprossimato::distanzaPredefinita(size_t lunghezza) {
+    if (lunghezza <= 2) {
+        return 0;
+    }
+    return lunghezza <= 5 ? 1 : 2;
+}
+
+/**
+ * @brief Calcola i bigrammi distinti di una parola, ordinati
+ * @param parola Parola normalizzata
+ * @return vector<uint16_t> Bigrammi della parola con BORDO all'inizio e alla fine
+ */
+vector<uint16_t> IndiceApprossimato::bigrammiDi(const string& parola) {
+    vector<uint16_t> risultato;
+    risultato.reserve(parola.size() + 1);
+    unsigned char precedente = BORDO;
+    for (unsigned char c : parola) {
+        risultato.push_back(static_cast<uint16_t>((precedente << 8) | c));
+        precedente = c;
+    }
+    risultato.push_back(static_cast<uint16_t>((precedente << 8) | BORDO));
+    sort(risultato.begin(), risultato.end());
+    risultato.erase(unique(risultato.begin(), risultato.end()), risultato.end());
+    return risultato;
+}
+
+/**
+ * @brief Restituisce la posizione di una parola, registrandola se è nuova
+ * @param parola Parola normalizzata
+ * @return uint32_t Posizione in parole
+ */
+uint32_t IndiceApprossimato::registraParola(const string& parola) {
+    auto it = indiceParole.find(parola);
+    if (it != indiceParole.end()) {
+        return it->second;
+    }
+    uint32_t posizione = static_cast<uint32_t>(parole.size());
+    vector<uint16_t> propri = bigrammiDi(parola);
+    for (uint16_t g : propri) {
+        bigrammi[g].push_back(posizione);
+    }
+    parole.push_back({parola, static_cast<uint32_t>(propri.size()), {}});
+    indiceParole.emplace(parola, posizione);
+    return posizione;
+}
+
+/**
+ * @brief Registra una transazione
+ * @param descrizione Descrizione della transazione
+ * @param id Identificativo della transazione
+ *
+ * Una descrizione già vista costa solo la normalizzazione e una ricerca
+ * nella tabella; le parole vengono indicizzate alla prima occorrenza.
+ */
+void IndiceApprossimato::aggiungi(const string& descrizione, uint64_t id) {
+    normalizzaDescrizione(descrizione, bufferNormalizzato);
+    auto it = indiceDescrizioni.find(bufferNormalizzato);
+    uint32_t posizione;
+    if (it != indiceDescrizioni.end()) {
+        posizione = it->second;
+    } else {
+        posizione = static_cast<uint32_t>(descrizioni.size());
+        descrizioni.push_back({descrizione, {}});
+        indiceDescrizioni.emplace(bufferNormalizzato, posizione);
+        vector<uint32_t> paroleDescrizione;
+        for (const string& parola : dividiInParole(bufferNormalizzato)) {
+            paroleDescrizione.push_back(registraParola(parola));
+        }
+        sort(paroleDescrizione.begin(), paroleDescrizione.end());
+        paroleDescrizione.erase(unique(paroleDescrizione.begin(), paroleDescrizione.end()), paroleDescrizione.end());
+        for (uint32_t p : paroleDescrizione) {
+            parole[p].descrizioni.push_back(posizione);
+        }
+    }
+    descrizioni[posizione].id.push_back(id);
+}
+
+/**
+ * @brief Trova le parole dell'indice entro una distanza da una parola
+ * @param parola Parola normalizzata cercata
+ * @param massima Distanza massima
+ * @return vector<pair<uint32_t, int>> Coppie (parola, distanza)
+ *
+ * Filtro sui bigrammi: ogni modifica altera al più due bigrammi, quindi una
+ * parola entro distanza k condivide almeno max(|A|, |B|) - 2k bigrammi
+ * distinti con quella cercata. Se la soglia non è positiva il filtro non
+ * esclude nulla e si confrontano tutte le parole di lunghezza compatibile.
+ */
+vector<pair<uint32_t, int>> IndiceApprossimato::paroleVicine(const string& parola, int massima) const {
+    vector<pair<uint32_t, int>> risultato;
+    vector<uint16_t> cercati = bigrammiDi(parola);
+    int soglia = static_cast<int>(cercati.size()) - 2 * massima;
+    auto verifica = [&](uint32_t p) {
+        if (abs(static_cast<int>(parole[p].testo.size()) - static_cast<int>(parola.size())) > massima) {
+            return;
+        }
+        int distanza = distanzaModifica(parola, parole[p].testo, massima);
+        if (distanza <= massima) {
+            risultato.emplace_back(p, distanza);
+        }
+    };
+
+    if (soglia <= 0) {
+        for (uint32_t p = 0; p < parole.size(); p++) {
+            verifica(p);
+        }
+        return risultato;
+    }
+
+    vector<uint32_t> conteggi(parole.size(), 0);
+    vector<uint32_t> toccate;
+    for (uint16_t g : cercati) {
+        for (uint32_t p : bigrammi[g]) {
+            if (conteggi[p]++ == 0) {
+                toccate.push_back(p);
+            }
+        }
+    }
+    for (uint32_t p : toccate) {
+        int comuni = static_cast<int>(conteggi[p]);
+        if (comuni >= soglia && comuni >= static_cast<int>(parole[p].bigrammiDistinti) - 2 * massima) {
+            verifica(p);
+        }
+    }
+    return risultato;
+}
+
+/**
+ * @brief Cerca le descrizioni simili a un testo
+ * @param testo Una o più parole, anche con errori di battitura
+ * @param maxRisultati Numero massimo di descrizioni restituite
+ * @param maxDistanza Distanza massima per parola (negativa = distanzaPredefinita)
+ * @return vector<DescrizioneApprossimata> Descrizioni ordinate per distanza
+ *         crescente e, a parità, per numero di transazioni decrescente
+ */
+vector<DescrizioneApprossimata> IndiceApprossimato::cerca(const string& testo, size_t maxRisultati, int maxDistanza) const {
+    vector<string> cercate = dividiInParole(normalizzaDescrizione(testo));
+    if (cercate.empty() || maxRisultati == 0) {
+        return {};
+    }
+
+    // Per ogni descrizione, somma delle distanze minime delle parole cercate;
+    // una descrizione resta candidata solo se tutte le parole la raggiungono.
+    unordered_map<uint32_t, int> punteggi;
+    for (size_t i = 0; i < cercate.size(); i++) {
+        int massima = maxDistanza < 0 ? distanzaPredefinita(cercate[i].size()) : maxDistanza;
+        unordered_map<uint32_t, int> migliori;
+        for (const auto& [p, distanza] : paroleVicine(cercate[i], massima)) {
+            for (uint32_t d : parole[p].descrizioni) {
+                auto [it, nuova] = migliori.emplace(d, distanza);
+                if (!nuova) {
+                    it->second = min(it->second, distanza);
+                }
+            }
+        }
+        if (i == 0) {
+            punteggi = move(migliori);
+            continue;
+        }
+        unordered_map<uint32_t, int> intersezione;
+        for (const auto& [d, distanza] : punteggi) {
+            auto it = migliori.find(d);
+            if (it != migliori.end()) {
+                intersezione.emplace(d, distanza + it->second);
+            }
+        }
+        punteggi = move(intersezione);
+        if (punteggi.empty()) {
+            return {};
+        }
+    }
+
+    vector<pair<uint32_t, int>> ordinati(punteggi.begin(), punteggi.end());
+    auto precede = [this](const pair<uint32_t, int>& a, const pair<uint32_t, int>& b) {
+        return make_tuple(a.second, -static_cast<int64_t>(descrizioni[a.first].id.size()), a.first) <
+               make_tuple(b.second, -static_cast<int64_t>(descrizioni[b.first].id.size()), b.first);
+    };
+    size_t quanti = min(maxRisultati, ordinati.size());
+    partial_sort(ordinati.begin(), ordinati.begin() + quanti, ordinati.end(), precede);
+
+    vector<DescrizioneApprossimata> risultato;
+    risultato.reserve(quanti);
+    for (size_t i = 0; i < quanti; i++) {
+        const Descrizione& d = descrizioni[ordinati[i].first];
+        risultato.push_back({d.originale, ordinati[i].second, d.id});
+    }
+    return risultato;
+}
+
+/**
+ * @brief Restituisce il numero di descrizioni distinte
+ * @return size_t Descrizioni indicizzate
+ */
+size_t IndiceApprossimato::getNumeroDescrizioni() const {
+    return descrizioni.size();
+}
+
+/**
+ * @brief Restituisce il numero di parole distinte
+ * @return size_t Parole indicizzate
+ */
+size_t IndiceApprossimato::getNumeroParole() const {
+    return parole.size();
+}
+
+/**
+ * @brief Restituisce la memoria occupata dall'indice (stima)
+ * @return size_t Byte allocati
+ *
+ * Le tabelle hash sono stimate con un nodo (chiave, valore, puntatore) per
+ * elemento più l'array dei bucket.
+ */
+size_t IndiceApprossimato::getUsoMemoria() const {
+    size_t totale = parole.capacity() * sizeof(Parola) + descrizioni.capacity() * sizeof(Descrizione) +
+                    bigrammi.capacity() * sizeof(vector<uint32_t>);
+    for (const Parola& p : parole) {
+        totale += memoriaEsterna(p.testo) + p.descrizioni.capacity() * sizeof(uint32_t);
+    }
+    for (const Descrizione& d : descrizioni) {
+        totale += memoriaEsterna(d.originale) + d.id.capacity() * sizeof(uint64_t);
+    }
+    for (const vector<uint32_t>& lista : bigrammi) {
+        totale += lista.capacity() * sizeof(uint32_t);
+    }
+    for (const auto& [chiave, valore] : indiceParole) {
+        totale += sizeof(chiave) + sizeof(valore) + sizeof(void*) + memoriaEsterna(chiave);
+    }
+    for (const auto& [chiave, valore] : indiceDescrizioni) {
+        totale += sizeof(chiave) + sizeof(valore) + sizeof(void*) + memoriaEsterna(chiave);
+    }
+    totale += (indiceParole.bucket_count() + indiceDescrizioni.bucket_count()) * sizeof(void*);
+    return totale;
+}
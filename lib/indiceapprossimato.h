@@ -0,0 +1,138 @@
+#ifndef INDICEAPPROSSIMATO_H
+#define INDICEAPPROSSIMATO_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Descrizione trovata da una ricerca approssimata
+ */
+struct DescrizioneApprossimata {
+    string descrizione;        /**< Descrizione come è stata inserita la prima volta */
+    int distanza;              /**< Somma delle distanze di modifica delle parole cercate */
+    vector<uint64_t> id;       /**< Identificativi delle transazioni con questa descrizione */
+};
+
+/**
+ * @brief Indice per la ricerca tollerante agli errori di battitura
+ *
+ * Indicizza le descrizioni distinte (normalizzate come in
+ * normalizzaDescrizione) e le parole distinte che le compongono. Per ogni
+ * parola sono registrati i bigrammi, con un byte di riempimento ai bordi, in
+ * liste invertite. Una parola a distanza di modifica k dalla parola cercata
+ * perde al più 2k bigrammi distinti, quindi i candidati si ottengono contando
+ * i bigrammi in comune nelle liste e solo questi vengono verificati con la
+ * distanza di Levenshtein. Il costo di una ricerca dipende dal numero di
+ * parole distinte che condividono bigrammi con quella cercata, non dal
+ * numero di transazioni.
+ */
+class IndiceApprossimato {
+private:
+    struct Parola {
+        string testo;                      /**< Parola normalizzata */
+        uint32_t bigrammiDistinti;         /**< Numero di bigrammi distinti */
+        vector<uint32_t> descrizioni;      /**< Descrizioni che contengono la parola */
+    };
+    struct Descrizione {
+        string originale;                  /**< Prima forma inserita */
+        vector<uint64_t> id;               /**< Transazioni con questa descrizione */
+    };
+
+    vector<Parola> parole;                            /**< Parole distinte */
+    unordered_map<string, uint32_t> indiceParole;     /**< Parola -> posizione in parole */
+    vector<Descrizione> descrizioni;                  /**< Descrizioni distinte */
+    unordered_map<string, uint32_t> indiceDescrizioni;  /**< Descrizione normalizzata -> posizione */
+    vector<vector<uint32_t>> bigrammi;                /**< Bigramma (16 bit) -> parole che lo contengono */
+    string bufferNormalizzato;                        /**< Buffer riutilizzato da aggiungi */
+
+    /**
+     * @brief Calcola i bigrammi distinti di una parola, ordinati
+     */
+    static vector<uint16_t> bigrammiDi(const string& parola);
+
+    /**
+     * @brief Restituisce la posizione di una parola, registrandola se è nuova
+     */
+    uint32_t registraParola(const string& parola);
+
+    /**
+     * @brief Trova le parole dell'indice entro una distanza da una parola
+     * @param parola Parola normalizzata cercata
+     * @param massima Distanza massima
+     * @return vector<pair<uint32_t, int>> Coppie (parola, distanza)
+     */
+    vector<pair<uint32_t, int>> paroleVicine(const string& parola, int massima) const;
+
+public:
+    /**
+     * @brief Crea un indice vuoto
+     */
+    IndiceApprossimato();
+
+    /**
+     * @brief Separa un testo normalizzato in parole
+     * @param normalizzato Testo normalizzato
+     * @return vector<string> Sequenze di lettere (anche UTF-8) e cifre
+     */
+    static vector<string> dividiInParole(const string& normalizzato);
+
+    /**
+     * @brief Calcola la distanza di Levenshtein (sui byte) entro una soglia
+     * @param a Prima parola
+     * @param b Seconda parola
+     * @param massima Distanza oltre la quale il calcolo si interrompe
+     * @return int Distanza, oppure massima + 1 se la supera
+     */
+    static int distanzaModifica(const string& a, const string& b, int massima);
+
+    /**
+     * @brief Distanza tollerata per una parola di una certa lunghezza
+     * @param lunghezza Byte della parola
+     * @return int 0 fino a 2 byte, 1 fino a 5, altrimenti 2
+     */
+    static int distanzaPredefinita(size_t lunghezza);
+
+    /**
+     * @brief Registra una transazione
+     * @param descrizione Descrizione della transazione
+     * @param id Identificativo della transazione
+     */
+    void aggiungi(const string& descrizione, uint64_t id);
+
+    /**
+     * @brief Cerca le descrizioni simili a un testo
+     * @param testo Una o più parole, anche con errori di battitura
+     * @param maxRisultati Numero massimo di descrizioni restituite
+     * @param maxDistanza Distanza massima per parola (negativa = distanzaPredefinita)
+     * @return vector<DescrizioneApprossimata> Descrizioni ordinate per distanza
+     *         crescente e, a parità, per numero di transazioni decrescente
+     *
+     * Ogni parola cercata deve corrispondere, entro la distanza, ad almeno
+     * una parola della descrizione.
+     */
+    vector<DescrizioneApprossimata> cerca(const string& testo, size_t maxRisultati, int maxDistanza = -1) const;
+
+    /**
+     * @brief Restituisce il numero di descrizioni distinte
+     * @return size_t Descrizioni indicizzate
+     */
+    size_t getNumeroDescrizioni() const;
+
+    /**
+     * @brief Restituisce il numero di parole distinte
+     * @return size_t Parole indicizzate
+     */
+    size_t getNumeroParole() const;
+
+    /**
+     * @brief Restituisce la memoria occupata dall'indice (stima)
+     * @return size_t Byte allocati
+     */
+    size_t getUsoMemoria() const;
+};
+
+#endif // INDICEAPPROSSIMATO_H
@@ -0,0 +1,363 @@
+#include "indiceblocchi.h"
+#include "utilita.h"
+#include <algorithm>
+
+using namespace std;
+
+static const char FIRMA_INDICE[4] = {'C', 'C', 'B', '1'};
+static const uint32_t BIT_PER_CHIAVE = 10;
+static const uint32_t NUMERO_HASH = 7;
+
+/**
+ * @brief Rimescola i bit di un valore (finalizzatore di splitmix64)
+ */
+static uint64_t mescola(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * @brief Accumula i byte di un testo in un hash FNV-1a
+ */
+static uint64_t accumulaFnv(uint64_t h, const string& testo) {
+    for (char c : testo) {
+        h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/**
+ * @brief Scrive un intero senza segno a 64 bit in little endian
+ */
+static void scriviIntero(ostream& out, uint64_t valore) {
+    char byte[8];
+    for (int i = 0; i < 8; i++) {
+        byte[i] = static_cast<char>((valore >> (8 * i)) & 0xFF);
+    }
+    out.write(byte, 8);
+}
+
+/**
+ * @brief Legge un intero senza segno a 64 bit in little endian
+ * @return bool false se lo stream è terminato
+ */
+static bool leggiIntero(istream& in, uint64_t& valore) {
+    unsigned char byte[8];
+    in.read(reinterpret_cast<char*>(byte), 8);
+    if (in.gcount() != 8) {
+        return false;
+    }
+    valore = 0;
+    for (int i = 0; i < 8; i++) {
+        valore |= static_cast<uint64_t>(byte[i]) << (8 * i);
+    }
+    return true;
+}
+
+/**
+ * @brief Costruttore: dimensiona il filtro per il numero di chiavi previsto
+ * @param chiavi Numero di chiavi distinte previste
+ */
+FiltroBloom::FiltroBloom(size_t chiavi)
+    : bit((max<size_t>(chiavi, 1) * BIT_PER_CHIAVE + 63) / 64, 0), numeroHash(NUMERO_HASH) {
+}
+
+/**
+ * @brief Imposta i bit della chiave
+ * @param chiave Hash della chiave
+ *
+ * Le posizioni sono ricavate con il doppio hashing h1 + i * h2.
+ */
+void FiltroBloom::aggiungi(uint64_t chiave) {
+    uint64_t totale = bit.size() * 64;
+    uint64_t h1 = mescola(chiave);
+    uint64_t h2 = mescola(h1) | 1;
+    for (uint32_t i = 0; i < numeroHash; i++) {
+        uint64_t posizione = (h1 + i * h2) % totale;
+        bit[posizione / 64] |= 1ULL << (posizione % 64);
+    }
+}
+
+/**
+ * @brief Verifica i bit della chiave
+ * @param chiave Hash della chiave
+ * @return bool false se almeno un bit non è impostato
+ */
+bool FiltroBloom::puoContenere(uint64_t chiave) const {
+    uint64_t totale = bit.size() * 64;
+    uint64_t h1 = mescola(chiave);
+    uint64_t h2 = mescola(h1) | 1;
+    for (uint32_t i = 0; i < numeroHash; i++) {
+        uint64_t posizione = (h1 + i * h2) % totale;
+        if (!(bit[posizione / 64] & (1ULL << (posizione % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Memoria occupata dal filtro
+ * @return size_t Byte dell'array di bit
+ */
+size_t FiltroBloom::getUsoMemoria() const {
+    return bit.capacity() * sizeof(uint64_t);
+}
+
+/**
+ * @brief Scrive numero di hash, numero di parole e parole del filtro
+ * @param out Stream di output
+ */
+void FiltroBloom::scrivi(ostream& out) const {
+    scriviIntero(out, numeroHash);
+    scriviIntero(out, bit.size());
+    for (uint64_t parola : bit) {
+        scriviIntero(out, parola);
+    }
+}
+
+/**
+ * @brief Legge un filtro
+ * @param in Stream di input
+ * @return bool false se i dati sono troncati o non validi
+ */
+bool FiltroBloom::leggi(istream& in) {
+    uint64_t hash, parole;
+    if (!leggiIntero(in, hash) || !leggiIntero(in, parole) || hash == 0 || hash > 64 ||
+        parole == 0 || parole > (1ULL << 26)) {
+        return false;
+    }
+    vector<uint64_t> letti(parole);
+    for (uint64_t& parola : letti) {
+        if (!leggiIntero(in, parola)) {
+            return false;
+        }
+    }
+    bit = move(letti);
+    numeroHash = static_cast<uint32_t>(hash);
+    return true;
+}
+
+/**
+ * @brief Calcola l'impronta di un blocco completo
+ * @param transazioni Righe del conto
+ * @param inizio Prima riga del blocco
+ * @return uint64_t Hash FNV-1a di descrizioni, date e centesimi
+ */
+uint64_t IndiceBlocchi::improntaBlocco(const vector<Transazione>& transazioni, size_t inizio) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = inizio; i < inizio + RIGHE_PER_BLOCCO; i++) {
+        const Transazione& t = transazioni[i];
+        h = accumulaFnv(h, t.getDescrizione());
+        h = accumulaFnv(h ^ 0xFF, t.getData());
+        h = mescola(h ^ static_cast<uint64_t>(importoInCentesimi(t.getImporto())));
+    }
+    return h;
+}
+
+/**
+ * @brief Raccoglie le chiavi distinte di date e trigrammi e costruisce i filtri
+ * @param transazioni Righe del conto
+ * @param inizio Prima riga del blocco
+ * @return Blocco Filtri dimensionati sul numero di chiavi distinte
+ */
+IndiceBlocchi::Blocco IndiceBlocchi::costruisciBlocco(const vector<Transazione>& transazioni, size_t inizio) {
+    vector<uint64_t> date;
+    vector<uint64_t> trigrammi;
+    date.reserve(RIGHE_PER_BLOCCO);
+    string piegata;
+    for (size_t i = inizio; i < inizio + RIGHE_PER_BLOCCO; i++) {
+        const Transazione& t = transazioni[i];
+        date.push_back(chiaveData(t.getData()));
+
+        const string& descrizione = t.getDescrizione();
+        piegata.resize(descrizione.size());
+        unsigned char precedente = 0;
+        for (size_t k = 0; k < descrizione.size(); k++) {
+            unsigned char byte = static_cast<unsigned char>(descrizione[k]);
+            piegata[k] = static_cast<char>(piegaByte(precedente, byte));
+            precedente = byte;
+        }
+        vector<uint64_t> chiavi = chiaviParola(piegata);
+        trigrammi.insert(trigrammi.end(), chiavi.begin(), chiavi.end());
+    }
+    sort(date.begin(), date.end());
+    date.erase(unique(date.begin(), date.end()), date.end());
+    sort(trigrammi.begin(), trigrammi.end());
+    trigrammi.erase(unique(trigrammi.begin(), trigrammi.end()), trigrammi.end());
+
+    Blocco blocco{improntaBlocco(transazioni, inizio), FiltroBloom(date.size()), FiltroBloom(trigrammi.size())};
+    for (uint64_t chiave : date) {
+        blocco.date.aggiungi(chiave);
+    }
+    for (uint64_t chiave : trigrammi) {
+        blocco.trigrammi.aggiungi(chiave);
+    }
+    return blocco;
+}
+
+/**
+ * @brief Costruisce i filtri dei nuovi blocchi completi
+ * @param transazioni Righe del conto
+ * @param righeStabili Righe che possono essere indicizzate
+ */
+void IndiceBlocchi::aggiorna(const vector<Transazione>& transazioni, size_t righeStabili) {
+    righeStabili = min(righeStabili, transazioni.size());
+    while ((blocchi.size() + 1) * RIGHE_PER_BLOCCO <= righeStabili) {
+        blocchi.push_back(costruisciBlocco(transazioni, blocchi.size() * RIGHE_PER_BLOCCO));
+    }
+}
+
+/**
+ * @brief Elimina i filtri dal blocco della riga in poi
+ * @param riga Prima riga modificata
+ */
+void IndiceBlocchi::invalidaDa(size_t riga) {
+    size_t blocco = riga / RIGHE_PER_BLOCCO;
+    if (blocco < blocchi.size()) {
+        blocchi.resize(blocco);
+    }
+}
+
+/**
+ * @brief Elimina tutti i filtri
+ */
+void IndiceBlocchi::svuota() {
+    blocchi.clear();
+}
+
+/**
+ * @brief Getter per il numero di blocchi indicizzati
+ * @return size_t Numero di blocchi
+ */
+size_t IndiceBlocchi::getNumeroBlocchi() const {
+    return blocchi.size();
+}
+
+/**
+ * @brief Fine del blocco che contiene la riga
+ * @param riga Riga
+ * @return size_t Prima riga del blocco successivo
+ */
+size_t IndiceBlocchi::fineBlocco(size_t riga) {
+    return (riga / RIGHE_PER_BLOCCO + 1) * RIGHE_PER_BLOCCO;
+}
+
+/**
+ * @brief Chiave di una data
+ * @param data Data
+ * @return uint64_t Hash FNV-1a della data
+ */
+uint64_t IndiceBlocchi::chiaveData(const string& data) {
+    return accumulaFnv(0xcbf29ce484222325ULL, data);
+}
+
+/**
+ * @brief Chiavi dei trigrammi di un testo piegato
+ * @param piegata Testo già convertito in minuscolo
+ * @return vector<uint64_t> Chiavi distinte ordinate
+ */
+vector<uint64_t> IndiceBlocchi::chiaviParola(const string& piegata) {
+    vector<uint64_t> chiavi;
+    if (piegata.size() < 3) {
+        return chiavi;
+    }
+    chiavi.reserve(piegata.size() - 2);
+    for (size_t k = 0; k + 3 <= piegata.size(); k++) {
+        chiavi.push_back(static_cast<uint64_t>(static_cast<unsigned char>(piegata[k])) |
+                         static_cast<uint64_t>(static_cast<unsigned char>(piegata[k + 1])) << 8 |
+                         static_cast<uint64_t>(static_cast<unsigned char>(piegata[k + 2])) << 16);
+    }
+    sort(chiavi.begin(), chiavi.end());
+    chiavi.erase(unique(chiavi.begin(), chiavi.end()), chiavi.end());
+    return chiavi;
+}
+
+/**
+ * @brief Verifica se il blocco della riga esclude la data
+ * @param riga Riga del blocco
+ * @param chiave Chiave della data
+ * @return bool true se la data è sicuramente assente dal blocco
+ */
+bool IndiceBlocchi::escludeData(size_t riga, uint64_t chiave) const {
+    size_t blocco = riga / RIGHE_PER_BLOCCO;
+    return blocco < blocchi.size() && !blocchi[blocco].date.puoContenere(chiave);
+}
+
+/**
+ * @brief Verifica se il blocco della riga esclude la parola
+ * @param riga Riga del blocco
+ * @param chiavi Chiavi dei trigrammi della parola
+ * @return bool true se almeno un trigramma è sicuramente assente dal blocco
+ */
+bool IndiceBlocchi::escludeParola(size_t riga, const vector<uint64_t>& chiavi) const {
+    size_t blocco = riga / RIGHE_PER_BLOCCO;
+    if (blocco >= blocchi.size()) {
+        return false;
+    }
+    for (uint64_t chiave : chiavi) {
+        if (!blocchi[blocco].trigrammi.puoContenere(chiave)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Memoria occupata dai filtri
+ * @return size_t Byte allocati
+ */
+size_t IndiceBlocchi::getUsoMemoria() const {
+    size_t totale = blocchi.capacity() * sizeof(Blocco);
+    for (const Blocco& blocco : blocchi) {
+        totale += blocco.date.getUsoMemoria() + blocco.trigrammi.getUsoMemoria();
+    }
+    return totale;
+}
+
+/**
+ * @brief Scrive firma, righe per blocco, numero di blocchi e filtri
+ * @param out Stream di output (aperto in modalità binaria)
+ */
+void IndiceBlocchi::salva(ostream& out) const {
+    out.write(FIRMA_INDICE, 4);
+    scriviIntero(out, RIGHE_PER_BLOCCO);
+    scriviIntero(out, blocchi.size());
+    for (const Blocco& blocco : blocchi) {
+        scriviIntero(out, blocco.impronta);
+        blocco.date.scrivi(out);
+        blocco.trigrammi.scrivi(out);
+    }
+}
+
+/**
+ * @brief Legge i filtri salvati fermandosi al primo blocco non valido
+ * @param in Stream di input (aperto in modalità binaria)
+ * @param transazioni Righe caricate
+ * @return size_t Numero di blocchi riutilizzati
+ */
+size_t IndiceBlocchi::carica(istream& in, const vector<Transazione>& transazioni) {
+    blocchi.clear();
+    char firma[4];
+    in.read(firma, 4);
+    uint64_t righePerBlocco, numero;
+    if (in.gcount() != 4 || !equal(firma, firma + 4, FIRMA_INDICE) ||
+        !leggiIntero(in, righePerBlocco) || righePerBlocco != RIGHE_PER_BLOCCO || !leggiIntero(in, numero)) {
+        return 0;
+    }
+
+    size_t completi = transazioni.size() / RIGHE_PER_BLOCCO;
+    for (uint64_t b = 0; b < numero && b < completi; b++) {
+        Blocco blocco{0, FiltroBloom(), FiltroBloom()};
+        if (!leggiIntero(in, blocco.impronta) || !blocco.date.leggi(in) || !blocco.trigrammi.leggi(in) ||
+            blocco.impronta != improntaBlocco(transazioni, b * RIGHE_PER_BLOCCO)) {
+            break;
+        }
+        blocchi.push_back(move(blocco));
+    }
+    return blocchi.size();
+}
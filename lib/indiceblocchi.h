@@ -0,0 +1,201 @@
+#ifndef INDICEBLOCCHI_H
+#define INDICEBLOCCHI_H
+
+#include "transazione.h"
+#include <vector>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ * @brief Filtro di Bloom su chiavi a 64 bit
+ *
+ * Risponde "forse presente" o "sicuramente assente": non produce mai falsi
+ * negativi. Viene dimensionato con circa 10 bit per chiave e 7 funzioni di
+ * hash (doppio hashing), per una probabilità di falso positivo intorno all'1%.
+ */
+class FiltroBloom {
+private:
+    vector<uint64_t> bit;     /**< Array di bit, a parole di 64 */
+    uint32_t numeroHash;      /**< Numero di posizioni impostate per chiave */
+
+public:
+    /**
+     * @brief Costruttore
+     * @param chiavi Numero di chiavi distinte previste
+     */
+    explicit FiltroBloom(size_t chiavi = 0);
+
+    /**
+     * @brief Inserisce una chiave
+     * @param chiave Hash della chiave
+     */
+    void aggiungi(uint64_t chiave);
+
+    /**
+     * @brief Verifica se una chiave può essere presente
+     * @param chiave Hash della chiave
+     * @return bool false se la chiave è sicuramente assente
+     */
+    bool puoContenere(uint64_t chiave) const;
+
+    /**
+     * @brief Restituisce la memoria occupata dal filtro
+     * @return size_t Byte allocati
+     */
+    size_t getUsoMemoria() const;
+
+    /**
+     * @brief Scrive il filtro in formato binario
+     * @param out Stream di output
+     */
+    void scrivi(ostream& out) const;
+
+    /**
+     * @brief Legge un filtro scritto con scrivi
+     * @param in Stream di input
+     * @return bool false se i dati sono troncati o non validi
+     */
+    bool leggi(istream& in);
+};
+
+/**
+ * @brief Filtri di Bloom per blocchi di righe consecutive
+ *
+ * Le righe sono suddivise in blocchi di RIGHE_PER_BLOCCO; per ogni blocco
+ * completo vengono costruiti due filtri: uno sulle date e uno sui trigrammi
+ * (sequenze di 3 byte) delle descrizioni convertite in minuscolo come in
+ * ParolaChiave. Una parola di almeno 3 byte contenuta in una descrizione ha
+ * tutti i suoi trigrammi nel filtro del blocco, quindi un blocco in cui ne
+ * manca anche uno solo può essere saltato senza leggere le righe.
+ *
+ * L'ultimo blocco, ancora incompleto, non ha filtri e va sempre scansionato.
+ * Quando le righe di un blocco cambiano posizione i filtri da quel blocco
+ * in poi devono essere invalidati con invalidaDa.
+ */
+class IndiceBlocchi {
+public:
+    static constexpr size_t RIGHE_PER_BLOCCO = 4096;  /**< Righe per blocco */
+
+private:
+    /**
+     * @brief Filtri di un blocco completo
+     */
+    struct Blocco {
+        uint64_t impronta;         /**< Impronta del contenuto, per validare i filtri salvati */
+        FiltroBloom date;          /**< Filtro sulle date */
+        FiltroBloom trigrammi;     /**< Filtro sui trigrammi delle descrizioni */
+    };
+    vector<Blocco> blocchi;        /**< Filtri dei blocchi completi, in ordine */
+
+    /**
+     * @brief Costruisce i filtri di un blocco
+     * @param transazioni Righe del conto
+     * @param inizio Prima riga del blocco
+     * @return Blocco Filtri del blocco
+     */
+    static Blocco costruisciBlocco(const vector<Transazione>& transazioni, size_t inizio);
+
+    /**
+     * @brief Calcola l'impronta di un blocco
+     * @param transazioni Righe del conto
+     * @param inizio Prima riga del blocco
+     * @return uint64_t Hash di descrizioni, date e importi del blocco
+     */
+    static uint64_t improntaBlocco(const vector<Transazione>& transazioni, size_t inizio);
+
+public:
+    /**
+     * @brief Costruisce i filtri dei blocchi completati dopo l'ultimo aggiornamento
+     * @param transazioni Righe del conto
+     * @param righeStabili Righe iniziali che non cambieranno posizione a breve
+     *
+     * Solo i blocchi interamente compresi nelle righe stabili vengono
+     * indicizzati, così le righe che possono ancora spostarsi (ad esempio per
+     * le fusioni della modalità ordinata) non costringono a ricostruire filtri.
+     */
+    void aggiorna(const vector<Transazione>& transazioni, size_t righeStabili);
+
+    /**
+     * @brief Elimina i filtri dei blocchi a partire da quello che contiene la riga
+     * @param riga Prima riga modificata
+     */
+    void invalidaDa(size_t riga);
+
+    /**
+     * @brief Elimina tutti i filtri
+     */
+    void svuota();
+
+    /**
+     * @brief Restituisce il numero di blocchi con filtri
+     * @return size_t Numero di blocchi completi indicizzati
+     */
+    size_t getNumeroBlocchi() const;
+
+    /**
+     * @brief Restituisce la prima riga successiva al blocco che contiene la riga
+     * @param riga Riga
+     * @return size_t Fine (esclusa) del blocco
+     */
+    static size_t fineBlocco(size_t riga);
+
+    /**
+     * @brief Calcola la chiave di una data per i filtri
+     * @param data Data in formato YYYY-MM-DD
+     * @return uint64_t Hash della data
+     */
+    static uint64_t chiaveData(const string& data);
+
+    /**
+     * @brief Calcola le chiavi dei trigrammi di una parola già convertita in minuscolo
+     * @param piegata Parola piegata (vedi ParolaChiave::getPiegata)
+     * @return vector<uint64_t> Chiavi distinte; vuoto se la parola ha meno di 3 byte
+     */
+    static vector<uint64_t> chiaviParola(const string& piegata);
+
+    /**
+     * @brief Verifica se il blocco della riga esclude sicuramente una data
+     * @param riga Riga del blocco
+     * @param chiave Chiave della data (vedi chiaveData)
+     * @return bool true se il blocco ha filtri e non contiene la data
+     */
+    bool escludeData(size_t riga, uint64_t chiave) const;
+
+    /**
+     * @brief Verifica se il blocco della riga esclude sicuramente una parola
+     * @param riga Riga del blocco
+     * @param chiavi Chiavi dei trigrammi (vedi chiaviParola)
+     * @return bool true se il blocco ha filtri e manca almeno un trigramma
+     */
+    bool escludeParola(size_t riga, const vector<uint64_t>& chiavi) const;
+
+    /**
+     * @brief Restituisce la memoria occupata dai filtri
+     * @return size_t Byte allocati
+     */
+    size_t getUsoMemoria() const;
+
+    /**
+     * @brief Scrive i filtri in formato binario
+     * @param out Stream di output
+     */
+    void salva(ostream& out) const;
+
+    /**
+     * @brief Legge i filtri salvati mantenendo solo quelli ancora validi
+     * @param in Stream di input
+     * @param transazioni Righe del conto appena caricate
+     * @return size_t Numero di blocchi riutilizzati
+     *
+     * Un blocco salvato è riutilizzato solo se la sua impronta coincide con
+     * quella delle righe caricate; dal primo blocco diverso in poi i filtri
+     * vanno ricostruiti con aggiorna.
+     */
+    size_t carica(istream& in, const vector<Transazione>& transazioni);
+};
+
+#endif // INDICEBLOCCHI_H
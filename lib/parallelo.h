@@ -0,0 +1,56 @@
+#ifndef PARALLELO_H
+#define PARALLELO_H
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Calcola in quanti blocchi suddividere un lavoro parallelo
+ * @param n Numero totale di elementi
+ * @param minimoPerBlocco Numero minimo di elementi che giustifica un thread
+ * @return size_t Numero di blocchi (almeno 1, al massimo i core disponibili)
+ */
+inline size_t numeroBlocchiParalleli(size_t n, size_t minimoPerBlocco) {
+    size_t core = max<size_t>(1, thread::hardware_concurrency());
+    return max<size_t>(1, min(core, n / max<size_t>(1, minimoPerBlocco)));
+}
+
+/**
+ * @brief Inizio del blocco b quando n elementi sono suddivisi in blocchi uguali
+ * @param n Numero totale di elementi
+ * @param blocchi Numero di blocchi
+ * @param b Indice del blocco (b == blocchi restituisce n)
+ * @return size_t Indice del primo elemento del blocco
+ */
+inline size_t inizioBlocco(size_t n, size_t blocchi, size_t b) {
+    return n / blocchi * b + min(b, n % blocchi);
+}
+
+/**
+ * @brief Esegue f(b) per ogni blocco b in [0, blocchi) su thread separati
+ * @param blocchi Numero di blocchi
+ * @param f Funzione da eseguire per ogni blocco
+ *
+ * Il blocco 0 viene eseguito dal thread chiamante; la funzione ritorna
+ * quando tutti i blocchi sono terminati.
+ */
+template <typename F>
+void eseguiInParallelo(size_t blocchi, F f) {
+    vector<thread> lavoratori;
+    lavoratori.reserve(blocchi > 0 ? blocchi - 1 : 0);
+    for (size_t b = 1; b < blocchi; b++) {
+        lavoratori.emplace_back(f, b);
+    }
+    if (blocchi > 0) {
+        f(0);
+    }
+    for (auto& t : lavoratori) {
+        t.join();
+    }
+}
+
+#endif // PARALLELO_H
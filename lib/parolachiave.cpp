@@ -0,0 +1,83 @@
+#include "parolachiave.h"
+#include "utilita.h"
+
+using namespace std;
+
+/**
+ * @brief Restituisce il byte i del testo convertito in minuscolo
+ *
+ * Il contesto del byte precedente serve a riconoscere le lettere accentate.
+ */
+static inline unsigned char byteMinuscolo(const unsigned char* testo, size_t i) {
+    return piegaByte(i > 0 ? testo[i - 1] : 0, testo[i]);
+}
+
+/**
+ * @brief Costruttore: converte la parola e prepara la tabella dei salti
+ * @param parola Parola da cercare
+ */
+ParolaChiave::ParolaChiave(const string& parola) : piegata(parola) {
+    unsigned char precedente = 0;
+    for (char& c : piegata) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        c = static_cast<char>(piegaByte(precedente, byte));
+        precedente = byte;
+    }
+
+    uint32_t m = static_cast<uint32_t>(piegata.size());
+    for (uint32_t& salto : salti) {
+        salto = m;
+    }
+    for (uint32_t k = 0; k + 1 < m; k++) {
+        salti[static_cast<unsigned char>(piegata[k])] = m - 1 - k;
+    }
+}
+
+/**
+ * @brief Ricerca Boyer-Moore-Horspool con conversione al volo del testo
+ * @param testo Testo in cui cercare
+ * @return bool true se la parola è presente
+ *
+ * Per ogni finestra confronta prima l'ultimo byte e, se coincide, il resto
+ * della parola; poi avanza del salto associato all'ultimo byte della finestra.
+ * Una parola UTF-8 valida inizia sempre con un byte iniziale di carattere,
+ * quindi non può coincidere a metà di un carattere multibyte del testo.
+ */
+bool ParolaChiave::trovaIn(string_view testo) const {
+    size_t m = piegata.size();
+    size_t n = testo.size();
+    if (m == 0) {
+        return true;
+    }
+    if (m > n) {
+        return false;
+    }
+
+    const unsigned char* h = reinterpret_cast<const unsigned char*>(testo.data());
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(piegata.data());
+    unsigned char ultimo = p[m - 1];
+
+    size_t i = 0;
+    while (i + m <= n) {
+        unsigned char c = byteMinuscolo(h, i + m - 1);
+        if (c == ultimo) {
+            size_t k = 0;
+            while (k + 1 < m && byteMinuscolo(h, i + k) == p[k]) {
+                k++;
+            }
+            if (k + 1 == m) {
+                return true;
+            }
+        }
+        i += salti[c];
+    }
+    return false;
+}
+
+/**
+ * @brief Getter per la parola convertita in minuscolo
+ * @return const string& Parola piegata
+ */
+const string& ParolaChiave::getPiegata() const {
+    return piegata;
+}
@@ -0,0 +1,47 @@
+#ifndef PAROLACHIAVE_H
+#define PAROLACHIAVE_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ * @brief Parola chiave compilata per ricerche case-insensitive ripetute
+ *
+ * La parola viene convertita in minuscolo una sola volta (vedi piegaByte,
+ * che gestisce anche le lettere accentate italiane in UTF-8) e viene
+ * precalcolata la tabella dei salti di Boyer-Moore-Horspool. La ricerca nei
+ * testi converte i byte al volo, senza copiare né allocare memoria.
+ *
+ * Conviene compilare la parola una volta e riusarla su tutte le righe
+ * da esaminare.
+ */
+class ParolaChiave {
+private:
+    string piegata;          /**< Parola convertita in minuscolo */
+    uint32_t salti[256];     /**< Salto di Horspool per ogni byte (minuscolo) */
+
+public:
+    /**
+     * @brief Compila una parola chiave
+     * @param parola Parola da cercare (UTF-8)
+     */
+    explicit ParolaChiave(const string& parola);
+
+    /**
+     * @brief Verifica se un testo contiene la parola, ignorando maiuscole e minuscole
+     * @param testo Testo in cui cercare (UTF-8), anche fuori da una string
+     * @return bool true se la parola è presente; sempre true per la parola vuota
+     */
+    bool trovaIn(string_view testo) const;
+
+    /**
+     * @brief Restituisce la parola convertita in minuscolo
+     * @return const string& Parola piegata
+     */
+    const string& getPiegata() const;
+};
+
+#endif // PAROLACHIAVE_H
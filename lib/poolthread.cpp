@@ -0,0 +1,73 @@
+#include "poolthread.h"
+#include <algorithm>
+
+using namespace std;
+
+/**
+ * @brief Costruttore: avvia i thread del pool
+ * @param numeroThread Numero di thread (0 = core disponibili)
+ */
+PoolThread::PoolThread(size_t numeroThread) : inChiusura(false) {
+    if (numeroThread == 0) {
+        numeroThread = max<size_t>(1, thread::hardware_concurrency());
+    }
+    lavoratori.reserve(numeroThread);
+    for (size_t i = 0; i < numeroThread; i++) {
+        lavoratori.emplace_back(&PoolThread::esegui, this);
+    }
+}
+
+/**
+ * @brief Distruttore: esegue i lavori rimasti e attende i thread
+ */
+PoolThread::~PoolThread() {
+    {
+        lock_guard<mutex> lock(mutexLavori);
+        inChiusura = true;
+    }
+    nuovoLavoro.notify_all();
+    for (thread& t : lavoratori) {
+        t.join();
+    }
+}
+
+/**
+ * @brief Accoda un lavoro e risveglia un thread
+ * @param lavoro Funzione da eseguire
+ */
+void PoolThread::accoda(function<void()> lavoro) {
+    {
+        lock_guard<mutex> lock(mutexLavori);
+        lavori.push_back(move(lavoro));
+    }
+    nuovoLavoro.notify_one();
+}
+
+/**
+ * @brief Getter per il numero di thread
+ * @return size_t Numero di thread
+ */
+size_t PoolThread::getNumeroThread() const {
+    return lavoratori.size();
+}
+
+/**
+ * @brief Estrae ed esegue lavori finché il pool non viene chiuso
+ *
+ * In chiusura i lavori già accodati vengono comunque completati.
+ */
+void PoolThread::esegui() {
+    while (true) {
+        function<void()> lavoro;
+        {
+            unique_lock<mutex> lock(mutexLavori);
+            nuovoLavoro.wait(lock, [this] { return inChiusura || !lavori.empty(); });
+            if (lavori.empty()) {
+                return;
+            }
+            lavoro = move(lavori.front());
+            lavori.pop_front();
+        }
+        lavoro();
+    }
+}
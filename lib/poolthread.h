@@ -0,0 +1,60 @@
+#ifndef POOLTHREAD_H
+#define POOLTHREAD_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Insieme fisso di thread che eseguono lavori da una coda condivisa
+ *
+ * I lavori vengono eseguiti nell'ordine di accodamento (ma in parallelo fra
+ * loro). Il distruttore attende il completamento dei lavori già accodati.
+ */
+class PoolThread {
+private:
+    vector<thread> lavoratori;           /**< Thread del pool */
+    deque<function<void()>> lavori;      /**< Lavori in attesa */
+    mutex mutexLavori;                   /**< Protegge lavori e inChiusura */
+    condition_variable nuovoLavoro;      /**< Segnala lavori disponibili o chiusura */
+    bool inChiusura;                     /**< true quando il pool sta terminando */
+
+    /**
+     * @brief Ciclo di un thread del pool
+     */
+    void esegui();
+
+public:
+    /**
+     * @brief Avvia il pool
+     * @param numeroThread Numero di thread (0 = numero di core disponibili)
+     */
+    explicit PoolThread(size_t numeroThread = 0);
+
+    /**
+     * @brief Attende i lavori accodati e termina i thread
+     */
+    ~PoolThread();
+
+    PoolThread(const PoolThread&) = delete;
+    PoolThread& operator=(const PoolThread&) = delete;
+
+    /**
+     * @brief Accoda un lavoro
+     * @param lavoro Funzione da eseguire su uno dei thread del pool
+     */
+    void accoda(function<void()> lavoro);
+
+    /**
+     * @brief Restituisce il numero di thread del pool
+     * @return size_t Numero di thread
+     */
+    size_t getNumeroThread() const;
+};
+
+#endif // POOLTHREAD_H
@@ -0,0 +1,341 @@
+#include "puntidicontrollo.h"
+#include "parallelo.h"
+#include "tracciato.h"
+#include "utilita.h"
+#include <charconv>
+#include <exception>
+#include <stdexcept>
+
+using namespace std;
+
+static constexpr uint64_t PRIMO_FNV = 0x100000001B3ULL;
+static constexpr string_view PREFISSO_CONTROLLO = "#controllo;";
+
+/**
+ * @brief Aggiorna un hash FNV-1a con una sequenza di byte
+ */
+static uint64_t aggiornaFnv(uint64_t h, const void* dati, size_t n) {
+    const unsigned char* byte = static_cast<const unsigned char*>(dati);
+    for (size_t i = 0; i < n; i++) {
+        h = (h ^ byte[i]) * PRIMO_FNV;
+    }
+    return h;
+}
+
+/**
+ * @brief Aggiorna un hash FNV-1a con un intero a 64 bit in little endian
+ */
+static uint64_t aggiornaFnv(uint64_t h, uint64_t valore) {
+    for (int i = 0; i < 8; i++) {
+        h = (h ^ ((valore >> (8 * i)) & 0xFF)) * PRIMO_FNV;
+    }
+    return h;
+}
+
+/**
+ * @brief Mese di una data YYYY-MM-DD come anno * 12 + mese
+ * @return int Mese, oppure -1 se la data non inizia con YYYY-MM
+ */
+static int meseDi(const string& data) {
+    if (data.size() < 7 || data[4] != '-') {
+        return -1;
+    }
+    int anno = 0;
+    int mese = 0;
+    auto ra = from_chars(data.data(), data.data() + 4, anno);
+    auto rm = from_chars(data.data() + 5, data.data() + 7, mese);
+    if (ra.ptr != data.data() + 4 || rm.ptr != data.data() + 7) {
+        return -1;
+    }
+    return anno * 12 + mese;
+}
+
+/**
+ * @brief Crea una catena vuota
+ * @param opzioni Regole di inserimento dei punti
+ */
+CatenaControlli::CatenaControlli(const OpzioniControlli& opzioni)
+    : opzioni(opzioni), righeUltimoPunto(0), meseMassimo(-1) {}
+
+/**
+ * @brief Aggiorna un'impronta con una riga
+ * @param impronta Impronta delle righe precedenti
+ * @param t Transazione
+ * @param centesimi Importo della riga come verrà riletto
+ * @return uint64_t Nuova impronta
+ *
+ * La riga contribuisce con descrizione, centesimi, data e identificativo,
+ * separati da byte che non compaiono nel testo: l'impronta non dipende dal
+ * formato del file.
+ */
+uint64_t CatenaControlli::improntaRiga(uint64_t impronta, const Transazione& t, int64_t centesimi) {
+    impronta = aggiornaFnv(impronta, t.getDescrizione().data(), t.getDescrizione().size());
+    impronta = aggiornaFnv(impronta, "\x1F", 1);
+    impronta = aggiornaFnv(impronta, static_cast<uint64_t>(centesimi));
+    impronta = aggiornaFnv(impronta, t.getData().data(), t.getData().size());
+    impronta = aggiornaFnv(impronta, "\x1F", 1);
+    return aggiornaFnv(impronta, t.getId());
+}
+
+/**
+ * @brief Indica se prima di una riga va scritto un punto di controllo
+ * @param t Prossima riga
+ * @return bool true se una regola è soddisfatta
+ */
+bool CatenaControlli::richiedeControllo(const Transazione& t) const {
+    if (punto.righe == righeUltimoPunto) {
+        return false;
+    }
+    if (opzioni.ogniRighe > 0 && punto.righe - righeUltimoPunto >= opzioni.ogniRighe) {
+        return true;
+    }
+    return opzioni.ogniMese && meseMassimo >= 0 && meseDi(t.getData()) > meseMassimo;
+}
+
+/**
+ * @brief Registra una riga scritta
+ * @param t Transazione
+ * @param centesimi Importo come verrà riletto
+ */
+void CatenaControlli::aggiungi(const Transazione& t, int64_t centesimi) {
+    punto.righe++;
+    punto.saldoCentesimi += centesimi;
+    punto.impronta = improntaRiga(punto.impronta, t, centesimi);
+    if (opzioni.ogniMese) {
+        meseMassimo = max(meseMassimo, meseDi(t.getData()));
+    }
+}
+
+/**
+ * @brief Restituisce il punto di controllo da scrivere ora
+ * @return PuntoDiControllo Stato corrente
+ */
+PuntoDiControllo CatenaControlli::chiudi() {
+    righeUltimoPunto = punto.righe;
+    return punto;
+}
+
+/**
+ * @brief Indica se ci sono righe dopo l'ultimo punto
+ * @return bool true se il file va chiuso con un punto
+ */
+bool CatenaControlli::haRigheAperte() const {
+    return opzioni.isAttive() && punto.righe > righeUltimoPunto;
+}
+
+/**
+ * @brief Verifica un singolo tratto
+ * @param segmento Tratto da verificare
+ * @param righe Righe decodificate (0 se la decodifica fallisce)
+ * @return string Motivo della corruzione, vuoto se il tratto è integro
+ */
+static string verificaSegmento(const SegmentoDaVerificare& segmento, uint64_t& righe) {
+    righe = 0;
+    vector<Transazione> transazioni;
+    try {
+        transazioni = segmento.decodifica();
+    } catch (const exception& e) {
+        return segmento.errore.empty() ? e.what() : segmento.errore;
+    }
+    righe = transazioni.size();
+    if (!segmento.errore.empty()) {
+        return segmento.errore;
+    }
+    if (!segmento.chiuso) {
+        return "";
+    }
+    if (!segmento.inizio) {
+        return "punto di controllo precedente illeggibile";
+    }
+    if (!segmento.fine) {
+        return "punto di controllo illeggibile";
+    }
+
+    PuntoDiControllo calcolato = *segmento.inizio;
+    for (const Transazione& t : transazioni) {
+        int64_t c = importoInCentesimi(t.getImporto());
+        calcolato.righe++;
+        calcolato.saldoCentesimi += c;
+        calcolato.impronta = CatenaControlli::improntaRiga(calcolato.impronta, t, c);
+    }
+    if (calcolato.righe != segmento.fine->righe) {
+        return "righe attese " + to_string(segmento.fine->righe - segmento.inizio->righe) + ", trovate " +
+               to_string(transazioni.size());
+    }
+    if (calcolato.saldoCentesimi != segmento.fine->saldoCentesimi) {
+        return "saldo diverso da quello registrato";
+    }
+    if (calcolato.impronta != segmento.fine->impronta) {
+        return "impronta diversa: righe modificate";
+    }
+    return "";
+}
+
+/**
+ * @brief Verifica in parallelo una sequenza di tratti
+ * @param segmenti Tratti nell'ordine del file
+ * @return RapportoVerifica Esito complessivo
+ *
+ * Gli importi riletti hanno al più due decimali, quindi importoInCentesimi
+ * restituisce esattamente i centesimi usati da chi ha scritto il file.
+ */
+RapportoVerifica verificaSegmenti(const vector<SegmentoDaVerificare>& segmenti) {
+    vector<string> motivi(segmenti.size());
+    vector<uint64_t> righe(segmenti.size(), 0);
+    size_t blocchi = numeroBlocchiParalleli(segmenti.size(), 1);
+    eseguiInParallelo(blocchi, [&](size_t b) {
+        size_t fine = inizioBlocco(segmenti.size(), blocchi, b + 1);
+        for (size_t i = inizioBlocco(segmenti.size(), blocchi, b); i < fine; i++) {
+            motivi[i] = verificaSegmento(segmenti[i], righe[i]);
+        }
+    });
+
+    RapportoVerifica rapporto;
+    uint64_t posizione = 0;
+    for (size_t i = 0; i < segmenti.size(); i++) {
+        if (segmenti[i].inizio) {
+            posizione = segmenti[i].inizio->righe;
+        }
+        if (segmenti[i].chiuso) {
+            rapporto.segmenti++;
+            if (segmenti[i].fine) {
+                rapporto.saldoCentesimi = segmenti[i].fine->saldoCentesimi;
+            }
+        }
+        if (!motivi[i].empty()) {
+            rapporto.corrotti.push_back({i, posizione, motivi[i]});
+        } else if (segmenti[i].chiuso) {
+            rapporto.righeVerificate += righe[i];
+        } else {
+            rapporto.righeSenzaControllo += righe[i];
+        }
+        posizione += righe[i];
+    }
+    return rapporto;
+}
+
+/**
+ * @brief Accoda la riga di testo di un punto di controllo
+ * @param out Buffer di output
+ * @param punto Punto da scrivere
+ */
+void scriviRigaControllo(string& out, const PuntoDiControllo& punto) {
+    char buffer[24];
+    out += PREFISSO_CONTROLLO;
+    out.append(buffer, to_chars(buffer, buffer + sizeof(buffer), punto.righe).ptr);
+    out.push_back(';');
+    out.append(buffer, to_chars(buffer, buffer + sizeof(buffer), punto.saldoCentesimi).ptr);
+    out.push_back(';');
+    out.append(buffer, to_chars(buffer, buffer + sizeof(buffer), punto.impronta, 16).ptr);
+}
+
+/**
+ * @brief Indica se una riga è un punto di controllo
+ * @param riga Riga del file
+ * @return bool true se la riga è un punto di controllo ben formato
+ *
+ * Il prefisso da solo non basta: "#controllo" è una descrizione lecita.
+ * Le righe delle transazioni scritte dal conto hanno però un importo con
+ * due decimali nel secondo campo, che non è mai un numero di righe valido,
+ * quindi nessuna transazione salvata viene scambiata per un punto.
+ */
+bool isRigaControllo(string_view riga) {
+    PuntoDiControllo punto;
+    return leggiRigaControllo(riga, punto);
+}
+
+/**
+ * @brief Interpreta la riga di un punto di controllo
+ * @param riga Riga del file
+ * @param punto Punto letto
+ * @return bool false se la riga non è valida
+ */
+bool leggiRigaControllo(string_view riga, PuntoDiControllo& punto) {
+    if (riga.substr(0, PREFISSO_CONTROLLO.size()) != PREFISSO_CONTROLLO) {
+        return false;
+    }
+    const char* p = riga.data() + PREFISSO_CONTROLLO.size();
+    const char* fine = riga.data() + riga.size();
+    auto r = from_chars(p, fine, punto.righe);
+    if (r.ec != errc() || r.ptr == fine || *r.ptr != ';') {
+        return false;
+    }
+    r = from_chars(r.ptr + 1, fine, punto.saldoCentesimi);
+    if (r.ec != errc() || r.ptr == fine || *r.ptr != ';') {
+        return false;
+    }
+    const char* inizioImpronta = r.ptr + 1;
+    r = from_chars(inizioImpronta, fine, punto.impronta, 16);
+    return r.ec == errc() && r.ptr == fine && r.ptr != inizioImpronta;
+}
+
+/**
+ * @brief Verifica i punti di controllo di un file di testo
+ * @param contenuto Contenuto completo del file
+ * @return RapportoVerifica Esito della verifica
+ *
+ * Una prima scansione sequenziale individua solo le righe dei punti di
+ * controllo; l'interpretazione delle righe dei tratti avviene in parallelo.
+ */
+RapportoVerifica verificaTesto(const string& contenuto) {
+    string_view testo(contenuto);
+    vector<SegmentoDaVerificare> segmenti;
+    optional<PuntoDiControllo> precedente = PuntoDiControllo();
+    size_t inizioSegmento = 0;
+
+    auto decodificatore = [testo](size_t da, size_t a) {
+        return [testo, da, a]() {
+            vector<Transazione> righe;
+            size_t pos = da;
+            while (pos < a) {
+                size_t fineRiga = min(a, testo.find('\n', pos));
+                string_view riga = testo.substr(pos, fineRiga - pos);
+                pos = fineRiga + 1;
+                if (riga.empty()) {
+                    continue;
+                }
+                Transazione t;
+                if (!TracciatoFile::leggi(riga, t)) {
+                    throw runtime_error("riga illeggibile: " + string(riga));
+                }
+                righe.push_back(move(t));
+            }
+            return righe;
+        };
+    };
+
+    size_t pos = 0;
+    while (pos < testo.size()) {
+        size_t fineRiga = testo.find('\n', pos);
+        if (fineRiga == string_view::npos) {
+            fineRiga = testo.size();
+        }
+        string_view riga = testo.substr(pos, fineRiga - pos);
+        PuntoDiControllo letto;
+        bool valido = leggiRigaControllo(riga, letto);
+        Transazione t;
+        if (valido || (riga.substr(0, PREFISSO_CONTROLLO.size()) == PREFISSO_CONTROLLO &&
+                       !TracciatoFile::leggi(riga, t))) {
+            // Con il prefisso ma illeggibile sia come punto sia come
+            // transazione: è un punto di controllo danneggiato
+            SegmentoDaVerificare segmento;
+            segmento.inizio = precedente;
+            if (valido) {
+                segmento.fine = letto;
+            }
+            segmento.decodifica = decodificatore(inizioSegmento, pos);
+            segmenti.push_back(move(segmento));
+            precedente = segmenti.back().fine;
+            inizioSegmento = fineRiga + 1;
+        }
+        pos = fineRiga + 1;
+    }
+    if (inizioSegmento < testo.size()) {
+        SegmentoDaVerificare coda;
+        coda.inizio = precedente;
+        coda.chiuso = false;
+        coda.decodifica = decodificatore(inizioSegmento, testo.size());
+        segmenti.push_back(move(coda));
+    }
+    return verificaSegmenti(segmenti);
+}
@@ -0,0 +1,188 @@
+#ifndef PUNTIDICONTROLLO_H
+#define PUNTIDICONTROLLO_H
+
+#include "transazione.h"
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Stato cumulato del registro dopo un certo numero di righe
+ *
+ * L'impronta è un hash concatenato (FNV-1a a 64 bit) di tutte le righe
+ * precedenti: ogni punto di controllo dipende dall'intera storia, ma per
+ * verificare un tratto basta ripartire dal punto che lo precede.
+ */
+struct PuntoDiControllo {
+    uint64_t righe = 0;            /**< Righe che precedono il punto */
+    int64_t saldoCentesimi = 0;    /**< Saldo delle righe precedenti */
+    uint64_t impronta = 0xCBF29CE484222325ULL;  /**< Hash di tutte le righe precedenti */
+};
+
+/**
+ * @brief Quando scrivere i punti di controllo nel file dei dati
+ *
+ * Le due regole si possono combinare; con entrambe disattivate (default)
+ * il file non contiene punti di controllo.
+ */
+struct OpzioniControlli {
+    size_t ogniRighe = 0;      /**< Un punto ogni tante righe (0 = mai) */
+    bool ogniMese = false;     /**< Un punto prima della prima riga di un mese successivo a tutti i precedenti */
+
+    /**
+     * @brief Indica se almeno una regola è attiva
+     * @return bool true se vanno scritti punti di controllo
+     */
+    bool isAttive() const {
+        return ogniRighe > 0 || ogniMese;
+    }
+};
+
+/**
+ * @brief Tratto del file corrotto
+ */
+struct SegmentoCorrotto {
+    size_t segmento;       /**< Indice del tratto (0 = righe prima del primo punto) */
+    uint64_t primaRiga;    /**< Posizione della prima riga del tratto nel file */
+    string motivo;         /**< Descrizione dell'errore */
+};
+
+/**
+ * @brief Esito della verifica dei punti di controllo di un file
+ */
+struct RapportoVerifica {
+    size_t segmenti = 0;                 /**< Tratti chiusi da un punto di controllo */
+    uint64_t righeVerificate = 0;        /**< Righe dei tratti risultati integri */
+    uint64_t righeSenzaControllo = 0;    /**< Righe dopo l'ultimo punto, non verificabili */
+    int64_t saldoCentesimi = 0;          /**< Saldo registrato nell'ultimo punto di controllo */
+    vector<SegmentoCorrotto> corrotti;   /**< Tratti che non corrispondono al loro punto di controllo */
+
+    /**
+     * @brief Indica se tutti i tratti sono integri
+     * @return bool true se non ci sono tratti corrotti
+     */
+    bool isIntegro() const {
+        return corrotti.empty();
+    }
+};
+
+/**
+ * @brief Accumula le righe scritte e decide dove inserire i punti di controllo
+ *
+ * Chi scrive il file chiama, per ogni riga, richiedeControllo (e se serve
+ * chiudi, scrivendo il punto restituito) e poi aggiungi.
+ */
+class CatenaControlli {
+private:
+    OpzioniControlli opzioni;     /**< Regole di inserimento */
+    PuntoDiControllo punto;       /**< Stato dopo le righe aggiunte */
+    uint64_t righeUltimoPunto;    /**< Righe al momento dell'ultimo punto scritto */
+    int meseMassimo;              /**< Mese più recente visto (anno * 12 + mese), -1 se nessuno */
+
+public:
+    /**
+     * @brief Crea una catena vuota
+     * @param opzioni Regole di inserimento dei punti
+     */
+    explicit CatenaControlli(const OpzioniControlli& opzioni = OpzioniControlli());
+
+    /**
+     * @brief Aggiorna un'impronta con una riga
+     * @param impronta Impronta delle righe precedenti
+     * @param t Transazione (descrizione, data e identificativo)
+     * @param centesimi Importo della riga come verrà riletto dal file
+     * @return uint64_t Nuova impronta
+     */
+    static uint64_t improntaRiga(uint64_t impronta, const Transazione& t, int64_t centesimi);
+
+    /**
+     * @brief Indica se prima di una riga va scritto un punto di controllo
+     * @param t Prossima riga da scrivere
+     * @return bool true se le regole lo richiedono e ci sono righe dopo l'ultimo punto
+     */
+    bool richiedeControllo(const Transazione& t) const;
+
+    /**
+     * @brief Registra una riga scritta
+     * @param t Transazione
+     * @param centesimi Importo della riga come verrà riletto dal file
+     */
+    void aggiungi(const Transazione& t, int64_t centesimi);
+
+    /**
+     * @brief Restituisce il punto di controllo da scrivere ora
+     * @return PuntoDiControllo Stato dopo tutte le righe aggiunte
+     */
+    PuntoDiControllo chiudi();
+
+    /**
+     * @brief Indica se ci sono righe dopo l'ultimo punto di controllo
+     * @return bool true se le regole sono attive e il file va chiuso con un punto
+     */
+    bool haRigheAperte() const;
+};
+
+/**
+ * @brief Tratto di un file da verificare
+ */
+struct SegmentoDaVerificare {
+    optional<PuntoDiControllo> inizio;          /**< Punto che precede il tratto (vuoto se illeggibile) */
+    optional<PuntoDiControllo> fine;            /**< Punto che chiude il tratto (vuoto se illeggibile) */
+    bool chiuso = true;                         /**< false per le righe dopo l'ultimo punto */
+    string errore;                              /**< Errore già rilevato leggendo il file (vuoto se nessuno) */
+    function<vector<Transazione>()> decodifica; /**< Legge le righe del tratto; può lanciare eccezioni */
+};
+
+/**
+ * @brief Verifica in parallelo una sequenza di tratti
+ * @param segmenti Tratti nell'ordine del file
+ * @return RapportoVerifica Esito complessivo
+ *
+ * Ogni tratto è ricalcolato partendo dal punto che lo precede e confrontato
+ * con quello che lo chiude, indipendentemente dagli altri: una corruzione
+ * resta confinata al tratto che la contiene (o ai due tratti adiacenti se è
+ * illeggibile il punto di controllo stesso).
+ */
+RapportoVerifica verificaSegmenti(const vector<SegmentoDaVerificare>& segmenti);
+
+/**
+ * @brief Accoda la riga di testo di un punto di controllo (senza a capo)
+ * @param out Buffer di output
+ * @param punto Punto da scrivere
+ *
+ * Formato: "#controllo;righe;saldoCentesimi;impronta" con l'impronta in
+ * esadecimale.
+ */
+void scriviRigaControllo(string& out, const PuntoDiControllo& punto);
+
+/**
+ * @brief Indica se una riga di un file di testo è un punto di controllo
+ * @param riga Riga del file
+ * @return bool true se la riga è un punto di controllo valido e non va letta come transazione
+ *
+ * Una transazione con descrizione "#controllo" non è mai riconosciuta come
+ * punto: il suo importo ha i decimali, il numero di righe di un punto no.
+ */
+bool isRigaControllo(string_view riga);
+
+/**
+ * @brief Interpreta la riga di testo di un punto di controllo
+ * @param riga Riga del file
+ * @param punto Punto letto
+ * @return bool false se la riga non è un punto di controllo valido
+ */
+bool leggiRigaControllo(string_view riga, PuntoDiControllo& punto);
+
+/**
+ * @brief Verifica i punti di controllo di un file di testo
+ * @param contenuto Contenuto completo del file
+ * @return RapportoVerifica Esito della verifica
+ */
+RapportoVerifica verificaTesto(const string& contenuto);
+
+#endif // PUNTIDICONTROLLO_H
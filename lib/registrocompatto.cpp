@@ -0,0 +1,184 @@
+#include "registrocompatto.h"
+#include "utilita.h"
+#include <climits>
+
+using namespace std;
+
+/**
+ * @brief Costruttore di default
+ */
+RegistroCompatto::RegistroCompatto() {
+}
+
+/**
+ * @brief Costruttore di copia
+ * @param altro Registro da copiare
+ */
+RegistroCompatto::RegistroCompatto(const RegistroCompatto& altro)
+    : righe(altro.righe), descrizioni(altro.descrizioni) {
+    ricostruisciIndice();
+}
+
+/**
+ * @brief Assegnazione per copia
+ * @param altro Registro da copiare
+ * @return RegistroCompatto& Questo registro
+ */
+RegistroCompatto& RegistroCompatto::operator=(const RegistroCompatto& altro) {
+    if (this != &altro) {
+        righe = altro.righe;
+        descrizioni = altro.descrizioni;
+        ricostruisciIndice();
+    }
+    return *this;
+}
+
+/**
+ * @brief Rifà le chiavi dell'indice sulle stringhe di questo dizionario
+ */
+void RegistroCompatto::ricostruisciIndice() {
+    indiceDescrizioni.clear();
+    indiceDescrizioni.reserve(descrizioni.size());
+    for (size_t i = 0; i < descrizioni.size(); i++) {
+        indiceDescrizioni.emplace(descrizioni[i], static_cast<uint32_t>(i));
+    }
+}
+
+/**
+ * @brief Costruttore da un vettore di transazioni
+ * @param transazioni Transazioni da convertire
+ */
+RegistroCompatto::RegistroCompatto(const vector<Transazione>& transazioni) {
+    righe.reserve(transazioni.size());
+    for (const Transazione& t : transazioni) {
+        aggiungi(t);
+    }
+}
+
+/**
+ * @brief Aggiunge una transazione riutilizzando le descrizioni già note
+ * @param t Transazione da aggiungere
+ */
+void RegistroCompatto::aggiungi(const Transazione& t) {
+    Riga riga;
+    riga.giorni = dataInGiorni(t.getData());
+    riga.centesimi = importoInCentesimi(t.getImporto());
+
+    auto trovata = indiceDescrizioni.find(t.getDescrizione());
+    if (trovata != indiceDescrizioni.end()) {
+        riga.descrizione = trovata->second;
+    } else {
+        riga.descrizione = static_cast<uint32_t>(descrizioni.size());
+        descrizioni.push_back(t.getDescrizione());
+        indiceDescrizioni.emplace(descrizioni.back(), riga.descrizione);
+    }
+    righe.push_back(riga);
+}
+
+/**
+ * @brief Getter per il numero di righe
+ * @return size_t Numero di transazioni
+ */
+size_t RegistroCompatto::getNumeroRighe() const {
+    return righe.size();
+}
+
+/**
+ * @brief Getter per una riga compatta
+ * @param i Posizione della riga
+ * @return const Riga& Riga compatta
+ */
+const RegistroCompatto::Riga& RegistroCompatto::getRiga(size_t i) const {
+    return righe[i];
+}
+
+/**
+ * @brief Getter per una descrizione del dizionario
+ * @param indice Indice nel dizionario
+ * @return const string& Descrizione
+ */
+const string& RegistroCompatto::getDescrizione(uint32_t indice) const {
+    return descrizioni[indice];
+}
+
+/**
+ * @brief Ricostruisce una transazione
+ * @param i Posizione della riga
+ * @return Transazione Transazione ricostruita
+ */
+Transazione RegistroCompatto::getTransazione(size_t i) const {
+    const Riga& riga = righe[i];
+    return Transazione(descrizioni[riga.descrizione], riga.centesimi / 100.0, giorniInData(riga.giorni));
+}
+
+/**
+ * @brief Ricostruisce tutte le transazioni
+ * @return vector<Transazione> Transazioni in ordine di inserimento
+ */
+vector<Transazione> RegistroCompatto::getTransazioni() const {
+    vector<Transazione> risultati;
+    risultati.reserve(righe.size());
+    for (size_t i = 0; i < righe.size(); i++) {
+        risultati.push_back(getTransazione(i));
+    }
+    return risultati;
+}
+
+/**
+ * @brief Saldo calcolato in centesimi interi
+ * @return double Saldo totale
+ */
+double RegistroCompatto::calcolaSaldo() const {
+    int64_t centesimi = 0;
+    for (const Riga& riga : righe) {
+        centesimi += riga.centesimi;
+    }
+    return centesimi / 100.0;
+}
+
+/**
+ * @brief Visita le transazioni accettate dal filtro
+ * @param filtro Condizioni da soddisfare
+ * @param visita Funzione chiamata per ogni transazione accettata
+ */
+void RegistroCompatto::perOgni(const Filtro& filtro, const function<void(const Transazione&)>& visita) const {
+    int minGiorno = filtro.getHaDataMinima() ? dataInGiorni(filtro.getDataMinima()) : INT_MIN;
+    int maxGiorno = filtro.getHaDataMassima() ? dataInGiorni(filtro.getDataMassima()) : INT_MAX;
+    for (size_t i = 0; i < righe.size(); i++) {
+        if (righe[i].giorni < minGiorno || righe[i].giorni > maxGiorno) {
+            continue;
+        }
+        Transazione t = getTransazione(i);
+        if (filtro.accetta(t, false)) {
+            visita(t);
+        }
+    }
+}
+
+/**
+ * @brief Memoria occupata da righe, dizionario e indice delle descrizioni
+ * @return UsoMemoria Ripartizione in byte
+ *
+ * Per l'indice del dizionario si stima un nodo per voce più i bucket.
+ */
+UsoMemoria RegistroCompatto::usoMemoria() const {
+    UsoMemoria uso;
+    uso.righe = righe.size() * sizeof(Riga);
+    uso.capacitaInutilizzata = (righe.capacity() - righe.size()) * sizeof(Riga);
+    uso.testo = descrizioni.size() * sizeof(string);
+    for (const string& descrizione : descrizioni) {
+        uso.testo += memoriaEsterna(descrizione);
+    }
+    uso.indici = indiceDescrizioni.bucket_count() * sizeof(void*) +
+                 indiceDescrizioni.size() * (sizeof(void*) + sizeof(size_t) + sizeof(pair<string_view, uint32_t>));
+    uso.totale = uso.righe + uso.capacitaInutilizzata + uso.testo + uso.indici;
+    return uso;
+}
+
+/**
+ * @brief Rilascia la capacità inutilizzata
+ */
+void RegistroCompatto::compatta() {
+    righe.shrink_to_fit();
+    indiceDescrizioni.rehash(0);
+}
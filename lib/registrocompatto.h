@@ -0,0 +1,179 @@
+#ifndef REGISTROCOMPATTO_H
+#define REGISTROCOMPATTO_H
+
+#include "transazione.h"
+#include "filtro.h"
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Ripartizione della memoria occupata da un insieme di transazioni
+ *
+ * Tutti i valori sono in byte e contano solo la memoria allocata, non
+ * l'oggetto che la contiene.
+ */
+struct UsoMemoria {
+    size_t righe = 0;                 /**< Righe effettivamente usate */
+    size_t capacitaInutilizzata = 0;  /**< Capacità riservata dai vettori ma non usata */
+    size_t testo = 0;                 /**< Testo delle descrizioni e delle date sullo heap */
+    size_t indici = 0;                /**< Strutture ausiliarie (saldi cumulati, impronte, sketch, flusso) */
+    size_t totale = 0;                /**< Somma delle voci precedenti */
+};
+
+/**
+ * @brief Registro di transazioni in formato compatto
+ *
+ * Ogni riga occupa esattamente 16 byte (non meno): data in giorni dal
+ * 1970-01-01 (4 byte), indice della descrizione in un dizionario (4 byte) e
+ * importo in centesimi (8 byte, per non limitare gli importi a ±21 milioni
+ * di euro). A queste si aggiungono, una volta per descrizione distinta, il
+ * testo nel dizionario e la sua voce nell'indice. Adatto a conti molto
+ * grandi da tenere in memoria per saldi e interrogazioni; le transazioni
+ * vengono ricostruite solo quando servono.
+ */
+class RegistroCompatto {
+public:
+    /**
+     * @brief Riga compatta
+     */
+    struct Riga {
+        int32_t giorni;        /**< Data in giorni dal 1970-01-01 */
+        uint32_t descrizione;  /**< Indice nel dizionario delle descrizioni */
+        int64_t centesimi;     /**< Importo in centesimi */
+    };
+
+private:
+    vector<Riga> righe;                                   /**< Righe in ordine di inserimento */
+    deque<string> descrizioni;                            /**< Dizionario (indirizzi stabili) */
+    unordered_map<string_view, uint32_t> indiceDescrizioni;  /**< Descrizione -> indice nel dizionario */
+
+    /**
+     * @brief Ricostruisce l'indice sulle descrizioni di questo registro
+     *
+     * Le chiavi dell'indice puntano nelle stringhe del dizionario: dopo una
+     * copia andrebbero rifatte sulle stringhe copiate.
+     */
+    void ricostruisciIndice();
+
+public:
+    /**
+     * @brief Crea un registro vuoto
+     */
+    RegistroCompatto();
+
+    /**
+     * @brief Costruttore di copia
+     * @param altro Registro da copiare
+     *
+     * L'indice delle descrizioni viene ricostruito sul dizionario copiato.
+     */
+    RegistroCompatto(const RegistroCompatto& altro);
+
+    /**
+     * @brief Assegnazione per copia
+     * @param altro Registro da copiare
+     * @return RegistroCompatto& Questo registro
+     */
+    RegistroCompatto& operator=(const RegistroCompatto& altro);
+
+    /**
+     * @brief Costruttore di spostamento (la deque sposta i blocchi, le chiavi restano valide)
+     */
+    RegistroCompatto(RegistroCompatto&&) = default;
+
+    /**
+     * @brief Assegnazione per spostamento
+     */
+    RegistroCompatto& operator=(RegistroCompatto&&) = default;
+
+    /**
+     * @brief Crea un registro con le transazioni indicate
+     * @param transazioni Transazioni da convertire
+     * @throws std::invalid_argument Se una data non è nel formato YYYY-MM-DD
+     */
+    explicit RegistroCompatto(const vector<Transazione>& transazioni);
+
+    /**
+     * @brief Aggiunge una transazione
+     * @param t Transazione da aggiungere
+     * @throws std::invalid_argument Se la data non è nel formato YYYY-MM-DD
+     *
+     * L'importo viene arrotondato al centesimo.
+     */
+    void aggiungi(const Transazione& t);
+
+    /**
+     * @brief Restituisce il numero di righe
+     * @return size_t Numero di transazioni
+     */
+    size_t getNumeroRighe() const;
+
+    /**
+     * @brief Restituisce la riga compatta in una posizione
+     * @param i Posizione della riga
+     * @return const Riga& Riga compatta
+     */
+    const Riga& getRiga(size_t i) const;
+
+    /**
+     * @brief Restituisce una descrizione del dizionario
+     * @param indice Indice nel dizionario
+     * @return const string& Descrizione
+     */
+    const string& getDescrizione(uint32_t indice) const;
+
+    /**
+     * @brief Ricostruisce la transazione in una posizione
+     * @param i Posizione della riga
+     * @return Transazione Transazione ricostruita
+     */
+    Transazione getTransazione(size_t i) const;
+
+    /**
+     * @brief Ricostruisce tutte le transazioni
+     * @return vector<Transazione> Transazioni in ordine di inserimento
+     */
+    vector<Transazione> getTransazioni() const;
+
+    /**
+     * @brief Calcola il saldo sommando i centesimi
+     * @return double Saldo totale (esatto al centesimo)
+     */
+    double calcolaSaldo() const;
+
+    /**
+     * @brief Visita le transazioni che soddisfano un filtro
+     * @param filtro Condizioni da soddisfare (in AND)
+     * @param visita Funzione chiamata per ogni transazione accettata
+     *
+     * I vincoli sulle date sono verificati sulle righe compatte; solo le righe
+     * che li superano vengono ricostruite per le altre condizioni.
+     * @throws std::invalid_argument Se le date del filtro non sono nel formato YYYY-MM-DD
+     */
+    void perOgni(const Filtro& filtro, const function<void(const Transazione&)>& visita) const;
+
+    /**
+     * @brief Restituisce la memoria occupata dal registro
+     * @return UsoMemoria Ripartizione in byte
+     */
+    UsoMemoria usoMemoria() const;
+
+    /**
+     * @brief Rilascia la capacità inutilizzata delle righe e dell'indice
+     *
+     * Il dizionario non viene compattato: shrink_to_fit su una deque
+     * invaliderebbe le stringhe a cui puntano le chiavi dell'indice.
+     */
+    void compatta();
+};
+
+static_assert(sizeof(RegistroCompatto::Riga) == 16, "Una riga compatta deve occupare 16 byte");
+
+#endif // REGISTROCOMPATTO_H
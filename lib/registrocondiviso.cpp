@@ -0,0 +1,422 @@
+#include "registrocondiviso.h"
+#include "parolachiave.h"
+#include "utilita.h"
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace SegmentoCondiviso;
+
+/**
+ * @brief Lancia runtime_error con il messaggio di errno
+ */
+static void errore(const string& operazione) {
+    throw runtime_error(operazione + ": " + strerror(errno));
+}
+
+/**
+ * @brief Dimensione del segmento
+ * @param capacitaRighe Righe allocate
+ * @param capacitaTesto Byte di testo allocati
+ * @return size_t Byte totali
+ *
+ * L'intestazione occupa un multiplo di 64 byte, quindi le righe iniziano
+ * allineate come in memoria privata.
+ */
+size_t SegmentoCondiviso::dimensione(uint64_t capacitaRighe, uint64_t capacitaTesto) {
+    return sizeof(Intestazione) + capacitaRighe * sizeof(Riga) + capacitaTesto;
+}
+
+/**
+ * @brief Crea e mappa il segmento condiviso
+ * @param nome Nome POSIX del segmento
+ * @param capacitaRighe Righe massime
+ * @param capacitaTesto Byte di testo (0 = 32 per riga)
+ */
+PubblicatoreCondiviso::PubblicatoreCondiviso(const string& nome, size_t capacitaRighe, size_t capacitaTesto)
+    : nome(nome), base(nullptr), byte(0) {
+    if (nome.size() < 2 || nome[0] != '/' || nome.find('/', 1) != string::npos) {
+        throw invalid_argument("Nome del segmento condiviso non valido: " + nome);
+    }
+    if (capacitaRighe == 0) {
+        throw invalid_argument("La capacità del segmento condiviso deve essere positiva");
+    }
+    if (capacitaTesto == 0) {
+        capacitaTesto = capacitaRighe * 32;
+    }
+    byte = dimensione(capacitaRighe, capacitaTesto);
+
+    // Un segmento rimasto da un pubblicatore terminato viene sostituito
+    shm_unlink(nome.c_str());
+    int fd = shm_open(nome.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        errore("shm_open " + nome);
+    }
+    if (ftruncate(fd, static_cast<off_t>(byte)) < 0) {
+        int codice = errno;
+        close(fd);
+        shm_unlink(nome.c_str());
+        errno = codice;
+        errore("ftruncate " + nome);
+    }
+    base = mmap(nullptr, byte, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        base = nullptr;
+        shm_unlink(nome.c_str());
+        errore("mmap " + nome);
+    }
+
+    Intestazione* i = new (base) Intestazione();
+    i->dimensioneRiga = sizeof(Riga);
+    i->capacitaRighe = capacitaRighe;
+    i->capacitaTesto = capacitaTesto;
+    // La firma per ultima: un lettore che la vede trova l'intestazione completa
+    atomic_thread_fence(memory_order_release);
+    memcpy(i->firma, FIRMA, sizeof(FIRMA));
+}
+
+/**
+ * @brief Distruttore: chiude, smappa e rimuove il nome del segmento
+ */
+PubblicatoreCondiviso::~PubblicatoreCondiviso() {
+    if (base) {
+        chiudi();
+        munmap(base, byte);
+        shm_unlink(nome.c_str());
+    }
+}
+
+/**
+ * @brief Intestazione del segmento
+ */
+Intestazione& PubblicatoreCondiviso::intestazione() const {
+    return *static_cast<Intestazione*>(base);
+}
+
+/**
+ * @brief Area delle righe
+ */
+Riga* PubblicatoreCondiviso::righe() const {
+    return reinterpret_cast<Riga*>(static_cast<char*>(base) + sizeof(Intestazione));
+}
+
+/**
+ * @brief Area del testo delle descrizioni
+ */
+char* PubblicatoreCondiviso::testo() const {
+    return reinterpret_cast<char*>(righe() + intestazione().capacitaRighe);
+}
+
+/**
+ * @brief Pubblica una transazione
+ * @param t Transazione da pubblicare
+ * @return bool false se mancano righe o testo o se la data non è codificabile
+ *
+ * La data è convertita prima di toccare il segmento, così una riga non
+ * rappresentabile non lascia nulla di scritto. Riga e descrizione sono
+ * scritte prima di aprire il seqlock: i lettori le considerano solo dopo
+ * aver letto il nuovo numero di righe.
+ */
+bool PubblicatoreCondiviso::pubblica(const Transazione& t) {
+    Intestazione& i = intestazione();
+    int32_t giorni;
+    try {
+        giorni = dataInGiorni(t.getData());
+    } catch (const invalid_argument&) {
+        return false;
+    }
+    int64_t centesimi = importoInCentesimi(t.getImporto());
+    uint64_t numero = i.righe.load(memory_order_relaxed);
+    uint64_t byteTesto = i.byteTesto.load(memory_order_relaxed);
+    if (numero == i.capacitaRighe) {
+        return false;
+    }
+
+    const string& descrizione = t.getDescrizione();
+    uint64_t offset;
+    auto trovata = offsetTesti.find(descrizione);
+    if (trovata != offsetTesti.end()) {
+        offset = trovata->second;
+    } else {
+        if (byteTesto + descrizione.size() > i.capacitaTesto) {
+            return false;
+        }
+        memcpy(testo() + byteTesto, descrizione.data(), descrizione.size());
+        offset = byteTesto;
+        byteTesto += descrizione.size();
+        offsetTesti.emplace(descrizione, offset);
+    }
+    new (&righe()[numero]) Riga{giorni, static_cast<uint32_t>(descrizione.size()), centesimi, offset, t.getId(), {0}};
+
+    uint64_t sequenza = i.sequenza.load(memory_order_relaxed);
+    i.sequenza.store(sequenza + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    i.righe.store(numero + 1, memory_order_relaxed);
+    i.byteTesto.store(byteTesto, memory_order_relaxed);
+    i.saldoCentesimi.store(i.saldoCentesimi.load(memory_order_relaxed) + centesimi, memory_order_relaxed);
+    i.versione.store(i.versione.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    i.sequenza.store(sequenza + 2, memory_order_release);
+
+    if (t.getId() != 0) {
+        rigaPerId[t.getId()] = numero;
+    }
+    return true;
+}
+
+/**
+ * @brief Segna come eliminata una riga
+ * @param id Identificativo della transazione
+ * @return bool false se l'identificativo non ha righe valide
+ *
+ * La riga resta nel segmento con la versione dell'eliminazione, così i
+ * lettori che stanno scorrendo una versione precedente continuano a vederla.
+ */
+bool PubblicatoreCondiviso::elimina(uint64_t id) {
+    auto trovata = rigaPerId.find(id);
+    if (trovata == rigaPerId.end()) {
+        return false;
+    }
+    Intestazione& i = intestazione();
+    Riga& r = righe()[trovata->second];
+    rigaPerId.erase(trovata);
+    uint64_t versione = i.versione.load(memory_order_relaxed) + 1;
+
+    uint64_t sequenza = i.sequenza.load(memory_order_relaxed);
+    i.sequenza.store(sequenza + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    r.eliminataAlla.store(versione, memory_order_relaxed);
+    i.saldoCentesimi.store(i.saldoCentesimi.load(memory_order_relaxed) - r.centesimi, memory_order_relaxed);
+    i.versione.store(versione, memory_order_relaxed);
+    i.sequenza.store(sequenza + 2, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Segnala ai lettori la fine degli aggiornamenti
+ */
+void PubblicatoreCondiviso::chiudi() {
+    intestazione().chiuso.store(1, memory_order_release);
+}
+
+/**
+ * @brief Getter per le righe pubblicate
+ * @return size_t Righe pubblicate
+ */
+size_t PubblicatoreCondiviso::getRighePubblicate() const {
+    return intestazione().righe.load(memory_order_relaxed);
+}
+
+/**
+ * @brief Getter per il nome del segmento
+ * @return const string& Nome
+ */
+const string& PubblicatoreCondiviso::getNome() const {
+    return nome;
+}
+
+/**
+ * @brief Collega in sola lettura un segmento esistente
+ * @param nome Nome POSIX del segmento
+ */
+LettoreCondiviso::LettoreCondiviso(const string& nome) : base(nullptr), byte(0) {
+    int fd = shm_open(nome.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        errore("shm_open " + nome);
+    }
+    struct stat informazioni;
+    if (fstat(fd, &informazioni) < 0) {
+        int codice = errno;
+        close(fd);
+        errno = codice;
+        errore("fstat " + nome);
+    }
+    byte = static_cast<size_t>(informazioni.st_size);
+    if (byte < sizeof(Intestazione)) {
+        close(fd);
+        throw runtime_error("Il segmento " + nome + " non contiene un registro");
+    }
+    void* mappato = mmap(nullptr, byte, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mappato == MAP_FAILED) {
+        errore("mmap " + nome);
+    }
+    base = mappato;
+
+    const Intestazione& i = intestazione();
+    if (memcmp(i.firma, FIRMA, sizeof(FIRMA)) != 0 || i.dimensioneRiga != sizeof(Riga) ||
+        dimensione(i.capacitaRighe, i.capacitaTesto) > byte) {
+        munmap(mappato, byte);
+        throw runtime_error("Il segmento " + nome + " non contiene un registro compatibile");
+    }
+    atomic_thread_fence(memory_order_acquire);
+}
+
+/**
+ * @brief Distruttore: scollega il segmento
+ */
+LettoreCondiviso::~LettoreCondiviso() {
+    munmap(const_cast<void*>(base), byte);
+}
+
+/**
+ * @brief Intestazione del segmento
+ */
+const Intestazione& LettoreCondiviso::intestazione() const {
+    return *static_cast<const Intestazione*>(base);
+}
+
+/**
+ * @brief Riga in una posizione
+ */
+const Riga& LettoreCondiviso::riga(size_t i) const {
+    return reinterpret_cast<const Riga*>(static_cast<const char*>(base) + sizeof(Intestazione))[i];
+}
+
+/**
+ * @brief Descrizione di una riga
+ */
+string_view LettoreCondiviso::descrizione(const Riga& r) const {
+    const char* testo = static_cast<const char*>(base) + sizeof(Intestazione) + intestazione().capacitaRighe * sizeof(Riga);
+    return string_view(testo + r.offsetDescrizione, r.lunghezzaDescrizione);
+}
+
+/**
+ * @brief Ricostruisce la transazione di una riga
+ */
+Transazione LettoreCondiviso::transazione(const Riga& r) const {
+    Transazione t(string(descrizione(r)), r.centesimi / 100.0, giorniInData(r.giorni));
+    t.setId(r.id);
+    return t;
+}
+
+/**
+ * @brief Visibilità di una riga in una versione
+ */
+bool LettoreCondiviso::visibile(const Riga& r, uint64_t versione) {
+    uint64_t eliminataAlla = r.eliminataAlla.load(memory_order_relaxed);
+    return eliminataAlla == 0 || eliminataAlla > versione;
+}
+
+/**
+ * @brief Legge lo stato con il seqlock
+ * @return Stato Stato coerente
+ *
+ * Se la sequenza è dispari, o cambia durante la lettura, il pubblicatore
+ * stava aggiornando i contatori e la lettura viene ripetuta.
+ */
+LettoreCondiviso::Stato LettoreCondiviso::leggiStato() const {
+    const Intestazione& i = intestazione();
+    while (true) {
+        uint64_t sequenza = i.sequenza.load(memory_order_acquire);
+        if (sequenza & 1) {
+            continue;
+        }
+        Stato stato{i.righe.load(memory_order_relaxed), i.versione.load(memory_order_relaxed),
+                    i.saldoCentesimi.load(memory_order_relaxed)};
+        atomic_thread_fence(memory_order_acquire);
+        if (i.sequenza.load(memory_order_relaxed) == sequenza) {
+            stato.righe = min(stato.righe, i.capacitaRighe);
+            return stato;
+        }
+    }
+}
+
+/**
+ * @brief Indica se il pubblicatore è attivo
+ * @return bool true se non ha ancora chiuso il registro
+ */
+bool LettoreCondiviso::isAttivo() const {
+    return intestazione().chiuso.load(memory_order_acquire) == 0;
+}
+
+/**
+ * @brief Numero di transazioni valide
+ * @return int Righe visibili nella versione corrente
+ */
+int LettoreCondiviso::getNumeroTransazioni() const {
+    Stato stato = leggiStato();
+    int conteggio = 0;
+    for (size_t r = 0; r < stato.righe; r++) {
+        conteggio += visibile(riga(r), stato.versione);
+    }
+    return conteggio;
+}
+
+/**
+ * @brief Saldo delle transazioni valide
+ * @return double Saldo, letto dall'intestazione in O(1)
+ */
+double LettoreCondiviso::calcolaSaldo() const {
+    return leggiStato().saldoCentesimi / 100.0;
+}
+
+/**
+ * @brief Ricostruisce le transazioni valide
+ * @return vector<Transazione> Transazioni
+ */
+vector<Transazione> LettoreCondiviso::getTransazioni() const {
+    vector<Transazione> risultati;
+    perOgni(Filtro(), [&](const Transazione& t) { risultati.push_back(t); });
+    return risultati;
+}
+
+/**
+ * @brief Cerca per data
+ * @param data Data cercata
+ * @return vector<Transazione> Transazioni della data
+ */
+vector<Transazione> LettoreCondiviso::cercaPerData(const string& data) const {
+    vector<Transazione> risultati;
+    perOgni(Filtro().traDate(data, data), [&](const Transazione& t) { risultati.push_back(t); });
+    return risultati;
+}
+
+/**
+ * @brief Cerca per parola chiave sul testo mappato
+ * @param parola Parola cercata
+ * @return vector<Transazione> Transazioni trovate
+ */
+vector<Transazione> LettoreCondiviso::cercaPerParolaChiave(const string& parola) const {
+    ParolaChiave compilata(parola);
+    Stato stato = leggiStato();
+    vector<Transazione> risultati;
+    for (size_t r = 0; r < stato.righe; r++) {
+        const Riga& corrente = riga(r);
+        if (visibile(corrente, stato.versione) && compilata.trovaIn(descrizione(corrente))) {
+            risultati.push_back(transazione(corrente));
+        }
+    }
+    return risultati;
+}
+
+/**
+ * @brief Visita le transazioni che soddisfano un filtro
+ * @param filtro Condizioni da soddisfare
+ * @param visita Funzione chiamata per ogni transazione accettata
+ *
+ * Come in RegistroCompatto, le date sono confrontate sulle righe e solo le
+ * righe che le superano vengono ricostruite per le altre condizioni.
+ */
+void LettoreCondiviso::perOgni(const Filtro& filtro, const function<void(const Transazione&)>& visita) const {
+    int minGiorno = filtro.getHaDataMinima() ? dataInGiorni(filtro.getDataMinima()) : INT_MIN;
+    int maxGiorno = filtro.getHaDataMassima() ? dataInGiorni(filtro.getDataMassima()) : INT_MAX;
+    Stato stato = leggiStato();
+    for (size_t r = 0; r < stato.righe; r++) {
+        const Riga& corrente = riga(r);
+        if (corrente.giorni < minGiorno || corrente.giorni > maxGiorno || !visibile(corrente, stato.versione)) {
+            continue;
+        }
+        Transazione t = transazione(corrente);
+        if (filtro.accetta(t, false)) {
+            visita(t);
+        }
+    }
+}
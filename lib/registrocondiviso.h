@@ -0,0 +1,264 @@
+#ifndef REGISTROCONDIVISO_H
+#define REGISTROCONDIVISO_H
+
+#include "transazione.h"
+#include "filtro.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Formato del segmento di memoria condivisa POSIX che ospita il registro
+ *
+ * Il segmento contiene solo offset, mai puntatori, quindi ogni processo può
+ * mapparlo a un indirizzo diverso:
+ *
+ *     [Intestazione][Riga x capacitaRighe][testo x capacitaTesto]
+ *
+ * Le righe e il testo delle descrizioni vengono solo aggiunti: una riga già
+ * pubblicata cambia unicamente per eliminataAlla. I contatori
+ * dell'intestazione sono protetti da un seqlock (sequenza dispari durante la
+ * scrittura), così un lettore ottiene sempre una coppia coerente di numero di
+ * righe, saldo e versione senza mai bloccare lo scrittore.
+ */
+namespace SegmentoCondiviso {
+    static_assert(atomic<uint64_t>::is_always_lock_free, "servono atomici senza lock per la memoria condivisa");
+
+    static constexpr char FIRMA[4] = {'C', 'C', 'S', '1'};  /**< Firma del segmento */
+
+    /**
+     * @brief Intestazione del segmento
+     */
+    struct alignas(64) Intestazione {
+        char firma[4];                      /**< FIRMA */
+        uint32_t dimensioneRiga;            /**< sizeof(Riga), per riconoscere layout incompatibili */
+        uint64_t capacitaRighe;             /**< Righe allocate */
+        uint64_t capacitaTesto;             /**< Byte di testo allocati */
+        atomic<uint64_t> sequenza;          /**< Seqlock: dispari durante un aggiornamento */
+        atomic<uint64_t> righe;             /**< Righe pubblicate */
+        atomic<uint64_t> byteTesto;         /**< Byte di testo usati */
+        atomic<int64_t> saldoCentesimi;     /**< Saldo delle righe valide */
+        atomic<uint64_t> versione;          /**< Incrementata a ogni inserimento o eliminazione */
+        atomic<uint64_t> chiuso;            /**< 1 quando il pubblicatore ha smesso di aggiornare */
+    };
+
+    /**
+     * @brief Riga del registro condiviso
+     */
+    struct Riga {
+        int32_t giorni;                     /**< Data in giorni dal 1970-01-01 */
+        uint32_t lunghezzaDescrizione;      /**< Byte della descrizione */
+        int64_t centesimi;                  /**< Importo in centesimi */
+        uint64_t offsetDescrizione;         /**< Posizione della descrizione nell'area di testo */
+        uint64_t id;                        /**< Identificativo della transazione */
+        atomic<uint64_t> eliminataAlla;     /**< Versione dell'eliminazione (0 se valida) */
+    };
+
+    /**
+     * @brief Calcola la dimensione del segmento
+     * @param capacitaRighe Righe allocate
+     * @param capacitaTesto Byte di testo allocati
+     * @return size_t Byte totali
+     */
+    size_t dimensione(uint64_t capacitaRighe, uint64_t capacitaTesto);
+}
+
+/**
+ * @brief Pubblica un registro in memoria condivisa (un solo processo scrittore)
+ *
+ * Crea il segmento con shm_open e lo rimuove dal namespace alla distruzione;
+ * i lettori già collegati continuano a vedere i dati fino allo scollegamento.
+ * Le descrizioni uguali sono scritte una sola volta nell'area di testo.
+ */
+class PubblicatoreCondiviso {
+private:
+    string nome;                                   /**< Nome del segmento (inizia con '/') */
+    void* base;                                    /**< Indirizzo del segmento mappato */
+    size_t byte;                                   /**< Dimensione del segmento */
+    unordered_map<string, uint64_t> offsetTesti;   /**< Descrizione -> offset nell'area di testo */
+    unordered_map<uint64_t, uint64_t> rigaPerId;   /**< Identificativo -> riga valida */
+
+    /**
+     * @brief Aree del segmento mappato
+     */
+    SegmentoCondiviso::Intestazione& intestazione() const;
+    SegmentoCondiviso::Riga* righe() const;
+    char* testo() const;
+
+public:
+    /**
+     * @brief Crea il segmento
+     * @param nome Nome POSIX del segmento, ad esempio "/conto"
+     * @param capacitaRighe Numero massimo di righe
+     * @param capacitaTesto Byte per le descrizioni (0 = 32 per riga)
+     * @throws std::invalid_argument Se il nome non inizia con '/' o le capacità sono nulle
+     * @throws std::runtime_error Se il segmento non può essere creato
+     *
+     * Un segmento con lo stesso nome lasciato da un processo terminato viene sostituito.
+     */
+    PubblicatoreCondiviso(const string& nome, size_t capacitaRighe, size_t capacitaTesto = 0);
+
+    /**
+     * @brief Segnala la chiusura ai lettori, smappa e rimuove il segmento
+     */
+    ~PubblicatoreCondiviso();
+
+    PubblicatoreCondiviso(const PubblicatoreCondiviso&) = delete;
+    PubblicatoreCondiviso& operator=(const PubblicatoreCondiviso&) = delete;
+
+    /**
+     * @brief Pubblica una transazione
+     * @param t Transazione (con il suo identificativo)
+     * @return bool false se il segmento è pieno o la data non è nel formato YYYY-MM-DD
+     */
+    bool pubblica(const Transazione& t);
+
+    /**
+     * @brief Segna come eliminata la riga con un identificativo
+     * @param id Identificativo della transazione
+     * @return bool false se non esiste una riga valida con quell'identificativo
+     */
+    bool elimina(uint64_t id);
+
+    /**
+     * @brief Segnala ai lettori che il registro non verrà più aggiornato
+     */
+    void chiudi();
+
+    /**
+     * @brief Restituisce il numero di righe pubblicate (incluse le eliminate)
+     * @return size_t Righe pubblicate
+     */
+    size_t getRighePubblicate() const;
+
+    /**
+     * @brief Restituisce il nome del segmento
+     * @return const string& Nome POSIX
+     */
+    const string& getNome() const;
+};
+
+/**
+ * @brief Collegamento in sola lettura a un registro pubblicato da un altro processo
+ *
+ * Non carica nulla: le interrogazioni scorrono direttamente le righe mappate.
+ * Ogni interrogazione legge prima lo stato con il seqlock e considera solo le
+ * righe valide in quella versione, quindi vede un'istantanea coerente anche
+ * se il pubblicatore continua ad aggiungere o eliminare righe.
+ */
+class LettoreCondiviso {
+public:
+    /**
+     * @brief Stato coerente del registro in un istante
+     */
+    struct Stato {
+        uint64_t righe;          /**< Righe pubblicate (incluse le eliminate) */
+        uint64_t versione;       /**< Versione del registro */
+        int64_t saldoCentesimi;  /**< Saldo delle righe valide */
+    };
+
+private:
+    const void* base;    /**< Indirizzo del segmento mappato */
+    size_t byte;         /**< Dimensione del segmento */
+
+    /**
+     * @brief Aree del segmento mappato
+     */
+    const SegmentoCondiviso::Intestazione& intestazione() const;
+    const SegmentoCondiviso::Riga& riga(size_t i) const;
+
+    /**
+     * @brief Descrizione di una riga, letta senza copie dall'area di testo
+     */
+    string_view descrizione(const SegmentoCondiviso::Riga& r) const;
+
+    /**
+     * @brief Ricostruisce la transazione di una riga
+     */
+    Transazione transazione(const SegmentoCondiviso::Riga& r) const;
+
+    /**
+     * @brief Verifica se una riga è valida in una versione
+     */
+    static bool visibile(const SegmentoCondiviso::Riga& r, uint64_t versione);
+
+public:
+    /**
+     * @brief Si collega a un segmento esistente
+     * @param nome Nome POSIX del segmento
+     * @throws std::runtime_error Se il segmento non esiste o non è un registro valido
+     */
+    explicit LettoreCondiviso(const string& nome);
+
+    /**
+     * @brief Scollega il segmento
+     */
+    ~LettoreCondiviso();
+
+    LettoreCondiviso(const LettoreCondiviso&) = delete;
+    LettoreCondiviso& operator=(const LettoreCondiviso&) = delete;
+
+    /**
+     * @brief Legge lo stato del registro con il seqlock
+     * @return Stato Numero di righe, versione e saldo coerenti tra loro
+     */
+    Stato leggiStato() const;
+
+    /**
+     * @brief Indica se il pubblicatore sta ancora aggiornando il registro
+     * @return bool false dopo la chiusura o la distruzione del pubblicatore
+     */
+    bool isAttivo() const;
+
+    /**
+     * @brief Restituisce il numero di transazioni valide
+     * @return int Numero di transazioni
+     */
+    int getNumeroTransazioni() const;
+
+    /**
+     * @brief Restituisce il saldo (esatto al centesimo)
+     * @return double Saldo delle transazioni valide
+     */
+    double calcolaSaldo() const;
+
+    /**
+     * @brief Ricostruisce le transazioni valide
+     * @return vector<Transazione> Transazioni in ordine di pubblicazione
+     */
+    vector<Transazione> getTransazioni() const;
+
+    /**
+     * @brief Cerca le transazioni di una data
+     * @param data Data in formato YYYY-MM-DD
+     * @return vector<Transazione> Transazioni trovate
+     * @throws std::invalid_argument Se la data non è nel formato YYYY-MM-DD
+     */
+    vector<Transazione> cercaPerData(const string& data) const;
+
+    /**
+     * @brief Cerca le transazioni la cui descrizione contiene una parola
+     * @param parola Parola chiave (senza distinzione tra maiuscole e minuscole)
+     * @return vector<Transazione> Transazioni trovate
+     *
+     * Il confronto avviene direttamente sul testo mappato; si ricostruiscono
+     * solo le righe trovate.
+     */
+    vector<Transazione> cercaPerParolaChiave(const string& parola) const;
+
+    /**
+     * @brief Visita le transazioni valide che soddisfano un filtro
+     * @param filtro Condizioni da soddisfare (in AND)
+     * @param visita Funzione chiamata per ogni transazione accettata
+     * @throws std::invalid_argument Se le date del filtro non sono nel formato YYYY-MM-DD
+     */
+    void perOgni(const Filtro& filtro, const function<void(const Transazione&)>& visita) const;
+};
+
+#endif // REGISTROCONDIVISO_H
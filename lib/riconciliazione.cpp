@@ -0,0 +1,374 @@
+#include "riconciliazione.h"
+#include "indiceblocchi.h"
+#include "parallelo.h"
+#include "tabellaimpronte.h"
+#include "utilita.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+
+using namespace std;
+
+/**
+ * @brief Riga preparata per i join: chiavi calcolate una sola volta
+ */
+struct RigaRiconciliazione {
+    uint32_t indice;              /**< Posizione nell'elenco di origine */
+    int32_t giorno;               /**< Data in giorni dal 1970-01-01 */
+    int64_t centesimi;            /**< Importo in centesimi */
+    uint64_t chiaveDescrizione;   /**< Hash della descrizione normalizzata */
+    uint64_t impronta;            /**< Impronta di data, importo e descrizione */
+};
+
+static constexpr uint32_t NESSUNA = UINT32_MAX;
+
+/**
+ * @brief Stato di una riga del conto dopo i passaggi
+ */
+enum Esito : uint8_t { Mancante, Abbinata, Discordante };
+
+/**
+ * @brief Mescola i bit di una chiave per distribuirla tra le partizioni (splitmix64)
+ */
+static uint64_t mescola(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief Calcola le chiavi di join di tutte le righe, in parallelo
+ * @param transazioni Righe da preparare
+ * @return vector<RigaRiconciliazione> Righe preparate, nello stesso ordine
+ */
+static vector<RigaRiconciliazione> prepara(const vector<const Transazione*>& transazioni) {
+    vector<RigaRiconciliazione> righe(transazioni.size());
+    size_t blocchi = numeroBlocchiParalleli(transazioni.size(), 16384);
+    vector<exception_ptr> errori(blocchi);
+    eseguiInParallelo(blocchi, [&](size_t b) {
+        try {
+            string normalizzata;
+            for (size_t i = inizioBlocco(righe.size(), blocchi, b); i < inizioBlocco(righe.size(), blocchi, b + 1); i++) {
+                const Transazione& t = *transazioni[i];
+                normalizzaDescrizione(t.getDescrizione(), normalizzata);
+                righe[i] = {static_cast<uint32_t>(i), dataInGiorni(t.getData()), importoInCentesimi(t.getImporto()),
+                            hash<string>()(normalizzata), improntaTransazione(t)};
+            }
+        } catch (...) {
+            errori[b] = current_exception();
+        }
+    });
+    for (const exception_ptr& errore : errori) {
+        if (errore) {
+            rethrow_exception(errore);
+        }
+    }
+    return righe;
+}
+
+/**
+ * @brief Stato condiviso dai passaggi della riconciliazione
+ *
+ * Ogni riga appartiene a una sola partizione per passaggio, quindi i thread
+ * scrivono sempre in posizioni distinte dei vettori.
+ */
+struct StatoRiconciliazione {
+    const vector<const Transazione*>& conto;
+    const vector<const Transazione*>& estratto;
+    vector<RigaRiconciliazione> righeConto;
+    vector<RigaRiconciliazione> righeEstratto;
+    vector<uint32_t> partnerConto;      /**< Riga dell'estratto abbinata (NESSUNA se libera) */
+    vector<uint32_t> partnerEstratto;   /**< Riga del conto abbinata (NESSUNA se libera) */
+    vector<Esito> esiti;                /**< Esito di ogni riga del conto */
+    vector<double> similarita;          /**< Similarità delle coppie, per riga del conto */
+    size_t partizioni;
+
+    /**
+     * @brief Abbina due righe
+     */
+    void abbina(uint32_t c, uint32_t e, Esito esito, double s) {
+        partnerConto[c] = e;
+        partnerEstratto[e] = c;
+        esiti[c] = esito;
+        similarita[c] = s;
+    }
+
+    /**
+     * @brief Suddivide le righe ancora libere in partizioni ed elabora ogni partizione in parallelo
+     * @param chiave Chiave di partizionamento di una riga preparata
+     * @param elabora Funzione chiamata con le righe libere di conto ed estratto di una partizione
+     */
+    template <typename Chiave, typename Elabora>
+    void perPartizioni(Chiave chiave, Elabora elabora) {
+        vector<vector<uint32_t>> partiConto(partizioni), partiEstratto(partizioni);
+        for (const RigaRiconciliazione& r : righeConto) {
+            if (partnerConto[r.indice] == NESSUNA) {
+                partiConto[mescola(chiave(r)) % partizioni].push_back(r.indice);
+            }
+        }
+        for (const RigaRiconciliazione& r : righeEstratto) {
+            if (partnerEstratto[r.indice] == NESSUNA) {
+                partiEstratto[mescola(chiave(r)) % partizioni].push_back(r.indice);
+            }
+        }
+        eseguiInParallelo(partizioni, [&](size_t p) {
+            if (!partiConto[p].empty() && !partiEstratto[p].empty()) {
+                elabora(partiConto[p], partiEstratto[p]);
+            }
+        });
+    }
+};
+
+/**
+ * @brief Trigrammi e testo normalizzato di una descrizione, per la similarità
+ */
+struct ProfiloDescrizione {
+    string normalizzata;
+    vector<uint64_t> trigrammi;
+
+    explicit ProfiloDescrizione(const string& descrizione)
+        : normalizzata(normalizzaDescrizione(descrizione)), trigrammi(IndiceBlocchi::chiaviParola(normalizzata)) {}
+};
+
+/**
+ * @brief Coefficiente di Dice tra due profili
+ */
+static double similarita(const ProfiloDescrizione& a, const ProfiloDescrizione& b) {
+    if (a.trigrammi.empty() || b.trigrammi.empty()) {
+        return a.normalizzata == b.normalizzata ? 1.0 : 0.0;
+    }
+    size_t comuni = 0;
+    size_t i = 0, j = 0;
+    while (i < a.trigrammi.size() && j < b.trigrammi.size()) {
+        if (a.trigrammi[i] < b.trigrammi[j]) {
+            i++;
+        } else if (b.trigrammi[j] < a.trigrammi[i]) {
+            j++;
+        } else {
+            comuni++;
+            i++;
+            j++;
+        }
+    }
+    return 2.0 * comuni / (a.trigrammi.size() + b.trigrammi.size());
+}
+
+/**
+ * @brief Similarità tra due descrizioni
+ * @param a Prima descrizione
+ * @param b Seconda descrizione
+ * @return double Coefficiente di Dice sui trigrammi
+ */
+double similaritaDescrizioni(const string& a, const string& b) {
+    return similarita(ProfiloDescrizione(a), ProfiloDescrizione(b));
+}
+
+/**
+ * @brief Primo passaggio: hash join sulle impronte
+ * @param stato Stato della riconciliazione
+ *
+ * Per ogni impronta le righe dell'estratto formano una lista nell'ordine
+ * originale; ogni riga del conto prende la prima ancora libera.
+ */
+static void joinImpronte(StatoRiconciliazione& stato) {
+    vector<uint32_t> successiva(stato.estratto.size(), NESSUNA);
+    stato.perPartizioni([](const RigaRiconciliazione& r) { return r.impronta; },
+                        [&](const vector<uint32_t>& conto, const vector<uint32_t>& estratto) {
+        unordered_map<uint64_t, uint32_t> teste;
+        teste.reserve(estratto.size());
+        for (size_t k = estratto.size(); k-- > 0;) {
+            uint32_t e = estratto[k];
+            auto [posizione, inserita] = teste.try_emplace(stato.righeEstratto[e].impronta, e);
+            if (!inserita) {
+                successiva[e] = posizione->second;
+                posizione->second = e;
+            }
+        }
+        for (uint32_t c : conto) {
+            auto trovata = teste.find(stato.righeConto[c].impronta);
+            if (trovata != teste.end() && trovata->second != NESSUNA) {
+                uint32_t e = trovata->second;
+                trovata->second = successiva[e];
+                stato.abbina(c, e, Abbinata, 1.0);
+            }
+        }
+    });
+}
+
+/**
+ * @brief Secondo passaggio: sort-merge per importo e data con descrizioni simili
+ * @param stato Stato della riconciliazione
+ * @param opzioni Finestra di date e soglia di similarità
+ */
+static void joinImporti(StatoRiconciliazione& stato, const OpzioniRiconciliazione& opzioni) {
+    stato.perPartizioni([](const RigaRiconciliazione& r) { return static_cast<uint64_t>(r.centesimi); },
+                        [&](vector<uint32_t> conto, vector<uint32_t> estratto) {
+        auto ordina = [](vector<uint32_t>& indici, const vector<RigaRiconciliazione>& righe) {
+            sort(indici.begin(), indici.end(), [&](uint32_t a, uint32_t b) {
+                return tie(righe[a].centesimi, righe[a].giorno, a) < tie(righe[b].centesimi, righe[b].giorno, b);
+            });
+        };
+        ordina(conto, stato.righeConto);
+        ordina(estratto, stato.righeEstratto);
+        // I profili sono calcolati solo quando una riga ha candidati
+        vector<unique_ptr<ProfiloDescrizione>> profili(estratto.size());
+        vector<bool> usate(estratto.size(), false);
+
+        size_t inizio = 0;
+        for (uint32_t c : conto) {
+            const RigaRiconciliazione& rc = stato.righeConto[c];
+            while (inizio < estratto.size() &&
+                   tie(stato.righeEstratto[estratto[inizio]].centesimi, stato.righeEstratto[estratto[inizio]].giorno) <
+                       make_tuple(rc.centesimi, rc.giorno - opzioni.finestraGiorni)) {
+                inizio++;
+            }
+            unique_ptr<ProfiloDescrizione> profiloConto;
+            size_t migliore = estratto.size();
+            double similaritaMigliore = -1.0;
+            int distanzaMigliore = 0;
+            for (size_t k = inizio; k < estratto.size(); k++) {
+                const RigaRiconciliazione& re = stato.righeEstratto[estratto[k]];
+                if (re.centesimi != rc.centesimi || re.giorno > rc.giorno + opzioni.finestraGiorni) {
+                    break;
+                }
+                if (usate[k]) {
+                    continue;
+                }
+                if (!profiloConto) {
+                    profiloConto = make_unique<ProfiloDescrizione>(stato.conto[c]->getDescrizione());
+                }
+                if (!profili[k]) {
+                    profili[k] = make_unique<ProfiloDescrizione>(stato.estratto[estratto[k]]->getDescrizione());
+                }
+                double s = similarita(*profiloConto, *profili[k]);
+                int distanza = abs(re.giorno - rc.giorno);
+                if (s > similaritaMigliore || (s == similaritaMigliore && distanza < distanzaMigliore)) {
+                    migliore = k;
+                    similaritaMigliore = s;
+                    distanzaMigliore = distanza;
+                }
+            }
+            if (migliore < estratto.size() && similaritaMigliore >= opzioni.similaritaMinima) {
+                usate[migliore] = true;
+                stato.abbina(c, estratto[migliore], Abbinata, similaritaMigliore);
+            }
+        }
+    });
+}
+
+/**
+ * @brief Terzo passaggio: sort-merge per descrizione e data con importi diversi
+ * @param stato Stato della riconciliazione
+ * @param opzioni Finestra di date
+ *
+ * A ogni riga del conto viene abbinata la riga libera dell'estratto con la
+ * stessa descrizione normalizzata e la data più vicina entro la finestra.
+ */
+static void joinDescrizioni(StatoRiconciliazione& stato, const OpzioniRiconciliazione& opzioni) {
+    stato.perPartizioni([](const RigaRiconciliazione& r) { return r.chiaveDescrizione; },
+                        [&](vector<uint32_t> conto, vector<uint32_t> estratto) {
+        auto ordina = [](vector<uint32_t>& indici, const vector<RigaRiconciliazione>& righe) {
+            sort(indici.begin(), indici.end(), [&](uint32_t a, uint32_t b) {
+                return tie(righe[a].chiaveDescrizione, righe[a].giorno, a) <
+                       tie(righe[b].chiaveDescrizione, righe[b].giorno, b);
+            });
+        };
+        ordina(conto, stato.righeConto);
+        ordina(estratto, stato.righeEstratto);
+        vector<bool> usate(estratto.size(), false);
+
+        size_t inizio = 0;
+        for (uint32_t c : conto) {
+            const RigaRiconciliazione& rc = stato.righeConto[c];
+            while (inizio < estratto.size() &&
+                   tie(stato.righeEstratto[estratto[inizio]].chiaveDescrizione,
+                       stato.righeEstratto[estratto[inizio]].giorno) <
+                       make_tuple(rc.chiaveDescrizione, rc.giorno - opzioni.finestraGiorni)) {
+                inizio++;
+            }
+            size_t migliore = estratto.size();
+            int distanzaMigliore = 0;
+            for (size_t k = inizio; k < estratto.size(); k++) {
+                const RigaRiconciliazione& re = stato.righeEstratto[estratto[k]];
+                if (re.chiaveDescrizione != rc.chiaveDescrizione || re.giorno > rc.giorno + opzioni.finestraGiorni) {
+                    break;
+                }
+                int distanza = abs(re.giorno - rc.giorno);
+                if (!usate[k] && (migliore == estratto.size() || distanza < distanzaMigliore)) {
+                    migliore = k;
+                    distanzaMigliore = distanza;
+                }
+            }
+            if (migliore < estratto.size()) {
+                usate[migliore] = true;
+                stato.abbina(c, estratto[migliore], Discordante, 1.0);
+            }
+        }
+    });
+}
+
+/**
+ * @brief Riconcilia conto ed estratto
+ * @param conto Transazioni del conto
+ * @param estratto Transazioni dell'estratto
+ * @param opzioni Opzioni della riconciliazione
+ * @return RapportoRiconciliazione Esito
+ */
+RapportoRiconciliazione riconcilia(const vector<Transazione>& conto, const vector<Transazione>& estratto,
+                                   const OpzioniRiconciliazione& opzioni) {
+    auto puntatori = [](const vector<Transazione>& righe) {
+        vector<const Transazione*> risultato;
+        risultato.reserve(righe.size());
+        for (const Transazione& t : righe) {
+            risultato.push_back(&t);
+        }
+        return risultato;
+    };
+    return riconcilia(puntatori(conto), puntatori(estratto), opzioni);
+}
+
+/**
+ * @brief Riconcilia conto ed estratto letti attraverso puntatori
+ * @param conto Righe del conto
+ * @param estratto Righe dell'estratto
+ * @param opzioni Opzioni della riconciliazione
+ * @return RapportoRiconciliazione Esito
+ */
+RapportoRiconciliazione riconcilia(const vector<const Transazione*>& conto, const vector<const Transazione*>& estratto,
+                                   const OpzioniRiconciliazione& opzioni) {
+    StatoRiconciliazione stato{conto, estratto, prepara(conto), prepara(estratto),
+                               vector<uint32_t>(conto.size(), NESSUNA), vector<uint32_t>(estratto.size(), NESSUNA),
+                               vector<Esito>(conto.size(), Mancante), vector<double>(conto.size(), 0.0),
+                               opzioni.partizioni};
+    if (stato.partizioni == 0) {
+        stato.partizioni = numeroBlocchiParalleli(conto.size() + estratto.size(), 65536);
+    }
+
+    joinImpronte(stato);
+    joinImporti(stato, opzioni);
+    joinDescrizioni(stato, opzioni);
+
+    RapportoRiconciliazione rapporto;
+    for (size_t c = 0; c < conto.size(); c++) {
+        if (stato.esiti[c] == Mancante) {
+            rapporto.mancantiNellEstratto.push_back(*conto[c]);
+            continue;
+        }
+        uint32_t e = stato.partnerConto[c];
+        CoppiaRiconciliata coppia{*conto[c], *estratto[e], stato.righeEstratto[e].giorno - stato.righeConto[c].giorno,
+                                  stato.similarita[c]};
+        (stato.esiti[c] == Abbinata ? rapporto.abbinate : rapporto.discordanti).push_back(move(coppia));
+    }
+    for (size_t e = 0; e < estratto.size(); e++) {
+        if (stato.partnerEstratto[e] == NESSUNA) {
+            rapporto.mancantiNelConto.push_back(*estratto[e]);
+        }
+    }
+    return rapporto;
+}
@@ -0,0 +1,93 @@
+#ifndef RICONCILIAZIONE_H
+#define RICONCILIAZIONE_H
+
+#include "transazione.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Parametri della riconciliazione tra due elenchi di transazioni
+ */
+struct OpzioniRiconciliazione {
+    int finestraGiorni = 3;             /**< Distanza massima in giorni tra le date di due righe abbinate */
+    double similaritaMinima = 0.5;      /**< Similarità minima delle descrizioni per abbinare righe non identiche */
+    size_t partizioni = 0;              /**< Partizioni elaborate in parallelo (0 = scelta automatica) */
+};
+
+/**
+ * @brief Coppia di righe abbinate dalla riconciliazione
+ */
+struct CoppiaRiconciliata {
+    Transazione conto;          /**< Riga del conto */
+    Transazione estratto;       /**< Riga dell'estratto */
+    int differenzaGiorni;       /**< Data dell'estratto meno data del conto, in giorni */
+    double similarita;          /**< Similarità delle descrizioni (1 se identiche) */
+};
+
+/**
+ * @brief Esito della riconciliazione
+ *
+ * Ogni riga dei due elenchi compare esattamente una volta: in una coppia
+ * (abbinate o discordanti) oppure tra le mancanti.
+ */
+struct RapportoRiconciliazione {
+    vector<CoppiaRiconciliata> abbinate;     /**< Stesso importo, date vicine e descrizioni simili */
+    vector<CoppiaRiconciliata> discordanti;  /**< Stessa descrizione e date vicine, ma importo diverso */
+    vector<Transazione> mancantiNellEstratto;  /**< Righe del conto senza corrispondenza */
+    vector<Transazione> mancantiNelConto;      /**< Righe dell'estratto senza corrispondenza */
+};
+
+/**
+ * @brief Calcola la similarità tra due descrizioni
+ * @param a Prima descrizione
+ * @param b Seconda descrizione
+ * @return double Coefficiente di Dice sui trigrammi delle descrizioni normalizzate, in [0, 1]
+ *
+ * Le descrizioni sono prima normalizzate (minuscole e spazi, vedi
+ * normalizzaDescrizione); quelle più corte di 3 byte valgono 1 solo se uguali.
+ */
+double similaritaDescrizioni(const string& a, const string& b);
+
+/**
+ * @brief Riconcilia le transazioni del conto con quelle di un estratto bancario
+ * @param conto Transazioni del conto
+ * @param estratto Transazioni dell'estratto
+ * @param opzioni Finestra di date, soglia di similarità e parallelismo
+ * @return RapportoRiconciliazione Righe abbinate, discordanti e mancanti, nell'ordine di conto ed estratto
+ * @throws std::invalid_argument Se una data non è nel formato YYYY-MM-DD
+ *
+ * Le righe vengono abbinate in tre passaggi, ciascuno su partizioni
+ * indipendenti (per hash della chiave di join) elaborate in parallelo:
+ * 1. hash join sull'impronta (data, centesimi, descrizione normalizzata):
+ *    le righe identiche, che sono la grande maggioranza;
+ * 2. sort-merge per (centesimi, data) sulle righe rimaste: per ogni riga del
+ *    conto si sceglie, tra le righe dell'estratto con lo stesso importo entro
+ *    la finestra di date, quella con la descrizione più simile (almeno
+ *    similaritaMinima);
+ * 3. sort-merge per (descrizione normalizzata, data) sulle righe ancora
+ *    rimaste: righe con la stessa descrizione entro la finestra ma importo
+ *    diverso, riportate come discordanti.
+ *
+ * Il costo è O(n log n) più, nel secondo passaggio, il numero di candidati
+ * con lo stesso importo nella finestra di ogni riga.
+ */
+RapportoRiconciliazione riconcilia(const vector<Transazione>& conto, const vector<Transazione>& estratto,
+                                   const OpzioniRiconciliazione& opzioni = OpzioniRiconciliazione());
+
+/**
+ * @brief Riconcilia righe lette attraverso puntatori, senza copiarle
+ * @param conto Righe del conto
+ * @param estratto Righe dell'estratto
+ * @param opzioni Finestra di date, soglia di similarità e parallelismo
+ * @return RapportoRiconciliazione Come nella variante con i vettori di transazioni
+ * @throws std::invalid_argument Se una data non è nel formato YYYY-MM-DD
+ *
+ * Le righe devono restare valide per tutta la chiamata; sono copiate solo
+ * quelle riportate nel rapporto.
+ */
+RapportoRiconciliazione riconcilia(const vector<const Transazione*>& conto, const vector<const Transazione*>& estratto,
+                                   const OpzioniRiconciliazione& opzioni = OpzioniRiconciliazione());
+
+#endif // RICONCILIAZIONE_H
@@ -0,0 +1,580 @@
+#include "serverconto.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <iomanip>
+#include <netinet/in.h>
+#include <sstream>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const uint64_t ID_EVENTO = 0;               /**< Id epoll dell'eventfd */
+static const uint64_t ID_PRIMO_ASCOLTO = 1;        /**< Id epoll della prima socket in ascolto */
+static const uint64_t ID_PRIMA_CONNESSIONE = 1 << 16;  /**< Primo id assegnato alle connessioni */
+static const size_t MASSIMA_RIGA = 1 << 20;        /**< Lunghezza massima di una richiesta */
+static const size_t MASSIME_RICHIESTE = 256;       /**< Richieste in coda oltre le quali si smette di leggere */
+static const size_t MASSIMA_USCITA = 4 << 20;      /**< Byte in uscita oltre i quali non si avviano richieste */
+
+/**
+ * @brief Stato di una connessione client
+ */
+struct ServerConto::Connessione {
+    uint64_t id;                  /**< Identificativo usato come dato epoll */
+    int fd;                       /**< Socket della connessione */
+    string ingresso;              /**< Byte ricevuti non ancora separati in righe */
+    string uscita;                /**< Byte da inviare */
+    deque<string> richieste;      /**< Richieste ricevute in attesa di esecuzione */
+    bool inElaborazione;          /**< true se una richiesta è nel pool */
+    bool daChiudere;              /**< true dopo ESCI: chiudere a buffer vuoto */
+    bool fineIngresso;            /**< true se il client ha chiuso il suo lato di scrittura */
+    uint32_t interesse;           /**< Eventi registrati in epoll (0 = non registrata) */
+};
+
+/**
+ * @brief Indica se una connessione ha finito il suo lavoro e va chiusa
+ *
+ * Dopo ESCI, o dopo che il client ha chiuso il suo lato, la connessione resta
+ * aperta finché le richieste già ricevute non hanno avuto risposta.
+ */
+bool ServerConto::isConclusa(const Connessione& c) {
+    return (c.daChiudere || (c.fineIngresso && c.richieste.empty())) && c.uscita.empty() && !c.inElaborazione;
+}
+
+/**
+ * @brief Lancia runtime_error con il messaggio di errno
+ */
+static void errore(const string& operazione) {
+    throw runtime_error(operazione + ": " + strerror(errno));
+}
+
+/**
+ * @brief Formatta un importo con due cifre decimali
+ */
+static string formattaImporto(double importo) {
+    ostringstream ss;
+    ss << fixed << setprecision(2) << importo;
+    return ss.str();
+}
+
+/**
+ * @brief Formatta un elenco di transazioni come risposta multiriga
+ */
+static string elenco(const vector<Transazione>& risultati) {
+    string risposta = "OK " + to_string(risultati.size()) + "\n";
+    for (const Transazione& t : risultati) {
+        risposta += t.toString();
+        risposta += '\n';
+    }
+    return risposta;
+}
+
+/**
+ * @brief Costruttore: prepara epoll ed eventfd
+ * @param c Conto da servire
+ * @param lavoratori Thread del pool
+ */
+ServerConto::ServerConto(ContoCorrente& c, size_t lavoratori)
+    : conto(c), numeroLavoratori(lavoratori), epollFd(-1), eventoFd(-1), fdRiserva(-1),
+      prossimoId(ID_PRIMA_CONNESSIONE), inEsecuzione(false) {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        errore("epoll_create1");
+    }
+    eventoFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (eventoFd < 0) {
+        close(epollFd);
+        errore("eventfd");
+    }
+    epoll_event evento{};
+    evento.events = EPOLLIN;
+    evento.data.u64 = ID_EVENTO;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, eventoFd, &evento);
+    fdRiserva = open("/dev/null", O_RDONLY | O_CLOEXEC);
+}
+
+/**
+ * @brief Distruttore: ferma il server e chiude tutti i descrittori
+ */
+ServerConto::~ServerConto() {
+    ferma();
+    for (int fd : ascolto) {
+        close(fd);
+    }
+    if (!percorsoUnix.empty()) {
+        unlink(percorsoUnix.c_str());
+    }
+    if (fdRiserva >= 0) {
+        close(fdRiserva);
+    }
+    close(eventoFd);
+    close(epollFd);
+}
+
+/**
+ * @brief Registra una socket in ascolto
+ * @param fd Socket già collegata e in ascolto
+ */
+void ServerConto::registraAscolto(int fd) {
+    epoll_event evento{};
+    evento.events = EPOLLIN;
+    evento.data.u64 = ID_PRIMO_ASCOLTO + ascolto.size();
+    ascolto.push_back(fd);
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &evento);
+}
+
+/**
+ * @brief Ascolto TCP limitato all'interfaccia di loopback
+ * @param porta Porta richiesta (0 = scelta dal sistema)
+ * @return uint16_t Porta effettiva
+ */
+uint16_t ServerConto::ascoltaTcp(uint16_t porta) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        errore("socket");
+    }
+    int uno = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &uno, sizeof(uno));
+
+    sockaddr_in indirizzo{};
+    indirizzo.sin_family = AF_INET;
+    indirizzo.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    indirizzo.sin_port = htons(porta);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&indirizzo), sizeof(indirizzo)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        int codice = errno;
+        close(fd);
+        errno = codice;
+        errore("bind/listen TCP");
+    }
+
+    socklen_t lunghezza = sizeof(indirizzo);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&indirizzo), &lunghezza);
+    registraAscolto(fd);
+    return ntohs(indirizzo.sin_port);
+}
+
+/**
+ * @brief Ascolto su socket Unix
+ * @param percorso Percorso della socket
+ */
+void ServerConto::ascoltaUnix(const string& percorso) {
+    sockaddr_un indirizzo{};
+    if (percorso.size() >= sizeof(indirizzo.sun_path)) {
+        throw runtime_error("Percorso della socket troppo lungo: " + percorso);
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        errore("socket");
+    }
+
+    indirizzo.sun_family = AF_UNIX;
+    memcpy(indirizzo.sun_path, percorso.c_str(), percorso.size() + 1);
+    unlink(percorso.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&indirizzo), sizeof(indirizzo)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        int codice = errno;
+        close(fd);
+        errno = codice;
+        errore("bind/listen Unix");
+    }
+    percorsoUnix = percorso;
+    registraAscolto(fd);
+}
+
+/**
+ * @brief Avvia pool e ciclo di eventi
+ */
+void ServerConto::avvia() {
+    if (inEsecuzione) {
+        return;
+    }
+    pool.reset(new PoolThread(numeroLavoratori));
+    inEsecuzione = true;
+    cicloEventi = thread(&ServerConto::ciclo, this);
+}
+
+/**
+ * @brief Ferma il server
+ *
+ * Il ciclo di eventi viene risvegliato tramite l'eventfd; il pool viene
+ * distrutto dopo il ciclo, così i lavori ancora in corso terminano prima
+ * che le connessioni vengano chiuse.
+ */
+void ServerConto::ferma() {
+    if (!inEsecuzione) {
+        return;
+    }
+    inEsecuzione = false;
+    uint64_t uno = 1;
+    ssize_t scritti = write(eventoFd, &uno, sizeof(uno));
+    (void)scritti;
+    cicloEventi.join();
+    pool.reset();
+
+    while (!connessioni.empty()) {
+        chiudi(connessioni.begin()->first);
+    }
+    completamenti.clear();
+}
+
+/**
+ * @brief Ciclo di eventi: smista gli eventi di eventfd, ascolto e connessioni
+ */
+void ServerConto::ciclo() {
+    epoll_event eventi[64];
+    while (inEsecuzione) {
+        int n = epoll_wait(epollFd, eventi, 64, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            uint64_t id = eventi[i].data.u64;
+            if (id == ID_EVENTO) {
+                uint64_t contatore;
+                while (read(eventoFd, &contatore, sizeof(contatore)) > 0) {
+                }
+                consegnaCompletamenti();
+            } else if (id < ID_PRIMA_CONNESSIONE) {
+                accetta(ascolto[id - ID_PRIMO_ASCOLTO]);
+            } else {
+                gestisciConnessione(id, eventi[i].events);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Accetta le connessioni in attesa e le registra in epoll
+ * @param fd Socket in ascolto
+ *
+ * Se i descrittori sono esauriti (EMFILE/ENFILE) la connessione resterebbe
+ * nella coda di ascolto e epoll, a livello, la segnalerebbe all'infinito:
+ * si libera il descrittore di riserva, si accetta e si chiude subito la
+ * connessione, poi si riapre la riserva.
+ */
+void ServerConto::accetta(int fd) {
+    while (true) {
+        int client = accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if ((errno == EMFILE || errno == ENFILE) && fdRiserva >= 0) {
+                close(fdRiserva);
+                int rifiutato = accept(fd, nullptr, nullptr);
+                if (rifiutato >= 0) {
+                    close(rifiutato);
+                }
+                fdRiserva = open("/dev/null", O_RDONLY | O_CLOEXEC);
+                if (rifiutato >= 0) {
+                    continue;
+                }
+            }
+            return;
+        }
+        uint64_t id = prossimoId++;
+        unique_ptr<Connessione> c(new Connessione{id, client, "", "", {}, false, false, false, 0});
+        aggiornaInteresse(*c);
+        connessioni.emplace(id, move(c));
+    }
+}
+
+/**
+ * @brief Gestisce lettura, scrittura e chiusura di una connessione
+ * @param id Identificativo della connessione
+ * @param eventi Maschera di eventi epoll
+ */
+void ServerConto::gestisciConnessione(uint64_t id, uint32_t eventi) {
+    auto trovata = connessioni.find(id);
+    if (trovata == connessioni.end()) {
+        return;
+    }
+    Connessione& c = *trovata->second;
+
+    if (eventi & EPOLLERR) {
+        chiudi(id);
+        return;
+    }
+    if ((eventi & EPOLLOUT) && !scrivi(c)) {
+        chiudi(id);
+        return;
+    }
+    if ((eventi & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) && !leggi(c)) {
+        chiudi(id);
+        return;
+    }
+    avanza(c);
+    if (isConclusa(c)) {
+        chiudi(id);
+        return;
+    }
+    aggiornaInteresse(c);
+}
+
+/**
+ * @brief Legge i byte disponibili e separa le righe di richiesta
+ * @param c Connessione
+ * @return bool false in caso di errore o se la richiesta è troppo lunga
+ *
+ * Smette di leggere quando in coda ci sono MASSIME_RICHIESTE richieste: il
+ * resto rimane nel buffer del kernel finché la coda non si svuota. Alla
+ * chiusura del lato di scrittura del client l'eventuale ultima riga senza
+ * terminatore diventa una richiesta; le richieste già ricevute vengono
+ * comunque eseguite e le risposte inviate prima di chiudere.
+ */
+bool ServerConto::leggi(Connessione& c) {
+    char buffer[4096];
+    while (!c.fineIngresso && c.richieste.size() < MASSIME_RICHIESTE) {
+        ssize_t letti = recv(c.fd, buffer, sizeof(buffer), 0);
+        if (letti > 0) {
+            c.ingresso.append(buffer, letti);
+            separaRichieste(c);
+            if (c.ingresso.size() > MASSIMA_RIGA) {
+                return false;
+            }
+            continue;
+        }
+        if (letti == 0) {
+            c.fineIngresso = true;
+            if (!c.ingresso.empty() && c.ingresso.back() == '\r') {
+                c.ingresso.pop_back();
+            }
+            if (!c.ingresso.empty()) {
+                c.richieste.push_back(move(c.ingresso));
+                c.ingresso.clear();
+            }
+            break;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Sposta le righe complete del buffer di ingresso nella coda delle richieste
+ * @param c Connessione
+ */
+void ServerConto::separaRichieste(Connessione& c) {
+    size_t inizio = 0;
+    size_t fine;
+    while ((fine = c.ingresso.find('\n', inizio)) != string::npos) {
+        size_t lunghezza = fine - inizio;
+        if (lunghezza > 0 && c.ingresso[fine - 1] == '\r') {
+            lunghezza--;
+        }
+        if (lunghezza > 0) {
+            c.richieste.emplace_back(c.ingresso, inizio, lunghezza);
+        }
+        inizio = fine + 1;
+    }
+    c.ingresso.erase(0, inizio);
+}
+
+/**
+ * @brief Allinea gli eventi registrati in epoll allo stato della connessione
+ * @param c Connessione
+ *
+ * EPOLLIN resta registrato solo finché il client può ancora inviare e la
+ * coda delle richieste non è piena; EPOLLOUT solo se ci sono byte da
+ * inviare. Senza eventi da attendere la socket viene tolta da epoll, che
+ * altrimenti segnalerebbe di continuo EPOLLHUP dopo la chiusura del client.
+ */
+void ServerConto::aggiornaInteresse(Connessione& c) {
+    uint32_t interesse = 0;
+    if (!c.fineIngresso && !c.daChiudere && c.richieste.size() < MASSIME_RICHIESTE) {
+        interesse |= EPOLLIN | EPOLLRDHUP;
+    }
+    if (!c.uscita.empty()) {
+        interesse |= EPOLLOUT;
+    }
+    if (interesse == c.interesse) {
+        return;
+    }
+    epoll_event evento{};
+    evento.events = interesse;
+    evento.data.u64 = c.id;
+    if (interesse == 0) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, c.fd, nullptr);
+    } else {
+        epoll_ctl(epollFd, c.interesse == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, c.fd, &evento);
+    }
+    c.interesse = interesse;
+}
+
+/**
+ * @brief Invia quanto possibile del buffer di uscita
+ * @param c Connessione
+ * @return bool false in caso di errore di scrittura
+ */
+bool ServerConto::scrivi(Connessione& c) {
+    size_t inviati = 0;
+    while (inviati < c.uscita.size()) {
+        ssize_t n = send(c.fd, c.uscita.data() + inviati, c.uscita.size() - inviati, MSG_NOSIGNAL);
+        if (n > 0) {
+            inviati += n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+    c.uscita.erase(0, inviati);
+    return true;
+}
+
+/**
+ * @brief Avvia la prossima richiesta della connessione
+ * @param c Connessione
+ *
+ * Una sola richiesta per connessione è nel pool alla volta: così le risposte
+ * escono nello stesso ordine delle richieste anche con più thread. Se il
+ * client non legge e il buffer di uscita supera MASSIMA_USCITA non vengono
+ * avviate altre richieste finché non si svuota.
+ */
+void ServerConto::avanza(Connessione& c) {
+    if (c.inElaborazione || c.daChiudere || c.richieste.empty() || c.uscita.size() >= MASSIMA_USCITA) {
+        return;
+    }
+    string richiesta = move(c.richieste.front());
+    c.richieste.pop_front();
+
+    if (richiesta == "ESCI") {
+        c.daChiudere = true;
+        c.richieste.clear();
+        c.uscita += "OK\n";
+        scrivi(c);
+        return;
+    }
+
+    uint64_t id = c.id;
+    c.inElaborazione = true;
+    pool->accoda([this, id, richiesta] {
+        string risposta = esegui(richiesta);
+        {
+            lock_guard<mutex> lock(mutexCompletamenti);
+            completamenti.push_back(Completamento{id, move(risposta)});
+        }
+        uint64_t uno = 1;
+        ssize_t scritti = write(eventoFd, &uno, sizeof(uno));
+        (void)scritti;
+    });
+}
+
+/**
+ * @brief Consegna le risposte pronte e avvia le richieste successive
+ */
+void ServerConto::consegnaCompletamenti() {
+    vector<Completamento> pronti;
+    {
+        lock_guard<mutex> lock(mutexCompletamenti);
+        pronti.swap(completamenti);
+    }
+    for (Completamento& completamento : pronti) {
+        auto trovata = connessioni.find(completamento.id);
+        if (trovata == connessioni.end()) {
+            continue;  // Il client si è disconnesso nel frattempo
+        }
+        Connessione& c = *trovata->second;
+        c.uscita += completamento.risposta;
+        c.inElaborazione = false;
+        if (!scrivi(c)) {
+            chiudi(completamento.id);
+            continue;
+        }
+        avanza(c);
+        if (isConclusa(c)) {
+            chiudi(completamento.id);
+            continue;
+        }
+        aggiornaInteresse(c);
+    }
+}
+
+/**
+ * @brief Chiude una connessione
+ * @param id Identificativo della connessione
+ */
+void ServerConto::chiudi(uint64_t id) {
+    auto trovata = connessioni.find(id);
+    if (trovata == connessioni.end()) {
+        return;
+    }
+    if (trovata->second->interesse != 0) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, trovata->second->fd, nullptr);
+    }
+    close(trovata->second->fd);
+    connessioni.erase(trovata);
+}
+
+/**
+ * @brief Esegue una richiesta del protocollo sul conto
+ * @param richiesta Riga di richiesta
+ * @return string Risposta terminata da '\n'
+ *
+ * Le richieste di sola lettura prendono il lock condiviso, quelle che
+ * modificano il conto o il suo file il lock esclusivo.
+ */
+string ServerConto::esegui(const string& richiesta) {
+    size_t spazio = richiesta.find(' ');
+    string comando = richiesta.substr(0, spazio);
+    string argomento = spazio == string::npos ? "" : richiesta.substr(spazio + 1);
+
+    if (comando == "SALDO") {
+        shared_lock<shared_mutex> lock(mutexConto);
+        return "OK " + formattaImporto(conto.calcolaSaldo()) + "\n";
+    }
+    if (comando == "DATA") {
+        shared_lock<shared_mutex> lock(mutexConto);
+        return elenco(conto.cercaPerData(argomento));
+    }
+    if (comando == "PAROLA") {
+        shared_lock<shared_mutex> lock(mutexConto);
+        return elenco(conto.cercaPerParolaChiave(argomento));
+    }
+    if (comando == "RIEPILOGO") {
+        shared_lock<shared_mutex> lock(mutexConto);
+        double entrate = 0.0, uscite = 0.0;
+        conto.perOgni(Filtro(), [&](const Transazione& t) {
+            if (t.getImporto() > 0) {
+                entrate += t.getImporto();
+            } else {
+                uscite += t.getImporto();
+            }
+        });
+        return "OK " + to_string(conto.getNumeroTransazioni()) + " " + formattaImporto(entrate + uscite) +
+               " " + formattaImporto(entrate) + " " + formattaImporto(uscite) + "\n";
+    }
+    if (comando == "AGGIUNGI") {
+        Transazione t;
+        try {
+            t = Transazione::fromString(argomento);
+        } catch (const exception& e) {
+            return "ERR formato non valido, usa descrizione;importo;data\n";
+        }
+        unique_lock<shared_mutex> lock(mutexConto);
+        if (!conto.aggiungiTransazione(t)) {
+            return "ERR transazione duplicata\n";
+        }
+        return "OK\n";
+    }
+    if (comando == "SALVA") {
+        unique_lock<shared_mutex> lock(mutexConto);
+        conto.salvaSuFile();
+        return "OK\n";
+    }
+    return "ERR comando sconosciuto: " + comando + "\n";
+}
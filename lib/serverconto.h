@@ -0,0 +1,146 @@
+#ifndef SERVERCONTO_H
+#define SERVERCONTO_H
+
+#include "contocorrente.h"
+#include "poolthread.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Server di interrogazione di un ContoCorrente su socket locale
+ *
+ * Mantiene il conto in memoria e risponde a richieste testuali, una per riga,
+ * ricevute su una socket Unix o TCP su 127.0.0.1. Un ciclo di eventi epoll
+ * gestisce connessioni e I/O non bloccante, mentre le richieste vengono
+ * eseguite da un pool di thread: le letture (saldo, ricerche, riepilogo)
+ * procedono in parallelo, inserimenti e salvataggi sono esclusivi.
+ * Le risposte di una stessa connessione rispettano l'ordine delle richieste.
+ * Le code di ogni connessione sono limitate: un client che invia senza
+ * leggere le risposte viene rallentato dal kernel invece di far crescere la
+ * memoria del server. Un client che chiude il proprio lato di scrittura
+ * riceve comunque le risposte alle richieste già inviate.
+ *
+ * Protocollo (ogni risposta inizia con "OK" oppure "ERR <messaggio>"):
+ * - SALDO                       -> OK <saldo>
+ * - DATA <YYYY-MM-DD>           -> OK <n>, seguito da n righe "descrizione;importo;data"
+ * - PAROLA <parola>             -> OK <n>, seguito da n righe come sopra
+ * - AGGIUNGI <desc;importo;data> -> OK (ERR se la deduplicazione la rifiuta)
+ * - RIEPILOGO                   -> OK <numero> <saldo> <entrate> <uscite>
+ * - SALVA                       -> OK (salva il conto sul suo file)
+ * - ESCI                        -> OK e chiusura della connessione
+ */
+class ServerConto {
+private:
+    struct Connessione;
+
+    /**
+     * @brief Risposta prodotta da un thread del pool per una connessione
+     */
+    struct Completamento {
+        uint64_t id;          /**< Identificativo della connessione */
+        string risposta;      /**< Testo della risposta */
+    };
+
+    ContoCorrente& conto;                                      /**< Conto servito */
+    shared_mutex mutexConto;                                   /**< Letture condivise, scritture esclusive */
+    size_t numeroLavoratori;                                   /**< Thread del pool da avviare */
+    unique_ptr<PoolThread> pool;                               /**< Pool che esegue le richieste */
+    int epollFd;                                               /**< Istanza epoll del ciclo di eventi */
+    int eventoFd;                                              /**< eventfd usato per risvegliare il ciclo */
+    int fdRiserva;                                             /**< Descrittore liberato quando i descrittori sono esauriti */
+    vector<int> ascolto;                                       /**< Socket in ascolto */
+    string percorsoUnix;                                       /**< Percorso della socket Unix (se usata) */
+    unordered_map<uint64_t, unique_ptr<Connessione>> connessioni;  /**< Connessioni aperte per id */
+    uint64_t prossimoId;                                       /**< Prossimo id di connessione */
+    mutex mutexCompletamenti;                                  /**< Protegge completamenti */
+    vector<Completamento> completamenti;                       /**< Risposte pronte da consegnare */
+    atomic<bool> inEsecuzione;                                 /**< true mentre il ciclo è attivo */
+    thread cicloEventi;                                        /**< Thread del ciclo di eventi */
+
+    /** @brief Registra una socket in ascolto nel ciclo di eventi */
+    void registraAscolto(int fd);
+    /** @brief Ciclo di eventi epoll (eseguito in cicloEventi) */
+    void ciclo();
+    /** @brief Accetta tutte le connessioni in attesa su una socket in ascolto */
+    void accetta(int fd);
+    /** @brief Gestisce gli eventi epoll di una connessione */
+    void gestisciConnessione(uint64_t id, uint32_t eventi);
+    /** @brief Legge i dati disponibili e separa le richieste; false se la connessione va chiusa */
+    bool leggi(Connessione& c);
+    /** @brief Sposta le righe complete ricevute nella coda delle richieste */
+    static void separaRichieste(Connessione& c);
+    /** @brief Registra in epoll solo gli eventi che la connessione può gestire ora */
+    void aggiornaInteresse(Connessione& c);
+    /** @brief Indica se la connessione ha risposto a tutto e va chiusa */
+    static bool isConclusa(const Connessione& c);
+    /** @brief Invia quanto possibile del buffer di uscita; false se la connessione va chiusa */
+    bool scrivi(Connessione& c);
+    /** @brief Affida al pool la prossima richiesta in coda, se nessuna è in corso */
+    void avanza(Connessione& c);
+    /** @brief Consegna alle connessioni le risposte prodotte dal pool */
+    void consegnaCompletamenti();
+    /** @brief Chiude una connessione e la rimuove dal ciclo di eventi */
+    void chiudi(uint64_t id);
+
+public:
+    /**
+     * @brief Crea il server per un conto
+     * @param c Conto da servire (deve restare valido finché il server è attivo)
+     * @param lavoratori Thread del pool (0 = numero di core disponibili)
+     * @throws std::runtime_error Se non è possibile creare epoll o eventfd
+     */
+    explicit ServerConto(ContoCorrente& c, size_t lavoratori = 0);
+
+    /**
+     * @brief Ferma il server e rilascia le risorse
+     */
+    ~ServerConto();
+
+    ServerConto(const ServerConto&) = delete;
+    ServerConto& operator=(const ServerConto&) = delete;
+
+    /**
+     * @brief Mette il server in ascolto su una porta TCP di 127.0.0.1
+     * @param porta Porta (0 = porta libera scelta dal sistema)
+     * @return uint16_t Porta effettivamente in ascolto
+     * @throws std::runtime_error Se la socket non può essere creata o collegata
+     */
+    uint16_t ascoltaTcp(uint16_t porta);
+
+    /**
+     * @brief Mette il server in ascolto su una socket Unix
+     * @param percorso Percorso della socket (un file esistente viene sostituito)
+     * @throws std::runtime_error Se la socket non può essere creata o collegata
+     */
+    void ascoltaUnix(const string& percorso);
+
+    /**
+     * @brief Avvia il pool e il ciclo di eventi in un thread dedicato
+     */
+    void avvia();
+
+    /**
+     * @brief Ferma il ciclo di eventi, completa le richieste in corso e chiude le connessioni
+     */
+    void ferma();
+
+    /**
+     * @brief Esegue una singola richiesta del protocollo
+     * @param richiesta Riga di richiesta senza terminatore
+     * @return string Risposta completa, terminata da '\n'
+     *
+     * Può essere chiamato da più thread contemporaneamente.
+     */
+    string esegui(const string& richiesta);
+};
+
+#endif // SERVERCONTO_H
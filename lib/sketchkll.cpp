@@ -0,0 +1,154 @@
+#include "sketchkll.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+using namespace std;
+
+/**
+ * @brief Costruttore
+ * @param parametroK Parametro di accuratezza
+ */
+SketchKll::SketchKll(size_t parametroK)
+    : k(max<size_t>(8, parametroK)), livelli(1), conteggio(0), minimo(0.0), massimo(0.0), generatore(1),
+      capacitaTotale(0), dimensione(0) {
+    ricalcolaCapacita();
+}
+
+/**
+ * @brief Ricalcola le capacità dei livelli
+ *
+ * La capacità del livello h è k * (2/3)^(profondità dalla cima), almeno 2:
+ * dipende solo dall'altezza, quindi cambia soltanto quando compatta aggiunge
+ * un livello e non va ricalcolata a ogni inserimento.
+ */
+void SketchKll::ricalcolaCapacita() {
+    capacita.resize(livelli.size());
+    capacitaTotale = 0;
+    for (size_t h = 0; h < livelli.size(); h++) {
+        size_t profondita = livelli.size() - 1 - h;
+        capacita[h] = max<size_t>(2, static_cast<size_t>(ceil(k * pow(2.0 / 3.0, profondita))));
+        capacitaTotale += capacita[h];
+    }
+}
+
+/**
+ * @brief Aggiunge un valore e compatta se necessario
+ * @param valore Valore da aggiungere
+ */
+void SketchKll::aggiungi(double valore) {
+    if (conteggio == 0) {
+        minimo = massimo = valore;
+    } else {
+        minimo = min(minimo, valore);
+        massimo = max(massimo, valore);
+    }
+    conteggio++;
+    livelli[0].push_back(valore);
+    dimensione++;
+
+    if (dimensione > capacitaTotale) {
+        compatta();
+    }
+}
+
+/**
+ * @brief Compattazione del livello più basso pieno
+ *
+ * Con un numero dispari di valori l'ultimo resta nel livello, così il
+ * peso totale si conserva esattamente.
+ */
+void SketchKll::compatta() {
+    size_t h = 0;
+    while (h < livelli.size() && livelli[h].size() < capacita[h]) {
+        h++;
+    }
+    if (h == livelli.size()) {
+        return;
+    }
+    if (h + 1 == livelli.size()) {
+        livelli.emplace_back();
+        ricalcolaCapacita();
+    }
+
+    vector<double>& livello = livelli[h];
+    sort(livello.begin(), livello.end());
+    double avanzo = 0.0;
+    bool haAvanzo = livello.size() % 2 == 1;
+    if (haAvanzo) {
+        avanzo = livello.back();
+        livello.pop_back();
+    }
+
+    size_t offset = generatore() & 1;
+    vector<double>& superiore = livelli[h + 1];
+    for (size_t i = offset; i < livello.size(); i += 2) {
+        superiore.push_back(livello[i]);
+    }
+    dimensione -= livello.size() / 2;
+    livello.clear();
+    if (haAvanzo) {
+        livello.push_back(avanzo);
+    }
+}
+
+/**
+ * @brief Stima del quantile tramite ranghi pesati
+ * @param q Quantile richiesto
+ * @return double Valore stimato
+ */
+double SketchKll::quantile(double q) const {
+    if (conteggio == 0) {
+        return 0.0;
+    }
+    if (q <= 0.0) return minimo;
+    if (q >= 1.0) return massimo;
+
+    vector<pair<double, uint64_t>> pesati;
+    uint64_t pesoTotale = 0;
+    for (size_t h = 0; h < livelli.size(); h++) {
+        for (double v : livelli[h]) {
+            pesati.emplace_back(v, uint64_t(1) << h);
+            pesoTotale += uint64_t(1) << h;
+        }
+    }
+    sort(pesati.begin(), pesati.end());
+
+    double obiettivo = q * pesoTotale;
+    uint64_t cumulato = 0;
+    for (const auto& voce : pesati) {
+        cumulato += voce.second;
+        if (cumulato >= obiettivo) {
+            return voce.first;
+        }
+    }
+    return massimo;
+}
+
+/**
+ * @brief Getter per il numero di valori inseriti
+ * @return uint64_t Valori inseriti
+ */
+uint64_t SketchKll::getConteggio() const {
+    return conteggio;
+}
+
+/**
+ * @brief Numero di valori conservati nei compattatori
+ * @return size_t Valori in memoria
+ */
+size_t SketchKll::getDimensione() const {
+    return dimensione;
+}
+
+/**
+ * @brief Memoria occupata dai compattatori
+ * @return size_t Byte allocati
+ */
+size_t SketchKll::getUsoMemoria() const {
+    size_t totale = livelli.capacity() * sizeof(vector<double>) + capacita.capacity() * sizeof(size_t);
+    for (const auto& livello : livelli) {
+        totale += livello.capacity() * sizeof(double);
+    }
+    return totale;
+}
@@ -0,0 +1,80 @@
+#ifndef SKETCHKLL_H
+#define SKETCHKLL_H
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Sketch KLL per quantili approssimati di un flusso di valori
+ *
+ * Mantiene una gerarchia di compattatori: il livello h contiene valori di
+ * peso 2^h. Quando lo spazio totale supera la capacità, il livello più basso
+ * pieno viene ordinato e metà dei suoi valori (presi a posizioni alterne con
+ * offset casuale) salgono al livello successivo. La memoria resta O(k) e
+ * l'errore di rango è circa 1.65/k indipendentemente dal numero di valori.
+ */
+class SketchKll {
+private:
+    size_t k;                          /**< Parametro di accuratezza */
+    vector<vector<double>> livelli;    /**< Compattatori, livello h con peso 2^h */
+    uint64_t conteggio;                /**< Valori inseriti */
+    double minimo;                     /**< Valore minimo esatto */
+    double massimo;                    /**< Valore massimo esatto */
+    minstd_rand generatore;            /**< Sorgente degli offset di compattazione */
+    vector<size_t> capacita;           /**< Capacità di ogni livello con l'altezza attuale */
+    size_t capacitaTotale;             /**< Somma delle capacità dei livelli */
+    size_t dimensione;                 /**< Valori conservati in tutti i livelli */
+
+    /**
+     * @brief Ricalcola le capacità dei livelli dopo un cambio di altezza
+     */
+    void ricalcolaCapacita();
+
+    /**
+     * @brief Compatta il livello più basso che ha raggiunto la capacità
+     */
+    void compatta();
+
+public:
+    /**
+     * @brief Crea uno sketch vuoto
+     * @param parametroK Parametro di accuratezza (maggiore = più preciso)
+     */
+    explicit SketchKll(size_t parametroK = 200);
+
+    /**
+     * @brief Aggiunge un valore
+     * @param valore Valore da aggiungere
+     */
+    void aggiungi(double valore);
+
+    /**
+     * @brief Stima il quantile q
+     * @param q Quantile in [0, 1] (0.5 = mediana)
+     * @return double Valore stimato (0 se lo sketch è vuoto)
+     */
+    double quantile(double q) const;
+
+    /**
+     * @brief Restituisce il numero di valori inseriti
+     * @return uint64_t Numero di valori
+     */
+    uint64_t getConteggio() const;
+
+    /**
+     * @brief Restituisce il numero di valori conservati
+     * @return size_t Valori effettivamente in memoria
+     */
+    size_t getDimensione() const;
+
+    /**
+     * @brief Restituisce la memoria occupata dai compattatori
+     * @return size_t Byte allocati
+     */
+    size_t getUsoMemoria() const;
+};
+
+#endif // SKETCHKLL_H
@@ -0,0 +1,161 @@
+#include "tabellaimpronte.h"
+#include "utilita.h"
+#include <utility>
+
+using namespace std;
+
+static const size_t CAPACITA_INIZIALE = 64;
+
+/**
+ * @brief Rimescola i bit di un valore (finalizzatore di splitmix64)
+ */
+static uint64_t mescola(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * @brief Impronta di una transazione
+ * @param t Transazione
+ * @return uint64_t Impronta diversa da 0
+ *
+ * La descrizione viene normalizzata e passata a FNV-1a; data e centesimi
+ * vengono combinati con un rimescolamento completo.
+ */
+uint64_t improntaTransazione(const Transazione& t) {
+    static thread_local string normalizzata;
+    normalizzaDescrizione(t.getDescrizione(), normalizzata);
+
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (char c : normalizzata) {
+        h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+    }
+    for (char c : t.getData()) {
+        h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+    }
+    h = mescola(h ^ mescola(static_cast<uint64_t>(importoInCentesimi(t.getImporto()))));
+    return h == 0 ? 1 : h;
+}
+
+/**
+ * @brief Costruttore
+ */
+TabellaImpronte::TabellaImpronte() : occupate(0) {
+}
+
+/**
+ * @brief Scansione lineare a partire dalla cella indicata dall'impronta
+ * @param impronta Impronta da cercare
+ * @return size_t Cella dell'impronta o prima cella vuota incontrata
+ */
+size_t TabellaImpronte::cella(uint64_t impronta) const {
+    size_t maschera = impronte.size() - 1;
+    size_t i = impronta & maschera;
+    while (impronte[i] != 0 && impronte[i] != impronta) {
+        i = (i + 1) & maschera;
+    }
+    return i;
+}
+
+/**
+ * @brief Raddoppia la capacità
+ */
+void TabellaImpronte::espandi() {
+    size_t capacita = impronte.empty() ? CAPACITA_INIZIALE : impronte.size() * 2;
+    vector<uint64_t> vecchieImpronte = move(impronte);
+    vector<uint32_t> vecchiConteggi = move(conteggi);
+    impronte.assign(capacita, 0);
+    conteggi.assign(capacita, 0);
+    for (size_t i = 0; i < vecchieImpronte.size(); i++) {
+        if (vecchieImpronte[i] != 0) {
+            size_t j = cella(vecchieImpronte[i]);
+            impronte[j] = vecchieImpronte[i];
+            conteggi[j] = vecchiConteggi[i];
+        }
+    }
+}
+
+/**
+ * @brief Occorrenze di un'impronta
+ * @param impronta Impronta da cercare
+ * @return uint32_t Occorrenze registrate
+ */
+uint32_t TabellaImpronte::conta(uint64_t impronta) const {
+    if (impronte.empty()) {
+        return 0;
+    }
+    size_t i = cella(impronta);
+    return impronte[i] == impronta ? conteggi[i] : 0;
+}
+
+/**
+ * @brief Registra un'occorrenza
+ * @param impronta Impronta da registrare
+ * @return uint32_t Occorrenze dopo la registrazione
+ */
+uint32_t TabellaImpronte::incrementa(uint64_t impronta) {
+    if ((occupate + 1) * 2 > impronte.size()) {
+        espandi();
+    }
+    size_t i = cella(impronta);
+    if (impronte[i] == 0) {
+        impronte[i] = impronta;
+        occupate++;
+    }
+    return ++conteggi[i];
+}
+
+/**
+ * @brief Decrementa il conteggio di un'impronta
+ * @param impronta Impronta da rimuovere
+ * @return uint32_t Occorrenze rimaste
+ */
+uint32_t TabellaImpronte::decrementa(uint64_t impronta) {
+    if (impronte.empty()) {
+        return 0;
+    }
+    size_t i = cella(impronta);
+    if (impronte[i] == 0 || conteggi[i] == 0) {
+        return 0;
+    }
+    return --conteggi[i];
+}
+
+/**
+ * @brief Espande la tabella in anticipo
+ * @param voci Numero previsto di impronte distinte
+ */
+void TabellaImpronte::riserva(size_t voci) {
+    while (voci * 2 > impronte.size()) {
+        espandi();
+    }
+}
+
+/**
+ * @brief Svuota la tabella
+ */
+void TabellaImpronte::svuota() {
+    vector<uint64_t>().swap(impronte);
+    vector<uint32_t>().swap(conteggi);
+    occupate = 0;
+}
+
+/**
+ * @brief Getter per il numero di impronte distinte
+ * @return size_t Impronte distinte
+ */
+size_t TabellaImpronte::getDimensione() const {
+    return occupate;
+}
+
+/**
+ * @brief Memoria occupata dai due vettori
+ * @return size_t Byte allocati
+ */
+size_t TabellaImpronte::getUsoMemoria() const {
+    return impronte.capacity() * sizeof(uint64_t) + conteggi.capacity() * sizeof(uint32_t);
+}
@@ -0,0 +1,98 @@
+#ifndef TABELLAIMPRONTE_H
+#define TABELLAIMPRONTE_H
+
+#include "transazione.h"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Calcola l'impronta a 64 bit di una transazione per la deduplicazione
+ * @param t Transazione
+ * @return uint64_t Impronta di (data, importo in centesimi, descrizione normalizzata)
+ *
+ * Due transazioni con la stessa data, lo stesso importo al centesimo e la
+ * stessa descrizione a meno di maiuscole e spazi hanno la stessa impronta.
+ * L'impronta non è mai 0.
+ */
+uint64_t improntaTransazione(const Transazione& t);
+
+/**
+ * @brief Tabella hash a indirizzamento aperto che conta le impronte
+ *
+ * Conserva solo impronte e contatori in due vettori paralleli (12 byte per
+ * voce), con scansione lineare e capacità potenza di 2 mantenuta sotto il 50%
+ * di occupazione. L'impronta 0 indica una cella vuota.
+ */
+class TabellaImpronte {
+private:
+    vector<uint64_t> impronte;    /**< Impronte memorizzate (0 = cella vuota) */
+    vector<uint32_t> conteggi;    /**< Occorrenze di ogni impronta */
+    size_t occupate;              /**< Numero di celle occupate */
+
+    /**
+     * @brief Restituisce la cella dell'impronta o la cella vuota in cui inserirla
+     */
+    size_t cella(uint64_t impronta) const;
+
+    /**
+     * @brief Raddoppia la capacità reinserendo le voci
+     */
+    void espandi();
+
+public:
+    /**
+     * @brief Crea una tabella vuota
+     */
+    TabellaImpronte();
+
+    /**
+     * @brief Restituisce le occorrenze registrate di un'impronta
+     * @param impronta Impronta da cercare
+     * @return uint32_t Occorrenze (0 se assente)
+     */
+    uint32_t conta(uint64_t impronta) const;
+
+    /**
+     * @brief Registra un'occorrenza di un'impronta
+     * @param impronta Impronta da registrare
+     * @return uint32_t Occorrenze dopo la registrazione
+     */
+    uint32_t incrementa(uint64_t impronta);
+
+    /**
+     * @brief Rimuove un'occorrenza di un'impronta
+     * @param impronta Impronta da rimuovere
+     * @return uint32_t Occorrenze dopo la rimozione
+     *
+     * L'impronta resta nella tabella con conteggio 0, così le catene di
+     * scansione lineare delle altre impronte non vengono interrotte.
+     */
+    uint32_t decrementa(uint64_t impronta);
+
+    /**
+     * @brief Prepara la tabella a contenere un certo numero di impronte distinte
+     * @param voci Numero previsto di impronte
+     */
+    void riserva(size_t voci);
+
+    /**
+     * @brief Svuota la tabella liberando la memoria
+     */
+    void svuota();
+
+    /**
+     * @brief Restituisce il numero di impronte distinte
+     * @return size_t Impronte distinte
+     */
+    size_t getDimensione() const;
+
+    /**
+     * @brief Restituisce la memoria occupata dalla tabella
+     * @return size_t Byte allocati
+     */
+    size_t getUsoMemoria() const;
+};
+
+#endif // TABELLAIMPRONTE_H
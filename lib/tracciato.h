@@ -0,0 +1,288 @@
+#ifndef TRACCIATO_H
+#define TRACCIATO_H
+
+#include "transazione.h"
+#include <charconv>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+using namespace std;
+
+/**
+ * @brief Campi che compongono un tracciato record (vedi TracciatoRecord)
+ *
+ * Ogni campo è un tipo senza stato con due funzioni statiche:
+ * - scrivi(t, out) accoda il valore del campo alla riga;
+ * - leggi(testo, t) interpreta il testo del campo (senza separatori) e
+ *   restituisce false se non è valido.
+ * FACOLTATIVO indica se il campo può mancare alla fine della riga.
+ */
+namespace Campo {
+    /**
+     * @brief Descrizione, copiata così com'è
+     */
+    struct Descrizione {
+        static constexpr bool FACOLTATIVO = false;
+
+        static void scrivi(const Transazione& t, string& out) {
+            out += t.getDescrizione();
+        }
+
+        static bool leggi(string_view testo, Transazione& t) {
+            t.setDescrizione(string(testo));
+            return true;
+        }
+    };
+
+    /**
+     * @brief Importo con due cifre decimali
+     *
+     * In lettura accetta, come faceva stod, spazi iniziali, un '+' e
+     * qualsiasi numero di decimali; sono tollerati anche spazi finali. Il
+     * resto del testo deve essere tutto numerico.
+     */
+    struct Importo {
+        static constexpr bool FACOLTATIVO = false;
+
+        static void scrivi(const Transazione& t, string& out) {
+            char buffer[64];
+            auto risultato = to_chars(buffer, buffer + sizeof(buffer), t.getImporto(), chars_format::fixed, 2);
+            out.append(buffer, risultato.ptr);
+        }
+
+        static bool leggi(string_view testo, Transazione& t) {
+            constexpr string_view SPAZI = " \t\n\v\f\r";
+            size_t inizio = testo.find_first_not_of(SPAZI);
+            if (inizio == string_view::npos) {
+                return false;
+            }
+            testo = testo.substr(inizio, testo.find_last_not_of(SPAZI) + 1 - inizio);
+            if (testo.front() == '+') {
+                testo.remove_prefix(1);
+            }
+            double importo = 0.0;
+            auto risultato = from_chars(testo.data(), testo.data() + testo.size(), importo);
+            if (risultato.ec != errc() || risultato.ptr != testo.data() + testo.size()) {
+                return false;
+            }
+            t.setImporto(importo);
+            return true;
+        }
+    };
+
+    /**
+     * @brief Data in formato YYYY-MM-DD (non validata, come nel tracciato storico)
+     */
+    struct Data {
+        static constexpr bool FACOLTATIVO = false;
+
+        static void scrivi(const Transazione& t, string& out) {
+            out += t.getData();
+        }
+
+        static bool leggi(string_view testo, Transazione& t) {
+            t.setData(string(testo));
+            return true;
+        }
+    };
+
+    /**
+     * @brief Identificativo assegnato dal conto
+     */
+    struct Id {
+        static constexpr bool FACOLTATIVO = false;
+
+        static void scrivi(const Transazione& t, string& out) {
+            char buffer[24];
+            auto risultato = to_chars(buffer, buffer + sizeof(buffer), t.getId());
+            out.append(buffer, risultato.ptr);
+        }
+
+        static bool leggi(string_view testo, Transazione& t) {
+            uint64_t id = 0;
+            auto risultato = from_chars(testo.data(), testo.data() + testo.size(), id);
+            if (testo.empty() || risultato.ec != errc() || risultato.ptr != testo.data() + testo.size() ||
+                id > Transazione::MASSIMO_ID) {
+                return false;
+            }
+            t.setId(id);
+            return true;
+        }
+    };
+
+    /**
+     * @brief Indice della categoria nel Classificatore del conto (-1 se nessuna)
+     */
+    struct Categoria {
+        static constexpr bool FACOLTATIVO = false;
+
+        static void scrivi(const Transazione& t, string& out) {
+            char buffer[16];
+            auto risultato = to_chars(buffer, buffer + sizeof(buffer), t.getCategoria());
+            out.append(buffer, risultato.ptr);
+        }
+
+        static bool leggi(string_view testo, Transazione& t) {
+            int categoria = -1;
+            auto risultato = from_chars(testo.data(), testo.data() + testo.size(), categoria);
+            if (testo.empty() || risultato.ec != errc() || risultato.ptr != testo.data() + testo.size() ||
+                categoria < -1 || categoria > Transazione::MASSIMA_CATEGORIA) {
+                return false;
+            }
+            t.setCategoria(categoria);
+            return true;
+        }
+    };
+
+    /**
+     * @brief Codice della valuta, fissato nel tracciato
+     *
+     * Il conto gestisce una sola valuta: in scrittura il codice viene
+     * ripetuto su ogni riga, in lettura le righe in un'altra valuta sono
+     * rifiutate invece di sommare importi non confrontabili.
+     */
+    template <char C1, char C2, char C3>
+    struct Valuta {
+        static constexpr bool FACOLTATIVO = false;
+        static constexpr char CODICE[3] = {C1, C2, C3};
+
+        static void scrivi(const Transazione&, string& out) {
+            out.append(CODICE, 3);
+        }
+
+        static bool leggi(string_view testo, Transazione&) {
+            return testo == string_view(CODICE, 3);
+        }
+    };
+
+    /**
+     * @brief Campo che può mancare (o essere vuoto) alla fine della riga
+     * @tparam C Campo racchiuso
+     */
+    template <typename C>
+    struct Facoltativo {
+        static constexpr bool FACOLTATIVO = true;
+
+        static void scrivi(const Transazione& t, string& out) {
+            C::scrivi(t, out);
+        }
+
+        static bool leggi(string_view testo, Transazione& t) {
+            return testo.empty() || C::leggi(testo, t);
+        }
+    };
+}
+
+/**
+ * @brief Tracciato di una riga di testo descritto a tempo di compilazione
+ * @tparam Separatore Carattere che separa i campi
+ * @tparam Campi Campi della riga, nell'ordine (vedi namespace Campo)
+ *
+ * Lettura e scrittura sono espanse campo per campo con fold expression:
+ * nessuna chiamata virtuale, nessuno stream, una sola scansione della riga.
+ * Come nel formato storico i campi non vengono racchiusi tra virgolette
+ * (una descrizione non deve contenere il separatore) e gli eventuali campi
+ * in più alla fine della riga sono ignorati.
+ */
+template <char Separatore, typename... Campi>
+class TracciatoRecord {
+private:
+    static_assert(sizeof...(Campi) > 0, "un tracciato deve avere almeno un campo");
+
+    /**
+     * @brief Legge il campo che inizia in posizione inizio e avanza oltre il separatore
+     * @return bool false se il campo è assente (e obbligatorio) o non valido
+     *
+     * inizio > riga.size() indica che la riga è già finita.
+     */
+    template <typename C>
+    static bool leggiCampo(string_view riga, size_t& inizio, Transazione& t) {
+        if (inizio > riga.size()) {
+            return C::FACOLTATIVO;
+        }
+        size_t fine = riga.find(Separatore, inizio);
+        if (fine == string_view::npos) {
+            fine = riga.size();
+        }
+        bool valido = C::leggi(riga.substr(inizio, fine - inizio), t);
+        inizio = fine + 1;
+        return valido;
+    }
+
+    /**
+     * @brief Accoda i campi, preceduti dal separatore tranne il primo
+     */
+    template <size_t... I>
+    static void scriviCampi(const Transazione& t, string& out, index_sequence<I...>) {
+        ((I == 0 ? void() : out.push_back(Separatore), Campi::scrivi(t, out)), ...);
+    }
+
+public:
+    /**
+     * @brief Accoda la riga di una transazione (senza a capo)
+     * @param t Transazione
+     * @param out Stringa a cui accodare la riga
+     */
+    static void scrivi(const Transazione& t, string& out) {
+        scriviCampi(t, out, index_sequence_for<Campi...>());
+    }
+
+    /**
+     * @brief Formatta una transazione
+     * @param t Transazione
+     * @return string Riga formattata
+     */
+    static string formatta(const Transazione& t) {
+        string riga;
+        scrivi(t, riga);
+        return riga;
+    }
+
+    /**
+     * @brief Interpreta una riga senza lanciare eccezioni
+     * @param riga Riga senza a capo
+     * @param t Transazione in cui scrivere i campi letti
+     * @return bool false se manca un campo obbligatorio o un campo non è valido
+     *         (t può essere stata modificata in parte)
+     */
+    static bool leggi(string_view riga, Transazione& t) {
+        size_t inizio = 0;
+        return (leggiCampo<Campi>(riga, inizio, t) && ...);
+    }
+
+    /**
+     * @brief Interpreta una riga
+     * @param riga Riga senza a capo
+     * @return Transazione Transazione letta
+     * @throws std::invalid_argument Se manca un campo obbligatorio o un campo non è valido
+     */
+    static Transazione analizza(string_view riga) {
+        Transazione t;
+        if (!leggi(riga, t)) {
+            throw invalid_argument("Riga non conforme al tracciato: " + string(riga));
+        }
+        return t;
+    }
+};
+
+/**
+ * @brief Tracciato storico "descrizione;importo;data" (Transazione::toString)
+ */
+using TracciatoClassico = TracciatoRecord<';', Campo::Descrizione, Campo::Importo, Campo::Data>;
+
+/**
+ * @brief Tracciato del file di testo del conto: il classico con l'identificativo facoltativo
+ */
+using TracciatoFile =
+    TracciatoRecord<';', Campo::Descrizione, Campo::Importo, Campo::Data, Campo::Facoltativo<Campo::Id>>;
+
+/**
+ * @brief Tracciato con identificativo, valuta (euro) e categoria
+ */
+using TracciatoEsteso = TracciatoRecord<';', Campo::Id, Campo::Descrizione, Campo::Importo, Campo::Valuta<'E', 'U', 'R'>,
+                                        Campo::Data, Campo::Categoria>;
+
+#endif // TRACCIATO_H
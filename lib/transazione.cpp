@@ -1,7 +1,6 @@
 #include "transazione.h"
-#include <sstream>
-#include <cctype>
-#include <iomanip>
+#include "tracciato.h"
+#include <stdexcept>
 
 using namespace std;
 
@@ -12,7 +11,7 @@ using namespace std;
  * @param dt Data della transazione
  */
 Transazione::Transazione(const string& desc, double imp, const string& dt) 
-    : descrizione(desc), importo(imp), data(dt) {
+    : descrizione(desc), importo(imp), data(dt), stato(0) {
 }
 
 /**
@@ -20,14 +19,14 @@ Transazione::Transazione(const string& desc, double imp, const string& dt)
  * 
  * Inizializza tutti i campi con valori di default
  */
-Transazione::Transazione() : descrizione(""), importo(0.0), data("") {
+Transazione::Transazione() : descrizione(""), importo(0.0), data(""), stato(0) {
 }
 
 /**
  * @brief Getter per la descrizione
- * @return string Descrizione della transazione
+ * @return const string& Descrizione della transazione
  */
-string Transazione::getDescrizione() const {
+const string& Transazione::getDescrizione() const {
     return descrizione;
 }
 
@@ -41,9 +40,9 @@ double Transazione::getImporto() const {
 
 /**
  * @brief Getter per la data
- * @return string Data della transazione
+ * @return const string& Data della transazione
  */
-string Transazione::getData() const {
+const string& Transazione::getData() const {
     return data;
 }
 
@@ -71,40 +70,81 @@ void Transazione::setData(const string& dt) {
     data = dt;
 }
 
+/**
+ * @brief Getter per la categoria
+ * @return int Indice della categoria (-1 se nessuna)
+ */
+int Transazione::getCategoria() const {
+    return static_cast<int>(stato >> BIT_CATEGORIA) - 1;
+}
+
+/**
+ * @brief Setter per la categoria
+ * @param cat Indice della categoria
+ */
+void Transazione::setCategoria(int cat) {
+    if (cat < -1 || cat > MASSIMA_CATEGORIA) {
+        throw invalid_argument("Categoria fuori intervallo: " + to_string(cat));
+    }
+    stato = (stato & ~(~uint64_t(0) << BIT_CATEGORIA)) | (static_cast<uint64_t>(cat + 1) << BIT_CATEGORIA);
+}
+
+/**
+ * @brief Getter per l'identificativo
+ * @return uint64_t Identificativo (0 se non assegnato)
+ */
+uint64_t Transazione::getId() const {
+    return stato & MASSIMO_ID;
+}
+
+/**
+ * @brief Setter per l'identificativo
+ * @param nuovoId Identificativo
+ */
+void Transazione::setId(uint64_t nuovoId) {
+    if (nuovoId > MASSIMO_ID) {
+        throw invalid_argument("Identificativo fuori intervallo: " + to_string(nuovoId));
+    }
+    stato = (stato & ~MASSIMO_ID) | nuovoId;
+}
+
+/**
+ * @brief Setter per il bit di eliminazione
+ * @param eliminata true se la riga è una lapide
+ */
+void Transazione::setEliminata(bool eliminata) {
+    stato = eliminata ? (stato | BIT_ELIMINATA) : (stato & ~BIT_ELIMINATA);
+}
+
+/**
+ * @brief Rilascia la capacità inutilizzata delle stringhe
+ */
+void Transazione::compatta() {
+    descrizione.shrink_to_fit();
+    data.shrink_to_fit();
+}
+
 /**
  * @brief Converte la transazione in stringa per il salvataggio su file
  * @return string Stringa formattata con separatori punto e virgola
  * 
- * Formato: "descrizione;importo.xx;YYYY-MM-DD"
+ * Formato: "descrizione;importo.xx;YYYY-MM-DD" (TracciatoClassico)
  * L'importo viene formattato con precisione a 2 cifre decimali
  */
 string Transazione::toString() const {
-    // Formatta l'importo con 2 cifre decimali
-    stringstream ss;
-    ss << fixed << setprecision(2) << importo;
-    return descrizione + ";" + ss.str() + ";" + data;
+    return TracciatoClassico::formatta(*this);
 }
 
 /**
  * @brief Crea una transazione da una stringa letta dal file
- * @param str Stringa nel formato "descrizione;importo;data"
+ * @param str Stringa nel formato "descrizione;importo;data[;id]"
  * @return Transazione Nuova transazione creata
- * @throws std::invalid_argument Se la conversione dell'importo fallisce
+ * @throws std::invalid_argument Se manca un campo o l'importo non è un numero
  * 
- * Utilizza il punto e virgola come separatore dei campi
+ * Utilizza il punto e virgola come separatore dei campi (TracciatoFile)
  */
 Transazione Transazione::fromString(const string& str) {
-    stringstream ss(str);
-    string desc, importoStr, dt;
-    
-    // Separa i campi usando il punto e virgola come delimitatore
-    getline(ss, desc, ';');
-    getline(ss, importoStr, ';');
-    getline(ss, dt, ';');
-    
-    double importo = stod(importoStr);
-    
-    return Transazione(desc, importo, dt);
+    return TracciatoFile::analizza(str);
 }
 
 /**
@@ -112,22 +152,18 @@ Transazione Transazione::fromString(const string& str) {
  * @param parola Parola chiave da cercare
  * @return bool true se la parola è contenuta nella descrizione, false altrimenti
  * 
- * La ricerca è case-insensitive: converte sia la descrizione che la parola
- * in minuscolo prima del confronto
+ * La ricerca è case-insensitive: compila la parola (conversione in minuscolo
+ * e tabella dei salti) e la cerca nella descrizione senza copiarla
  */
 bool Transazione::contieneParolaChiave(const string& parola) const {
-    // Converte tutto in minuscolo per confronto case-insensitive
-    string descLower = descrizione;
-    string parolaLower = parola;
-    
-    // Converte in minuscolo
-    for (char& c : descLower) {
-        c = tolower(c);
-    }
-    for (char& c : parolaLower) {
-        c = tolower(c);
-    }
-    
-    // Cerca la parola nella descrizione
-    return descLower.find(parolaLower) != string::npos;
+    return ParolaChiave(parola).trovaIn(descrizione);
+}
+
+/**
+ * @brief Verifica se la descrizione contiene una parola chiave compilata
+ * @param parola Parola chiave compilata
+ * @return bool true se la parola è contenuta nella descrizione
+ */
+bool Transazione::contieneParolaChiave(const ParolaChiave& parola) const {
+    return parola.trovaIn(descrizione);
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #ifndef TRANSAZIONE_H
 #define TRANSAZIONE_H
 
+#include "parolachiave.h"
 #include <string>
+#include <cstdint>
 
 using namespace std;
 
@@ -17,8 +19,15 @@ private:
     string descrizione;  /**< Descrizione della transazione */
     double importo;      /**< Importo (positivo per entrate, negativo per uscite) */
     string data;         /**< Data in formato YYYY-MM-DD */
+    uint64_t stato;      /**< Identificativo (bit 0-46), riga eliminata (bit 47), categoria + 1 (bit 48-63) */
+
+    static constexpr uint64_t BIT_ELIMINATA = uint64_t(1) << 47;  /**< Bit della riga eliminata in stato */
+    static constexpr int BIT_CATEGORIA = 48;                      /**< Primo bit della categoria in stato */
 
 public:
+    static constexpr uint64_t MASSIMO_ID = BIT_ELIMINATA - 1;  /**< Identificativo più alto rappresentabile */
+    static constexpr int MASSIMA_CATEGORIA = 0xFFFE;            /**< Indice di categoria più alto rappresentabile */
+
     /**
      * @brief Costruttore parametrico
      * @param desc Descrizione della transazione
@@ -37,9 +46,9 @@ public:
     
     /**
      * @brief Restituisce la descrizione della transazione
-     * @return string Descrizione della transazione
+     * @return const string& Descrizione della transazione
      */
-    string getDescrizione() const;
+    const string& getDescrizione() const;
     
     /**
      * @brief Restituisce l'importo della transazione
@@ -49,9 +58,9 @@ public:
     
     /**
      * @brief Restituisce la data della transazione
-     * @return string Data in formato YYYY-MM-DD
+     * @return const string& Data in formato YYYY-MM-DD
      */
-    string getData() const;
+    const string& getData() const;
     
     /**
      * @brief Imposta la descrizione della transazione
@@ -71,6 +80,61 @@ public:
      */
     void setData(const string& dt);
     
+    /**
+     * @brief Restituisce la categoria assegnata alla transazione
+     * @return int Indice della categoria nel Classificatore del conto (-1 se nessuna)
+     * 
+     * La categoria è una cache calcolata dal conto: non viene salvata su file.
+     */
+    int getCategoria() const;
+    
+    /**
+     * @brief Imposta la categoria della transazione
+     * @param cat Indice della categoria (-1 per nessuna)
+     * @throws std::invalid_argument Se cat è fuori da [-1, MASSIMA_CATEGORIA]
+     */
+    void setCategoria(int cat);
+    
+    /**
+     * @brief Restituisce l'identificativo della transazione
+     * @return uint64_t Identificativo assegnato dal conto (0 se non assegnato)
+     * 
+     * Tutte le versioni di una transazione modificata hanno lo stesso identificativo.
+     */
+    uint64_t getId() const;
+    
+    /**
+     * @brief Imposta l'identificativo della transazione
+     * @param nuovoId Identificativo
+     * @throws std::invalid_argument Se nuovoId supera MASSIMO_ID
+     */
+    void setId(uint64_t nuovoId);
+    
+    /**
+     * @brief Indica se la riga è una lapide del conto
+     * @return bool true se la riga è stata eliminata (o sostituita da una modifica)
+     * 
+     * Una riga eliminata resta nel conto finché non viene compattata, così
+     * le istantanee precedenti continuano a vederla; la versione
+     * dell'eliminazione è conservata dal conto, non nella riga.
+     */
+    bool isEliminata() const {
+        return (stato & BIT_ELIMINATA) != 0;
+    }
+    
+    /**
+     * @brief Segna la riga come eliminata o valida
+     * @param eliminata true per trasformarla in lapide
+     */
+    void setEliminata(bool eliminata);
+    
+    /**
+     * @brief Riduce la capacità di descrizione e data alla loro lunghezza
+     * 
+     * Gli altri campi (identificativo, categoria, eliminazione) non cambiano.
+     */
+    void compatta();
+    
     /**
      * @brief Converte la transazione in stringa per il salvataggio
      * @return string Stringa formattata con descrizione;importo;data
@@ -82,9 +146,12 @@ public:
     
     /**
      * @brief Crea una transazione da una stringa
-     * @param str Stringa nel formato "descrizione;importo;data"
+     * @param str Stringa nel formato "descrizione;importo;data" seguita
+     *            facoltativamente da ";id" (vedi ContoCorrente::salvaSuFile)
      * @return Transazione Nuova transazione creata dalla stringa
      * @throws std::invalid_argument Se la stringa non è nel formato corretto
+     * 
+     * Altri tracciati (con valuta, categoria...) sono disponibili in tracciato.h.
      */
     static Transazione fromString(const string& str);
     
@@ -93,9 +160,18 @@ public:
      * @param parola Parola chiave da cercare nella descrizione
      * @return bool true se la parola è trovata, false altrimenti
      * 
-     * La ricerca è case-insensitive
+     * La ricerca è case-insensitive, anche per le lettere accentate
      */
     bool contieneParolaChiave(const string& parola) const;
+    
+    /**
+     * @brief Verifica se la transazione contiene una parola chiave già compilata
+     * @param parola Parola chiave compilata
+     * @return bool true se la parola è trovata, false altrimenti
+     * 
+     * Da preferire quando la stessa parola viene cercata su molte transazioni
+     */
+    bool contieneParolaChiave(const ParolaChiave& parola) const;
 };
 
 #endif // TRANSAZIONE_H
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "utilita.h"
+#include <charconv>
+#include <cmath>
+#include <cctype>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * @brief Converte una data YYYY-MM-DD in giorni dal 1970-01-01
+ * @param data Data da convertire
+ * @return int Numero di giorni
+ * @throws std::invalid_argument Se la data non è nel formato corretto o non esiste
+ *
+ * Utilizza l'algoritmo "days from civil" sul calendario gregoriano
+ * prolettico, valido anche per anni molto lontani. Mese e giorno vengono
+ * controllati: l'algoritmo accetterebbe anche 2024-02-30 (come 2024-03-01),
+ * e chi salva i giorni al posto del testo cambierebbe la data.
+ */
+int dataInGiorni(const string& data) {
+    if (data.length() != 10 || data[4] != '-' || data[7] != '-') {
+        throw invalid_argument("Data non valida: " + data);
+    }
+    for (int i = 0; i < 10; i++) {
+        if (i == 4 || i == 7) continue;
+        if (!isdigit(static_cast<unsigned char>(data[i]))) {
+            throw invalid_argument("Data non valida: " + data);
+        }
+    }
+
+    int anno = (data[0] - '0') * 1000 + (data[1] - '0') * 100 + (data[2] - '0') * 10 + (data[3] - '0');
+    int mese = (data[5] - '0') * 10 + (data[6] - '0');
+    int giorno = (data[8] - '0') * 10 + (data[9] - '0');
+    static const int giorniMese[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool bisestile = (anno % 4 == 0 && anno % 100 != 0) || anno % 400 == 0;
+    if (mese < 1 || mese > 12 || giorno < 1 || giorno > giorniMese[mese - 1] + (mese == 2 && bisestile)) {
+        throw invalid_argument("Data non valida: " + data);
+    }
+
+    anno -= mese <= 2;
+    int era = (anno >= 0 ? anno : anno - 399) / 400;
+    int annoEra = anno - era * 400;
+    int giornoAnno = (153 * (mese + (mese > 2 ? -3 : 9)) + 2) / 5 + giorno - 1;
+    int giornoEra = annoEra * 365 + annoEra / 4 - annoEra / 100 + giornoAnno;
+    return era * 146097 + giornoEra - 719468;
+}
+
+/**
+ * @brief Converte giorni dal 1970-01-01 in una data YYYY-MM-DD
+ * @param giorni Numero di giorni
+ * @return string Data formattata
+ *
+ * Inverso esatto di dataInGiorni ("civil from days").
+ */
+string giorniInData(int giorni) {
+    giorni += 719468;
+    int era = (giorni >= 0 ? giorni : giorni - 146096) / 146097;
+    int giornoEra = giorni - era * 146097;
+    int annoEra = (giornoEra - giornoEra / 1460 + giornoEra / 36524 - giornoEra / 146096) / 365;
+    int anno = annoEra + era * 400;
+    int giornoAnno = giornoEra - (365 * annoEra + annoEra / 4 - annoEra / 100);
+    int mp = (5 * giornoAnno + 2) / 153;
+    int giorno = giornoAnno - (153 * mp + 2) / 5 + 1;
+    int mese = mp < 10 ? mp + 3 : mp - 9;
+    anno += mese <= 2;
+
+    string risultato = "0000-00-00";
+    risultato[0] = '0' + (anno / 1000) % 10;
+    risultato[1] = '0' + (anno / 100) % 10;
+    risultato[2] = '0' + (anno / 10) % 10;
+    risultato[3] = '0' + anno % 10;
+    risultato[5] = '0' + mese / 10;
+    risultato[6] = '0' + mese % 10;
+    risultato[8] = '0' + giorno / 10;
+    risultato[9] = '0' + giorno % 10;
+    return risultato;
+}
+
+/**
+ * @brief Converte un importo in centesimi
+ * @param importo Importo in euro
+ * @return long long Centesimi arrotondati
+ */
+long long importoInCentesimi(double importo) {
+    return llround(importo * 100.0);
+}
+
+/**
+ * @brief Centesimi di un importo formattato con due decimali
+ * @param importo Importo in euro
+ * @return long long Centesimi letti dal testo formattato
+ */
+long long centesimiTesto(double importo) {
+    char buffer[64];
+    auto risultato = to_chars(buffer, buffer + sizeof(buffer), importo, chars_format::fixed, 2);
+    double letto = 0.0;
+    from_chars(buffer, risultato.ptr, letto);
+    return importoInCentesimi(letto);
+}
+
+/**
+ * @brief Normalizza una descrizione nel buffer indicato
+ * @param descrizione Descrizione originale
+ * @param risultato Buffer di output
+ */
+void normalizzaDescrizione(const string& descrizione, string& risultato) {
+    risultato.clear();
+    bool spazioInSospeso = false;
+    unsigned char precedente = 0;
+    for (char c : descrizione) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (byte < 0x80 && isspace(byte)) {
+            spazioInSospeso = !risultato.empty();
+            precedente = byte;
+            continue;
+        }
+        if (spazioInSospeso) {
+            risultato.push_back(' ');
+            spazioInSospeso = false;
+        }
+        risultato.push_back(static_cast<char>(piegaByte(precedente, byte)));
+        precedente = byte;
+    }
+}
+
+/**
+ * @brief Normalizza una descrizione restituendo una nuova stringa
+ * @param descrizione Descrizione originale
+ * @return string Descrizione normalizzata
+ */
+string normalizzaDescrizione(const string& descrizione) {
+    string risultato;
+    normalizzaDescrizione(descrizione, risultato);
+    return risultato;
+}
+
+/**
+ * @brief Memoria allocata sullo heap da una stringa
+ * @param s Stringa
+ * @return size_t Capacità più il terminatore, oppure 0 se il testo è interno
+ */
+size_t memoriaEsterna(const string& s) {
+    const char* oggetto = reinterpret_cast<const char*>(&s);
+    if (s.data() >= oggetto && s.data() < oggetto + sizeof(string)) {
+        return 0;
+    }
+    return s.capacity() + 1;
+}
+
+/**
+ * @brief Byte tra la posizione corrente e la fine dello stream
+ * @param in Stream di input
+ * @return uint64_t Byte restanti, UINT64_MAX se lo stream non è posizionabile
+ */
+uint64_t byteRestanti(istream& in) {
+    streampos inizio = in.tellg();
+    if (inizio == streampos(-1)) {
+        in.clear();
+        return UINT64_MAX;
+    }
+    in.seekg(0, ios::end);
+    streampos fine = in.tellg();
+    in.clear();
+    in.seekg(inizio);
+    if (fine == streampos(-1) || fine < inizio) {
+        return UINT64_MAX;
+    }
+    return static_cast<uint64_t>(fine - inizio);
+}
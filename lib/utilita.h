@@ -0,0 +1,108 @@
+#ifndef UTILITA_H
+#define UTILITA_H
+
+#include <cstdint>
+#include <istream>
+#include <string>
+
+using namespace std;
+
+/**
+ * @brief Converte una data in formato YYYY-MM-DD nel numero di giorni dal 1970-01-01
+ * @param data Data in formato YYYY-MM-DD
+ * @return int Giorni trascorsi dal 1970-01-01 (negativi per date precedenti)
+ * @throws std::invalid_argument Se la data non è nel formato YYYY-MM-DD o non esiste
+ *         (ad esempio 2024-02-30 o 2024-13-01)
+ *
+ * La conversione permette di confrontare e codificare a delta le date
+ * usando semplici interi.
+ */
+int dataInGiorni(const string& data);
+
+/**
+ * @brief Converte un numero di giorni dal 1970-01-01 in una data YYYY-MM-DD
+ * @param giorni Giorni trascorsi dal 1970-01-01
+ * @return string Data in formato YYYY-MM-DD
+ */
+string giorniInData(int giorni);
+
+/**
+ * @brief Converte un importo in centesimi arrotondando al centesimo più vicino
+ * @param importo Importo in euro
+ * @return long long Importo in centesimi
+ */
+long long importoInCentesimi(double importo);
+
+/**
+ * @brief Centesimi di un importo così come appare nei file di testo
+ * @param importo Importo in euro
+ * @return long long Centesimi dell'importo formattato con due decimali
+ *
+ * Il file di testo arrotonda con to_chars, che sui valori esattamente a metà
+ * (ad esempio 0.125) può differire da importoInCentesimi: questa funzione
+ * restituisce i centesimi che si ottengono rileggendo il file.
+ */
+long long centesimiTesto(double importo);
+
+/**
+ * @brief Converte in minuscolo un byte di testo UTF-8
+ * @param precedente Byte che precede c nel testo (0 se c è il primo)
+ * @param c Byte da convertire
+ * @return unsigned char Byte convertito
+ *
+ * Oltre alle lettere ASCII gestisce le lettere accentate maiuscole del
+ * blocco Latin-1 (À-Þ, codificate come 0xC3 0x80-0x9E eccetto il segno ×):
+ * in UTF-8 la minuscola differisce solo per il secondo byte (+0x20), quindi
+ * la conversione avviene byte per byte senza cambiare la lunghezza del testo.
+ */
+inline unsigned char piegaByte(unsigned char precedente, unsigned char c) {
+    if (c < 0x80) {
+        return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+    }
+    if (precedente == 0xC3 && c >= 0x80 && c <= 0x9E && c != 0x97) {
+        return c + 0x20;
+    }
+    return c;
+}
+
+/**
+ * @brief Normalizza una descrizione per confronti e raggruppamenti
+ * @param descrizione Descrizione originale
+ * @param risultato Buffer in cui scrivere la descrizione normalizzata
+ *
+ * Converte in minuscolo (incluse le lettere accentate, vedi piegaByte),
+ * elimina gli spazi iniziali e finali e riduce
+ * ogni sequenza di spazi a un singolo spazio. Il buffer viene riutilizzato
+ * per evitare allocazioni quando la funzione è chiamata in un ciclo.
+ */
+void normalizzaDescrizione(const string& descrizione, string& risultato);
+
+/**
+ * @brief Normalizza una descrizione per confronti e raggruppamenti
+ * @param descrizione Descrizione originale
+ * @return string Descrizione normalizzata
+ */
+string normalizzaDescrizione(const string& descrizione);
+
+/**
+ * @brief Restituisce la memoria allocata da una stringa fuori dall'oggetto
+ * @param s Stringa
+ * @return size_t Byte allocati sullo heap (0 se il testo è nel buffer interno)
+ *
+ * Le stringhe corte sono conservate nell'oggetto stesso (small string
+ * optimization) e non occupano memoria aggiuntiva.
+ */
+size_t memoriaEsterna(const string& s);
+
+/**
+ * @brief Restituisce i byte che restano da leggere in uno stream
+ * @param in Stream di input (la posizione non cambia)
+ * @return uint64_t Byte dalla posizione corrente alla fine, UINT64_MAX se lo
+ *         stream non consente di spostarsi
+ *
+ * Serve a confrontare le lunghezze lette da un file prima di allocare: un
+ * file corrotto non può far riservare più memoria di quanta ne contiene.
+ */
+uint64_t byteRestanti(istream& in);
+
+#endif // UTILITA_H
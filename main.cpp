@@ -132,8 +132,11 @@ void aggiungiTransazione(ContoCorrente& conto) {
         }
     } while (!dataValida);
     
-    conto.aggiungiTransazione(descrizione, importo, data);
-    cout << "Transazione aggiunta con successo!" << endl;
+    if (conto.aggiungiTransazione(descrizione, importo, data)) {
+        cout << "Transazione aggiunta con successo!" << endl;
+    } else {
+        cout << "Transazione già presente, non aggiunta." << endl;
+    }
 }
 
 /**
@@ -0,0 +1,64 @@
+#include <iostream>
+#include <string>
+#include <csignal>
+#include <algorithm>
+#include "lib/contocorrente.h"
+#include "lib/serverconto.h"
+
+using namespace std;
+
+/**
+ * @brief Avvia il server di interrogazione del conto corrente
+ * @param argc Numero di argomenti
+ * @param argv Argomenti: [file dati] [porta TCP oppure percorso socket Unix] [segmento condiviso]
+ * @return int Codice di uscita (0 = successo)
+ *
+ * Carica il conto una sola volta e lo serve finché non riceve SIGINT o
+ * SIGTERM; alla chiusura salva automaticamente le transazioni.
+ * Un argomento composto solo da cifre è interpretato come porta TCP su
+ * 127.0.0.1, altrimenti come percorso di una socket Unix.
+ * Se è indicato un nome di segmento (ad esempio "/conto") il conto viene
+ * anche pubblicato in memoria condivisa per i lettori di altri processi.
+ */
+int main(int argc, char** argv) {
+    string file = argc > 1 ? argv[1] : "../data/dati.txt";
+    string indirizzo = argc > 2 ? argv[2] : "/tmp/conto_corrente.sock";
+    string segmento = argc > 3 ? argv[3] : "";
+
+    // I segnali vengono bloccati prima di creare i thread, che ereditano la
+    // maschera: solo sigwait nel thread principale li riceverà
+    sigset_t segnali;
+    sigemptyset(&segnali);
+    sigaddset(&segnali, SIGINT);
+    sigaddset(&segnali, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &segnali, nullptr);
+
+    ContoCorrente conto(file);
+    try {
+        if (!segmento.empty()) {
+            // Spazio per raddoppiare le righe attuali prima di riempire il segmento
+            conto.abilitaCondivisione(segmento, max<size_t>(1 << 20, 2 * conto.getNumeroTransazioni()));
+            cout << "Conto pubblicato nel segmento condiviso " << segmento << endl;
+        }
+        ServerConto server(conto);
+        if (indirizzo.find_first_not_of("0123456789") == string::npos) {
+            uint16_t porta = server.ascoltaTcp(static_cast<uint16_t>(stoi(indirizzo)));
+            cout << "In ascolto su 127.0.0.1:" << porta << endl;
+        } else {
+            server.ascoltaUnix(indirizzo);
+            cout << "In ascolto su " << indirizzo << endl;
+        }
+        server.avvia();
+
+        int segnale;
+        sigwait(&segnali, &segnale);
+        cout << "\nArresto del server..." << endl;
+        server.ferma();
+    } catch (const exception& e) {
+        cout << "Errore del server: " << e.what() << endl;
+        return 1;
+    }
+
+    conto.salvaSuFile();
+    return 0;
+}
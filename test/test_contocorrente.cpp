@@ -1,7 +1,29 @@
 #include <gtest/gtest.h>
 #include "../lib/transazione.h"
 #include "../lib/contocorrente.h"
+#include "../lib/formatocompresso.h"
+#include "../lib/utilita.h"
+#include "../lib/parolachiave.h"
+#include "../lib/serverconto.h"
+#include "../lib/classificatore.h"
+#include "../lib/generatorecarico.h"
+#include "../lib/registrocondiviso.h"
+#include "../lib/tracciato.h"
+#include "../lib/puntidicontrollo.h"
 #include <chrono>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <map>
+#include <cstring>
 
 using namespace std;
 
@@ -113,6 +135,51 @@ TEST_F(TransazioneTest, CaratteriSpeciali) {
     EXPECT_EQ(copia.getDescrizione(), "Spesa supermercato con sconti");
 }
 
+// Test compattazione delle stringhe sul posto
+TEST_F(TransazioneTest, Compatta) {
+    Transazione t(string(200, 'x'), -5.0, "2024-01-01");
+    t.setDescrizione("Descrizione più corta ma non breve");
+    t.setId(7);
+    t.setCategoria(2);
+    t.setEliminata(true);
+    EXPECT_GT(memoriaEsterna(t.getDescrizione()), t.getDescrizione().size() + 1);
+
+    t.compatta();
+    EXPECT_EQ(memoriaEsterna(t.getDescrizione()), t.getDescrizione().size() + 1);
+    EXPECT_EQ(t.getDescrizione(), "Descrizione più corta ma non breve");
+    EXPECT_EQ(t.getId(), 7u);
+    EXPECT_EQ(t.getCategoria(), 2);
+    EXPECT_TRUE(t.isEliminata());
+}
+
+// Test campi impaccati: identificativo, categoria ed eliminazione in una parola
+TEST_F(TransazioneTest, CampiImpaccati) {
+    EXPECT_EQ(sizeof(Transazione), 2 * sizeof(string) + sizeof(double) + sizeof(uint64_t));
+    Transazione t("Spesa", -3.0, "2024-01-01");
+    EXPECT_EQ(t.getId(), 0u);
+    EXPECT_EQ(t.getCategoria(), -1);
+    EXPECT_FALSE(t.isEliminata());
+
+    t.setId(Transazione::MASSIMO_ID);
+    t.setCategoria(Transazione::MASSIMA_CATEGORIA);
+    t.setEliminata(true);
+    EXPECT_EQ(t.getId(), Transazione::MASSIMO_ID);
+    EXPECT_EQ(t.getCategoria(), Transazione::MASSIMA_CATEGORIA);
+    EXPECT_TRUE(t.isEliminata());
+
+    t.setCategoria(-1);
+    t.setId(42);
+    t.setEliminata(false);
+    EXPECT_EQ(t.getId(), 42u);
+    EXPECT_EQ(t.getCategoria(), -1);
+    EXPECT_FALSE(t.isEliminata());
+
+    EXPECT_THROW(t.setId(Transazione::MASSIMO_ID + 1), invalid_argument);
+    EXPECT_THROW(t.setCategoria(Transazione::MASSIMA_CATEGORIA + 1), invalid_argument);
+    EXPECT_THROW(t.setCategoria(-2), invalid_argument);
+    EXPECT_EQ(t.getId(), 42u);
+}
+
 // Test per la classe ContoCorrente
 class ContoCorrenteTest : public ::testing::Test {
 protected:
@@ -125,6 +192,8 @@ protected:
         delete conto;
         // Rimuovi il file di test (opzionale)
         remove("test_data.txt");
+        remove("test_data.txt.mesi");
+        remove("test_data.txt.blocchi");
     }
     
     ContoCorrente* conto;
@@ -434,4 +503,1554 @@ TEST_F(ValidazioneTest, EdgeCasesAnni) {
     EXPECT_TRUE(validaData("0001-01-01")); // Anno minimo
     EXPECT_TRUE(validaData("9999-12-31")); // Anno massimo
     EXPECT_TRUE(validaData("1000-06-15")); // Anno a 4 cifre
-}
\ No newline at end of file
+}
+// Test per le funzioni di utilità
+class UtilitaTest : public ::testing::Test {
+};
+
+// Test conversione date in giorni e ritorno
+TEST_F(UtilitaTest, ConversioneDate) {
+    EXPECT_EQ(dataInGiorni("1970-01-01"), 0);
+    EXPECT_EQ(dataInGiorni("1970-01-02"), 1);
+    EXPECT_EQ(dataInGiorni("1969-12-31"), -1);
+    EXPECT_EQ(dataInGiorni("2024-03-01") - dataInGiorni("2024-02-28"), 2); // Anno bisestile
+
+    for (string data : {"0001-01-01", "2000-02-29", "2024-12-31", "9999-12-31"}) {
+        EXPECT_EQ(giorniInData(dataInGiorni(data)), data);
+    }
+    EXPECT_THROW(dataInGiorni("2024/01/01"), invalid_argument);
+    EXPECT_THROW(dataInGiorni(""), invalid_argument);
+    EXPECT_THROW(dataInGiorni("2024-02-30"), invalid_argument);
+    EXPECT_THROW(dataInGiorni("2023-02-29"), invalid_argument);
+    EXPECT_THROW(dataInGiorni("2024-13-01"), invalid_argument);
+    EXPECT_THROW(dataInGiorni("2024-01-00"), invalid_argument);
+    EXPECT_EQ(dataInGiorni("2024-02-29") + 1, dataInGiorni("2024-03-01"));
+}
+
+// Test salvataggio e caricamento nel formato compresso
+TEST_F(ContoCorrenteTest, SalvataggioCompresso) {
+    for (int i = 0; i < 10000; i++) {
+        conto->aggiungiTransazione(i % 3 == 0 ? "Stipendio" : "Spesa supermercato",
+                                   (i % 3 == 0) ? 1500.25 : -(i % 97) - 0.5,
+                                   giorniInData(dataInGiorni("2020-01-01") + i / 10));
+    }
+    conto->setFormatoFile(FormatoFile::Compresso);
+    conto->salvaSuFile();
+
+    ContoCorrente nuovoConto("test_data.txt");
+    EXPECT_EQ(nuovoConto.getFormatoFile(), FormatoFile::Compresso);
+    ASSERT_EQ(nuovoConto.getNumeroTransazioni(), 10000);
+    EXPECT_NEAR(nuovoConto.calcolaSaldo(), conto->calcolaSaldo(), 0.001);
+
+    vector<Transazione> originali = conto->getTransazioni();
+    vector<Transazione> caricate = nuovoConto.getTransazioni();
+    for (size_t i = 0; i < originali.size(); i += 997) {
+        EXPECT_EQ(caricate[i].getDescrizione(), originali[i].getDescrizione());
+        EXPECT_DOUBLE_EQ(caricate[i].getImporto(), originali[i].getImporto());
+        EXPECT_EQ(caricate[i].getData(), originali[i].getData());
+    }
+
+    // Il formato compresso deve occupare molto meno del formato testo
+    auto dimensioneCompressa = filesystem::file_size("test_data.txt");
+    conto->setFormatoFile(FormatoFile::Testo);
+    conto->salvaSuFile();
+    EXPECT_LT(dimensioneCompressa * 3, filesystem::file_size("test_data.txt"));
+}
+
+// Test lettura per intervallo di date con salto dei blocchi
+TEST_F(ContoCorrenteTest, IntervalloCompresso) {
+    for (int i = 0; i < 3 * (int)FormatoCompresso::RIGHE_PER_BLOCCO; i++) {
+        conto->aggiungiTransazione("Riga " + to_string(i % 50), 1.0,
+                                   giorniInData(dataInGiorni("2024-01-01") + i / 100));
+    }
+    conto->setFormatoFile(FormatoFile::Compresso);
+    conto->salvaSuFile();
+
+    vector<Transazione> risultati = FormatoCompresso::leggiIntervallo("test_data.txt", "2024-01-01", "2024-01-02");
+    EXPECT_EQ(risultati.size(), 200);
+
+    risultati = FormatoCompresso::leggiIntervallo("test_data.txt", "2030-01-01", "2030-12-31");
+    EXPECT_EQ(risultati.size(), 0);
+}
+
+// Test che una data non valida non tronchi il file già salvato
+TEST_F(ContoCorrenteTest, CompressioneDataNonValida) {
+    conto->aggiungiTransazione("Valida", 10.0, "2024-01-01");
+    conto->salvaSuFile();
+
+    conto->aggiungiTransazione("Non valida", 10.0, "01/01/2024");
+    conto->setFormatoFile(FormatoFile::Compresso);
+    conto->salvaSuFile();
+
+    ContoCorrente nuovoConto("test_data.txt");
+    EXPECT_EQ(nuovoConto.getNumeroTransazioni(), 1);
+}
+
+// Test file di testo che inizia come una vecchia firma: non va scambiato per compresso
+TEST_F(ContoCorrenteTest, TestoSimileAllaFirma) {
+    ofstream("test_data.txt") << "CCZ1 rimborso;12.50;2024-01-05\nCaffè;-1.20;2024-01-06\n";
+    {
+        ContoCorrente letto("test_data.txt");
+        EXPECT_EQ(letto.getFormatoFile(), FormatoFile::Testo);
+        EXPECT_EQ(letto.getNumeroTransazioni(), 2);
+        letto.salvaSuFile();
+    }
+    ContoCorrente riletto("test_data.txt");
+    EXPECT_EQ(riletto.getNumeroTransazioni(), 2);
+
+    // Un file compresso illeggibile non cambia il formato di salvataggio
+    ofstream("test_data.txt", ios::binary) << "\x89" "CZ3" "troncato";
+    ContoCorrente corrotto("test_data.txt");
+    EXPECT_EQ(corrotto.getFormatoFile(), FormatoFile::Testo);
+    EXPECT_EQ(corrotto.getNumeroTransazioni(), 0);
+}
+
+// Test lunghezze corrotte: errore di formato, non allocazioni di gigabyte
+TEST(FormatoCompressoTest, LunghezzeCorrotte) {
+    // Blocco da una riga che dichiara 4 GiB di dati
+    string blocco("\x01\0\0\0" "\0\0\0\0" "\0\0\0\0" "\xff\xff\xff\xff" "abc", 19);
+    istringstream grande(blocco, ios::binary);
+    EXPECT_THROW(FormatoCompresso::leggi(grande, 3), runtime_error);
+    grande.clear();
+    grande.seekg(0);
+    EXPECT_THROW(FormatoCompresso::leggiIntervallo(grande, "1970-01-01", "1970-01-01", 3), runtime_error);
+
+    // Dizionario da 16383 voci in un blocco di due byte
+    string dizionario("\xff\xff\xff\xff" "\0\0\0\0" "\0\0\0\0" "\x02\0\0\0" "\xff\x7f", 18);
+    istringstream voci(dizionario, ios::binary);
+    EXPECT_THROW(FormatoCompresso::leggi(voci, 3), runtime_error);
+
+    // File colonnare con un lotto di 4 miliardi di righe
+    istringstream colonnare(string("CCC1" "\xff\xff\xff\xff" "0123456789", 18), ios::binary);
+    EXPECT_THROW(Esportatore::leggiColonnare(colonnare), runtime_error);
+}
+
+// Test modalità ordinata: ricerche equivalenti a quelle della modalità normale
+TEST_F(ContoCorrenteTest, ModalitaOrdinataRicerche) {
+    ContoCorrente normale("test_data_normale.txt");
+    conto->setOrdinatoPerData(true);
+
+    // Date in ordine con qualche riga arretrata, oltre la soglia di fusione
+    for (int i = 0; i < 1000; i++) {
+        int giorno = (i % 7 == 0) ? i / 4 - 30 : i / 4;
+        string data = giorniInData(dataInGiorni("2024-01-01") + giorno);
+        conto->aggiungiTransazione("Riga " + to_string(i), i % 5 - 2.0, data);
+        normale.aggiungiTransazione("Riga " + to_string(i), i % 5 - 2.0, data);
+    }
+
+    vector<Transazione> ordinate = conto->getTransazioni();
+    EXPECT_TRUE(is_sorted(ordinate.begin(), ordinate.end() - 64,
+                          [](const Transazione& a, const Transazione& b) { return a.getData() < b.getData(); }));
+
+    for (string data : {"2023-12-05", "2024-01-01", "2024-02-15", "2024-03-20", "2025-01-01"}) {
+        EXPECT_EQ(conto->cercaPerData(data).size(), normale.cercaPerData(data).size());
+        EXPECT_NEAR(conto->calcolaSaldoAl(data), normale.calcolaSaldoAl(data), 1e-9);
+    }
+    EXPECT_EQ(conto->cercaPerIntervallo("2024-01-10", "2024-02-10").size(),
+              normale.cercaPerIntervallo("2024-01-10", "2024-02-10").size());
+    EXPECT_DOUBLE_EQ(conto->calcolaSaldo(), normale.calcolaSaldo());
+}
+
+// Test modalità ordinata: ordinamento stabile all'attivazione
+TEST_F(ContoCorrenteTest, ModalitaOrdinataAttivazione) {
+    conto->aggiungiTransazione("Terza", 3.0, "2024-03-01");
+    conto->aggiungiTransazione("Prima", 1.0, "2024-01-01");
+    conto->aggiungiTransazione("Seconda A", 2.0, "2024-02-01");
+    conto->aggiungiTransazione("Seconda B", 2.5, "2024-02-01");
+
+    conto->setOrdinatoPerData(true);
+    EXPECT_TRUE(conto->isOrdinatoPerData());
+
+    vector<Transazione> ordinate = conto->getTransazioni();
+    EXPECT_EQ(ordinate[0].getDescrizione(), "Prima");
+    EXPECT_EQ(ordinate[1].getDescrizione(), "Seconda A");
+    EXPECT_EQ(ordinate[2].getDescrizione(), "Seconda B");
+    EXPECT_EQ(ordinate[3].getDescrizione(), "Terza");
+
+    vector<Transazione> intervallo = conto->cercaPerIntervallo("2024-01-15", "2024-02-28");
+    ASSERT_EQ(intervallo.size(), 2);
+    EXPECT_EQ(intervallo[0].getDescrizione(), "Seconda A");
+    EXPECT_DOUBLE_EQ(conto->calcolaSaldoAl("2024-02-01"), 5.5);
+    EXPECT_DOUBLE_EQ(conto->calcolaSaldoAl("2023-12-31"), 0.0);
+}
+
+// Test aggregazione per mese e anno
+TEST_F(ContoCorrenteTest, AggregazionePerData) {
+    conto->aggiungiTransazione("Stipendio", 2000.0, "2024-01-27");
+    conto->aggiungiTransazione("Affitto", -800.0, "2024-01-02");
+    conto->aggiungiTransazione("Spesa", -150.0, "2024-02-03");
+    conto->aggiungiTransazione("Bonus", 300.0, "2024-02-04");
+    conto->aggiungiTransazione("Regalo", 50.0, "2023-12-25");
+
+    vector<Aggregato> mesi = conto->aggrega(Raggruppamento::Mese);
+    ASSERT_EQ(mesi.size(), 3);
+    EXPECT_EQ(mesi[0].chiave, "2023-12");
+    EXPECT_EQ(mesi[1].chiave, "2024-01");
+    EXPECT_DOUBLE_EQ(mesi[1].somma, 1200.0);
+    EXPECT_DOUBLE_EQ(mesi[1].entrate, 2000.0);
+    EXPECT_DOUBLE_EQ(mesi[1].uscite, -800.0);
+    EXPECT_EQ(mesi[1].conteggio, 2);
+    EXPECT_EQ(mesi[2].conteggio, 2);
+
+    vector<Aggregato> anni = conto->aggrega(Raggruppamento::Anno);
+    ASSERT_EQ(anni.size(), 2);
+    EXPECT_EQ(anni[1].chiave, "2024");
+    EXPECT_DOUBLE_EQ(anni[1].somma, 1350.0);
+
+    EXPECT_EQ(conto->aggrega(Raggruppamento::Giorno).size(), 5);
+}
+
+// Test aggregazione per descrizione normalizzata
+TEST_F(ContoCorrenteTest, AggregazionePerDescrizione) {
+    conto->aggiungiTransazione("Spesa  Supermercato", -50.0, "2024-01-01");
+    conto->aggiungiTransazione(" spesa supermercato ", -30.0, "2024-01-02");
+    conto->aggiungiTransazione("SPESA SUPERMERCATO", -20.0, "2024-01-03");
+    conto->aggiungiTransazione("Stipendio", 1500.0, "2024-01-04");
+
+    vector<Aggregato> gruppi = conto->aggrega(Raggruppamento::Descrizione);
+    ASSERT_EQ(gruppi.size(), 2);
+    EXPECT_EQ(gruppi[0].chiave, "spesa supermercato");
+    EXPECT_EQ(gruppi[0].conteggio, 3);
+    EXPECT_DOUBLE_EQ(gruppi[0].somma, -100.0);
+    EXPECT_EQ(gruppi[1].chiave, "stipendio");
+}
+
+// Test filtro composto: date, importi, parola chiave e segno
+TEST_F(ContoCorrenteTest, FiltroComposto) {
+    conto->aggiungiTransazione("Bonifico stipendio", 2000.0, "2024-01-27");
+    conto->aggiungiTransazione("Bonifico affitto", -800.0, "2024-01-02");
+    conto->aggiungiTransazione("Bonifico rimborso", 50.0, "2024-02-10");
+    conto->aggiungiTransazione("Spesa", -150.0, "2024-01-15");
+    conto->aggiungiTransazione("Bonifico bonus", 300.0, "2024-01-20");
+
+    Filtro gennaio;
+    gennaio.traDate("2024-01-01", "2024-01-31");
+    EXPECT_EQ(conto->conta(gennaio), 4);
+
+    Filtro bonificiGrandi;
+    bonificiGrandi.traDate("2024-01-01", "2024-01-31").conParolaChiave("BONIFICO").importoMinimo(100);
+    vector<Transazione> risultati = conto->cerca(bonificiGrandi);
+    ASSERT_EQ(risultati.size(), 2);
+    EXPECT_EQ(risultati[0].getDescrizione(), "Bonifico stipendio");
+    EXPECT_EQ(risultati[1].getDescrizione(), "Bonifico bonus");
+
+    EXPECT_EQ(conto->conta(Filtro().soloUscite()), 2);
+    EXPECT_EQ(conto->conta(Filtro().soloEntrate().importoMassimo(300)), 2);
+    EXPECT_EQ(conto->conta(Filtro().daData("2024-01-20")), 3);
+    EXPECT_EQ(conto->conta(Filtro()), 5);
+}
+
+// Test filtro in modalità ordinata: stesso risultato della scansione completa
+TEST_F(ContoCorrenteTest, FiltroModalitaOrdinata) {
+    for (int i = 1; i <= 500; i++) {
+        int giorno = (i % 11 == 0) ? i / 3 - 20 : i / 3;
+        conto->aggiungiTransazione(i % 2 ? "Spesa" : "Entrata", i % 2 ? -i : i,
+                                   giorniInData(dataInGiorni("2024-01-01") + giorno));
+    }
+    Filtro filtro;
+    filtro.traDate("2024-02-01", "2024-03-15").conParolaChiave("spesa").importoMassimo(-100);
+    int attesi = conto->conta(filtro);
+
+    conto->setOrdinatoPerData(true);
+    conto->aggiungiTransazione("Spesa tardiva", -500.0, "2024-02-02");
+    EXPECT_EQ(conto->conta(filtro), attesi + 1);
+    EXPECT_EQ(conto->conta(Filtro().aData("2024-01-31").soloUscite()),
+              (int)conto->cercaPerIntervallo("0000-01-01", "2024-01-31").size() -
+              conto->conta(Filtro().aData("2024-01-31").soloEntrate()));
+}
+
+// Test ricerca parola chiave con lettere accentate UTF-8
+TEST_F(TransazioneTest, ContieneParolaChiaveAccentate) {
+    Transazione t("CAFFÈ e PERCHÉ al BAR DELL'UNIVERSITÀ", -2.5, "2024-01-18");
+
+    EXPECT_TRUE(t.contieneParolaChiave("caffè"));
+    EXPECT_TRUE(t.contieneParolaChiave("Perché"));
+    EXPECT_TRUE(t.contieneParolaChiave("università"));
+    EXPECT_TRUE(t.contieneParolaChiave("UNIVERSITÀ"));
+    EXPECT_FALSE(t.contieneParolaChiave("caffe"));
+    EXPECT_FALSE(t.contieneParolaChiave("perche"));
+}
+
+// Test ricerca con parola compilata confrontata con una ricerca ingenua
+TEST_F(TransazioneTest, ParolaChiaveCompilata) {
+    vector<string> testi = {"aaaaab", "abababac", "Pagamento POS Supermercato", "", "x",
+                            "bonifico BONIFICO bonifico", "ìòàùèé ÌÒÀÙÈÉ"};
+    vector<string> parole = {"ab", "aab", "bac", "pos", "MERCATO", "x", "ifico b", "ÒÀ", "àù", "zz", ""};
+    for (const string& testo : testi) {
+        string testoMinuscolo = normalizzaDescrizione(testo);
+        for (const string& parola : parole) {
+            ParolaChiave compilata(parola);
+            bool atteso = testo.empty() ? parola.empty()
+                                        : testoMinuscolo.find(normalizzaDescrizione(parola)) != string::npos;
+            EXPECT_EQ(compilata.trovaIn(testo), atteso) << testo << " / " << parola;
+        }
+    }
+}
+
+// Client di prova per il server: connessione bloccante e lettura a righe
+class ClientProva {
+private:
+    int fd;
+    string buffer;
+
+public:
+    explicit ClientProva(uint16_t porta) {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in indirizzo{};
+        indirizzo.sin_family = AF_INET;
+        indirizzo.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        indirizzo.sin_port = htons(porta);
+        connect(fd, reinterpret_cast<sockaddr*>(&indirizzo), sizeof(indirizzo));
+    }
+
+    explicit ClientProva(const string& percorso) {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un indirizzo{};
+        indirizzo.sun_family = AF_UNIX;
+        strncpy(indirizzo.sun_path, percorso.c_str(), sizeof(indirizzo.sun_path) - 1);
+        connect(fd, reinterpret_cast<sockaddr*>(&indirizzo), sizeof(indirizzo));
+    }
+
+    ~ClientProva() {
+        close(fd);
+    }
+
+    void invia(const string& testo) {
+        send(fd, testo.data(), testo.size(), MSG_NOSIGNAL);
+    }
+
+    void chiudiScrittura() {
+        shutdown(fd, SHUT_WR);
+    }
+
+    string riga() {
+        size_t fine;
+        while ((fine = buffer.find('\n')) == string::npos) {
+            char dati[4096];
+            ssize_t letti = recv(fd, dati, sizeof(dati), 0);
+            if (letti <= 0) {
+                string resto = buffer;
+                buffer.clear();
+                return resto;
+            }
+            buffer.append(dati, letti);
+        }
+        string risultato = buffer.substr(0, fine);
+        buffer.erase(0, fine + 1);
+        return risultato;
+    }
+
+    string richiesta(const string& testo) {
+        invia(testo + "\n");
+        return riga();
+    }
+};
+
+// Test esecuzione diretta dei comandi del protocollo
+TEST_F(ContoCorrenteTest, ServerEseguiComandi) {
+    ServerConto server(*conto, 2);
+
+    EXPECT_EQ(server.esegui("AGGIUNGI Stipendio;1500.00;2024-01-27"), "OK\n");
+    EXPECT_EQ(server.esegui("AGGIUNGI Affitto;-800.50;2024-01-02"), "OK\n");
+    EXPECT_EQ(server.esegui("AGGIUNGI senza campi"), "ERR formato non valido, usa descrizione;importo;data\n");
+    EXPECT_EQ(server.esegui("SALDO"), "OK 699.50\n");
+    EXPECT_EQ(server.esegui("DATA 2024-01-02"), "OK 1\nAffitto;-800.50;2024-01-02\n");
+    EXPECT_EQ(server.esegui("PAROLA stip"), "OK 1\nStipendio;1500.00;2024-01-27\n");
+    EXPECT_EQ(server.esegui("RIEPILOGO"), "OK 2 699.50 1500.00 -800.50\n");
+    EXPECT_EQ(server.esegui("BOH"), "ERR comando sconosciuto: BOH\n");
+    EXPECT_EQ(conto->getNumeroTransazioni(), 2);
+}
+
+// Test server TCP su loopback
+TEST_F(ContoCorrenteTest, ServerTcpLoopback) {
+    ServerConto server(*conto, 2);
+    uint16_t porta = server.ascoltaTcp(0);
+    ASSERT_NE(porta, 0);
+    server.avvia();
+
+    ClientProva client(porta);
+    EXPECT_EQ(client.richiesta("AGGIUNGI Spesa supermercato;-50.00;2024-01-19"), "OK");
+    EXPECT_EQ(client.richiesta("AGGIUNGI Benzina;-45.00;2024-01-20"), "OK");
+    EXPECT_EQ(client.richiesta("SALDO"), "OK -95.00");
+    EXPECT_EQ(client.richiesta("PAROLA SUPERMERCATO"), "OK 1");
+    EXPECT_EQ(client.riga(), "Spesa supermercato;-50.00;2024-01-19");
+    EXPECT_EQ(client.richiesta("DATA 2030-01-01"), "OK 0");
+
+    // Richieste in pipeline: le risposte arrivano nello stesso ordine
+    client.invia("SALDO\r\nRIEPILOGO\nBOH\n");
+    EXPECT_EQ(client.riga(), "OK -95.00");
+    EXPECT_EQ(client.riga(), "OK 2 -95.00 0.00 -95.00");
+    EXPECT_EQ(client.riga(), "ERR comando sconosciuto: BOH");
+
+    EXPECT_EQ(client.richiesta("ESCI"), "OK");
+    EXPECT_EQ(client.riga(), "");  // Connessione chiusa dal server
+
+    // Il client chiude il suo lato subito dopo le richieste: le risposte arrivano lo stesso
+    ClientProva breve(porta);
+    breve.invia("SALDO\nDATA 2024-01-20\nSALDO");
+    breve.chiudiScrittura();
+    EXPECT_EQ(breve.riga(), "OK -95.00");
+    EXPECT_EQ(breve.riga(), "OK 1");
+    EXPECT_EQ(breve.riga(), "Benzina;-45.00;2024-01-20");
+    EXPECT_EQ(breve.riga(), "OK -95.00");
+    EXPECT_EQ(breve.riga(), "");
+
+    // Richieste in pipeline oltre il limite della coda senza leggere le risposte
+    ClientProva insistente(porta);
+    string molte;
+    for (int i = 0; i < 2000; i++) {
+        molte += "SALDO\n";
+    }
+    insistente.invia(molte);
+    for (int i = 0; i < 2000; i++) {
+        ASSERT_EQ(insistente.riga(), "OK -95.00");
+    }
+    server.ferma();
+}
+
+// Test server su socket Unix con più client concorrenti
+TEST_F(ContoCorrenteTest, ServerUnixConcorrente) {
+    string percorso = "/tmp/test_conto_" + to_string(getpid()) + ".sock";
+    ServerConto server(*conto, 4);
+    server.ascoltaUnix(percorso);
+    server.avvia();
+
+    const int CLIENT = 4;
+    const int RICHIESTE = 200;
+    vector<thread> client;
+    vector<int> errori(CLIENT, 0);
+    for (int c = 0; c < CLIENT; c++) {
+        client.emplace_back([&, c] {
+            ClientProva connessione(percorso);
+            for (int i = 0; i < RICHIESTE; i++) {
+                if (connessione.richiesta("AGGIUNGI Client " + to_string(c) + ";1.00;2024-01-01") != "OK") {
+                    errori[c]++;
+                }
+                if (connessione.richiesta("SALDO").compare(0, 3, "OK ") != 0) {
+                    errori[c]++;
+                }
+            }
+        });
+    }
+    for (thread& t : client) {
+        t.join();
+    }
+    server.ferma();
+
+    for (int e : errori) {
+        EXPECT_EQ(e, 0);
+    }
+    EXPECT_EQ(conto->getNumeroTransazioni(), CLIENT * RICHIESTE);
+    EXPECT_DOUBLE_EQ(conto->calcolaSaldo(), CLIENT * RICHIESTE * 1.0);
+}
+
+// Test caricamento e salvataggio asincroni
+TEST_F(ContoCorrenteTest, CaricamentoSalvataggioAsincrono) {
+    conto->aggiungiTransazione("Test1", 100.0, "2024-01-19");
+    conto->aggiungiTransazione("Test2", -50.0, "2024-01-20");
+    conto->salvaAsync().attendi();
+
+    ContoCorrente daCaricare("test_data.txt");
+    EXPECT_EQ(daCaricare.getNumeroTransazioni(), 2);
+    EXPECT_EQ(daCaricare.caricaAsync().attendi(), 2);  // Ricarica accodando
+    EXPECT_EQ(daCaricare.getNumeroTransazioni(), 4);
+}
+
+// Coroutine di prova: salva un conto e ne ricarica il file in un altro
+static Compito<int> copiaConto(const ContoCorrente& origine, ContoCorrente& destinazione) {
+    co_await origine.salvaAsync();
+    int caricate = co_await destinazione.caricaAsync();
+    co_return caricate;
+}
+
+// Test composizione di coroutine e caricamento parallelo di più conti
+TEST_F(ContoCorrenteTest, AsincronoComposizioneEParallelo) {
+    const int CONTI = 6;
+    vector<unique_ptr<ContoCorrente>> origini;
+    vector<unique_ptr<ContoCorrente>> destinazioni;
+    for (int c = 0; c < CONTI; c++) {
+        string file = "test_async_" + to_string(c) + ".txt";
+        remove(file.c_str());
+        origini.emplace_back(new ContoCorrente(file));
+        for (int i = 0; i <= c; i++) {
+            origini.back()->aggiungiTransazione("Riga", 1.0, "2024-01-01");
+        }
+        destinazioni.emplace_back(new ContoCorrente(file));
+    }
+
+    vector<Compito<int>> compiti;
+    for (int c = 0; c < CONTI; c++) {
+        compiti.push_back(copiaConto(*origini[c], *destinazioni[c]));
+    }
+    attendiTutti(compiti);
+
+    for (int c = 0; c < CONTI; c++) {
+        EXPECT_EQ(compiti[c].risultato(), c + 1);
+        EXPECT_EQ(destinazioni[c]->getNumeroTransazioni(), c + 1);
+        remove(("test_async_" + to_string(c) + ".txt").c_str());
+        remove(("test_async_" + to_string(c) + ".txt.mesi").c_str());
+        remove(("test_async_" + to_string(c) + ".txt.blocchi").c_str());
+    }
+}
+
+// Test propagazione delle eccezioni dai lavori asincroni
+TEST_F(ContoCorrenteTest, AsincronoEccezioni) {
+    auto lavoroCheFallisce = []() -> Compito<void> {
+        co_await suPoolIO([] { throw runtime_error("errore di I/O"); });
+    };
+    EXPECT_THROW(lavoroCheFallisce().attendi(), runtime_error);
+}
+
+// Test sottoscrizione: più consumatori ricevono le nuove transazioni
+TEST_F(ContoCorrenteTest, FlussoSottoscrizioni) {
+    conto->aggiungiTransazione("Prima della sottoscrizione", 1.0, "2024-01-01");
+    Sottoscrizione primo = conto->sottoscrivi();
+    Sottoscrizione secondo = conto->sottoscrivi();
+
+    EventoTransazione evento;
+    EXPECT_FALSE(primo.prossimo(evento));
+
+    conto->aggiungiTransazione("Stipendio", 1500.0, "2024-01-27");
+    conto->aggiungiTransazione(Transazione(string(200, 'x'), -20.0, "2024-01-28"));
+
+    ASSERT_TRUE(primo.prossimo(evento));
+    EXPECT_EQ(evento.sequenza, 0);  // Il flusso nasce con la prima sottoscrizione
+    EXPECT_EQ(evento.getTransazione().getDescrizione(), "Stipendio");
+    EXPECT_DOUBLE_EQ(evento.getTransazione().getImporto(), 1500.0);
+    EXPECT_EQ(evento.getTransazione().getData(), "2024-01-27");
+    ASSERT_TRUE(primo.prossimo(evento));
+    EXPECT_TRUE(evento.isTroncata());
+    EXPECT_EQ(evento.lunghezzaDescrizione, 200);
+    EXPECT_FALSE(primo.prossimo(evento));
+
+    vector<EventoTransazione> eventi;
+    EXPECT_EQ(secondo.getRitardo(), 2);
+    EXPECT_EQ(secondo.leggi(eventi, 10), 2);
+    EXPECT_EQ(secondo.getPersi(), 0);
+    EXPECT_EQ(eventi[0].operazione, OperazioneFlusso::Inserimento);
+
+    // Modifiche ed eliminazioni portano l'identificativo della transazione
+    uint64_t id = eventi[0].id;
+    EXPECT_EQ(eventi[0].getTransazione().getId(), id);
+    ASSERT_TRUE(conto->modificaTransazione(id, "Stipendio", 1600.0, "2024-01-27"));
+    ASSERT_TRUE(conto->eliminaTransazione(id));
+    ASSERT_TRUE(primo.prossimo(evento));
+    EXPECT_EQ(evento.operazione, OperazioneFlusso::Sostituzione);
+    EXPECT_EQ(evento.id, id);
+    EXPECT_DOUBLE_EQ(evento.importo, 1600.0);
+    ASSERT_TRUE(primo.prossimo(evento));
+    EXPECT_EQ(evento.operazione, OperazioneFlusso::Eliminazione);
+    EXPECT_EQ(evento.id, id);
+    EXPECT_FALSE(primo.prossimo(evento));
+}
+
+// Test consumatore lento: il produttore non attende e gli eventi persi sono contati
+TEST_F(ContoCorrenteTest, FlussoConsumatoreLento) {
+    conto->abilitaFlusso(8);
+    Sottoscrizione lento = conto->sottoscrivi();
+    for (int i = 0; i < 20; i++) {
+        conto->aggiungiTransazione("Riga " + to_string(i), i, "2024-01-01");
+    }
+
+    vector<EventoTransazione> eventi;
+    EXPECT_EQ(lento.leggi(eventi, 100), 8);
+    EXPECT_EQ(lento.getPersi(), 12);
+    EXPECT_EQ(eventi.front().getTransazione().getDescrizione(), "Riga 12");
+    EXPECT_EQ(eventi.back().getTransazione().getDescrizione(), "Riga 19");
+}
+
+// Test consumatori concorrenti su altri thread
+TEST_F(ContoCorrenteTest, FlussoConsumatoriConcorrenti) {
+    conto->abilitaFlusso(1 << 16);
+    const int RIGHE = 20000;
+    vector<Sottoscrizione> sottoscrizioni;
+    for (int c = 0; c < 3; c++) {
+        sottoscrizioni.push_back(conto->sottoscrivi());
+    }
+
+    vector<double> somme(3, 0.0);
+    vector<thread> consumatori;
+    for (int c = 0; c < 3; c++) {
+        consumatori.emplace_back([&, c] {
+            EventoTransazione evento;
+            int letti = 0;
+            while (letti + (int)sottoscrizioni[c].getPersi() < RIGHE) {
+                if (sottoscrizioni[c].prossimo(evento)) {
+                    somme[c] += evento.importo;
+                    letti++;
+                } else {
+                    this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int i = 0; i < RIGHE; i++) {
+        conto->aggiungiTransazione("Riga", 1.0, "2024-01-01");
+    }
+    for (thread& t : consumatori) {
+        t.join();
+    }
+    for (int c = 0; c < 3; c++) {
+        EXPECT_EQ(somme[c] + sottoscrizioni[c].getPersi(), RIGHE);
+    }
+}
+
+// Test top-K di entrate e uscite, anche limitato a un intervallo di date
+TEST_F(ContoCorrenteTest, TopEntrateUscite) {
+    for (int i = 1; i <= 300; i++) {
+        string data = giorniInData(dataInGiorni("2024-01-01") + i % 60);
+        conto->aggiungiTransazione("Riga", i % 3 ? -i : i, data);
+    }
+
+    vector<Transazione> uscite = conto->topUscite(5);
+    ASSERT_EQ(uscite.size(), 5u);
+    EXPECT_DOUBLE_EQ(uscite[0].getImporto(), -299.0);
+    EXPECT_DOUBLE_EQ(uscite[4].getImporto(), -293.0);
+
+    vector<Transazione> entrate = conto->topEntrate(3, Filtro().traDate("2024-01-01", "2024-01-10"));
+    ASSERT_EQ(entrate.size(), 3u);
+    for (size_t i = 0; i < entrate.size(); i++) {
+        EXPECT_LE(entrate[i].getData(), "2024-01-10");
+        EXPECT_GT(entrate[i].getImporto(), 0.0);
+        if (i > 0) {
+            EXPECT_GE(entrate[i - 1].getImporto(), entrate[i].getImporto());
+        }
+    }
+    EXPECT_DOUBLE_EQ(entrate[0].getImporto(), 300.0);
+    EXPECT_TRUE(conto->topUscite(0).empty());
+    EXPECT_EQ(conto->topEntrate(1000).size(), 100u);
+}
+
+// Test quantili: sketch approssimato e calcolo esatto filtrato
+TEST_F(ContoCorrenteTest, QuantiliImporti) {
+    EXPECT_DOUBLE_EQ(conto->quantileImporti(0.5), 0.0);
+    const int RIGHE = 20000;
+    for (int i = 1; i <= RIGHE; i++) {
+        conto->aggiungiTransazione("Riga", (i * 7919) % RIGHE + 1, i <= 100 ? "2024-01-01" : "2024-02-01");
+    }
+
+    EXPECT_NEAR(conto->quantileImporti(0.5), RIGHE * 0.5, RIGHE * 0.02);
+    EXPECT_NEAR(conto->quantileImporti(0.99), RIGHE * 0.99, RIGHE * 0.02);
+    EXPECT_DOUBLE_EQ(conto->quantileImporti(0.0), 1.0);
+    EXPECT_DOUBLE_EQ(conto->quantileImporti(1.0), RIGHE);
+
+    vector<double> attesi;
+    for (const Transazione& t : conto->cerca(Filtro().aData("2024-01-31"))) {
+        attesi.push_back(t.getImporto());
+    }
+    sort(attesi.begin(), attesi.end());
+    EXPECT_DOUBLE_EQ(conto->quantileImporti(0.5, Filtro().aData("2024-01-31")), attesi[49]);
+    EXPECT_DOUBLE_EQ(conto->quantileImporti(1.0, Filtro().aData("2024-01-31")), attesi[99]);
+    EXPECT_DOUBLE_EQ(conto->quantileImporti(0.5, Filtro().daData("2025-01-01")), 0.0);
+
+    // Dopo un'eliminazione più lettori concorrenti ricostruiscono lo sketch
+    ASSERT_TRUE(conto->eliminaTransazione(conto->cerca(Filtro().importoMinimo(RIGHE))[0].getId()));
+    vector<double> massimi(4);
+    vector<thread> lettori;
+    for (size_t i = 0; i < massimi.size(); i++) {
+        lettori.emplace_back([&, i] { massimi[i] = conto->quantileImporti(1.0); });
+    }
+    for (thread& lettore : lettori) {
+        lettore.join();
+    }
+    for (double massimo : massimi) {
+        EXPECT_DOUBLE_EQ(massimo, RIGHE - 1);
+    }
+
+    SketchKll sketch(200);
+    for (int i = 0; i < 100000; i++) {
+        sketch.aggiungi(i);
+    }
+    EXPECT_EQ(sketch.getConteggio(), 100000u);
+    EXPECT_LT(sketch.getDimensione(), 1000u);
+    EXPECT_NEAR(sketch.quantile(0.5), 50000, 2000);
+    EXPECT_NEAR(sketch.quantile(0.9), 90000, 2000);
+}
+
+// Test deduplicazione: inserimento singolo e reimportazione di un estratto
+TEST_F(ContoCorrenteTest, DeduplicazioneImportazione) {
+    conto->aggiungiTransazione("Caffè", -1.5, "2024-01-10");
+    conto->aggiungiTransazione("Caffè", -1.5, "2024-01-10");
+    conto->setDeduplicazione(true);
+    EXPECT_TRUE(conto->isDeduplicazione());
+
+    EXPECT_FALSE(conto->aggiungiTransazione("  CAFFÈ ", -1.50, "2024-01-10"));
+    EXPECT_TRUE(conto->aggiungiTransazione("Caffè", -1.5, "2024-01-11"));
+    EXPECT_TRUE(conto->aggiungiTransazione("Caffè", -1.6, "2024-01-10"));
+    EXPECT_EQ(conto->getNumeroTransazioni(), 4);
+
+    vector<Transazione> estratto = {
+        Transazione("Caffè", -1.5, "2024-01-10"),
+        Transazione("Caffè", -1.5, "2024-01-10"),
+        Transazione("Caffè", -1.5, "2024-01-10"),
+        Transazione("Stipendio", 1500.0, "2024-01-27"),
+    };
+    RapportoImportazione rapporto = conto->importa(estratto);
+    EXPECT_EQ(rapporto.importate, 2);
+    ASSERT_EQ(rapporto.scartate.size(), 2u);
+    EXPECT_EQ(rapporto.scartate[0].getDescrizione(), "Caffè");
+
+    rapporto = conto->importa(estratto);
+    EXPECT_EQ(rapporto.importate, 0);
+    EXPECT_EQ(rapporto.scartate.size(), 4u);
+    EXPECT_EQ(conto->getNumeroTransazioni(), 6);
+}
+
+// Test importazione da file con righe non valide
+TEST_F(ContoCorrenteTest, DeduplicazioneDaFile) {
+    const string fileEstratto = "test_estratto.txt";
+    {
+        ofstream out(fileEstratto);
+        out << "Affitto;-700;2024-02-01\n";
+        out << "riga non valida\n";
+        out << "Bolletta;-80.5;2024-02-03\n";
+    }
+    conto->setDeduplicazione(true);
+    conto->aggiungiTransazione("affitto", -700.0, "2024-02-01");
+
+    RapportoImportazione rapporto = conto->importaDaFile(fileEstratto);
+    EXPECT_EQ(rapporto.importate, 1);
+    EXPECT_EQ(rapporto.scartate.size(), 1u);
+    EXPECT_EQ(rapporto.righeNonValide, 1);
+    EXPECT_THROW(conto->importaDaFile("file_inesistente.txt"), runtime_error);
+
+    conto->setDeduplicazione(false);
+    EXPECT_TRUE(conto->aggiungiTransazione("affitto", -700.0, "2024-02-01"));
+    remove(fileEstratto.c_str());
+}
+
+// Test uso della memoria e compattazione
+TEST_F(ContoCorrenteTest, UsoMemoriaECompattazione) {
+    for (int i = 0; i < 1000; i++) {
+        conto->aggiungiTransazione("Pagamento con carta presso il supermercato " + to_string(i % 10),
+                                   -(i % 50) - 0.25, giorniInData(dataInGiorni("2024-01-01") + i % 300));
+    }
+    UsoMemoria prima = conto->usoMemoria();
+    EXPECT_EQ(prima.righe, 1000 * sizeof(Transazione));
+    EXPECT_GT(prima.testo, 0u);
+    EXPECT_EQ(prima.totale, prima.righe + prima.capacitaInutilizzata + prima.testo + prima.indici);
+
+    conto->compatta();
+    UsoMemoria dopo = conto->usoMemoria();
+    EXPECT_EQ(dopo.capacitaInutilizzata, 0u);
+    EXPECT_LE(dopo.totale, prima.totale);
+    EXPECT_EQ(conto->getNumeroTransazioni(), 1000);
+
+    RegistroCompatto registro = conto->creaRegistroCompatto();
+    ASSERT_EQ(registro.getNumeroRighe(), 1000u);
+    UsoMemoria compatto = registro.usoMemoria();
+    EXPECT_EQ(compatto.righe, 1000 * 16u);
+    EXPECT_LT(compatto.totale, dopo.totale / 4);
+    EXPECT_NEAR(registro.calcolaSaldo(), conto->calcolaSaldo(), 1e-6);
+
+    Transazione t = registro.getTransazione(42);
+    EXPECT_EQ(t.getDescrizione(), conto->getTransazioni()[42].getDescrizione());
+    EXPECT_EQ(t.getData(), conto->getTransazioni()[42].getData());
+    EXPECT_DOUBLE_EQ(t.getImporto(), conto->getTransazioni()[42].getImporto());
+
+    Filtro filtro;
+    filtro.traDate("2024-02-01", "2024-03-31").conParolaChiave("supermercato 3").importoMassimo(-10);
+    int trovate = 0;
+    registro.perOgni(filtro, [&trovate](const Transazione&) { trovate++; });
+    EXPECT_EQ(trovate, conto->conta(filtro));
+    EXPECT_GT(trovate, 0);
+}
+
+// Test registro compatto: copie e compattazione non lasciano chiavi pendenti
+TEST(RegistroCompattoTest, CopiaECompattazione) {
+    RegistroCompatto copia;
+    {
+        RegistroCompatto originale;
+        originale.aggiungi(Transazione("Affitto di gennaio e febbraio", -800, "2024-01-05"));
+        originale.aggiungi(Transazione("Caffè", -1.5, "2024-01-06"));
+        copia = originale;
+        RegistroCompatto costruita(originale);
+        costruita.aggiungi(Transazione("Caffè", -1.5, "2024-01-07"));
+        EXPECT_EQ(costruita.getRiga(2).descrizione, costruita.getRiga(1).descrizione);
+    }
+    copia.compatta();
+    copia.aggiungi(Transazione("Affitto di gennaio e febbraio", -800, "2024-02-05"));
+    copia.aggiungi(Transazione("Caffè", -1.5, "2024-02-06"));
+    ASSERT_EQ(copia.getNumeroRighe(), 4u);
+    EXPECT_EQ(copia.getRiga(2).descrizione, copia.getRiga(0).descrizione);
+    EXPECT_EQ(copia.getRiga(3).descrizione, copia.getRiga(1).descrizione);
+    EXPECT_EQ(copia.getTransazione(2).getDescrizione(), "Affitto di gennaio e febbraio");
+    EXPECT_NEAR(copia.calcolaSaldo(), -1603.0, 1e-9);
+}
+
+// Test istantanee: risultati stabili mentre si aggiungono transazioni
+TEST_F(ContoCorrenteTest, IstantaneeConsistenti) {
+    conto->setOrdinatoPerData(true);
+    for (int i = 0; i < 100; i++) {
+        conto->aggiungiTransazione("Riga", 10.0, giorniInData(dataInGiorni("2024-01-01") + i));
+    }
+    Istantanea chiusura = conto->istantanea();
+    EXPECT_EQ(chiusura.getRighe(), 100u);
+    EXPECT_EQ(chiusura.getVersione(), conto->getVersione());
+
+    // Righe fuori ordine oltre la soglia: la fusione va rimandata
+    for (int i = 0; i < 200; i++) {
+        conto->aggiungiTransazione("Rettifica", -1.0, giorniInData(dataInGiorni("2024-01-01") + i % 50));
+    }
+    EXPECT_GT(conto->getVersione(), chiusura.getVersione());
+    EXPECT_DOUBLE_EQ(conto->calcolaSaldo(chiusura), 1000.0);
+    EXPECT_DOUBLE_EQ(conto->calcolaSaldoAl("2024-01-10", chiusura), 100.0);
+    EXPECT_EQ(conto->cercaPerData("2024-01-05", chiusura).size(), 1u);
+    EXPECT_EQ(conto->cercaPerIntervallo("2024-01-01", "2024-01-31", chiusura).size(), 31u);
+    EXPECT_EQ(conto->conta(Filtro().conParolaChiave("rettifica"), chiusura), 0);
+    EXPECT_EQ(conto->cercaPerParolaChiave("riga", chiusura).size(), 100u);
+    EXPECT_EQ(conto->getTransazioni(chiusura).size(), 100u);
+    EXPECT_EQ(conto->aggrega(Raggruppamento::Mese, chiusura).size(), 4u);
+    EXPECT_TRUE(conto->topUscite(3, Filtro(), chiusura).empty());
+
+    // Lo stato corrente vede tutto
+    EXPECT_DOUBLE_EQ(conto->calcolaSaldo(), 800.0);
+    EXPECT_EQ(conto->cercaPerData("2024-01-05").size(), 5u);
+
+    // Rilasciata l'istantanea, la coda viene fusa al prossimo inserimento
+    chiusura = Istantanea();
+    conto->aggiungiTransazione("Riga", 10.0, "2024-01-02");
+    vector<Transazione> tutte = conto->getTransazioni();
+    EXPECT_TRUE(is_sorted(tutte.begin(), tutte.end(),
+                          [](const Transazione& a, const Transazione& b) { return a.getData() < b.getData(); }));
+    EXPECT_DOUBLE_EQ(conto->calcolaSaldoAl("2024-01-02"), 20.0 - 8.0 + 10.0);
+
+    ContoCorrente altro("test_altro.txt");
+    EXPECT_THROW(conto->calcolaSaldo(altro.istantanea()), invalid_argument);
+    EXPECT_THROW(conto->calcolaSaldo(Istantanea()), invalid_argument);
+}
+
+// Test modalità ordinata attivata mentre un'istantanea è in uso
+TEST_F(ContoCorrenteTest, OrdinatoConIstantaneaAttiva) {
+    conto->aggiungiTransazione("B", 5.0, "2024-01-02");
+    conto->aggiungiTransazione("A", 10.0, "2024-01-01");
+    Istantanea prima = conto->istantanea();
+
+    conto->setOrdinatoPerData(true);
+    conto->aggiungiTransazione("C", 1.0, "2024-01-03");
+    conto->aggiungiTransazione("D", 2.0, "2024-01-04");
+    EXPECT_DOUBLE_EQ(conto->calcolaSaldoAl("2024-01-01"), 10.0);
+    EXPECT_DOUBLE_EQ(conto->calcolaSaldoAl("2024-01-03"), 16.0);
+    EXPECT_DOUBLE_EQ(conto->calcolaSaldo(prima), 15.0);
+
+    prima = Istantanea();
+    conto->setOrdinatoPerData(false);
+    conto->setOrdinatoPerData(true);
+    EXPECT_EQ(conto->getTransazioni().front().getDescrizione(), "A");
+    EXPECT_DOUBLE_EQ(conto->calcolaSaldoAl("2024-01-04"), 18.0);
+}
+
+// Test esportazione CSV e JSON Lines con caratteri da proteggere
+TEST_F(ContoCorrenteTest, EsportazioneCsvJson) {
+    conto->aggiungiTransazione("Cena, \"Da Mario\"", -45.5, "2024-03-01");
+    conto->aggiungiTransazione("Stipendio", 1500.0, "2024-03-27");
+    conto->aggiungiTransazione("Nota\\tab\t", -1.0, "2024-04-01");
+
+    ostringstream csv;
+    EXPECT_EQ(conto->esporta(csv, FormatoEsportazione::Csv, Filtro().aData("2024-03-31")), 2u);
+    EXPECT_EQ(csv.str(), "data,importo,descrizione\r\n"
+                         "2024-03-01,-45.50,\"Cena, \"\"Da Mario\"\"\"\r\n"
+                         "2024-03-27,1500.00,Stipendio\r\n");
+
+    ostringstream json;
+    EXPECT_EQ(conto->esporta(json, FormatoEsportazione::JsonLines, Filtro().soloUscite()), 2u);
+    EXPECT_EQ(json.str(), "{\"data\":\"2024-03-01\",\"importo\":-45.50,\"descrizione\":\"Cena, \\\"Da Mario\\\"\"}\n"
+                          "{\"data\":\"2024-04-01\",\"importo\":-1.00,\"descrizione\":\"Nota\\\\tab\\t\"}\n");
+}
+
+// Test esportazione colonnare su più lotti e rilettura
+TEST_F(ContoCorrenteTest, EsportazioneColonnare) {
+    const size_t RIGHE = Esportatore::RIGHE_PER_LOTTO * 2 + 123;
+    for (size_t i = 0; i < RIGHE; i++) {
+        conto->aggiungiTransazione("Riga " + to_string(i % 97), (i % 2 ? -1.0 : 1.0) * (i % 1000) / 4.0,
+                                   giorniInData(dataInGiorni("2023-01-01") + i % 700));
+    }
+    const string fileColonnare = "test_export.ccc";
+    EXPECT_EQ(conto->esportaSuFile(fileColonnare, FormatoEsportazione::Colonnare), RIGHE);
+
+    ifstream in(fileColonnare, ios::binary);
+    vector<Transazione> lette = Esportatore::leggiColonnare(in);
+    vector<Transazione> originali = conto->getTransazioni();
+    ASSERT_EQ(lette.size(), originali.size());
+    for (size_t i = 0; i < lette.size(); i += 777) {
+        EXPECT_EQ(lette[i].toString(), originali[i].toString());
+    }
+    EXPECT_EQ(lette.back().toString(), originali.back().toString());
+    remove(fileColonnare.c_str());
+
+    Transazione nonValida("Data errata", 1.0, "01/01/2024");
+    conto->aggiungiTransazione(nonValida);
+    ostringstream scarto(ios::binary);
+    EXPECT_THROW(conto->esporta(scarto, FormatoEsportazione::Colonnare), invalid_argument);
+}
+
+// Test automa del classificatore: corrispondenze sovrapposte, priorità e accenti
+TEST_F(TransazioneTest, ClassificatoreRegole) {
+    Classificatore regole;
+    int casa = regole.aggiungiRegola("Casa", "affitto");
+    int utenze = regole.aggiungiRegola("Utenze", "bolletta");
+    regole.aggiungiRegola("Utenze", "enel");
+    int svago = regole.aggiungiRegola("Svago", "caffè");
+    regole.aggiungiRegola("Casa", "condominio");
+    EXPECT_THROW(regole.classifica("affitto"), logic_error);
+    EXPECT_THROW(regole.aggiungiRegola("Vuota", ""), invalid_argument);
+    regole.compila();
+
+    EXPECT_EQ(regole.classifica("Pagamento AFFITTO marzo"), casa);
+    EXPECT_EQ(regole.classifica("Bolletta ENEL luce"), utenze);
+    EXPECT_EQ(regole.classifica("bolletta condominio e affitto"), casa);
+    EXPECT_EQ(regole.classifica("CAFFÈ al bar"), svago);
+    EXPECT_EQ(regole.classifica("affittx"), Classificatore::NESSUNA_CATEGORIA);
+    EXPECT_EQ(regole.classifica("aaffitto"), casa);
+    EXPECT_EQ(regole.classifica("benelux"), utenze);
+    EXPECT_EQ(regole.classifica(""), Classificatore::NESSUNA_CATEGORIA);
+    EXPECT_EQ(regole.getNomeCategoria(svago), "Svago");
+    EXPECT_EQ(regole.getNomeCategoria(Classificatore::NESSUNA_CATEGORIA), "");
+    EXPECT_EQ(regole.cercaCategoria("Utenze"), utenze);
+
+    // Stesso risultato di contieneParolaChiave regola per regola
+    vector<string> descrizioni = {"Affitto", "condominio via Roma", "Bar caffè", "Spesa", "SERENELLA"};
+    for (const string& d : descrizioni) {
+        Transazione t(d, 1.0, "2024-01-01");
+        bool attesa = t.contieneParolaChiave("affitto") || t.contieneParolaChiave("bolletta") ||
+                      t.contieneParolaChiave("enel") || t.contieneParolaChiave("caffè") ||
+                      t.contieneParolaChiave("condominio");
+        EXPECT_EQ(regole.classifica(d) != Classificatore::NESSUNA_CATEGORIA, attesa) << d;
+    }
+}
+
+// Test categorie memorizzate nelle righe e totali per categoria
+TEST_F(ContoCorrenteTest, AggregazionePerCategoria) {
+    conto->aggiungiTransazione("Affitto gennaio", -700.0, "2024-01-01");
+    conto->aggiungiTransazione("Bolletta gas", -80.0, "2024-01-05");
+    conto->aggiungiTransazione("Stipendio", 1500.0, "2024-01-27");
+
+    Classificatore regole;
+    regole.aggiungiRegola("Casa", "affitto");
+    regole.aggiungiRegola("Utenze", "bolletta");
+    regole.aggiungiRegola("Entrate", "stipendio");
+    conto->setClassificatore(regole);
+    conto->aggiungiTransazione("Affitto febbraio", -700.0, "2024-02-01");
+    conto->aggiungiTransazione("Regalo", 50.0, "2024-02-10");
+
+    vector<Transazione> righe = conto->getTransazioni();
+    EXPECT_EQ(conto->getClassificatore()->getNomeCategoria(righe[0].getCategoria()), "Casa");
+    EXPECT_EQ(righe[3].getCategoria(), righe[0].getCategoria());
+    EXPECT_EQ(righe[4].getCategoria(), Classificatore::NESSUNA_CATEGORIA);
+
+    vector<Aggregato> categorie = conto->aggregaPerCategoria();
+    ASSERT_EQ(categorie.size(), 4u);
+    EXPECT_EQ(categorie[0].chiave, "");
+    EXPECT_EQ(categorie[1].chiave, "Casa");
+    EXPECT_EQ(categorie[1].conteggio, 2);
+    EXPECT_DOUBLE_EQ(categorie[1].somma, -1400.0);
+    EXPECT_EQ(categorie[3].chiave, "Utenze");
+    EXPECT_DOUBLE_EQ(categorie[3].uscite, -80.0);
+
+    conto->compatta();
+    EXPECT_EQ(conto->getTransazioni()[0].getCategoria(), righe[0].getCategoria());
+}
+
+// Test riepiloghi mensili: aggiornamento incrementale e confronto con l'aggregazione
+TEST_F(ContoCorrenteTest, RiepiloghiMensili) {
+    conto->aggiungiTransazione("Stipendio", 2000.0, "2024-01-27");
+    conto->aggiungiTransazione("Affitto", -700.0, "2024-01-02");
+    conto->aggiungiTransazione("Spesa", -45.3, "2024-02-10");
+    conto->aggiungiTransazione("Rimborso", 12.1, "2023-12-30");
+
+    vector<Aggregato> mesi = conto->riepiloghiMensili();
+    vector<Aggregato> attesi = conto->aggrega(Raggruppamento::Mese);
+    ASSERT_EQ(mesi.size(), 3u);
+    ASSERT_EQ(mesi.size(), attesi.size());
+    for (size_t i = 0; i < mesi.size(); i++) {
+        EXPECT_EQ(mesi[i].chiave, attesi[i].chiave);
+        EXPECT_NEAR(mesi[i].somma, attesi[i].somma, 1e-9);
+        EXPECT_NEAR(mesi[i].entrate, attesi[i].entrate, 1e-9);
+        EXPECT_NEAR(mesi[i].uscite, attesi[i].uscite, 1e-9);
+        EXPECT_EQ(mesi[i].conteggio, attesi[i].conteggio);
+    }
+
+    Aggregato periodo = conto->riepilogoPeriodo("2024-01", "2024-12");
+    EXPECT_EQ(periodo.conteggio, 3);
+    EXPECT_NEAR(periodo.somma, 1254.7, 1e-9);
+    EXPECT_EQ(conto->riepilogoPeriodo("2025-01", "2025-12").conteggio, 0);
+}
+
+// Test riepiloghi mensili salvati accanto al file e ricalcolati se non aggiornati
+TEST_F(ContoCorrenteTest, RiepiloghiMensiliPersistenti) {
+    conto->aggiungiTransazione("Stipendio", 2000.0, "2024-01-27");
+    conto->aggiungiTransazione("Spesa", -45.3, "2024-02-10");
+    conto->salvaSuFile();
+    {
+        ifstream riepiloghi("test_data.txt.mesi");
+        ASSERT_TRUE(riepiloghi.is_open());
+        string intestazione;
+        getline(riepiloghi, intestazione);
+        EXPECT_EQ(intestazione.rfind("#riepiloghi;2;195470;", 0), 0u);
+    }
+
+    ContoCorrente ricaricato("test_data.txt");
+    ASSERT_EQ(ricaricato.riepiloghiMensili().size(), 2u);
+    EXPECT_NEAR(ricaricato.riepiloghiMensili()[1].uscite, -45.3, 1e-9);
+
+    // Una riga aggiunta al file senza aggiornare i riepiloghi li rende non validi
+    {
+        ofstream dati("test_data.txt", ios::app);
+        dati << "Bonifico;100;2024-03-01\n";
+    }
+    ContoCorrente modificato("test_data.txt");
+    vector<Aggregato> mesi = modificato.riepiloghiMensili();
+    ASSERT_EQ(mesi.size(), 3u);
+    EXPECT_EQ(mesi[2].chiave, "2024-03");
+    EXPECT_NEAR(mesi[2].somma, 100.0, 1e-9);
+
+    // Una data cambiata a mano lascia uguali righe e somma, non l'impronta
+    modificato.salvaSuFile();
+    {
+        ifstream in("test_data.txt");
+        stringstream contenuto;
+        contenuto << in.rdbuf();
+        in.close();
+        string testo = contenuto.str();
+        size_t pos = testo.find("2024-03-01");
+        ASSERT_NE(pos, string::npos);
+        testo.replace(pos, 10, "2024-04-01");
+        ofstream("test_data.txt") << testo;
+    }
+    ContoCorrente spostato("test_data.txt");
+    mesi = spostato.riepiloghiMensili();
+    ASSERT_EQ(mesi.size(), 3u);
+    EXPECT_EQ(mesi[2].chiave, "2024-04");
+}
+
+// Test filtri di Bloom per blocchi: nessun falso negativo, anche dopo il salvataggio
+TEST_F(ContoCorrenteTest, FiltriBloomBlocchi) {
+    FiltroBloom filtro(1000);
+    for (uint64_t k = 0; k < 1000; k++) {
+        filtro.aggiungi(k * 7919);
+    }
+    int falsiPositivi = 0;
+    for (uint64_t k = 0; k < 1000; k++) {
+        EXPECT_TRUE(filtro.puoContenere(k * 7919));
+        falsiPositivi += filtro.puoContenere(k * 7919 + 1);
+    }
+    EXPECT_LT(falsiPositivi, 50);
+
+    const size_t RIGHE = IndiceBlocchi::RIGHE_PER_BLOCCO * 3 + 10;
+    size_t attese = 0;
+    for (size_t i = 0; i < RIGHE; i++) {
+        attese += i % 50 == 49;
+        string data = giorniInData(19000 + static_cast<int>(i / 100));
+        string descrizione = i == 5000 ? "Rimborso Assicurazione" : "Spesa " + to_string(i % 50);
+        conto->aggiungiTransazione(descrizione, -1.0, data);
+    }
+    EXPECT_EQ(conto->cercaPerData(giorniInData(19000 + 50)).size(), 100u);
+    EXPECT_TRUE(conto->cercaPerData("1999-01-01").empty());
+    ASSERT_EQ(conto->cercaPerParolaChiave("ASSICURAZ").size(), 1u);
+    EXPECT_TRUE(conto->cercaPerParolaChiave("bonifico").empty());
+    EXPECT_EQ(conto->cercaPerParolaChiave("sa 49").size(), attese);
+
+    conto->salvaSuFile();
+    ContoCorrente ricaricato("test_data.txt");
+    EXPECT_EQ(ricaricato.cercaPerParolaChiave("assicurazione").size(), 1u);
+    EXPECT_EQ(ricaricato.cercaPerData(giorniInData(19000 + 120)).size(), 100u);
+
+    // La modalità ordinata sposta le righe: i filtri vengono ricostruiti
+    ricaricato.aggiungiTransazione("Assicurazione auto", -300.0, "2020-01-01");
+    ricaricato.setOrdinatoPerData(true);
+    EXPECT_EQ(ricaricato.cercaPerParolaChiave("assicurazione").size(), 2u);
+    EXPECT_EQ(ricaricato.cercaPerData("2020-01-01").size(), 1u);
+}
+
+// Test modifica ed eliminazione con lapidi e istantanee
+TEST_F(ContoCorrenteTest, ModificaEliminazione) {
+    conto->aggiungiTransazione("Stipendio", 2000.0, "2024-01-27");
+    conto->aggiungiTransazione("Affitto", -700.0, "2024-01-02");
+    conto->aggiungiTransazione("Spesa", -45.0, "2024-02-10");
+    vector<Transazione> righe = conto->getTransazioni();
+    ASSERT_EQ(righe.size(), 3u);
+    EXPECT_NE(righe[0].getId(), righe[1].getId());
+    uint64_t idAffitto = righe[1].getId();
+    uint64_t idSpesa = righe[2].getId();
+
+    Istantanea prima = conto->istantanea();
+    EXPECT_TRUE(conto->modificaTransazione(idAffitto, "Affitto", -750.0, "2024-01-03"));
+    EXPECT_TRUE(conto->eliminaTransazione(idSpesa));
+    EXPECT_FALSE(conto->eliminaTransazione(idSpesa));
+    EXPECT_FALSE(conto->modificaTransazione(9999, "X", 1.0, "2024-01-01"));
+
+    EXPECT_EQ(conto->getNumeroTransazioni(), 2);
+    EXPECT_EQ(conto->getRigheEliminate(), 2u);
+    EXPECT_DOUBLE_EQ(conto->calcolaSaldo(), 1250.0);
+    EXPECT_TRUE(conto->cercaPerData("2024-01-02").empty());
+    ASSERT_EQ(conto->cercaPerParolaChiave("affitto").size(), 1u);
+    EXPECT_EQ(conto->cercaPerParolaChiave("affitto")[0].getId(), idAffitto);
+    EXPECT_EQ(conto->riepiloghiMensili().size(), 1u);
+    EXPECT_EQ(conto->aggrega(Raggruppamento::Mese).size(), 1u);
+
+    // L'istantanea precedente vede ancora le versioni originali
+    EXPECT_DOUBLE_EQ(conto->calcolaSaldo(prima), 1255.0);
+    EXPECT_EQ(conto->getTransazioni(prima).size(), 3u);
+    EXPECT_EQ(conto->cercaPerData("2024-01-02", prima).size(), 1u);
+    vector<Aggregato> mesiPrima = conto->aggrega(Raggruppamento::Mese, prima);
+    ASSERT_EQ(mesiPrima.size(), 2u);
+    EXPECT_EQ(mesiPrima[0].conteggio + mesiPrima[1].conteggio, 3);
+    EXPECT_DOUBLE_EQ(mesiPrima[0].somma + mesiPrima[1].somma, 1255.0);
+    conto->compatta();
+    EXPECT_EQ(conto->getRigheEliminate(), 2u);
+
+    prima = Istantanea();
+    conto->compatta();
+    EXPECT_EQ(conto->getRigheEliminate(), 0u);
+    EXPECT_EQ(conto->getNumeroTransazioni(), 2);
+    EXPECT_TRUE(conto->modificaTransazione(idAffitto, "Affitto", -800.0, "2024-01-03"));
+
+    conto->salvaSuFile();
+    ContoCorrente ricaricato("test_data.txt");
+    EXPECT_EQ(ricaricato.getNumeroTransazioni(), 2);
+    EXPECT_DOUBLE_EQ(ricaricato.calcolaSaldo(), 1200.0);
+
+    // Lo sketch dei quantili non conta le righe eliminate
+    EXPECT_DOUBLE_EQ(conto->quantileImporti(1.0), 2000.0);
+    EXPECT_TRUE(conto->eliminaTransazione(righe[0].getId()));
+    EXPECT_DOUBLE_EQ(conto->quantileImporti(1.0), 800.0);
+}
+
+// Test eliminazioni in modalità ordinata e compattazione automatica e asincrona
+TEST_F(ContoCorrenteTest, EliminazioneModalitaOrdinata) {
+    conto->setOrdinatoPerData(true);
+    for (int i = 0; i < 4000; i++) {
+        conto->aggiungiTransazione("Riga " + to_string(i), 1.0, giorniInData(19000 + i / 10));
+    }
+    vector<Transazione> righe = conto->getTransazioni();
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(conto->eliminaTransazione(righe[i * 2].getId()));
+    }
+    EXPECT_EQ(conto->getRigheEliminate(), 1000u);
+    EXPECT_DOUBLE_EQ(conto->calcolaSaldo(), 3000.0);
+    EXPECT_DOUBLE_EQ(conto->calcolaSaldoAl(giorniInData(19000 + 9)), 50.0);
+
+    // La milleventiquattresima lapide supera un quarto delle righe e attiva la compattazione
+    for (int i = 1000; i < 1024; i++) {
+        conto->eliminaTransazione(righe[i * 2].getId());
+    }
+    EXPECT_EQ(conto->getRigheEliminate(), 0u);
+    EXPECT_EQ(conto->getNumeroTransazioni(), 4000 - 1024);
+    EXPECT_DOUBLE_EQ(conto->calcolaSaldoAl(giorniInData(19000 + 9)), 50.0);
+    EXPECT_EQ(conto->cercaPerIntervallo(giorniInData(19000), giorniInData(19000 + 399)).size(), 4000u - 1024);
+
+    conto->eliminaTransazione(righe[3999].getId());
+    EXPECT_EQ(conto->compattaAsync().attendi(), 1u);
+    ContoCorrente ricaricato("test_data.txt");
+    EXPECT_EQ(ricaricato.getNumeroTransazioni(), 4000 - 1025);
+}
+
+// Test identificativi stabili: persistenza in entrambi i formati e ricerca diretta
+TEST_F(ContoCorrenteTest, IdentificativiStabili) {
+    conto->aggiungiTransazione("Affitto", -700.0, "2024-01-02");
+    conto->aggiungiTransazione("Spesa", -45.0, "2024-02-10");
+    conto->aggiungiTransazione("Stipendio", 2000.0, "2024-01-27");
+    vector<Transazione> righe = conto->getTransazioni();
+    EXPECT_TRUE(conto->eliminaTransazione(righe[0].getId()));
+    EXPECT_FALSE(conto->trova(righe[0].getId()).has_value());
+    EXPECT_FALSE(conto->trova(0).has_value());
+    ASSERT_TRUE(conto->trova(righe[2].getId()).has_value());
+    EXPECT_EQ(conto->trova(righe[2].getId())->getDescrizione(), "Stipendio");
+
+    for (FormatoFile formato : {FormatoFile::Testo, FormatoFile::Compresso}) {
+        conto->setFormatoFile(formato);
+        conto->salvaSuFile();
+        ContoCorrente ricaricato("test_data.txt");
+        ASSERT_TRUE(ricaricato.trova(righe[1].getId()).has_value());
+        EXPECT_EQ(ricaricato.trova(righe[1].getId())->getDescrizione(), "Spesa");
+        EXPECT_FALSE(ricaricato.trova(righe[0].getId()).has_value());
+        // Il nuovo identificativo non riusa quelli già salvati
+        ricaricato.aggiungiTransazione("Bolletta", -60.0, "2024-02-15");
+        EXPECT_GT(ricaricato.getTransazioni().back().getId(), righe[2].getId());
+    }
+
+    // I file senza identificativi ricevono identificativi nuovi e distinti
+    {
+        ofstream file("test_data.txt");
+        file << "Affitto;-700.00;2024-01-02\nSpesa;-45.00;2024-02-10\n";
+    }
+    ContoCorrente precedente("test_data.txt");
+    vector<Transazione> lette = precedente.getTransazioni();
+    ASSERT_EQ(lette.size(), 2u);
+    EXPECT_NE(lette[0].getId(), 0u);
+    EXPECT_NE(lette[0].getId(), lette[1].getId());
+    EXPECT_EQ(precedente.trova(lette[1].getId())->getDescrizione(), "Spesa");
+}
+
+// Test ricerca per identificativo dopo fusioni e compattazioni della modalità ordinata
+TEST_F(ContoCorrenteTest, TrovaDopoFusioniECompattazione) {
+    conto->setOrdinatoPerData(true);
+    for (int i = 0; i < 3000; i++) {
+        // Una riga su tre arriva in ritardo e finisce nella coda da fondere
+        int giorno = i % 3 == 0 ? i / 2 : i;
+        conto->aggiungiTransazione("Riga " + to_string(i), i, giorniInData(19000 + giorno));
+    }
+    for (uint64_t id = 1; id <= 3000; id += 2) {
+        conto->eliminaTransazione(id);
+    }
+    // Almeno una compattazione automatica ha spostato le righe
+    EXPECT_LT(conto->getRigheEliminate(), 1500u);
+    for (uint64_t id = 1; id <= 3000; id++) {
+        optional<Transazione> t = conto->trova(id);
+        ASSERT_EQ(t.has_value(), id % 2 == 0);
+        if (t) {
+            EXPECT_EQ(t->getDescrizione(), "Riga " + to_string(id - 1));
+        }
+    }
+}
+
+// Test generatore di carico: ripetibilità, pagamenti ricorrenti e popolarità di Zipf
+TEST(GeneratoreCaricoTest, DistribuzioniERicorrenti) {
+    ParametriGeneratore parametri;
+    parametri.righePerGiorno = 20.0;
+    parametri.vocabolario = 500;
+    GeneratoreTransazioni a(parametri), b(parametri);
+    vector<Transazione> righe = a.genera(20000);
+    vector<Transazione> ripetute = b.genera(20000);
+    ASSERT_EQ(righe.size(), ripetute.size());
+    EXPECT_EQ(righe[19999].toString(), ripetute[19999].toString());
+
+    map<string, int> stipendiPerMese;
+    map<string, int> frequenze;
+    for (const Transazione& t : righe) {
+        EXPECT_GE(t.getData(), giorniInData(dataInGiorni("2021-01-01") - parametri.ritardoMassimo));
+        EXPECT_LE(t.getData(), a.getDataCorrente());
+        EXPECT_NE(t.getImporto(), 0.0);
+        if (t.getDescrizione() == "Stipendio") {
+            EXPECT_EQ(t.getData().substr(8), "27");
+            stipendiPerMese[t.getData().substr(0, 7)]++;
+        } else {
+            frequenze[t.getDescrizione()]++;
+        }
+    }
+    // Circa 1000 giorni: uno stipendio per ogni mese intero
+    EXPECT_GE(stipendiPerMese.size(), 30u);
+    for (const auto& [mese, conteggio] : stipendiPerMese) {
+        EXPECT_EQ(conteggio, 1) << mese;
+    }
+    // La descrizione più popolare compare molto più spesso della centesima
+    const vector<string>& vocabolario = a.getVocabolario();
+    EXPECT_GT(frequenze[vocabolario[0]], 10 * frequenze[vocabolario[99]]);
+    EXPECT_LE(frequenze.size(), 500u + parametri.ricorrenti.size());
+
+    parametri.vocabolario = 0;
+    EXPECT_THROW(GeneratoreTransazioni{parametri}, invalid_argument);
+}
+
+// Test registro in memoria condivisa: lettori senza caricamento, anche in un altro processo
+TEST_F(ContoCorrenteTest, RegistroCondiviso) {
+    string nome = "/conto_test_" + to_string(getpid());
+    conto->aggiungiTransazione("Stipendio", 2000.0, "2024-01-27");
+    conto->aggiungiTransazione("Affitto", -700.0, "2024-01-02");
+    conto->abilitaCondivisione(nome, 8);
+    LettoreCondiviso lettore(nome);
+    EXPECT_TRUE(lettore.isAttivo());
+    EXPECT_EQ(lettore.getNumeroTransazioni(), 2);
+    EXPECT_DOUBLE_EQ(lettore.calcolaSaldo(), 1300.0);
+
+    // Le modifiche successive sono visibili senza ricollegarsi
+    conto->aggiungiTransazione("Spesa supermercato", -45.5, "2024-02-10");
+    uint64_t idAffitto = conto->cercaPerParolaChiave("affitto")[0].getId();
+    conto->modificaTransazione(idAffitto, "Affitto", -750.0, "2024-01-03");
+    EXPECT_EQ(lettore.getNumeroTransazioni(), 3);
+    EXPECT_DOUBLE_EQ(lettore.calcolaSaldo(), conto->calcolaSaldo());
+    ASSERT_EQ(lettore.cercaPerParolaChiave("AFFITTO").size(), 1u);
+    EXPECT_DOUBLE_EQ(lettore.cercaPerParolaChiave("AFFITTO")[0].getImporto(), -750.0);
+    EXPECT_EQ(lettore.cercaPerParolaChiave("AFFITTO")[0].getId(), idAffitto);
+    EXPECT_TRUE(lettore.cercaPerData("2024-01-02").empty());
+    EXPECT_EQ(lettore.cercaPerData("2024-02-10").size(), 1u);
+    EXPECT_EQ(lettore.getTransazioni().size(), 3u);
+
+    // Il conto non si copia (condividerebbe il segmento), ma si sposta con esso
+    static_assert(!is_copy_constructible_v<ContoCorrente> && !is_copy_assignable_v<ContoCorrente>);
+    static_assert(is_move_constructible_v<ContoCorrente> && is_move_assignable_v<ContoCorrente>);
+    ContoCorrente spostato = move(*conto);
+    spostato.aggiungiTransazione("Bonifico", 0.5, "2024-02-11");
+    spostato.eliminaTransazione(spostato.cercaPerData("2024-02-11")[0].getId());
+    *conto = move(spostato);
+    EXPECT_EQ(lettore.getNumeroTransazioni(), 3);
+    EXPECT_DOUBLE_EQ(lettore.calcolaSaldo(), conto->calcolaSaldo());
+
+    pid_t figlio = fork();
+    if (figlio == 0) {
+        LettoreCondiviso altro(nome);
+        bool corretto = altro.getNumeroTransazioni() == 3 && altro.calcolaSaldo() == 1204.5 &&
+                        altro.cercaPerParolaChiave("spesa").size() == 1;
+        _exit(corretto ? 0 : 1);
+    }
+    int stato = 0;
+    waitpid(figlio, &stato, 0);
+    EXPECT_TRUE(WIFEXITED(stato) && WEXITSTATUS(stato) == 0);
+
+    // Con il segmento pieno la pubblicazione si interrompe, il conto no
+    for (int i = 0; i < 5; i++) {
+        conto->aggiungiTransazione("Extra", -1.0, "2024-03-01");
+    }
+    EXPECT_FALSE(lettore.isAttivo());
+    EXPECT_EQ(conto->getNumeroTransazioni(), 8);
+    EXPECT_THROW(LettoreCondiviso{nome}, runtime_error);
+    EXPECT_THROW(conto->abilitaCondivisione("senza_barra", 8), invalid_argument);
+
+    // Una data non rappresentabile interrompe la pubblicazione senza eccezioni
+    conto->abilitaCondivisione(nome, 64);
+    LettoreCondiviso ultimo(nome);
+    EXPECT_NO_THROW(conto->aggiungiTransazione("Data errata", 1.0, "01/02/2024"));
+    EXPECT_EQ(conto->getNumeroTransazioni(), 9);
+    EXPECT_FALSE(ultimo.isAttivo());
+    EXPECT_EQ(ultimo.getNumeroTransazioni(), 8);
+}
+
+// Test riconciliazione con un estratto: identiche, simili, discordanti e mancanti
+TEST_F(ContoCorrenteTest, RiconciliazioneEstratto) {
+    conto->aggiungiTransazione("Stipendio", 2000.0, "2024-01-27");
+    conto->aggiungiTransazione("Affitto gennaio", -700.0, "2024-01-02");
+    conto->aggiungiTransazione("Bolletta luce", -60.0, "2024-01-15");
+    conto->aggiungiTransazione("Spesa supermercato", -45.5, "2024-01-10");
+    conto->aggiungiTransazione("Cena", -30.0, "2024-01-20");
+    conto->aggiungiTransazione("Cena", -30.0, "2024-01-20");
+
+    ContoCorrente estratto("test_estratto.txt");
+    estratto.aggiungiTransazione("STIPENDIO", 2000.0, "2024-01-27");                 // identica a meno delle maiuscole
+    estratto.aggiungiTransazione("Addebito affitto gennaio", -700.0, "2024-01-03");   // simile, un giorno dopo
+    estratto.aggiungiTransazione("Bolletta luce", -62.0, "2024-01-16");              // importo diverso
+    estratto.aggiungiTransazione("Cena", -30.0, "2024-01-20");
+    estratto.aggiungiTransazione("Commissioni", -2.0, "2024-01-31");                 // solo nell'estratto
+    estratto.aggiungiTransazione("Spesa supermercato", -45.5, "2024-01-20");         // fuori finestra
+
+    RapportoRiconciliazione rapporto = conto->riconciliaCon(estratto);
+    ASSERT_EQ(rapporto.abbinate.size(), 3u);
+    EXPECT_EQ(rapporto.abbinate[0].estratto.getDescrizione(), "STIPENDIO");
+    EXPECT_EQ(rapporto.abbinate[1].estratto.getDescrizione(), "Addebito affitto gennaio");
+    EXPECT_EQ(rapporto.abbinate[1].differenzaGiorni, 1);
+    EXPECT_GE(rapporto.abbinate[1].similarita, 0.5);
+    EXPECT_LT(rapporto.abbinate[1].similarita, 1.0);
+    EXPECT_EQ(rapporto.abbinate[2].conto.getDescrizione(), "Cena");
+    ASSERT_EQ(rapporto.discordanti.size(), 1u);
+    EXPECT_DOUBLE_EQ(rapporto.discordanti[0].estratto.getImporto(), -62.0);
+    EXPECT_EQ(rapporto.discordanti[0].differenzaGiorni, 1);
+    ASSERT_EQ(rapporto.mancantiNellEstratto.size(), 2u);
+    EXPECT_EQ(rapporto.mancantiNellEstratto[0].getDescrizione(), "Spesa supermercato");
+    EXPECT_EQ(rapporto.mancantiNellEstratto[1].getDescrizione(), "Cena");
+    ASSERT_EQ(rapporto.mancantiNelConto.size(), 2u);
+    EXPECT_EQ(rapporto.mancantiNelConto[0].getDescrizione(), "Commissioni");
+
+    // Con una finestra più ampia la spesa registrata in ritardo diventa un abbinamento
+    OpzioniRiconciliazione ampia;
+    ampia.finestraGiorni = 10;
+    ampia.partizioni = 3;
+    rapporto = conto->riconciliaCon(estratto, ampia);
+    EXPECT_EQ(rapporto.abbinate.size(), 4u);
+    EXPECT_EQ(rapporto.mancantiNellEstratto.size(), 1u);
+    EXPECT_EQ(rapporto.mancantiNelConto.size(), 1u);
+
+    // Le righe eliminate dell'estratto non partecipano
+    ASSERT_TRUE(estratto.eliminaTransazione(estratto.cercaPerParolaChiave("commissioni")[0].getId()));
+    rapporto = conto->riconciliaCon(estratto, ampia);
+    EXPECT_EQ(rapporto.abbinate.size(), 4u);
+    EXPECT_TRUE(rapporto.mancantiNelConto.empty());
+    remove("test_estratto.txt");
+
+    EXPECT_DOUBLE_EQ(similaritaDescrizioni("Bonifico  AFFITTO", "bonifico affitto"), 1.0);
+    EXPECT_DOUBLE_EQ(similaritaDescrizioni("abc", "xyz"), 0.0);
+}
+
+// Test ricerca tollerante agli errori di battitura
+TEST_F(ContoCorrenteTest, RicercaApprossimata) {
+    conto->aggiungiTransazione("Amazon Marketplace", -25.0, "2024-01-05");
+    conto->aggiungiTransazione("AMAZON marketplace", -12.0, "2024-01-09");
+    conto->aggiungiTransazione("Amazon Prime", -4.99, "2024-01-10");
+    conto->aggiungiTransazione("Bolletta Enel", -60.0, "2024-01-15");
+    conto->aggiungiTransazione("Enel energia", -55.0, "2024-02-15");
+    conto->aggiungiTransazione("Panetteria", -3.0, "2024-01-16");
+
+    // Senza indice la ricerca non è disponibile
+    EXPECT_THROW(conto->cercaApprossimata("amazn"), runtime_error);
+    conto->setRicercaApprossimata(true);
+    EXPECT_TRUE(conto->isRicercaApprossimata());
+    vector<RisultatoApprossimato> risultati = conto->cercaApprossimata("amazn");
+    ASSERT_EQ(risultati.size(), 2u);
+    EXPECT_EQ(risultati[0].descrizione, "Amazon Marketplace");
+    EXPECT_EQ(risultati[0].distanza, 1);
+    EXPECT_EQ(risultati[0].transazioni.size(), 2u);
+    EXPECT_EQ(risultati[1].descrizione, "Amazon Prime");
+
+    risultati = conto->cercaApprossimata("eneI");
+    ASSERT_EQ(risultati.size(), 2u);
+    EXPECT_EQ(risultati[0].distanza, 1);
+
+    // Più parole: tutte devono corrispondere
+    risultati = conto->cercaApprossimata("boleta eneI");
+    ASSERT_EQ(risultati.size(), 1u);
+    EXPECT_EQ(risultati[0].descrizione, "Bolletta Enel");
+    EXPECT_EQ(risultati[0].distanza, 3);
+    EXPECT_TRUE(conto->cercaApprossimata("amazn", 10, 0).empty());
+    EXPECT_EQ(conto->cercaApprossimata("amazn", 1).size(), 1u);
+
+    // L'indice segue inserimenti, modifiche ed eliminazioni
+    uint64_t idPrime = conto->cercaApprossimata("prime")[0].transazioni[0].getId();
+    conto->modificaTransazione(idPrime, "Amazon Music", -9.99, "2024-01-10");
+    conto->aggiungiTransazione("Panetteria Rossi", -2.5, "2024-02-01");
+    risultati = conto->cercaApprossimata("amazon");
+    ASSERT_EQ(risultati.size(), 2u);
+    EXPECT_EQ(risultati[1].descrizione, "Amazon Music");
+    EXPECT_TRUE(conto->cercaApprossimata("prime").empty());
+    conto->eliminaTransazione(conto->cercaApprossimata("enel energia")[0].transazioni[0].getId());
+    EXPECT_EQ(conto->cercaApprossimata("enel").size(), 1u);
+    EXPECT_EQ(conto->cercaApprossimata("panettera").size(), 2u);
+
+    EXPECT_EQ(IndiceApprossimato::distanzaModifica("kitten", "sitting", 5), 3);
+    EXPECT_EQ(IndiceApprossimato::distanzaModifica("kitten", "sitting", 1), 2);
+}
+
+// Test tracciati record generati a tempo di compilazione
+TEST_F(TransazioneTest, TracciatiRecord) {
+    Transazione t("Caffè", -1.2, "2024-03-01");
+    t.setId(42);
+    t.setCategoria(3);
+    EXPECT_EQ(TracciatoClassico::formatta(t), "Caffè;-1.20;2024-03-01");
+    EXPECT_EQ(TracciatoClassico::formatta(t), t.toString());
+    EXPECT_EQ(TracciatoFile::formatta(t), "Caffè;-1.20;2024-03-01;42");
+
+    string riga = TracciatoEsteso::formatta(t);
+    EXPECT_EQ(riga, "42;Caffè;-1.20;EUR;2024-03-01;3");
+    Transazione letta = TracciatoEsteso::analizza(riga);
+    EXPECT_EQ(letta.getId(), 42u);
+    EXPECT_EQ(letta.getDescrizione(), "Caffè");
+    EXPECT_DOUBLE_EQ(letta.getImporto(), -1.2);
+    EXPECT_EQ(letta.getData(), "2024-03-01");
+    EXPECT_EQ(letta.getCategoria(), 3);
+
+    // Valuta diversa, campi mancanti o non numerici
+    Transazione scarto;
+    EXPECT_FALSE(TracciatoEsteso::leggi("42;Caffè;-1.20;USD;2024-03-01;3", scarto));
+    EXPECT_FALSE(TracciatoEsteso::leggi("42;Caffè;-1.20;EUR;2024-03-01", scarto));
+    EXPECT_FALSE(TracciatoClassico::leggi("Caffè;1,20;2024-03-01", scarto));
+    EXPECT_THROW(Transazione::fromString("Caffè;-1.20"), invalid_argument);
+    EXPECT_THROW(Transazione::fromString("Caffè;-1.20;2024-03-01;x"), invalid_argument);
+
+    // Il tracciato del file accetta l'identificativo facoltativo e un '+' iniziale
+    EXPECT_EQ(Transazione::fromString("Rimborso;+5;2024-03-02").getId(), 0u);
+    EXPECT_DOUBLE_EQ(Transazione::fromString("Rimborso;+5;2024-03-02").getImporto(), 5.0);
+    EXPECT_EQ(Transazione::fromString("Rimborso;5;2024-03-02;7").getId(), 7u);
+    EXPECT_EQ(Transazione::fromString("Rimborso;5;2024-03-02;").getId(), 0u);
+
+    // Come con stod, gli spazi attorno all'importo di un file scritto a mano sono ammessi
+    EXPECT_DOUBLE_EQ(Transazione::fromString("desc; -12.50;2024-01-01").getImporto(), -12.5);
+    EXPECT_DOUBLE_EQ(Transazione::fromString("desc;\t+3 ;2024-01-01").getImporto(), 3.0);
+    EXPECT_THROW(Transazione::fromString("desc;  ;2024-01-01"), invalid_argument);
+    EXPECT_THROW(Transazione::fromString("desc;- 12.50;2024-01-01"), invalid_argument);
+}
+
+// Test punti di controllo nel file dei dati e verifica per tratti
+TEST_F(ContoCorrenteTest, PuntiDiControllo) {
+    // A metà centesimo testo (to_chars) e centesimi (llround) arrotondano diversamente
+    EXPECT_EQ(centesimiTesto(0.125), 12);
+    EXPECT_EQ(importoInCentesimi(0.125), 13);
+
+    for (int i = 0; i < 3000; i++) {
+        conto->aggiungiTransazione("Spesa " + to_string(i % 30), (i % 7) - 3.25,
+                                   giorniInData(dataInGiorni("2024-01-01") + i / 40));
+    }
+    OpzioniControlli opzioni;
+    opzioni.ogniRighe = 500;
+    opzioni.ogniMese = true;
+    conto->setPuntiDiControllo(opzioni);
+    long long saldo = importoInCentesimi(conto->calcolaSaldo());
+
+    // Testo: 6 tratti da 500 righe più i cambi di mese (gennaio-marzo)
+    conto->salvaSuFile();
+    RapportoVerifica rapporto = conto->verificaFile();
+    EXPECT_TRUE(rapporto.isIntegro());
+    EXPECT_EQ(rapporto.righeVerificate, 3000u);
+    EXPECT_EQ(rapporto.righeSenzaControllo, 0u);
+    EXPECT_GT(rapporto.segmenti, 6u);
+    EXPECT_EQ(rapporto.saldoCentesimi, saldo);
+    {
+        ContoCorrente riletto("test_data.txt");
+        EXPECT_EQ(riletto.getNumeroTransazioni(), 3000);
+    }
+
+    // Una riga modificata invalida solo il proprio tratto
+    ifstream in("test_data.txt");
+    stringstream contenuto;
+    contenuto << in.rdbuf();
+    in.close();
+    string testo = contenuto.str();
+    size_t pos = testo.find("Spesa 7;");
+    pos = testo.find("Spesa 7;", pos + 1200 * 20);
+    testo.replace(pos, 8, "Spesa 8;");
+    ofstream("test_data.txt") << testo;
+    rapporto = conto->verificaFile();
+    ASSERT_EQ(rapporto.corrotti.size(), 1u);
+    EXPECT_GT(rapporto.corrotti[0].primaRiga, 0u);
+    EXPECT_EQ(rapporto.corrotti[0].motivo, "impronta diversa: righe modificate");
+    EXPECT_LT(3000u - rapporto.righeVerificate, 501u);
+
+    // Compresso: un punto di controllo alterato coinvolge solo i due tratti adiacenti
+    conto->setFormatoFile(FormatoFile::Compresso);
+    conto->salvaSuFile();
+    rapporto = conto->verificaFile();
+    EXPECT_TRUE(rapporto.isIntegro());
+    EXPECT_EQ(rapporto.righeVerificate, 3000u);
+    EXPECT_EQ(rapporto.saldoCentesimi, saldo);
+    {
+        ContoCorrente riletto("test_data.txt");
+        EXPECT_EQ(riletto.getNumeroTransazioni(), 3000);
+        EXPECT_EQ(FormatoCompresso::leggiIntervallo("test_data.txt", "2024-01-01", "2024-01-01").size(), 40u);
+    }
+    fstream binario("test_data.txt", ios::in | ios::out | ios::binary);
+    string dati((istreambuf_iterator<char>(binario)), istreambuf_iterator<char>());
+    size_t blocco = 4;
+    int controlliVisti = 0;
+    while (blocco + 16 <= dati.size()) {
+        uint32_t righe = 0;
+        uint32_t byteDati = 0;
+        memcpy(&righe, &dati[blocco], 4);
+        memcpy(&byteDati, &dati[blocco + 12], 4);
+        if (righe == 0 && ++controlliVisti == 3) {
+            binario.seekp(blocco + 16 + 8);
+            binario.put(static_cast<char>(dati[blocco + 16 + 8] ^ 1));
+            break;
+        }
+        blocco += 16 + byteDati;
+    }
+    binario.close();
+    rapporto = conto->verificaFile();
+    ASSERT_EQ(rapporto.corrotti.size(), 2u);
+    EXPECT_EQ(rapporto.corrotti[0].segmento, 2u);
+    EXPECT_EQ(rapporto.corrotti[1].segmento, 3u);
+    EXPECT_EQ(rapporto.corrotti[0].motivo, "saldo diverso da quello registrato");
+
+    // Senza punti di controllo il formato resta la versione 2
+    conto->setPuntiDiControllo(OpzioniControlli());
+    conto->salvaSuFile();
+    ifstream firma("test_data.txt", ios::binary);
+    EXPECT_EQ(FormatoCompresso::riconosci(firma), 2);
+    firma.close();
+    rapporto = conto->verificaFile();
+    EXPECT_EQ(rapporto.segmenti, 0u);
+    EXPECT_EQ(rapporto.righeSenzaControllo, 3000u);
+}
+
+// Test transazione con la stessa descrizione del prefisso dei punti di controllo
+TEST_F(ContoCorrenteTest, DescrizioneComePuntoDiControllo) {
+    OpzioniControlli opzioni;
+    opzioni.ogniRighe = 1;
+    conto->setPuntiDiControllo(opzioni);
+    conto->aggiungiTransazione("#controllo", 7.0, "2024-02-01");
+    conto->aggiungiTransazione("Spesa", -2.0, "2024-02-02");
+    conto->salvaSuFile();
+    EXPECT_FALSE(isRigaControllo("#controllo;7.00;2024-02-01;1"));
+
+    ContoCorrente riletto("test_data.txt");
+    ASSERT_EQ(riletto.getNumeroTransazioni(), 2);
+    EXPECT_EQ(riletto.getTransazioni()[0].getDescrizione(), "#controllo");
+    RapportoVerifica rapporto = riletto.verificaFile();
+    EXPECT_TRUE(rapporto.isIntegro());
+    EXPECT_EQ(rapporto.righeVerificate, 2u);
+}